@@ -0,0 +1,101 @@
+#ifndef CHAINEDHASHTABLE_HPP
+#define CHAINEDHASHTABLE_HPP
+
+// The original separate-chaining table (vector<list<node>>, full rehash on
+// resize), kept only as a baseline for bench_hashtable.
+
+#include <string>
+#include <vector>
+#include <list>
+#include <functional>
+#include <algorithm>
+
+using namespace std;
+
+class ChainedHashTable {
+private:
+    struct Node {
+        string key;
+        string value;
+        long long expiryTime;
+
+        Node(const string& k, const string& v, long long exp) : key(k), value(v), expiryTime(exp) {}
+    };
+
+    vector<list<Node>> table;
+    size_t tableSize;
+    size_t numElements;
+
+    size_t hash(const string& key) const {
+        std::hash<std::string> hasher;
+        return hasher(key) % tableSize;
+    }
+
+    void resize() {
+        vector<list<Node>> oldTable = move(table);
+
+        tableSize *= 2;
+        table.clear();
+        table.resize(tableSize);
+        numElements = 0;
+
+        // Rehash all elements
+        for (const auto& bucket : oldTable) {
+            for (const auto& node : bucket) {
+                insert(node.key, node.value, node.expiryTime);
+            }
+        }
+    }
+
+public:
+    ChainedHashTable() : tableSize(16), numElements(0) {
+        table.resize(tableSize);
+    }
+
+    bool insert(const string& key, const string& value, long long expiryTime = -1) {
+        auto& bucket = table[hash(key)];
+
+        for (auto& node : bucket) {
+            if (node.key == key) {
+                node.value = value;
+                node.expiryTime = expiryTime;
+                return true;
+            }
+        }
+
+        bucket.emplace_back(key, value, expiryTime);
+        numElements++;
+
+        if (static_cast<double>(numElements) / tableSize > 0.75) {
+            resize();
+        }
+        return true;
+    }
+
+    bool get(const string& key, string& value) const {
+        for (const auto& node : table[hash(key)]) {
+            if (node.key == key) {
+                value = node.value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool remove(const string& key) {
+        auto& bucket = table[hash(key)];
+        auto it = find_if(bucket.begin(), bucket.end(),
+            [&key](const Node& node) { return node.key == key; });
+
+        if (it != bucket.end()) {
+            bucket.erase(it);
+            numElements--;
+            return true;
+        }
+        return false;
+    }
+
+    size_t size() const { return numElements; }
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "../include/Cache.hpp"
+#include "../include/AppendOnlyFile.hpp"
+#include "../include/CommandProcessor.hpp"
+#include "../include/utils.hpp"
+
+using namespace std;
+
+// Write throughput with the AOF off and under each fsync policy. Commands
+// go through CommandProcessor in batches, with one commit per batch, the
+// way the server commits once per event-loop iteration. Then times
+// replaying the log into an empty cache.
+// Usage: ./bench_aof [operations] [batchSize] [valueSize] [dir]
+
+class NullReplyWriter : public ReplyWriter {
+public:
+    using ReplyWriter::bulk;
+
+    void status(const string&) override {}
+    void error(const string&) override {}
+    void integer(long long) override {}
+    void bulk(const string&) override {}
+    void nil() override {}
+    void arrayHeader(size_t) override {}
+    void text(const string&) override {}
+};
+
+struct Result {
+    double opsPerSec;
+    AOFStats stats;
+};
+
+static Result runWrites(AppendOnlyFile* aof, size_t operations, size_t batchSize, size_t valueSize) {
+    Cache cache(SIZE_MAX, SIZE_MAX);
+    CommandProcessor processor(cache, aof);
+    NullReplyWriter reply;
+    string value(valueSize, 'v');
+    vector<string> argv;
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < operations; i++) {
+        argv = {"SET", "key:" + to_string(i % 100000), value};
+        processor.execute(argv, reply);
+        if (aof && (i + 1) % batchSize == 0) {
+            aof->commit();
+        }
+    }
+    if (aof) {
+        aof->commit();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    Result result;
+    result.opsPerSec = operations / seconds;
+    if (aof) {
+        result.stats = aof->getStats();
+    }
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    size_t operations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 200000;
+    size_t batchSize = argc > 2 ? strtoull(argv[2], nullptr, 10) : 16;
+    size_t valueSize = argc > 3 ? strtoull(argv[3], nullptr, 10) : 64;
+    string dir = argc > 4 ? argv[4] : "/tmp";
+    string path = dir + "/bench_aof_" + to_string(getpid()) + ".aof";
+
+    cout << "=== AOF WRITE THROUGHPUT ===" << endl;
+    cout << operations << " SETs, " << valueSize << "-byte values, commit every " << batchSize
+         << " commands, log in " << dir << endl << endl;
+    cout << left << setw(12) << "fsync" << right << setw(14) << "ops/sec" << setw(10) << "fsyncs"
+         << setw(14) << "log size" << endl;
+
+    Result baseline = runWrites(nullptr, operations, batchSize, valueSize);
+    cout << left << setw(12) << "(no aof)" << right << setw(14) << fixed << setprecision(0)
+         << baseline.opsPerSec << setw(10) << "-" << setw(14) << "-" << endl;
+
+    for (FsyncPolicy policy : {FsyncPolicy::NO, FsyncPolicy::EVERYSEC, FsyncPolicy::ALWAYS}) {
+        remove(path.c_str());
+        Result result;
+        {
+            AppendOnlyFile aof(path, policy);
+            aof.start();
+            result = runWrites(&aof, operations, batchSize, valueSize);
+        }
+        cout << left << setw(12) << fsyncPolicyName(policy) << right << setw(14) << result.opsPerSec
+             << setw(10) << result.stats.fsyncs << setw(14) << Utils::formatMemorySize(result.stats.fileBytes) << endl;
+    }
+
+    // The last log (always) is complete; time a restart from it
+    Cache cache(SIZE_MAX, SIZE_MAX);
+    CommandProcessor loader(cache);
+    AppendOnlyFile aof(path);
+    auto start = chrono::steady_clock::now();
+    size_t commands = aof.load(loader);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << endl << "Replay: " << commands << " commands in " << setprecision(3) << seconds << " s ("
+         << setprecision(0) << commands / seconds << " commands/sec), " << cache.getKeyCount() << " keys" << endl;
+
+    remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/Cache.hpp"
+
+using namespace std;
+
+// Lists and sets through Cache as the command handlers call it: memory per
+// element against the raw payload, and ns/op for each command. Lists should
+// cost a few bytes over their payload in every size; sets of integers an
+// intset's 2 to 8 bytes per member up to 512, a table's record and slot
+// past that.
+// Usage: ./bench_collections [ops]
+
+static double nanosSince(chrono::steady_clock::time_point start, size_t ops) {
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
+}
+
+static void benchLists(size_t ops) {
+    cout << "=== LIST BENCHMARK (" << ops << " ops per column, ns/op) ===" << endl;
+    cout << left << setw(10) << "elements" << right << setw(8) << "RPUSH" << setw(8) << "LPUSH" << setw(8) << "RPOP"
+         << setw(8) << "LPOP" << setw(10) << "LRANGE10" << setw(10) << "B/elem" << setw(10) << "payload"
+         << setw(11) << "encoding" << endl;
+
+    for (size_t elements : {100, 10000, 1000000}) {
+        Cache cache(SIZE_MAX, SIZE_MAX);
+        vector<string> values;
+        size_t payload = 0;
+        for (size_t i = 0; i < elements; i++) {
+            values.push_back("job:" + to_string(i));
+            payload += values.back().size();
+        }
+
+        size_t before = cache.getMemoryUsage();
+        size_t length;
+        for (size_t i = 0; i < elements; i++) {
+            string_view view = values[i];
+            cache.push("queue", &view, 1, false, length);
+        }
+        double bytesPerElement = static_cast<double>(cache.getMemoryUsage() - before) / elements;
+        const char* encoding = cache.encoding("queue");
+
+        // Pushes and pops in pairs, so the list keeps its size
+        string_view value = "job:pushed";
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            cache.push("queue", &value, 1, false, length);
+        }
+        double rpushNs = nanosSince(start, ops);
+
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            cache.push("queue", &value, 1, true, length);
+        }
+        double lpushNs = nanosSince(start, ops);
+
+        vector<string> popped;
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            cache.pop("queue", false, 1, popped);
+        }
+        double rpopNs = nanosSince(start, ops);
+
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            cache.pop("queue", true, 1, popped);
+        }
+        double lpopNs = nanosSince(start, ops);
+
+        // Ten elements from a random index
+        mt19937_64 rng(elements);
+        Cache::Result result;
+        size_t sink = 0;
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            size_t from = rng() % (elements - 9);
+            cache.readList("queue", result)->forEachInRange(from, from + 9, [&](string_view v) { sink += v.size(); });
+        }
+        double rangeNs = nanosSince(start, ops);
+
+        cout << left << setw(10) << elements << right << fixed << setprecision(0) << setw(8) << rpushNs << setw(8)
+             << lpushNs << setw(8) << rpopNs << setw(8) << lpopNs << setw(10) << rangeNs << setprecision(1)
+             << setw(10) << bytesPerElement << setw(10) << static_cast<double>(payload) / elements << setw(11)
+             << encoding << (sink == 42 ? " " : "") << endl;
+    }
+}
+
+static void benchSets(size_t ops) {
+    cout << endl << "=== SET BENCHMARK (" << ops << " ops per column, ns/op) ===" << endl;
+    cout << left << setw(10) << "members" << setw(9) << "kind" << right << setw(8) << "SADD" << setw(10) << "SISMEMBER"
+         << setw(8) << "SREM" << setw(9) << "SINTER" << setw(10) << "B/member" << setw(10) << "payload"
+         << setw(11) << "encoding" << endl;
+
+    for (size_t members : {100, 500, 10000, 1000000}) {
+        for (bool integers : {true, false}) {
+            Cache cache(SIZE_MAX, SIZE_MAX);
+            vector<string> names;
+            size_t payload = 0;
+            for (size_t i = 0; i < members; i++) {
+                names.push_back(integers ? to_string(i * 7) : "user:" + to_string(i));
+                payload += names.back().size();
+            }
+            vector<string_view> views(names.begin(), names.end());
+
+            size_t before = cache.getMemoryUsage();
+            size_t added, removed;
+            for (size_t i = 0; i < members; i += 1000) {
+                cache.sadd("big", &views[i], min<size_t>(1000, members - i), added);
+            }
+            double bytesPerMember = static_cast<double>(cache.getMemoryUsage() - before) / members;
+            const char* encoding = cache.encoding("big");
+
+            // A smaller set sharing every other member, for SINTER
+            for (size_t i = 0; i < members && i < 1000; i += 2) {
+                cache.sadd("small", &views[i], 1, added);
+            }
+
+            mt19937_64 rng(members);
+            vector<size_t> picks(ops);
+            for (size_t& pick : picks) pick = rng() % members;
+
+            Cache::Result result;
+            size_t sink = 0;
+            auto start = chrono::steady_clock::now();
+            for (size_t i = 0; i < ops; i++) {
+                sink += cache.readSet("big", result)->contains(views[picks[i]]);
+            }
+            double isMemberNs = nanosSince(start, ops);
+
+            // Each removal put back, so the set keeps its size and encoding
+            start = chrono::steady_clock::now();
+            for (size_t i = 0; i < ops; i++) {
+                cache.srem("big", &views[picks[i]], 1, removed);
+                cache.sadd("big", &views[picks[i]], 1, added);
+            }
+            double churnNs = nanosSince(start, ops);
+
+            start = chrono::steady_clock::now();
+            for (size_t i = 0; i < ops; i++) {
+                cache.sadd("big", &views[picks[i]], 1, added);
+            }
+            double saddNs = nanosSince(start, ops);
+
+            // The smaller set walked, each member probed in the larger
+            vector<const SetValue*> sets;
+            string_view keys[] = {"big", "small"};
+            size_t intersections = ops / 100 + 1;
+            start = chrono::steady_clock::now();
+            for (size_t i = 0; i < intersections; i++) {
+                cache.readSets(keys, 2, sets);
+                sets[1]->forEach([&](string_view member) { sink += sets[0]->contains(member); });
+            }
+            double interNs = nanosSince(start, intersections);
+
+            cout << left << setw(10) << members << setw(9) << (integers ? "int" : "string") << right << fixed
+                 << setprecision(0) << setw(8) << saddNs << setw(10) << isMemberNs << setw(8)
+                 << churnNs - saddNs << setw(9) << interNs << setprecision(1) << setw(10) << bytesPerMember
+                 << setw(10) << static_cast<double>(payload) / members << setw(11) << encoding
+                 << (sink == 42 ? " " : "") << endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t ops = argc > 1 ? stoul(argv[1]) : 200000;
+    benchLists(ops);
+    benchSets(ops);
+    return 0;
+}
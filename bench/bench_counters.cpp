@@ -0,0 +1,222 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "../include/Cache.hpp"
+#include "../include/Server.hpp"
+#include "../include/LatencyHistogram.hpp"
+#include "../include/utils.hpp"
+
+using namespace std;
+
+// A rate limiter's counter update done two ways: the client's GET, parse,
+// SET, and a server-side INCR. Over loopback, clients share a few hot keys,
+// so GET/SET also loses updates that INCR cannot. In process, the same two
+// paths through Cache isolate the integer encoding from the round trips.
+// Last, the bytes a million counters take stored inline against the same
+// digits as a string.
+// Usage: ./bench_counters [increments] [clients] [keys]
+
+static long long nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    return fd;
+}
+
+static string resp(const vector<string>& args) {
+    string out = "*" + to_string(args.size()) + "\r\n";
+    for (const string& arg : args) {
+        out += "$" + to_string(arg.size()) + "\r\n" + arg + "\r\n";
+    }
+    return out;
+}
+
+static void sendAll(int fd, const string& bytes) {
+    size_t sent = 0;
+    while (sent < bytes.size()) {
+        ssize_t n = send(fd, bytes.data() + sent, bytes.size() - sent, 0);
+        if (n <= 0) exit(1);
+        sent += n;
+    }
+}
+
+// One reply line, or a bulk string's payload; nothing is pipelined, so a
+// reply is all the connection holds
+static string readReply(int fd) {
+    string in;
+    char buffer[256];
+    for (;;) {
+        size_t lineEnd = in.find("\r\n");
+        if (lineEnd != string::npos) {
+            if (in[0] != '$') {
+                return in.substr(1, lineEnd - 1);
+            }
+            long long length = stoll(in.substr(1, lineEnd - 1));
+            if (length < 0) {
+                return "";
+            }
+            if (in.size() >= lineEnd + 2 + length + 2) {
+                return in.substr(lineEnd + 2, length);
+            }
+        }
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) exit(1);
+        in.append(buffer, n);
+    }
+}
+
+static void runClient(int port, int clientId, size_t increments, size_t keys, bool incr, LatencyHistogram* latency) {
+    int fd = connectTo(port);
+    for (size_t i = 0; i < increments; i++) {
+        string key = "rate:" + to_string((clientId + i) % keys);
+        long long start = nowNanos();
+        if (incr) {
+            sendAll(fd, resp({"INCR", key}));
+            readReply(fd);
+        } else {
+            sendAll(fd, resp({"GET", key}));
+            string value = readReply(fd);
+            long long count = 0;
+            Utils::parseInteger(value, count);
+            sendAll(fd, resp({"SET", key, to_string(count + 1)}));
+            readReply(fd);
+        }
+        latency->record(nowNanos() - start);
+    }
+    close(fd);
+}
+
+static void benchLoopback(size_t increments, int clients, size_t keys) {
+    Cache cache(SIZE_MAX, SIZE_MAX);
+    Server server(cache, 0);
+    server.start();
+    thread loop([&server]() { server.run(); });
+
+    cout << "=== COUNTERS OVER LOOPBACK (" << increments << " increments, " << clients << " clients, " << keys
+         << " keys) ===" << endl;
+    cout << left << setw(10) << "pattern" << right << setw(14) << "increments/s" << setw(10) << "p50 us"
+         << setw(10) << "p99 us" << setw(10) << "lost" << endl;
+
+    for (bool incr : {false, true}) {
+        size_t perClient = increments / clients;
+        vector<LatencyHistogram> latencies(clients);
+        vector<thread> threads;
+        auto start = chrono::steady_clock::now();
+        for (int c = 0; c < clients; c++) {
+            threads.emplace_back(runClient, server.getPort(), c, perClient, keys, incr, &latencies[c]);
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        // Updates that raced another client's and were overwritten
+        int fd = connectTo(server.getPort());
+        long long total = 0;
+        for (size_t k = 0; k < keys; k++) {
+            sendAll(fd, resp({"GET", "rate:" + to_string(k)}));
+            long long count = 0;
+            Utils::parseInteger(readReply(fd), count);
+            total += count;
+        }
+        sendAll(fd, resp({"FLUSHALL"}));
+        readReply(fd);
+        close(fd);
+
+        LatencyHistogram latency;
+        for (const LatencyHistogram& h : latencies) latency.merge(h);
+        cout << left << setw(10) << (incr ? "INCR" : "GET+SET") << right << fixed << setprecision(0) << setw(14)
+             << perClient * clients / seconds << setprecision(1) << setw(10) << latency.percentile(50) / 1000.0
+             << setw(10) << latency.percentile(99) / 1000.0 << setw(10)
+             << static_cast<long long>(perClient * clients) - total << endl;
+    }
+
+    server.stop();
+    loop.join();
+}
+
+static void benchInProcess(size_t increments, size_t keys) {
+    cout << endl << "=== COUNTERS IN PROCESS (" << increments << " increments, ns/op) ===" << endl;
+    cout << left << setw(10) << "pattern" << right << setw(10) << "ns/op" << endl;
+
+    vector<string> names;
+    for (size_t k = 0; k < keys; k++) names.push_back("rate:" + to_string(k));
+
+    Cache cache(SIZE_MAX, SIZE_MAX);
+    string value;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < increments; i++) {
+        const string& key = names[i % keys];
+        long long count = 0;
+        if (cache.get(key, value)) {
+            Utils::parseInteger(value, count);
+        }
+        cache.set(key, to_string(count + 1));
+    }
+    double getSetNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / increments;
+
+    cache.flush();
+    long long count;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < increments; i++) {
+        cache.incrby(names[i % keys], 1, count);
+    }
+    double incrNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / increments;
+
+    cout << left << setw(10) << "GET+SET" << right << fixed << setprecision(0) << setw(10) << getSetNs << endl;
+    cout << left << setw(10) << "INCR" << right << setw(10) << incrNs << endl;
+}
+
+static void benchMemory() {
+    const size_t counters = 1000000;
+    cout << endl << "=== MEMORY FOR " << counters << " COUNTERS ===" << endl;
+    cout << left << setw(22) << "stored as" << right << setw(12) << "B/counter" << setw(12) << "value B" << endl;
+
+    // The same digits, once canonical and once with a '+' that keeps them
+    // a string
+    for (bool inlined : {true, false}) {
+        Cache cache(SIZE_MAX, SIZE_MAX);
+        size_t before = cache.getMemoryUsage();
+        for (size_t i = 0; i < counters; i++) {
+            string digits = to_string(i * 37);
+            cache.set("rate:" + to_string(i), inlined ? digits : "+" + digits);
+        }
+        CacheStats stats = cache.getStats();
+        cout << left << setw(22) << (inlined ? "int (inline)" : "embstr (\"+N\")") << right << fixed
+             << setprecision(1) << setw(12) << static_cast<double>(cache.getMemoryUsage() - before) / counters
+             << setw(12) << static_cast<double>(stats.valueBytes) / counters << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t increments = argc > 1 ? stoul(argv[1]) : 200000;
+    int clients = argc > 2 ? stoi(argv[2]) : 4;
+    size_t keys = argc > 3 ? stoul(argv[3]) : 16;
+
+    benchLoopback(increments, clients, keys);
+    benchInProcess(increments * 10, keys);
+    benchMemory();
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include "../include/Cache.hpp"
+
+using namespace std;
+
+// Replays zipfian GET traffic against a Cache bounded to a fraction of the
+// key space, filling on miss, and reports hit ratio and throughput for each
+// eviction policy.
+// Usage: ./bench_eviction [numKeys] [cacheKeys] [numOps] [skew]
+
+// Ranks drawn from a zipfian distribution over numKeys keys, by inverting
+// the cumulative distribution
+static vector<size_t> zipfTrace(size_t numKeys, size_t numOps, double skew, mt19937_64& rng) {
+    vector<double> cdf(numKeys);
+    double sum = 0;
+    for (size_t i = 0; i < numKeys; i++) {
+        sum += 1.0 / pow(double(i + 1), skew);
+        cdf[i] = sum;
+    }
+
+    // Popular ranks are scattered over the key space, not clustered at the start
+    vector<size_t> keyOfRank(numKeys);
+    for (size_t i = 0; i < numKeys; i++) keyOfRank[i] = i;
+    shuffle(keyOfRank.begin(), keyOfRank.end(), rng);
+
+    uniform_real_distribution<double> uniform(0, sum);
+    vector<size_t> trace(numOps);
+    for (size_t i = 0; i < numOps; i++) {
+        size_t rank = lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        trace[i] = keyOfRank[min(rank, numKeys - 1)];
+    }
+    return trace;
+}
+
+int main(int argc, char* argv[]) {
+    size_t numKeys = argc > 1 ? stoul(argv[1]) : 1000000;
+    size_t cacheKeys = argc > 2 ? stoul(argv[2]) : numKeys / 10;
+    size_t numOps = argc > 3 ? stoul(argv[3]) : 5000000;
+    vector<double> skews = argc > 4 ? vector<double>{stod(argv[4])} : vector<double>{0.8, 0.99, 1.2};
+
+    vector<string> keys(numKeys);
+    for (size_t i = 0; i < numKeys; i++) {
+        keys[i] = "key:" + to_string(i);
+    }
+    string value(32, 'v');
+
+    cout << "=== EVICTION BENCHMARK (" << numKeys << " keys, cache of " << cacheKeys << ", "
+         << numOps << " GETs, fill on miss) ===" << endl;
+    cout << setw(8) << "skew" << setw(14) << "policy" << setw(12) << "hit ratio" << setw(14) << "ops/sec" << endl;
+
+    mt19937_64 rng(42);
+    for (double skew : skews) {
+        vector<size_t> trace = zipfTrace(numKeys, numOps, skew, rng);
+
+        for (EvictionType type : allEvictionTypes()) {
+            Cache cache(SIZE_MAX, cacheKeys, type);
+            string out;
+            size_t hits = 0;
+
+            auto start = chrono::steady_clock::now();
+            for (size_t key : trace) {
+                if (cache.get(keys[key], out)) {
+                    hits++;
+                } else {
+                    cache.set(keys[key], value);
+                }
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            cout << setw(8) << fixed << setprecision(2) << skew
+                 << setw(14) << cache.getStats().evictionPolicy
+                 << setw(11) << setprecision(2) << 100.0 * hits / numOps << "%"
+                 << setw(14) << setprecision(0) << numOps / seconds << endl;
+        }
+    }
+
+    return 0;
+}
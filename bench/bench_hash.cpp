@@ -0,0 +1,101 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "../include/Cache.hpp"
+
+using namespace std;
+
+// Cost of updating one field of a stored profile, kept either as a hash or
+// as the whole profile serialized into a string value that has to be read,
+// changed and rewritten, at several profile sizes; plus memory per profile
+// in each form.
+// Usage: ./bench_hash [profiles] [updates]
+
+// "field=value;" pairs, the string form of a profile
+static string serializeProfile(const vector<string>& fields, const vector<string>& values) {
+    string out;
+    for (size_t i = 0; i < fields.size(); i++) {
+        out += fields[i] + "=" + values[i] + ";";
+    }
+    return out;
+}
+
+// Replaces the value of field in a serialized profile
+static void updateProfile(string& profile, const string& field, const string& value) {
+    size_t start = profile.find(field + "=");
+    start += field.size() + 1;
+    size_t end = profile.find(';', start);
+    profile.replace(start, end - start, value);
+}
+
+static double nanosSince(chrono::steady_clock::time_point start, size_t ops) {
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
+}
+
+int main(int argc, char* argv[]) {
+    size_t profiles = argc > 1 ? stoul(argv[1]) : 10000;
+    size_t updates = argc > 2 ? stoul(argv[2]) : 500000;
+
+    cout << "=== HASH BENCHMARK (" << profiles << " profiles, " << updates << " updates) ===" << endl;
+    cout << left << setw(8) << "fields" << right << setw(14) << "string ns/upd" << setw(14) << "hash ns/upd"
+         << setw(10) << "speedup" << setw(16) << "string B/prof" << setw(14) << "hash B/prof" << setw(12)
+         << "encoding" << endl;
+
+    for (size_t fieldCount : {4, 16, 64, 128, 512}) {
+        vector<string> fields;
+        vector<string> values;
+        for (size_t i = 0; i < fieldCount; i++) {
+            fields.push_back("attribute_" + to_string(i));
+            values.push_back("value-" + to_string(i * 7919 % 100000));
+        }
+        string serialized = serializeProfile(fields, values);
+        vector<string> keys;
+        for (size_t p = 0; p < profiles; p++) {
+            keys.push_back("user:" + to_string(p));
+        }
+
+        // Whole profile as one string: GET, change a field, SET it all back
+        Cache strings(SIZE_MAX, SIZE_MAX);
+        for (const string& key : keys) {
+            strings.set(key, serialized);
+        }
+        size_t stringBytes = strings.getMemoryUsage() / profiles;
+        string profile;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < updates; i++) {
+            const string& key = keys[i % profiles];
+            strings.get(key, profile);
+            updateProfile(profile, fields[i % fieldCount], to_string(i % 100000));
+            strings.set(key, move(profile));
+        }
+        double stringNs = nanosSince(start, updates);
+
+        // A hash per profile: HSET of the one field
+        Cache hashes(SIZE_MAX, SIZE_MAX);
+        vector<string_view> pairs;
+        for (size_t i = 0; i < fieldCount; i++) {
+            pairs.push_back(fields[i]);
+            pairs.push_back(values[i]);
+        }
+        size_t added;
+        for (const string& key : keys) {
+            hashes.hset(key, pairs.data(), fieldCount, added);
+        }
+        size_t hashBytes = hashes.getMemoryUsage() / profiles;
+        string value;
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < updates; i++) {
+            value = to_string(i % 100000);
+            string_view pair[] = {fields[i % fieldCount], value};
+            hashes.hset(keys[i % profiles], pair, 1, added);
+        }
+        double hashNs = nanosSince(start, updates);
+
+        cout << left << setw(8) << fieldCount << right << fixed << setprecision(0) << setw(14) << stringNs
+             << setw(14) << hashNs << setw(9) << setprecision(1) << stringNs / hashNs << "x" << setw(16)
+             << stringBytes << setw(14) << hashBytes << setw(12) << hashes.encoding(keys[0]) << endl;
+    }
+    return 0;
+}
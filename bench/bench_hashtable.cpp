@@ -0,0 +1,118 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../include/HashTable.hpp"
+#include "ChainedHashTable.hpp"
+
+using namespace std;
+
+// Compares the open-addressing HashTable against the original chained table.
+// Usage: ./bench_hashtable [numKeys]
+
+struct BenchResult {
+    double insertOps;
+    double maxInsertMicros;
+    double hitOps;
+    double missOps;
+    double removeOps;
+};
+
+static double opsPerSec(size_t ops, chrono::steady_clock::duration d) {
+    double seconds = chrono::duration<double>(d).count();
+    return seconds > 0 ? ops / seconds : 0;
+}
+
+template <typename Table>
+BenchResult runBench(const vector<string>& keys, const vector<string>& lookupOrder,
+                     const vector<string>& missing, const string& value) {
+    BenchResult result;
+    Table table;
+
+    // Inserts, timing each one to catch resize stalls
+    chrono::steady_clock::duration worst(0);
+    auto start = chrono::steady_clock::now();
+    for (const string& key : keys) {
+        auto opStart = chrono::steady_clock::now();
+        table.insert(key, value);
+        worst = max(worst, chrono::steady_clock::now() - opStart);
+    }
+    result.insertOps = opsPerSec(keys.size(), chrono::steady_clock::now() - start);
+    result.maxInsertMicros = chrono::duration<double, micro>(worst).count();
+
+    string out;
+    start = chrono::steady_clock::now();
+    for (const string& key : lookupOrder) {
+        table.get(key, out);
+    }
+    result.hitOps = opsPerSec(lookupOrder.size(), chrono::steady_clock::now() - start);
+
+    start = chrono::steady_clock::now();
+    for (const string& key : missing) {
+        table.get(key, out);
+    }
+    result.missOps = opsPerSec(missing.size(), chrono::steady_clock::now() - start);
+
+    start = chrono::steady_clock::now();
+    for (const string& key : lookupOrder) {
+        table.remove(key);
+    }
+    result.removeOps = opsPerSec(lookupOrder.size(), chrono::steady_clock::now() - start);
+
+    return result;
+}
+
+static void printRow(const string& name, const BenchResult& r) {
+    cout << left << setw(16) << name << right << fixed << setprecision(0)
+         << setw(14) << r.insertOps
+         << setw(14) << r.hitOps
+         << setw(14) << r.missOps
+         << setw(14) << r.removeOps
+         << setprecision(1) << setw(16) << r.maxInsertMicros << endl;
+}
+
+// Runs each table in a child process so allocator state left behind by one
+// run (e.g. freeing millions of list nodes) does not show up in the next.
+template <typename Table>
+void runIsolated(const string& name, const vector<string>& keys, const vector<string>& lookupOrder,
+                 const vector<string>& missing, const string& value) {
+    cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        printRow(name, runBench<Table>(keys, lookupOrder, missing, value));
+        cout.flush();
+        _exit(0);
+    }
+    waitpid(pid, nullptr, 0);
+}
+
+int main(int argc, char* argv[]) {
+    size_t numKeys = argc > 1 ? stoul(argv[1]) : 1000000;
+    string value(32, 'v');
+
+    vector<string> keys, missing;
+    keys.reserve(numKeys);
+    missing.reserve(numKeys);
+    for (size_t i = 0; i < numKeys; i++) {
+        keys.push_back("key:" + to_string(i));
+        missing.push_back("missing:" + to_string(i));
+    }
+    vector<string> lookupOrder = keys;
+    shuffle(lookupOrder.begin(), lookupOrder.end(), mt19937(42));
+
+    cout << "=== HASH TABLE BENCHMARK (" << numKeys << " keys) ===" << endl;
+    cout << left << setw(16) << "table" << right
+         << setw(14) << "insert/s"
+         << setw(14) << "hit/s"
+         << setw(14) << "miss/s"
+         << setw(14) << "remove/s"
+         << setw(16) << "max insert us" << endl;
+
+    runIsolated<ChainedHashTable>("chained", keys, lookupOrder, missing, value);
+    runIsolated<HashTable>("open-addressing", keys, lookupOrder, missing, value);
+
+    return 0;
+}
@@ -0,0 +1,510 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "../include/Cache.hpp"
+#include "../include/ShardedCache.hpp"
+#include "../include/Server.hpp"
+#include "../include/LatencyHistogram.hpp"
+
+using namespace std;
+
+// Load generator: drives a Cache, a ShardedCache or a server over loopback
+// with a configurable mix of GETs and SETs, and reports throughput and
+// latency percentiles per command, as text or as JSON for tracking
+// regressions. Run with --help for the options.
+//
+// Each thread's requests (command, key, value size) are generated before
+// the clock starts, so only the cache (or the round trip) is timed, plus
+// two clock reads per request. Against a server, a request's latency is the
+// round trip of the pipeline it was sent in.
+
+struct Options {
+    string target = "cache";    // cache, sharded or server
+    size_t keys = 100000;
+    size_t requests = 1000000;  // in total, split over threads
+    size_t minValueSize = 64;
+    size_t maxValueSize = 64;
+    double readRatio = 0.9;     // share of GETs; the rest are SETs
+    string distribution = "zipf";
+    double skew = 0.99;
+    double ttlRatio = 0;        // share of SETs that carry a TTL
+    long long ttlMs = 60000;
+    int threads = 1;
+    size_t shards = 16;
+    size_t pipeline = 1;
+    string host = "127.0.0.1";
+    int port = 0;               // 0: start a server in this process
+    bool preload = true;
+    bool json = false;
+    unsigned seed = 1;
+};
+
+enum OpType : uint8_t { OP_GET, OP_SET, OP_PSETEX };
+
+struct Op {
+    uint32_t key;
+    uint8_t type;
+    uint8_t value;      // index into the value pool
+};
+
+struct ThreadResult {
+    LatencyHistogram get;
+    LatencyHistogram set;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+static const size_t VALUE_POOL_SIZE = 64;
+
+// Zipfian ranks in O(1) per draw (Gray et al., "Quickly generating
+// billion-record synthetic databases"), after an O(n) setup. Ranks are
+// scrambled so the popular keys are spread over the key space.
+class ZipfGenerator {
+private:
+    size_t n;
+    double theta, alpha, zetan, eta;
+
+    static double zeta(size_t n, double theta) {
+        double sum = 0;
+        for (size_t i = 1; i <= n; i++) {
+            sum += 1.0 / pow(double(i), theta);
+        }
+        return sum;
+    }
+
+public:
+    ZipfGenerator(size_t count, double skew) : n(count), theta(skew) {
+        zetan = zeta(n, theta);
+        double zeta2 = zeta(2, theta);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+    }
+
+    size_t next(mt19937_64& rng) {
+        double u = uniform_real_distribution<double>(0, 1)(rng);
+        double uz = u * zetan;
+        size_t rank;
+        if (uz < 1.0) {
+            rank = 0;
+        } else if (uz < 1.0 + pow(0.5, theta)) {
+            rank = 1;
+        } else {
+            rank = static_cast<size_t>(n * pow(eta * u - eta + 1.0, alpha));
+        }
+        // Fibonacci hashing scatters neighbouring ranks
+        return (min(rank, n - 1) * 11400714819323198485ULL) % n;
+    }
+};
+
+static vector<Op> generateOps(const Options& options, size_t count, unsigned seed) {
+    mt19937_64 rng(seed);
+    uniform_real_distribution<double> coin(0, 1);
+    uniform_int_distribution<size_t> uniformKey(0, options.keys - 1);
+    uniform_int_distribution<int> valueIndex(0, VALUE_POOL_SIZE - 1);
+    // The zipf constant is only defined for skew != 1
+    double skew = options.skew == 1.0 ? 0.9999 : options.skew;
+    ZipfGenerator zipf(options.keys, skew);
+    bool useZipf = options.distribution == "zipf";
+
+    vector<Op> ops(count);
+    for (Op& op : ops) {
+        op.key = useZipf ? zipf.next(rng) : uniformKey(rng);
+        if (coin(rng) < options.readRatio) {
+            op.type = OP_GET;
+        } else {
+            op.type = coin(rng) < options.ttlRatio ? OP_PSETEX : OP_SET;
+        }
+        op.value = valueIndex(rng);
+    }
+    return ops;
+}
+
+static inline uint64_t nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Direct calls; CacheType is Cache or ShardedCache
+template <typename CacheType>
+static void runDirect(CacheType& cache, const vector<Op>& ops, const vector<string>& keys,
+                      const vector<string>& values, const Options& options, ThreadResult& result) {
+    string value;
+    for (const Op& op : ops) {
+        const string& key = keys[op.key];
+        uint64_t start = nowNanos();
+        if (op.type == OP_GET) {
+            bool hit = cache.get(key, value);
+            result.get.record(nowNanos() - start);
+            hit ? result.hits++ : result.misses++;
+        } else {
+            if (op.type == OP_PSETEX) {
+                cache.psetex(key, values[op.value], options.ttlMs);
+            } else {
+                cache.set(key, values[op.value]);
+            }
+            result.set.record(nowNanos() - start);
+        }
+    }
+}
+
+static int connectTo(const string& host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 ||
+        connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    return fd;
+}
+
+static void appendCommand(string& out, initializer_list<string_view> args) {
+    out += "*" + to_string(args.size()) + "\r\n";
+    for (string_view arg : args) {
+        out += "$" + to_string(arg.size()) + "\r\n";
+        out.append(arg);
+        out += "\r\n";
+    }
+}
+
+// Reads until count replies are complete; counts GET hits and misses
+class ReplyReader {
+private:
+    int fd;
+    string buffer;
+    size_t pos = 0;
+
+    bool fill() {
+        if (pos > 0 && pos == buffer.size()) {
+            buffer.clear();
+            pos = 0;
+        }
+        char chunk[64 * 1024];
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            cerr << "server closed the connection" << endl;
+            exit(1);
+        }
+        buffer.append(chunk, n);
+        return true;
+    }
+
+    // One reply starting at pos; false if it is not all here yet
+    bool parseOne(bool& nil) {
+        size_t eol = buffer.find("\r\n", pos);
+        if (eol == string::npos) return false;
+        char type = buffer[pos];
+        nil = false;
+        if (type == '$') {
+            long long length = atoll(buffer.c_str() + pos + 1);
+            if (length < 0) {
+                nil = true;
+            } else if (buffer.size() < eol + 2 + length + 2) {
+                return false;
+            } else {
+                eol += length + 2;
+            }
+        } else if (type == '-') {
+            cerr << "server error: " << buffer.substr(pos, eol - pos) << endl;
+        }
+        pos = eol + 2;
+        return true;
+    }
+
+public:
+    explicit ReplyReader(int socket) : fd(socket) {}
+
+    void read(const Op* ops, size_t count, ThreadResult& result) {
+        for (size_t i = 0; i < count; i++) {
+            bool nil;
+            while (!parseOne(nil)) {
+                fill();
+            }
+            if (ops[i].type == OP_GET) {
+                nil ? result.misses++ : result.hits++;
+            }
+        }
+        buffer.erase(0, pos);
+        pos = 0;
+    }
+};
+
+static void runClient(const Options& options, const vector<Op>& ops, const vector<string>& keys,
+                      const vector<string>& values, ThreadResult& result, bool record) {
+    int fd = connectTo(options.host, options.port);
+    ReplyReader reader(fd);
+    string batch;
+    string ttl = to_string(options.ttlMs);
+
+    for (size_t first = 0; first < ops.size(); first += options.pipeline) {
+        size_t count = min(options.pipeline, ops.size() - first);
+        batch.clear();
+        size_t gets = 0;
+        for (size_t i = first; i < first + count; i++) {
+            const Op& op = ops[i];
+            if (op.type == OP_GET) {
+                appendCommand(batch, {"GET", keys[op.key]});
+                gets++;
+            } else if (op.type == OP_PSETEX) {
+                appendCommand(batch, {"PSETEX", keys[op.key], ttl, values[op.value]});
+            } else {
+                appendCommand(batch, {"SET", keys[op.key], values[op.value]});
+            }
+        }
+
+        uint64_t start = nowNanos();
+        for (size_t sent = 0; sent < batch.size();) {
+            ssize_t n = send(fd, batch.data() + sent, batch.size() - sent, 0);
+            if (n <= 0) {
+                perror("send");
+                exit(1);
+            }
+            sent += n;
+        }
+        reader.read(&ops[first], count, result);
+        uint64_t elapsed = nowNanos() - start;
+        if (record && gets > 0) result.get.record(elapsed, gets);
+        if (record && gets < count) result.set.record(elapsed, count - gets);
+    }
+    close(fd);
+}
+
+static void printUsage() {
+    cout << "Usage: bench_load [options]\n"
+         << "  --target T         cache (default, one thread), sharded or server\n"
+         << "  --keys N           key space size (default 100000)\n"
+         << "  --requests N       total requests over all threads (default 1000000)\n"
+         << "  --value-size A[-B] value bytes, or uniformly between A and B (default 64)\n"
+         << "  --read-ratio R     share of GETs, the rest SETs (default 0.9)\n"
+         << "  --distribution D   zipf (default) or uniform key popularity\n"
+         << "  --skew S           zipf skew (default 0.99)\n"
+         << "  --ttl-ratio R      share of SETs sent as PSETEX (default 0)\n"
+         << "  --ttl-ms N         their TTL (default 60000)\n"
+         << "  --threads N        threads, or client connections for a server (default 1)\n"
+         << "  --shards N         ShardedCache shards (default 16)\n"
+         << "  --pipeline N       requests per round trip to a server (default 1)\n"
+         << "  --host H --port P  use a running server instead of starting one\n"
+         << "  --no-preload       start from an empty cache instead of one SET per key\n"
+         << "  --seed N           random seed (default 1)\n"
+         << "  --json             print the results as JSON\n";
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--target" && hasValue) {
+            options.target = argv[++i];
+        } else if (arg == "--keys" && hasValue) {
+            options.keys = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--requests" && hasValue) {
+            options.requests = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--value-size" && hasValue) {
+            string range = argv[++i];
+            size_t dash = range.find('-');
+            options.minValueSize = strtoull(range.c_str(), nullptr, 10);
+            options.maxValueSize = dash == string::npos ? options.minValueSize
+                                                        : strtoull(range.c_str() + dash + 1, nullptr, 10);
+        } else if (arg == "--read-ratio" && hasValue) {
+            options.readRatio = atof(argv[++i]);
+        } else if (arg == "--distribution" && hasValue) {
+            options.distribution = argv[++i];
+        } else if (arg == "--skew" && hasValue) {
+            options.skew = atof(argv[++i]);
+        } else if (arg == "--ttl-ratio" && hasValue) {
+            options.ttlRatio = atof(argv[++i]);
+        } else if (arg == "--ttl-ms" && hasValue) {
+            options.ttlMs = atoll(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = atoi(argv[++i]);
+        } else if (arg == "--shards" && hasValue) {
+            options.shards = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--pipeline" && hasValue) {
+            options.pipeline = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--host" && hasValue) {
+            options.host = argv[++i];
+            options.target = "server";
+        } else if (arg == "--port" && hasValue) {
+            options.port = atoi(argv[++i]);
+            options.target = "server";
+        } else if (arg == "--no-preload") {
+            options.preload = false;
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--json") {
+            options.json = true;
+        } else {
+            return false;
+        }
+    }
+
+    if (options.target != "cache" && options.target != "sharded" && options.target != "server") {
+        cerr << "Unknown target: " << options.target << endl;
+        return false;
+    }
+    if (options.distribution != "zipf" && options.distribution != "uniform") {
+        cerr << "Unknown distribution: " << options.distribution << endl;
+        return false;
+    }
+    if (options.target == "cache" && options.threads != 1) {
+        cerr << "Cache is single-threaded; use --target sharded for more threads" << endl;
+        return false;
+    }
+    if (options.keys == 0 || options.threads < 1 || options.pipeline == 0 ||
+        options.minValueSize > options.maxValueSize) {
+        return false;
+    }
+    return true;
+}
+
+static void printLatency(ostream& out, const string& name, const LatencyHistogram& h, bool json) {
+    if (json) {
+        out << "\"" << name << "\": {\"count\": " << h.count() << ", \"mean_ns\": " << fixed << setprecision(1)
+            << h.mean() << ", \"p50_ns\": " << h.percentile(50) << ", \"p99_ns\": " << h.percentile(99)
+            << ", \"p999_ns\": " << h.percentile(99.9) << ", \"max_ns\": " << h.max() << "}";
+    } else {
+        out << left << setw(6) << name << right << setw(12) << h.count() << fixed << setprecision(0)
+            << setw(10) << h.mean() << setw(10) << h.percentile(50) << setw(10) << h.percentile(99)
+            << setw(10) << h.percentile(99.9) << setw(12) << h.max() << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return argc > 1 && strcmp(argv[1], "--help") == 0 ? 0 : 1;
+    }
+
+    vector<string> keys(options.keys);
+    for (size_t i = 0; i < options.keys; i++) {
+        keys[i] = "key:" + to_string(i);
+    }
+    vector<string> values(VALUE_POOL_SIZE);
+    mt19937_64 rng(options.seed);
+    uniform_int_distribution<size_t> valueSize(options.minValueSize, options.maxValueSize);
+    for (string& value : values) {
+        value.assign(valueSize(rng), 'v');
+    }
+
+    size_t perThread = options.requests / options.threads;
+    vector<vector<Op>> ops(options.threads);
+    for (int t = 0; t < options.threads; t++) {
+        ops[t] = generateOps(options, perThread, options.seed * 1000 + t);
+    }
+    vector<ThreadResult> results(options.threads);
+
+    // Unbounded, so only the workload decides what is stored
+    Cache cache(SIZE_MAX, SIZE_MAX);
+    ShardedCache sharded(options.shards, SIZE_MAX, SIZE_MAX);
+    Server* server = nullptr;
+    thread serverLoop;
+    if (options.target == "server" && options.port == 0) {
+        server = new Server(cache, 0);
+        server->start();
+        options.port = server->getPort();
+        serverLoop = thread([server]() { server->run(); });
+    }
+
+    if (options.preload) {
+        if (options.target == "cache" || server) {
+            for (const string& key : keys) cache.set(key, values[0]);
+        } else if (options.target == "sharded") {
+            for (const string& key : keys) sharded.set(key, values[0]);
+        } else {
+            vector<Op> fill(options.keys);
+            for (size_t i = 0; i < options.keys; i++) fill[i] = {static_cast<uint32_t>(i), OP_SET, 0};
+            Options preload = options;
+            preload.pipeline = 64;
+            ThreadResult ignored;
+            runClient(preload, fill, keys, values, ignored, false);
+        }
+    }
+
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (int t = 0; t < options.threads; t++) {
+        workers.emplace_back([&, t]() {
+            if (options.target == "cache") {
+                runDirect(cache, ops[t], keys, values, options, results[t]);
+            } else if (options.target == "sharded") {
+                runDirect(sharded, ops[t], keys, values, options, results[t]);
+            } else {
+                runClient(options, ops[t], keys, values, results[t], true);
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (server) {
+        server->stop();
+        serverLoop.join();
+        delete server;
+    }
+
+    ThreadResult total;
+    for (const ThreadResult& result : results) {
+        total.get.merge(result.get);
+        total.set.merge(result.set);
+        total.hits += result.hits;
+        total.misses += result.misses;
+    }
+    LatencyHistogram all = total.get;
+    all.merge(total.set);
+    size_t completed = perThread * options.threads;
+    double hitRatio = total.hits + total.misses ? double(total.hits) / (total.hits + total.misses) : 0;
+
+    ostringstream out;
+    if (options.json) {
+        out << "{\"target\": \"" << options.target << "\", \"keys\": " << options.keys
+            << ", \"requests\": " << completed << ", \"threads\": " << options.threads
+            << ", \"pipeline\": " << options.pipeline << ", \"value_size\": [" << options.minValueSize << ", "
+            << options.maxValueSize << "], \"read_ratio\": " << options.readRatio << ", \"distribution\": \""
+            << options.distribution << "\", \"skew\": " << options.skew << ", \"ttl_ratio\": " << options.ttlRatio
+            << ", \"seconds\": " << fixed << setprecision(4) << seconds << ", \"ops_per_sec\": " << setprecision(0)
+            << completed / seconds << ", \"hit_ratio\": " << setprecision(4) << hitRatio << ", \"latency\": {";
+        printLatency(out, "get", total.get, true);
+        out << ", ";
+        printLatency(out, "set", total.set, true);
+        out << ", ";
+        printLatency(out, "all", all, true);
+        out << "}}\n";
+    } else {
+        out << "=== LOAD (" << options.target << ", " << options.threads << " threads, "
+            << thread::hardware_concurrency() << " cores) ===\n";
+        out << options.keys << " keys, " << options.distribution;
+        if (options.distribution == "zipf") out << " " << options.skew;
+        out << ", " << options.readRatio * 100 << "% reads, values " << options.minValueSize << "-"
+            << options.maxValueSize << " B, " << options.ttlRatio * 100 << "% of SETs with TTL";
+        if (options.target == "server") out << ", pipeline " << options.pipeline;
+        out << "\n\n" << fixed << setprecision(0) << completed / seconds << " requests/s over " << setprecision(3)
+            << seconds << " s, GET hit ratio " << setprecision(1) << hitRatio * 100 << "%\n\n";
+        out << left << setw(6) << "" << right << setw(12) << "count" << setw(10) << "mean ns" << setw(10)
+            << "p50" << setw(10) << "p99" << setw(10) << "p99.9" << setw(12) << "max" << "\n";
+        printLatency(out, "GET", total.get, false);
+        printLatency(out, "SET", total.set, false);
+        printLatency(out, "ALL", all, false);
+    }
+    cout << out.str();
+    return 0;
+}
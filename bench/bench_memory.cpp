@@ -0,0 +1,46 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <unistd.h>
+#include "../include/Cache.hpp"
+
+using namespace std;
+
+// Measures resident bytes per key and GET throughput for a populated Cache.
+// Usage: ./bench_memory [numKeys] [valueSize]
+
+static size_t residentBytes() {
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+int main(int argc, char* argv[]) {
+    size_t numKeys = argc > 1 ? stoul(argv[1]) : 1000000;
+    size_t valueSize = argc > 2 ? stoul(argv[2]) : 32;
+    string value(valueSize, 'v');
+
+    size_t before = residentBytes();
+    Cache cache(SIZE_MAX, numKeys + 1);
+    for (size_t i = 0; i < numKeys; i++) {
+        cache.set("key:" + to_string(i), value, i % 2 ? 3600 : -1);
+    }
+    size_t after = residentBytes();
+
+    string out;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < numKeys; i++) {
+        cache.get("key:" + to_string((i * 7919) % numKeys), out);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "=== MEMORY BENCHMARK (" << numKeys << " keys, " << valueSize << "B values, half with TTL) ===" << endl;
+    cout << fixed << setprecision(1);
+    cout << "RSS bytes/key:       " << double(after - before) / numKeys << endl;
+    cout << "Tracked bytes/key:   " << double(cache.getMemoryUsage()) / numKeys << endl;
+    cout << "GET ops/sec:         " << setprecision(0) << numKeys / seconds << endl;
+
+    return 0;
+}
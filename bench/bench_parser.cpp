@@ -0,0 +1,140 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include "../include/Cache.hpp"
+#include "../include/CommandProcessor.hpp"
+#include "../include/RESP.hpp"
+#include "../include/utils.hpp"
+
+using namespace std;
+
+// Commands per second on one core through each front-end stage: splitting
+// inline commands, parsing RESP multibulk, looking up the command and the
+// whole parse + execute path with replies discarded.
+// Usage: ./bench_parser [commands] [valueSize]
+
+// Swallows replies so only parsing and dispatch are timed
+class NullReplyWriter : public ReplyWriter {
+public:
+    using ReplyWriter::bulk;
+
+    void status(const string&) override {}
+    void error(const string&) override {}
+    void integer(long long) override {}
+    void bulk(const string&) override {}
+    void nil() override {}
+    void arrayHeader(size_t) override {}
+    void text(const string&) override {}
+};
+
+static string resp(const vector<string>& args) {
+    string out = "*" + to_string(args.size()) + "\r\n";
+    for (const string& arg : args) {
+        out += "$" + to_string(arg.size()) + "\r\n" + arg + "\r\n";
+    }
+    return out;
+}
+
+static string toUpper(const string& str) {
+    string result = str;
+    transform(result.begin(), result.end(), result.begin(), ::toupper);
+    return result;
+}
+
+static void report(const string& name, size_t commands, chrono::steady_clock::time_point start) {
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << left << setw(36) << name << right << setw(12) << fixed << setprecision(0)
+         << commands / seconds << " cmds/s" << setw(10) << setprecision(1)
+         << seconds * 1e9 / commands << " ns/cmd" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t commands = argc > 1 ? stoul(argv[1]) : 1000000;
+    size_t valueSize = argc > 2 ? stoul(argv[2]) : 32;
+    string value(valueSize, 'v');
+
+    // A mix of reads and writes over 1000 keys
+    vector<vector<string>> mix;
+    for (size_t i = 0; i < 1000; i++) {
+        string key = "key:" + to_string(i);
+        if (i % 4 == 0) {
+            mix.push_back({"set", key, value});
+        } else {
+            mix.push_back({"get", key});
+        }
+    }
+    vector<string> lines;
+    string pipeline;
+    for (const vector<string>& args : mix) {
+        string line = args[0];
+        for (size_t i = 1; i < args.size(); i++) line += " " + args[i];
+        lines.push_back(line);
+        pipeline += resp(args);
+    }
+
+    cout << "=== PARSER BENCHMARK (" << commands << " commands, " << valueSize << "-byte values) ===" << endl;
+    size_t checksum = 0;
+
+    // Inline: the old CLI path, copying every token, against views split in place
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < commands; i++) {
+        vector<string> tokens = Utils::splitString(lines[i % lines.size()], ' ');
+        tokens[0] = toUpper(tokens[0]);
+        checksum += tokens.size();
+    }
+    report("inline split (strings)", commands, start);
+
+    vector<string_view> views;
+    string line;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < commands; i++) {
+        line = lines[i % lines.size()];
+        RESPParser::splitInline(&line[0], line.size(), views);
+        checksum += views.size();
+    }
+    report("inline split (views)", commands, start);
+
+    // Multibulk into views; the buffer holds the whole mix back to back
+    string error;
+    start = chrono::steady_clock::now();
+    size_t pos = 0;
+    for (size_t i = 0; i < commands; i++) {
+        if (pos == pipeline.size()) pos = 0;
+        RESPParser::parseCommand(pipeline, pos, views, error);
+        checksum += views.size();
+    }
+    report("multibulk parse (views)", commands, start);
+
+    // Lookup: upper-case copy and a hash map, as before, against the table
+    unordered_map<string, int> names = {{"SET", 0}, {"GET", 1}};
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < commands; i++) {
+        checksum += names.find(toUpper(mix[i % mix.size()][0]))->second;
+    }
+    report("lookup (toUpper + map)", commands, start);
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < commands; i++) {
+        checksum += CommandProcessor::lookupCommand(mix[i % mix.size()][0])->arity;
+    }
+    report("lookup (command table)", commands, start);
+
+    // Everything the server does per command short of the socket
+    Cache cache(1024 * 1024 * 256, 100000);
+    CommandProcessor processor(cache);
+    NullReplyWriter reply;
+    start = chrono::steady_clock::now();
+    pos = 0;
+    for (size_t i = 0; i < commands; i++) {
+        if (pos == pipeline.size()) pos = 0;
+        RESPParser::parseCommand(pipeline, pos, views, error);
+        processor.execute(views, reply);
+    }
+    report("parse + execute", commands, start);
+
+    cout << "(checksum " << checksum << ")" << endl;
+    return 0;
+}
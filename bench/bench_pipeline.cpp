@@ -0,0 +1,114 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "../include/Cache.hpp"
+#include "../include/Server.hpp"
+
+using namespace std;
+
+// Loopback throughput of the server at increasing pipeline depths. Each
+// client sends `depth` commands (alternating SET and GET) before reading
+// their replies.
+// Usage: ./bench_pipeline [requestsPerDepth] [clients] [valueSize]
+
+static int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    return fd;
+}
+
+static string resp(const vector<string>& args) {
+    string out = "*" + to_string(args.size()) + "\r\n";
+    for (const string& arg : args) {
+        out += "$" + to_string(arg.size()) + "\r\n" + arg + "\r\n";
+    }
+    return out;
+}
+
+static void runClient(int port, int clientId, size_t requests, size_t depth, size_t valueSize) {
+    int fd = connectTo(port);
+    string value(valueSize, 'v');
+
+    // Prebuild one pipeline and the exact bytes its replies take
+    string batch;
+    size_t replyBytes = 0;
+    for (size_t i = 0; i < depth; i++) {
+        string key = "key:" + to_string(clientId) + ":" + to_string(i);
+        if (i % 2 == 0) {
+            batch += resp({"SET", key, value});
+            replyBytes += strlen("+OK\r\n");
+        } else {
+            batch += resp({"GET", "key:" + to_string(clientId) + ":" + to_string(i - 1)});
+            replyBytes += ("$" + to_string(value.size()) + "\r\n" + value + "\r\n").size();
+        }
+    }
+
+    vector<char> buffer(64 * 1024);
+    for (size_t done = 0; done < requests; done += depth) {
+        size_t sent = 0;
+        while (sent < batch.size()) {
+            ssize_t n = send(fd, batch.data() + sent, batch.size() - sent, 0);
+            if (n <= 0) exit(1);
+            sent += n;
+        }
+        size_t received = 0;
+        while (received < replyBytes) {
+            ssize_t n = recv(fd, buffer.data(), buffer.size(), 0);
+            if (n <= 0) exit(1);
+            received += n;
+        }
+    }
+    close(fd);
+}
+
+int main(int argc, char* argv[]) {
+    size_t requests = argc > 1 ? stoul(argv[1]) : 200000;
+    int clients = argc > 2 ? stoi(argv[2]) : 4;
+    size_t valueSize = argc > 3 ? stoul(argv[3]) : 16;
+
+    Cache cache(SIZE_MAX, 1000000);
+    Server server(cache, 0);
+    server.start();
+    thread loop([&server]() { server.run(); });
+
+    cout << "=== PIPELINE BENCHMARK (" << requests << " requests, " << clients << " clients, "
+         << valueSize << "-byte values, " << thread::hardware_concurrency() << " cores) ===" << endl;
+    cout << left << setw(8) << "depth" << right << setw(16) << "requests/s" << endl;
+
+    for (size_t depth : {1, 16, 64}) {
+        size_t perClient = requests / clients / depth * depth;
+        vector<thread> threads;
+        auto start = chrono::steady_clock::now();
+        for (int c = 0; c < clients; c++) {
+            threads.emplace_back(runClient, server.getPort(), c, perClient, depth, valueSize);
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << left << setw(8) << depth << right << fixed << setprecision(0)
+             << setw(16) << perClient * clients / seconds << endl;
+    }
+
+    server.stop();
+    loop.join();
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include "../include/Cache.hpp"
+#include "../include/ShardedCache.hpp"
+
+using namespace std;
+
+// Throughput of a single Cache behind one global lock versus ShardedCache,
+// from 1 to 32 threads, on a 90% GET / 10% SET uniform workload.
+// Usage: ./bench_sharded [opsPerThread] [numKeys] [numShards]
+
+class GlobalLockCache {
+private:
+    mutex lock;
+    Cache cache;
+
+public:
+    GlobalLockCache(size_t maxKeys) : cache(SIZE_MAX, maxKeys) {}
+
+    bool set(const string& key, const string& value) {
+        lock_guard<mutex> guard(lock);
+        return cache.set(key, value);
+    }
+
+    bool get(const string& key, string& value) {
+        lock_guard<mutex> guard(lock);
+        return cache.get(key, value);
+    }
+};
+
+template <typename CacheType>
+double runThreads(CacheType& cache, int numThreads, size_t opsPerThread, const vector<string>& keys) {
+    vector<thread> threads;
+    auto start = chrono::steady_clock::now();
+
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&cache, &keys, opsPerThread, t]() {
+            mt19937_64 rng(t + 1);
+            uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+            string value;
+            for (size_t i = 0; i < opsPerThread; i++) {
+                const string& key = keys[pick(rng)];
+                if (i % 10 == 0) {
+                    cache.set(key, "value");
+                } else {
+                    cache.get(key, value);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return numThreads * opsPerThread / seconds;
+}
+
+int main(int argc, char* argv[]) {
+    size_t opsPerThread = argc > 1 ? stoul(argv[1]) : 200000;
+    size_t numKeys = argc > 2 ? stoul(argv[2]) : 100000;
+    size_t numShards = argc > 3 ? stoul(argv[3]) : 64;
+
+    vector<string> keys;
+    for (size_t i = 0; i < numKeys; i++) {
+        keys.push_back("key:" + to_string(i));
+    }
+
+    cout << "=== SHARDED CACHE BENCHMARK (" << numKeys << " keys, " << numShards << " shards, "
+         << thread::hardware_concurrency() << " cores) ===" << endl;
+    cout << left << setw(10) << "threads" << right << setw(18) << "global lock ops/s"
+         << setw(18) << "sharded ops/s" << setw(10) << "speedup" << endl;
+
+    for (int threads = 1; threads <= 32; threads *= 2) {
+        GlobalLockCache global(numKeys + 1);
+        ShardedCache sharded(numShards, SIZE_MAX, numKeys + numShards * 16);
+        for (const string& key : keys) {
+            global.set(key, "value");
+            sharded.set(key, "value");
+        }
+
+        double globalOps = runThreads(global, threads, opsPerThread, keys);
+        double shardedOps = runThreads(sharded, threads, opsPerThread, keys);
+        cout << left << setw(10) << threads << right << fixed << setprecision(0)
+             << setw(18) << globalOps << setw(18) << shardedOps
+             << setprecision(2) << setw(9) << shardedOps / globalOps << "x" << endl;
+    }
+
+    return 0;
+}
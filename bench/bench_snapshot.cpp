@@ -0,0 +1,164 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "../include/Cache.hpp"
+#include "../include/ShardedCache.hpp"
+#include "../include/Snapshot.hpp"
+#include "../include/utils.hpp"
+
+using namespace std;
+
+// Snapshot save and load times. Loading is compared against rebuilding the
+// same keyspace, laid out back to back in memory like the file, key by key
+// through Cache::set (whose table grows by repeated doubling) and through
+// loadKey with and without the up-front reserve, to separate what the bulk
+// path and the pre-sizing each buy. The file is read from the page cache;
+// drop caches first to include the disk.
+//
+// Then saves and loads in 1, 2, 4 ... maxSegments segments, loading into a
+// Cache (segments read in parallel, table built on one thread) and into a
+// 16-shard ShardedCache (tables built in parallel too).
+// Usage: ./bench_snapshot [keys] [valueSize] [dir] [maxSegments]
+
+struct PackedEntry {
+    size_t offset;      // key, then value, in the arena
+    size_t keyLength;
+    size_t valueLength;
+    long long ttlMs;
+};
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void report(const string& name, double seconds, size_t keys, size_t bytes) {
+    cout << left << setw(30) << name << right << fixed << setprecision(3) << setw(10) << seconds
+         << setprecision(0) << setw(14) << keys / seconds << setw(12) << setprecision(1)
+         << bytes / seconds / (1024 * 1024) << endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t keys = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t valueSize = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100;
+    string dir = argc > 3 ? argv[3] : "/tmp";
+    size_t maxSegments = argc > 4 ? strtoull(argv[4], nullptr, 10) : 8;
+    string path = dir + "/bench_snapshot_" + to_string(getpid()) + ".snapshot";
+
+    Cache source(SIZE_MAX, SIZE_MAX);
+    string value(valueSize, 'v');
+    for (size_t i = 0; i < keys; i++) {
+        // One key in ten with a TTL
+        source.set("key:" + to_string(i), value, i % 10 == 0 ? 3600 : -1);
+    }
+
+    cout << "=== SNAPSHOT SAVE / LOAD ===" << endl;
+    cout << keys << " keys, " << valueSize << "-byte values, file in " << dir << endl << endl;
+    cout << left << setw(30) << "" << right << setw(10) << "seconds" << setw(14) << "keys/sec"
+         << setw(12) << "MB/sec" << endl;
+
+    auto start = chrono::steady_clock::now();
+    size_t fileBytes = Snapshot::save(source, path, false);
+    report("SAVE, no checksum", secondsSince(start), keys, fileBytes);
+
+    start = chrono::steady_clock::now();
+    Snapshot::save(source, path, true);
+    report("SAVE", secondsSince(start), keys, fileBytes);
+
+    // Baselines from memory, no file involved
+    string arena;
+    vector<PackedEntry> entries;
+    entries.reserve(keys);
+    source.forEachEntry([&](string_view key, const ValueRef& v, long long ttlMs) {
+        char digits[ValueRef::MAX_DIGITS];
+        string_view bytes = v.view(digits);
+        entries.push_back({arena.size(), key.size(), bytes.size(), ttlMs});
+        arena.append(key);
+        arena.append(bytes);
+    });
+    auto keyOf = [&](const PackedEntry& e) { return string_view(arena.data() + e.offset, e.keyLength); };
+    auto valueOf = [&](const PackedEntry& e) {
+        return string_view(arena.data() + e.offset + e.keyLength, e.valueLength);
+    };
+    {
+        Cache cache(SIZE_MAX, SIZE_MAX);
+        start = chrono::steady_clock::now();
+        for (const PackedEntry& e : entries) {
+            cache.set(string(keyOf(e)), string(valueOf(e)), e.ttlMs < 0 ? -1 : static_cast<int>(e.ttlMs / 1000));
+        }
+        report("set() key by key", secondsSince(start), keys, fileBytes);
+    }
+    {
+        Cache cache(SIZE_MAX, SIZE_MAX);
+        start = chrono::steady_clock::now();
+        for (const PackedEntry& e : entries) {
+            cache.loadKey(keyOf(e), valueOf(e), e.ttlMs);
+        }
+        report("loadKey, no reserve", secondsSince(start), keys, fileBytes);
+    }
+    {
+        Cache cache(SIZE_MAX, SIZE_MAX);
+        start = chrono::steady_clock::now();
+        cache.reserve(keys);
+        for (const PackedEntry& e : entries) {
+            cache.loadKey(keyOf(e), valueOf(e), e.ttlMs);
+        }
+        report("loadKey after reserve", secondsSince(start), keys, fileBytes);
+    }
+    string().swap(arena);
+    vector<PackedEntry>().swap(entries);
+
+    // From the file: mmap, checksum, reserve and loadKey
+    double loadSeconds;
+    {
+        Cache cache(SIZE_MAX, SIZE_MAX);
+        start = chrono::steady_clock::now();
+        size_t loaded = Snapshot::load(cache, path);
+        loadSeconds = secondsSince(start);
+        report("Snapshot::load", loadSeconds, loaded, fileBytes);
+    }
+    Snapshot::save(source, path, false);
+    {
+        Cache cache(SIZE_MAX, SIZE_MAX);
+        start = chrono::steady_clock::now();
+        size_t loaded = Snapshot::load(cache, path);
+        report("Snapshot::load, no checksum", secondsSince(start), loaded, fileBytes);
+    }
+
+    const double target = 20.0 * 1024 * 1024 * 1024;
+    cout << endl << "File: " << Utils::formatMemorySize(fileBytes) << "; at this rate a 20 GB snapshot loads in "
+         << setprecision(1) << loadSeconds * target / fileBytes << " s" << endl;
+
+    cout << endl << "=== SEGMENTS (" << thread::hardware_concurrency() << " cores) ===" << endl;
+    cout << left << setw(10) << "segments" << right << setw(12) << "save s" << setw(14) << "load Cache s"
+         << setw(16) << "load Sharded s" << endl;
+    for (size_t segments = 1; segments <= maxSegments; segments *= 2) {
+        start = chrono::steady_clock::now();
+        Snapshot::save(source, path, true, segments);
+        double saveSeconds = secondsSince(start);
+
+        double cacheSeconds, shardedSeconds;
+        {
+            Cache cache(SIZE_MAX, SIZE_MAX);
+            start = chrono::steady_clock::now();
+            Snapshot::load(cache, path);
+            cacheSeconds = secondsSince(start);
+        }
+        {
+            ShardedCache cache(16, SIZE_MAX, SIZE_MAX);
+            start = chrono::steady_clock::now();
+            Snapshot::load(cache, path);
+            shardedSeconds = secondsSince(start);
+        }
+        cout << left << setw(10) << segments << right << setprecision(3) << setw(12) << saveSeconds
+             << setw(14) << cacheSeconds << setw(16) << shardedSeconds << endl;
+    }
+
+    Snapshot::remove(path);
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/Cache.hpp"
+
+using namespace std;
+
+// Per-operation cost of the sorted set commands on one set of 1K to 1M
+// members, through Cache as the command handlers call it. Updates, rank and
+// range lookups should grow with log N, ZSCORE not at all; memory is per
+// member, index and skiplist nodes included.
+// Usage: ./bench_zset [ops]
+
+static double nanosSince(chrono::steady_clock::time_point start, size_t ops) {
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
+}
+
+int main(int argc, char* argv[]) {
+    size_t ops = argc > 1 ? stoul(argv[1]) : 200000;
+
+    cout << "=== SORTED SET BENCHMARK (" << ops << " ops per column, ns/op) ===" << endl;
+    cout << left << setw(10) << "members" << right << setw(8) << "ZADD" << setw(8) << "ZSCORE" << setw(8) << "ZRANK"
+         << setw(8) << "ZRANGE" << setw(9) << "BYSCORE" << setw(9) << "ZINCRBY" << setw(8) << "ZREM" << setw(10)
+         << "B/member" << setw(10) << "encoding" << endl;
+
+    for (size_t members : {1000, 10000, 100000, 1000000}) {
+        Cache cache(SIZE_MAX, SIZE_MAX);
+        mt19937_64 rng(members);
+        vector<string> names;
+        vector<double> scores;
+        for (size_t i = 0; i < members; i++) {
+            names.push_back("player:" + to_string(i));
+            scores.push_back(static_cast<double>(rng() % (members * 10)));
+        }
+        vector<string_view> views(names.begin(), names.end());
+
+        size_t before = cache.getMemoryUsage();
+        size_t added, updated;
+        double score;
+        for (size_t i = 0; i < members; i += 1000) {
+            size_t batch = min<size_t>(1000, members - i);
+            cache.zadd("board", &scores[i], &views[i], batch, 0, added, updated, score);
+        }
+        size_t bytesPerMember = (cache.getMemoryUsage() - before) / members;
+
+        // Random members in a fixed order, so every column sees the same keys
+        vector<size_t> picks(ops);
+        for (size_t& pick : picks) pick = rng() % members;
+
+        // ZADD of a new score to an existing member moves it
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            double newScore = static_cast<double>(rng() % (members * 10));
+            cache.zadd("board", &newScore, &views[picks[i]], 1, 0, added, updated, score);
+        }
+        double zaddNs = nanosSince(start, ops);
+
+        Cache::Result result;
+        double sink = 0;
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            cache.readZSet("board", result)->score(views[picks[i]], score);
+            sink += score;
+        }
+        double scoreNs = nanosSince(start, ops);
+
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            sink += cache.readZSet("board", result)->rank(views[picks[i]]);
+        }
+        double rankNs = nanosSince(start, ops);
+
+        // Ten members from a random rank, and from a random score
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            size_t from = picks[i] < members - 10 ? picks[i] : members - 10;
+            cache.readZSet("board", result)->forEachInRanks(from, from + 9, false,
+                                                            [&](string_view, double s) { sink += s; });
+        }
+        double rangeNs = nanosSince(start, ops);
+
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            ScoreRange range{static_cast<double>(picks[i] * 10), INFINITY};
+            cache.readZSet("board", result)->forEachInRange(range, false, 0, 10,
+                                                            [&](string_view, double s) { sink += s; });
+        }
+        double byScoreNs = nanosSince(start, ops);
+
+        double increment = 1;
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            cache.zadd("board", &increment, &views[picks[i]], 1, ZSetValue::ADD_INCR, added, updated, score);
+        }
+        double incrNs = nanosSince(start, ops);
+
+        // Removes up to half the set, each member once
+        size_t removals = min(ops, members / 2);
+        size_t removed;
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < removals; i++) {
+            cache.zrem("board", &views[i * 2], 1, removed);
+        }
+        double zremNs = nanosSince(start, removals);
+
+        const char* encoding = cache.encoding("board");
+        cout << left << setw(10) << members << right << fixed << setprecision(0) << setw(8) << zaddNs << setw(8)
+             << scoreNs << setw(8) << rankNs << setw(8) << rangeNs << setw(9) << byScoreNs << setw(9) << incrNs
+             << setw(8) << zremNs << setw(10) << bytesPerMember << setw(10) << encoding
+             << (sink == 42 ? " " : "") << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+#include "../include/Cache.hpp"
+
+using namespace std;
+
+// Replays a key trace against every eviction policy, filling on miss, and
+// reports hit ratio, replay speed and the time a request costs on average
+// once each miss is charged missCostMicros (the backend fetch it causes).
+// Usage: ./trace_replay [traceFile|synthetic] [cacheKeys] [missCostMicros]
+//
+// A trace has one key per line; for lines like "GET key ..." the second
+// field is the key. Without a file, a zipfian trace with periodic scan
+// bursts is generated.
+
+struct Trace {
+    vector<string> keys;        // distinct keys
+    vector<uint32_t> requests;  // index into keys per request
+};
+
+static bool loadTrace(const string& path, Trace& trace) {
+    ifstream in(path);
+    if (!in) return false;
+
+    unordered_map<string, uint32_t> ids;
+    string line, first, second;
+    while (getline(in, line)) {
+        istringstream fields(line);
+        if (!(fields >> first)) continue;
+        const string& key = fields >> second ? second : first;
+
+        auto it = ids.find(key);
+        if (it == ids.end()) {
+            it = ids.emplace(key, static_cast<uint32_t>(trace.keys.size())).first;
+            trace.keys.push_back(key);
+        }
+        trace.requests.push_back(it->second);
+    }
+    return true;
+}
+
+// Zipfian reads over a working set, interrupted every scanEvery requests by
+// a scan of scanLength keys that are never read again
+static Trace syntheticTrace(size_t numKeys, size_t numRequests, double skew,
+                            size_t scanEvery, size_t scanLength) {
+    mt19937_64 rng(42);
+    vector<double> cdf(numKeys);
+    double sum = 0;
+    for (size_t i = 0; i < numKeys; i++) {
+        sum += 1.0 / pow(double(i + 1), skew);
+        cdf[i] = sum;
+    }
+
+    Trace trace;
+    for (size_t i = 0; i < numKeys; i++) {
+        trace.keys.push_back("key:" + to_string(i));
+    }
+
+    uniform_real_distribution<double> uniform(0, sum);
+    while (trace.requests.size() < numRequests) {
+        if (trace.requests.size() % scanEvery == scanEvery - 1) {
+            for (size_t i = 0; i < scanLength; i++) {
+                trace.requests.push_back(static_cast<uint32_t>(trace.keys.size()));
+                trace.keys.push_back("scan:" + to_string(trace.keys.size()));
+            }
+        }
+        size_t rank = lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        trace.requests.push_back(static_cast<uint32_t>(min(rank, numKeys - 1)));
+    }
+    return trace;
+}
+
+int main(int argc, char* argv[]) {
+    string source = argc > 1 ? argv[1] : "synthetic";
+    size_t cacheKeys = argc > 2 ? stoul(argv[2]) : 20000;
+    double missCostMicros = argc > 3 ? stod(argv[3]) : 100;
+
+    Trace trace;
+    if (source == "synthetic") {
+        trace = syntheticTrace(200000, 3000000, 0.9, 500000, 50000);
+    } else if (!loadTrace(source, trace)) {
+        cerr << "Cannot read trace " << source << endl;
+        return 1;
+    }
+    if (trace.requests.empty()) {
+        cerr << "Empty trace" << endl;
+        return 1;
+    }
+
+    cout << "=== TRACE REPLAY (" << source << ": " << trace.requests.size() << " requests, "
+         << trace.keys.size() << " keys, cache of " << cacheKeys << ", "
+         << missCostMicros << " us per miss) ===" << endl;
+    cout << setw(14) << "policy" << setw(12) << "hit ratio" << setw(12) << "misses"
+         << setw(14) << "ops/sec" << setw(16) << "us/request" << endl;
+
+    string value(32, 'v');
+    string bestPolicy;
+    double bestCost = 0;
+    for (EvictionType type : allEvictionTypes()) {
+        Cache cache(SIZE_MAX, cacheKeys, type);
+        string out;
+        size_t hits = 0;
+
+        auto start = chrono::steady_clock::now();
+        for (uint32_t id : trace.requests) {
+            if (cache.get(trace.keys[id], out)) {
+                hits++;
+            } else {
+                cache.set(trace.keys[id], value);
+            }
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        size_t requests = trace.requests.size();
+        size_t misses = requests - hits;
+        double cost = (seconds * 1e6 + misses * missCostMicros) / requests;
+        string policy = cache.getStats().evictionPolicy;
+        if (bestPolicy.empty() || cost < bestCost) {
+            bestPolicy = policy;
+            bestCost = cost;
+        }
+
+        cout << setw(14) << policy
+             << setw(11) << fixed << setprecision(2) << 100.0 * hits / requests << "%"
+             << setw(12) << misses
+             << setw(14) << setprecision(0) << requests / seconds
+             << setw(16) << setprecision(3) << cost << endl;
+    }
+    cout << "Cheapest at this miss cost: " << bestPolicy << endl;
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#ifndef ARCPOLICY_HPP
+#define ARCPOLICY_HPP
+
+#include "LRUCache.hpp"
+#include <list>
+#include <unordered_map>
+
+using namespace std;
+
+// Adaptive Replacement Cache (Megiddo and Modha). Resident keys are split
+// between T1, seen once recently, and T2, seen at least twice; the ghost
+// lists B1 and B2 remember the hashes of keys recently evicted from each.
+// A miss that hits a ghost list shows which side was cut too short and
+// moves the target size p of T1 towards it, so the balance between
+// recency and frequency adapts to the workload.
+//
+// The cache size ARC balances against is the number of resident keys, so
+// the policy follows whichever limit (keys or memory) Cache enforces.
+// Ghosts are kept by hash; a collision only skews one adaptation step.
+class ARCPolicy : public EvictionPolicy {
+private:
+    enum Side : uint32_t { T1 = 1, T2 = 2 };
+    
+    struct Ghost {
+        Side side;
+        list<size_t>::iterator position;
+    };
+    
+    LRUCache t1;
+    LRUCache t2;
+    list<size_t> b1;    // most recent first
+    list<size_t> b2;
+    unordered_map<size_t, Ghost> ghosts;
+    size_t target;      // p, the size T1 is steered towards
+    bool lastFromB2;
+    const HashNode* evicting;   // returned by victim, becomes a ghost on remove
+    
+    void forgetGhost(unordered_map<size_t, Ghost>::iterator it);
+    void trimGhosts();
+    
+public:
+    ARCPolicy() : t1(0), t2(0), target(0), lastFromB2(false), evicting(nullptr) {}
+    
+    void insert(HashNode* node) override;
+    void access(HashNode* node) override;
+    void remove(HashNode* node) override;
+    HashNode* victim(const HashNode* keep) override;
+    void clear() override;
+    
+    size_t size() const override { return t1.size() + t2.size(); }
+    size_t memoryUsage() const override;
+    const char* name() const override { return "arc"; }
+    
+    size_t getTarget() const { return target; }
+    size_t ghostCount() const { return ghosts.size(); }
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef APPENDONLYFILE_HPP
+#define APPENDONLYFILE_HPP
+
+#include <string>
+#include <string_view>
+#include <initializer_list>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+#include <iostream>
+#include <sys/types.h>
+
+using namespace std;
+
+class CommandProcessor;
+class Cache;
+class HashValue;
+class ZSetValue;
+class ListValue;
+class SetValue;
+
+// When the AOF writer calls fdatasync
+enum class FsyncPolicy {
+    ALWAYS,     // before the replies of the commands it covers are sent
+    EVERYSEC,   // at most once a second; a crash loses about a second of writes
+    NO          // never; the kernel flushes when it likes
+};
+
+bool parseFsyncPolicy(const string& name, FsyncPolicy& policy);   // always, everysec, no
+const char* fsyncPolicyName(FsyncPolicy policy);
+
+// Point-in-time AOF counters, as reported by STATS
+struct AOFStats {
+    FsyncPolicy policy = FsyncPolicy::EVERYSEC;
+    size_t fileBytes = 0;       // on disk, written but maybe not yet synced
+    size_t bufferedBytes = 0;   // appended, not yet written
+    size_t unsyncedBytes = 0;   // written since the last fsync
+    long long fsyncs = 0;
+    long long writeErrors = 0;
+    bool rewriteInProgress = false;
+    long long rewrites = 0;
+    size_t rewriteBaseBytes = 0;    // size after the last rewrite, or at startup
+};
+
+// Append-only log of the commands that changed the keyspace, encoded as
+// RESP so replaying it is just running it through a CommandProcessor.
+//
+// The command thread only appends to an in-memory buffer. A writer thread
+// swaps the buffer out and writes and syncs it, so every write or fsync
+// covers whatever accumulated meanwhile (group commit). The event loop
+// calls commit once per iteration, before sending replies: it wakes the
+// writer and, with FsyncPolicy::ALWAYS, waits until everything appended so
+// far is on disk, so no client sees a reply for a write that could be lost.
+//
+// The log is compacted by a background rewrite, as in Redis: a forked child
+// writes the keyspace it inherited (one SET, plus PEXPIREAT, per live key)
+// to a temporary file, copy-on-write keeping it consistent while the parent
+// goes on serving. Records appended meanwhile are also kept aside; once the
+// child exits, the writer thread appends them to the new file, syncs it and
+// renames it over the old one. cron starts a rewrite by itself whenever the
+// file has grown by autoRewritePercentage since the last one.
+class AppendOnlyFile {
+private:
+    string path;
+    FsyncPolicy policy;
+    int fd;
+
+    // Shared with the writer thread, under lock
+    mutex lock;
+    condition_variable wake;        // writer: there is data, or stop
+    condition_variable durable;     // commit: the writer made progress
+    string buffer;                  // appended, not yet taken by the writer
+    uint64_t appendedBytes;         // totals since start
+    uint64_t writtenBytes;
+    uint64_t syncedBytes;
+    size_t fileBytes;               // written to the current file
+    long long fsyncs;
+    long long writeErrors;
+    bool failing;                   // the last write failed; retried on the next pass
+    bool stopping;
+
+    // Rewrite state shared with the writer, under lock
+    bool rewriteTee;                // copy appends into rewriteBuffer
+    string rewriteBuffer;           // appended since the rewrite child forked
+    bool rewriteReady;              // child succeeded; the writer swaps files
+    size_t rewriteBaseBytes;
+    long long rewrites;
+
+    // Command thread only
+    pid_t rewritePid;               // -1 when no child is running
+    int autoRewritePercentage;
+    size_t autoRewriteMinBytes;
+
+    thread writer;
+
+    // How long the writer sleeps when nobody wakes it
+    static const int WRITER_IDLE_MS = 100;
+    static const long long EVERYSEC_INTERVAL_MS = 1000;
+    static const size_t READ_CHUNK = 1024 * 1024;
+    static const size_t REWRITE_CHUNK = 64 * 1024;
+    static const size_t REWRITE_ITEMS_PER_COMMAND = 64;
+
+    static void encodeHeader(string& out, size_t argc);
+    static void encodeArg(string& out, string_view arg);
+    static void encode(string& out, initializer_list<string_view> argv);
+    static bool writeAll(int out, string& data);
+    static void encodeHash(string& out, string_view key, const HashValue& hash);
+    static void encodeZSet(string& out, string_view key, const ZSetValue& zset);
+    static void encodeList(string& out, string_view key, const ListValue& list);
+    static void encodeSet(string& out, string_view key, const SetValue& set);
+    void writerLoop();
+    void appended(size_t before);
+    string rewritePath() const { return path + ".rewrite"; }
+    static bool writeKeyspace(const Cache& cache, int out);
+    bool swapInRewrite();
+
+public:
+    AppendOnlyFile(const string& filePath, FsyncPolicy fsyncPolicy = FsyncPolicy::EVERYSEC);
+    ~AppendOnlyFile();     // writes and syncs what is left
+    AppendOnlyFile(const AppendOnlyFile&) = delete;
+    AppendOnlyFile& operator=(const AppendOnlyFile&) = delete;
+
+    // Replays an existing log through processor (which must not log to this
+    // file) and returns the number of commands run. An incomplete command at
+    // the end, left by a crash mid-write, is cut off. Throws runtime_error
+    // if the file cannot be read or is corrupt. Call before start.
+    size_t load(CommandProcessor& processor);
+
+    // Opens the file for appending and starts the writer thread; throws
+    // runtime_error on failure
+    void start();
+
+    // Called from the command thread only
+    void append(initializer_list<string_view> argv);
+    void append(const vector<string_view>& argv);
+    void commit();
+
+    // Forks the rewrite child; false if one is already running or fork
+    // failed. Command thread only, after start.
+    bool startRewrite(const Cache& cache);
+    bool isRewriting();
+    // Reaps a finished rewrite child and starts automatic rewrites; the
+    // server calls it from its cron
+    void cron(const Cache& cache);
+    // Rewrite once the file is minBytes or more and has grown by percentage
+    // since the last rewrite; 0 turns automatic rewrites off
+    void setAutoRewrite(int percentage, size_t minBytes) {
+        autoRewritePercentage = percentage;
+        autoRewriteMinBytes = minBytes;
+    }
+
+    AOFStats getStats();
+    static void printStats(const AOFStats& stats, ostream& out = cout);
+    const string& getPath() const { return path; }
+
+    static const int DEFAULT_REWRITE_PERCENTAGE = 100;
+    static const size_t DEFAULT_REWRITE_MIN_BYTES = 64 * 1024 * 1024;
+};
+
+#endif
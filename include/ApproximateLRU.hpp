@@ -0,0 +1,85 @@
+#ifndef APPROXIMATELRU_HPP
+#define APPROXIMATELRU_HPP
+
+#include "EvictionPolicy.hpp"
+#include <cstdint>
+
+using namespace std;
+
+// Policies that approximate LRU without a recency list. A hit writes one
+// field of the entry it has already loaded instead of splicing neighbours
+// on other cache lines, and eviction finds candidates by walking the hash
+// table's slots.
+
+// Draws entries from random slots, for policies that evict by sampling
+class SlotSampler {
+private:
+    HashTable& table;
+    uint64_t rng;
+    
+public:
+    explicit SlotSampler(HashTable& t) : table(t), rng(0x9E3779B97F4A7C15ULL) {}
+    
+    uint64_t random() {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return rng;
+    }
+    
+    // First entry at or after a random slot other than keep, or null
+    HashNode* sample(const HashNode* keep);
+};
+
+// CLOCK over the table's slots: a hit sets the entry's reference bit; the
+// hand sweeps slots in order, clearing set bits and evicting the first
+// entry whose bit is already clear. New keys start unreferenced, so a key
+// that is never read again goes before any key that is.
+class ClockPolicy : public EvictionPolicy {
+private:
+    HashTable& table;
+    size_t hand;
+    size_t count;
+    
+public:
+    explicit ClockPolicy(HashTable& t) : table(t), hand(0), count(0) {}
+    
+    void insert(HashNode* node) override { node->evictionState = 0; count++; }
+    void access(HashNode* node) override { node->evictionState = 1; }
+    void remove(HashNode*) override { count--; }
+    HashNode* victim(const HashNode* keep) override;
+    void clear() override { hand = 0; count = 0; }
+    
+    size_t size() const override { return count; }
+    const char* name() const override { return "clock"; }
+};
+
+// Approximated LRU in the style of Redis: a hit stamps the entry with the
+// current tick, and eviction samples a few random entries and picks the one
+// stamped longest ago. The tick only advances on inserts, so hits never
+// write shared state; stamps are as fine as eviction decisions need, since
+// those only happen on inserts too.
+class SampledLRUPolicy : public EvictionPolicy {
+private:
+    SlotSampler sampler;
+    size_t samples;
+    uint32_t tick;
+    size_t count;
+    
+public:
+    static const size_t DEFAULT_SAMPLES = 5;
+    
+    explicit SampledLRUPolicy(HashTable& t, size_t sampleCount = DEFAULT_SAMPLES)
+        : sampler(t), samples(sampleCount), tick(0), count(0) {}
+    
+    void insert(HashNode* node) override { node->evictionState = ++tick; count++; }
+    void access(HashNode* node) override { node->evictionState = tick; }
+    void remove(HashNode*) override { count--; }
+    HashNode* victim(const HashNode* keep) override;
+    void clear() override { count = 0; }
+    
+    size_t size() const override { return count; }
+    const char* name() const override { return "sampled-lru"; }
+};
+
+#endif
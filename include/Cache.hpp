@@ -2,48 +2,269 @@
 #define CACHE_HPP
 
 #include "HashTable.hpp"
-#include "LRUCache.hpp"
+#include "HashValue.hpp"
+#include "ZSetValue.hpp"
+#include "ListValue.hpp"
+#include "SetValue.hpp"
+#include "EvictionPolicy.hpp"
 #include "TTLManager.hpp"
 #include <string>
+#include <vector>
 #include <chrono>
+#include <functional>
+#include <string_view>
+#include <iostream>
 
 using namespace std;
 
+// Point-in-time counters, also summed across shards by ShardedCache
+struct CacheStats {
+    size_t keys = 0;
+    size_t memoryBytes = 0;
+    size_t maxMemoryBytes = 0;
+    
+    // Where memoryBytes goes; the first six add up to it
+    size_t keyBytes = 0;            // entry chunks (key inline), less the eviction links
+    size_t valueBytes = 0;          // value chunks and adopted buffers
+    size_t indexBytes = 0;          // control bytes and slots, both tables while rehashing
+    size_t evictionBytes = 0;       // eviction links inside the entries, plus policy state
+    size_t ttlBytes = 0;            // TTL wheel bucket capacity
+    size_t pinnedBytes = 0;         // values no longer stored but still held by readers
+    size_t fragmentationBytes = 0;  // slab page bytes not holding requested data
+    
+    long long totalOperations = 0;
+    double opsPerSecond = 0;
+    const char* evictionPolicy = "";
+    size_t trackedKeys = 0;         // keys the eviction policy tracks
+    size_t maxKeys = 0;
+    size_t ttlEntries = 0;
+    long long evictedKeys = 0;
+    long long expiredKeys = 0;
+    long long expireCycles = 0;
+    size_t lastCycleExpired = 0;
+    long long lastCycleMicros = 0;
+    long long totalCycleMicros = 0;
+    long long keyspaceHits = 0;     // GET and MGET lookups that found a live key
+    long long keyspaceMisses = 0;
+    long long resizes = 0;          // index growth, see ResizeStats
+    long long lastResizeMicros = 0;
+    long long maxResizeMicros = 0;
+    long long totalResizeMicros = 0;
+    size_t slabPageBytes = 0;       // reserved from the system in slab pages
+    size_t slabUsedBytes = 0;       // chunks in use plus large allocations
+    size_t shards = 1;
+    
+    void merge(const CacheStats& other);
+};
+
+// One key for Cache::loadKeys; ttlMs is -1 for no TTL. A value of another
+// type is in its serialized form.
+struct LoadEntry {
+    string_view key;
+    string_view value;
+    long long ttlMs;
+    ValueType type;
+};
+
 class Cache {
+public:
+    // Outcome of an operation on a key that must hold a given type
+    enum Result { OK, NOT_FOUND, WRONG_TYPE, NOT_INTEGER, OUT_OF_RANGE, NOT_A_NUMBER };
+    
 private:
     HashTable* hashTable;
-    LRUCache* lruCache;
+    EvictionPolicy* eviction;
     TTLManager* ttlManager;
     
     size_t maxMemoryBytes;
-    size_t currentMemoryBytes;
     size_t maxKeys;
     
+    // Bytes held by stored keys, per structure. The total used for eviction
+    // comes from the allocator instead, see getMemoryUsage.
+    size_t entryBytes;
+    size_t valueBytes;
+    
+    // Time commands compare expiry against, in Utils::monotonicMillis. Read
+    // once per command (or batch) unless an event loop pins it with setClock.
+    long long clockMs;
+    bool clockPinned;
+    
     // Performance metrics
     long long totalOperations;
     chrono::high_resolution_clock::time_point startTime;
     
-    void cleanupExpiredKeys();
-    void evictIfNeeded();
-    size_t estimateKeyMemory(const string& key, const string& value) const;
+    // Expiry and eviction metrics
+    long long expiredKeys;
+    long long evictedKeys;
+    long long expireCycles;
+    size_t lastCycleExpired;
+    long long lastCycleMicros;
+    long long totalCycleMicros;
+    
+    // Read lookups, as Redis counts keyspace hits and misses
+    long long keyspaceHits;
+    long long keyspaceMisses;
+    
+    // Active expiry runs on every command with a small, bounded budget
+    static const size_t ACTIVE_EXPIRE_KEYS_PER_CYCLE = 20;
+    static const long long ACTIVE_EXPIRE_CYCLE_BUDGET_US = 1000;
+    
+    // How many keys ahead batch operations prefetch
+    static const size_t BATCH_PREFETCH_DISTANCE = 8;
+    
+    // Reused by the batch operations so they do not allocate per call
+    vector<size_t> batchHashes;
+    
+    HashNode* lookupKey(string_view key) { return lookupKey(key, HashTable::hashKey(key)); }
+    HashNode* lookupKey(string_view key, size_t h);
+    void setKey(string_view key, size_t h, ValueRef value, long long ttlMs);
+    
+    // Typed access: the live entry for key if it holds that type, else null
+    // with NOT_FOUND or WRONG_TYPE. readKey counts a keyspace hit or miss;
+    // writeKey creates an empty T for a missing key. valueChanged then
+    // settles the accounting after a change.
+    HashNode* readKey(string_view key, ValueType type, Result& result);
+    template <typename T> HashNode* writeKey(string_view key, Result& result, bool& created);
+    void valueChanged(HashNode* node, size_t oldBytes, bool created);
+    
+    // The batch operations, for keys held as string or string_view
+    template <typename Key> void hashBatch(const Key* keys, size_t count, size_t stride);
+    template <typename Key> void mgetKeys(const Key* keys, size_t count, vector<ValueRef>& values);
+    template <typename Key> void msetKeys(const Key* keysAndValues, size_t pairCount, int ttlSeconds);
+    template <typename Key> size_t mdelKeys(const Key* keys, size_t count);
+    void loadKey(string_view key, size_t h, string_view value, long long ttlMs, ValueType type);
+    void removeKey(HashNode* node);
+    void evictIfNeeded(const HashNode* keep);
+    size_t entryMemory(const HashNode* node) const;
     
 public:
-    Cache(size_t maxMem = 1024 * 1024 * 100, size_t maxKeysLimit = 10000); // 100MB default
+    Cache(size_t maxMem = 1024 * 1024 * 100, size_t maxKeysLimit = 10000, // 100MB default
+          EvictionType evictionType = EvictionType::LRU);
     ~Cache();
     
-    // Core Redis-like operations
-    bool set(const string& key, const string& value, int ttlSeconds = -1);
-    bool get(const string& key, string& value);
-    bool del(const string& key);
-    bool exists(const string& key);
-    bool expire(const string& key, int seconds);
+    // Core Redis-like operations. Keys and copied values are taken as
+    // string_view, so a command parsed in place stores straight from the
+    // input buffer; the const char* overloads only resolve literals.
+    bool set(string_view key, string_view value, int ttlSeconds = -1);
+    bool set(string_view key, string&& value, int ttlSeconds = -1);     // moves the value in
+    bool set(string_view key, const char* value, int ttlSeconds = -1) { return set(key, string_view(value), ttlSeconds); }
+    bool get(string_view key, string& value);
+    bool get(string_view key, ValueRef& value);     // pins the stored bytes, no copy
+    // As get, telling a key of another type (WRONG_TYPE) from a missing one
+    Result getString(string_view key, ValueRef& value);
+    bool del(string_view key);
+    bool exists(string_view key);
+    bool expire(string_view key, int seconds);
     void flush();
     
+    // Counters, as INCRBY and INCRBYFLOAT: a missing key counts from 0 and
+    // an existing one keeps its TTL. incrby fails with NOT_INTEGER or
+    // OUT_OF_RANGE on overflow; incrbyfloat with NOT_A_NUMBER for a value
+    // that is not a float and OUT_OF_RANGE for a NaN or infinite result,
+    // and leaves the key's remaining TTL in ttlMs as pttl reports it.
+    Result incrby(string_view key, long long increment, long long& value);
+    Result incrbyfloat(string_view key, double increment, double& value, long long& ttlMs);
+    Result incrbyfloat(string_view key, double increment, double& value) { long long ttlMs; return incrbyfloat(key, increment, value, ttlMs); }
+    
+    // Millisecond TTLs. pttl and ttl return -2 for a missing key and -1
+    // for one without a TTL; ttl rounds to the nearest second.
+    bool psetex(string_view key, string_view value, long long ttlMs);
+    bool psetex(string_view key, string&& value, long long ttlMs);
+    bool psetex(string_view key, const char* value, long long ttlMs) { return psetex(key, string_view(value), ttlMs); }
+    bool pexpire(string_view key, long long ms);
+    long long pttl(string_view key);
+    long long ttl(string_view key);
+    
+    // Type and encoding name of a key, as TYPE and OBJECT ENCODING report
+    // them; false and null for a missing key
+    bool type(string_view key, ValueType& type);
+    const char* encoding(string_view key);
+    
+    // Hashes. Writes create the key, and the key goes once its last field
+    // is deleted. readHash returns the hash, good until the next command,
+    // or null with NOT_FOUND or WRONG_TYPE in result. hincrby fails with
+    // NOT_INTEGER or OUT_OF_RANGE as HINCRBY does.
+    const HashValue* readHash(string_view key, Result& result);
+    Result hset(string_view key, const string_view* fieldsAndValues, size_t pairCount, size_t& added);
+    Result hdel(string_view key, const string_view* fields, size_t count, size_t& removed);
+    Result hincrby(string_view key, string_view field, long long increment, long long& value);
+    
+    // Sorted sets, created and removed the same way. zadd applies
+    // ZSetValue::add with flags to each member in turn, counting the members
+    // added and those whose score changed; score is what the last member
+    // holds afterwards, NaN if it was skipped. A NaN sum with ADD_INCR fails
+    // with NOT_A_NUMBER before anything changes.
+    const ZSetValue* readZSet(string_view key, Result& result);
+    Result zadd(string_view key, const double* scores, const string_view* members, size_t count, uint32_t flags,
+                size_t& added, size_t& updated, double& score);
+    Result zrem(string_view key, const string_view* members, size_t count, size_t& removed);
+    
+    // Lists, created and removed the same way. push adds values one at a
+    // time at the front (or back), as LPUSH does, leaving the new length in
+    // length; pop takes up to count elements from that end into values.
+    const ListValue* readList(string_view key, Result& result);
+    Result push(string_view key, const string_view* values, size_t count, bool front, size_t& length);
+    Result pop(string_view key, bool front, size_t count, vector<string>& values);
+    
+    // Sets, likewise. readSets looks up several keys for one command, such
+    // as SINTER: sets[i] is null for a missing key, and any key of another
+    // type fails the whole call with WRONG_TYPE.
+    const SetValue* readSet(string_view key, Result& result);
+    Result readSets(const string_view* keys, size_t count, vector<const SetValue*>& sets);
+    Result sadd(string_view key, const string_view* members, size_t count, size_t& added);
+    Result srem(string_view key, const string_view* members, size_t count, size_t& removed);
+    
+    // Pins the time every following command sees until the next call, so an
+    // event loop reads the clock once per iteration instead of per command
+    void setClock(long long nowMs);
+    
+    // Multi-key operations. One expiry cycle and counter update per call;
+    // keys are hashed up front and their buckets prefetched ahead of lookup.
+    // mget resizes values to count; missing keys come back as null refs.
+    void mget(const string* keys, size_t count, vector<ValueRef>& values);
+    void mget(const string_view* keys, size_t count, vector<ValueRef>& values);
+    void mset(const string* keysAndValues, size_t pairCount, int ttlSeconds = -1);
+    void mset(const string_view* keysAndValues, size_t pairCount, int ttlSeconds = -1);
+    size_t mdel(const string* keys, size_t count);
+    size_t mdel(const string_view* keys, size_t count);
+    
+    // Expires at most keyLimit keys from the TTL wheel, stopping early once
+    // budgetMicros is spent. Called with the default budget on every command.
+    void activeExpireCycle(size_t keyLimit = ACTIVE_EXPIRE_KEYS_PER_CYCLE,
+                           long long budgetMicros = ACTIVE_EXPIRE_CYCLE_BUDGET_US);
+    
+    // Bulk loading, as from a snapshot: reserve sizes the index for count
+    // more keys up front, and loadKey adds a key that must not be present
+    // yet, without the per-command expiry cycle or counters. Limits still
+    // apply. ttlMs is -1 for no TTL; a value of another type is in its
+    // serialized form, already checked. loadKeys hashes a batch up front
+    // and prefetches ahead, like mset.
+    void reserve(size_t count);
+    void loadKey(string_view key, string_view value, long long ttlMs, ValueType type = ValueType::STRING);
+    void loadKeys(const LoadEntry* entries, size_t count);
+    
+    // Calls visit for every live key, in table order, with its remaining TTL
+    // in milliseconds (-1 for none). Only reads, touching no eviction state
+    // or counters, so a forked child can walk its copy of the keyspace, and
+    // several threads can walk it at once: with parts > 1 only the part-th
+    // of that many equal slot ranges is visited.
+    void forEachEntry(const function<void(string_view key, const ValueRef& value, long long ttlMs)>& visit,
+                      size_t part = 0, size_t parts = 1) const;
+    
     // Status and metrics
     void showStats() const;
+    CacheStats getStats() const;
+    static void printStats(const CacheStats& stats, ostream& out = cout);
+    vector<SlabClassStats> getSlabStats() const { return hashTable->allocator().classStats(); }
+    static void printSlabStats(const vector<SlabClassStats>& classes, ostream& out = cout);
     double getOpsPerSecond() const;
-    size_t getMemoryUsage() const { return currentMemoryBytes; }
+    // Zeroes the counters above (operations, hits, expiry, eviction and
+    // resize metrics) and restarts the ops/sec window; keys stay
+    void resetStats();
+    size_t getMemoryUsage() const;
     size_t getKeyCount() const;
+    long long getExpiredKeyCount() const { return expiredKeys; }
+    long long getEvictedKeyCount() const { return evictedKeys; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,191 @@
+#ifndef COMMANDPROCESSOR_HPP
+#define COMMANDPROCESSOR_HPP
+
+#include "Cache.hpp"
+#include "ReplyWriter.hpp"
+#include "AppendOnlyFile.hpp"
+#include "Snapshot.hpp"
+#include "LatencyHistogram.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Calls and latency of one command, reply encoding included. Each processor
+// keeps its own and the server runs one per event loop, so recording is a
+// few plain increments with no lock.
+struct CommandStats {
+    long long calls = 0;
+    long long failedCalls = 0;      // replied with an error
+    LatencyHistogram latency;       // nanoseconds
+};
+
+// Executes parsed commands against a Cache. Shared by the interactive CLI
+// and the network server, which differ only in how replies are rendered.
+//
+// Commands are rows of a static table carrying their handler, arity, flags
+// and key positions, as in Redis. Names are looked up case-insensitively
+// through a perfect hash built at compile time, so dispatch is one hash,
+// one probe and one compare, and arity is checked before the handler runs.
+//
+// Keys hold strings, hashes, sorted sets, lists or sets; a command on a key
+// of another type fails with WRONGTYPE, as in Redis, except MGET, which
+// returns nil for it.
+//
+// With an AppendOnlyFile attached, every command that changed the keyspace
+// is logged. Relative TTLs are logged as PEXPIREAT with a wall-clock time,
+// so replaying the log later does not extend them. With a SnapshotManager,
+// SAVE, BGSAVE and LASTSAVE write and report its snapshot file.
+//
+// STATS prints the counters for people; INFO prints the same in Redis's
+// "# Section" / "field:value" format for tools, per-command call counts and
+// latency percentiles included. STATS RESET zeroes them.
+class CommandProcessor {
+public:
+    // Command flags, as COMMAND reports them
+    enum CommandFlags : uint32_t {
+        CMD_WRITE = 1 << 0,     // may change the keyspace
+        CMD_READONLY = 1 << 1,  // only reads keys
+        CMD_ADMIN = 1 << 2,     // persistence and server state
+        CMD_FAST = 1 << 3,      // constant or logarithmic time
+    };
+    
+    typedef void (CommandProcessor::*Handler)(const vector<string_view>& argv, ReplyWriter& reply);
+    
+    // One row of the command table. arity counts the name itself; -N means
+    // at least N. Keys are argv[firstKey], argv[firstKey + keyStep], ... up
+    // to lastKey, where -1 is the last argument; firstKey 0 means no keys.
+    struct CommandSpec {
+        string_view name;
+        Handler handler;
+        int arity;
+        uint32_t flags;
+        int firstKey;
+        int lastKey;
+        int keyStep;
+    };
+
+private:
+    Cache& cache;
+    AppendOnlyFile* aof;
+    SnapshotManager* snapshots;
+    bool closeRequested;    // set by QUIT, returned by execute
+    
+    // Reused by MGET, LPOP / RPOP and SINTER so large batches do not
+    // allocate per call; each belongs to one command
+    vector<ValueRef> batchValues;
+    vector<string> poppedValues;
+    vector<const SetValue*> batchSets;
+    vector<string> interMembers;
+    
+    // Indexed like COMMAND_TABLE
+    vector<CommandStats> commandStats;
+    long long unknownCommands;
+    
+    static const CommandSpec COMMAND_TABLE[];
+    static const size_t COMMAND_COUNT;
+    struct CommandIndex;
+    static const CommandIndex COMMAND_INDEX;
+    static constexpr CommandIndex buildCommandIndex();
+    
+    static void wrongArity(string_view command, ReplyWriter& reply);
+    static void wrongType(ReplyWriter& reply);
+    
+    void handleSetCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleGetCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleIncrCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleDecrCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleIncrByCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleDecrByCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void incrementBy(const vector<string_view>& argv, long long increment, ReplyWriter& reply);
+    void handleIncrByFloatCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleDeleteCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleMGetCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleMSetCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleExistsCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleExpireCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handlePExpireCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void expireKey(const vector<string_view>& argv, ReplyWriter& reply, bool millis);
+    void handlePSetExCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleTTLCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handlePTTLCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handlePExpireAtCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleTypeCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleObjectCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleHSetCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleHGetCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleHMGetCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleHDelCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleHLenCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleHExistsCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleHGetAllCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleHIncrByCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleZAddCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleZIncrByCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void zaddIncrement(string_view key, double increment, string_view member, uint32_t flags, ReplyWriter& reply);
+    void handleZRemCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleZCardCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleZScoreCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleZRankCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleZRevRankCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void zsetRank(const vector<string_view>& argv, ReplyWriter& reply, bool reverse);
+    void handleZRangeCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleZRevRangeCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void zrangeByRank(const vector<string_view>& argv, ReplyWriter& reply, bool reverse, bool withScores);
+    void handleZRangeByScoreCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleZRevRangeByScoreCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void zrangeByScore(const vector<string_view>& argv, ReplyWriter& reply, bool reverse);
+    void handleZCountCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleLPushCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleRPushCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void pushList(const vector<string_view>& argv, ReplyWriter& reply, bool front);
+    void handleLPopCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleRPopCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void popList(const vector<string_view>& argv, ReplyWriter& reply, bool front);
+    void handleLLenCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleLRangeCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleSAddCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleSRemCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleSIsMemberCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleSCardCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleSMembersCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleSInterCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleFlushCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleBgRewriteAofCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleSaveCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleBgSaveCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleLastSaveCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleStatsCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleInfoCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleDbSizeCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handlePingCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleEchoCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleCommandCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleConfigCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void handleQuitCommand(const vector<string_view>& argv, ReplyWriter& reply);
+    void logSet(string_view key, string_view value, long long ttlMs);
+    void logExpiry(string_view key, long long ttlMs);
+    static void describeCommand(const CommandSpec& command, ReplyWriter& reply);
+    vector<size_t> commandsByName() const;
+    void printCommandStats(ostream& out) const;
+    void resetStats();
+
+public:
+    CommandProcessor(Cache& c, AppendOnlyFile* log = nullptr, SnapshotManager* dumps = nullptr);
+    
+    // Runs one command and writes exactly one reply. Returns false when the
+    // client asked to close the connection (QUIT). The arguments only need
+    // to stay valid for the call; anything kept is copied.
+    bool execute(const vector<string_view>& argv, ReplyWriter& reply);
+    // For callers holding their arguments as strings
+    bool execute(const vector<string>& argv, ReplyWriter& reply);
+    
+    // The table row for a command name, in any case; null if unknown
+    static const CommandSpec* lookupCommand(string_view name);
+    // Stats of a command by name; null if it is not known
+    const CommandStats* getCommandStats(string_view command) const;
+};
+
+#endif
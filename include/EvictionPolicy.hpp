@@ -0,0 +1,47 @@
+#ifndef EVICTIONPOLICY_HPP
+#define EVICTIONPOLICY_HPP
+
+#include "HashTable.hpp"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+enum class EvictionType {
+    LRU,            // exact recency list (LRUCache)
+    CLOCK,          // reference bit per entry, hand sweeps the table
+    SAMPLED_LRU,    // coarse access stamp per entry, oldest of a few samples
+    LFU,            // decaying log counter per entry, coldest of a few samples
+    TINY_LFU,       // LRU window, sketch-gated admission to a segmented LRU
+    ARC             // adaptive split between recency and frequency lists
+};
+
+// Decides which key Cache evicts next. Policies keep their state in the
+// entries (HashNode::lruPrev/lruNext and evictionState) and never own or
+// free nodes. Cache calls insert for a new key, access on every hit or
+// overwrite, and remove before a key leaves the table for any reason.
+class EvictionPolicy {
+public:
+    virtual ~EvictionPolicy() {}
+    
+    virtual void insert(HashNode* node) = 0;
+    virtual void access(HashNode* node) = 0;
+    virtual void remove(HashNode* node) = 0;    // no-op if the node is not tracked
+    
+    // The key to evict next, never keep; null if there is none. The policy
+    // keeps tracking it until Cache calls remove.
+    virtual HashNode* victim(const HashNode* keep) = 0;
+    virtual void clear() = 0;
+    
+    virtual size_t size() const = 0;
+    virtual size_t memoryUsage() const { return 0; }   // bytes held outside the entries
+    virtual const char* name() const = 0;
+};
+
+// Policies that sweep or sample the table keep a reference to it; capacity
+// sizes the policies' own structures
+EvictionPolicy* createEvictionPolicy(EvictionType type, HashTable& table, size_t capacity);
+bool parseEvictionType(const string& name, EvictionType& type);    // case-insensitive
+const vector<EvictionType>& allEvictionTypes();
+
+#endif
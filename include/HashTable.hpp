@@ -1,46 +1,152 @@
 #ifndef HASHTABLE_HPP
 #define HASHTABLE_HPP
 
+#include "Value.hpp"
+#include "SlabAllocator.hpp"
 #include <string>
+#include <string_view>
 #include <vector>
-#include <list>
+#include <cstdint>
 
 using namespace std;
 
+// The single record for a key. The table owns it; the eviction policy and
+// TTLManager link it intrusively instead of keeping their own copies of the
+// key. The key's bytes follow the node in the same slab chunk.
 struct HashNode {
-    string key;
-    string value;
-    long long expiryTime;
-    
-    HashNode(const string& k, const string& v, long long exp = -1) 
-        : key(k), value(v), expiryTime(exp) {}
+    ValueRef value;     // shared with readers that still hold it
+    long long expiryTime;   // Utils::monotonicMillis, -1 for none
+    size_t hash;        // cached so rehashing never touches the key
+    HashNode* lruPrev;  // owned by list-based eviction policies, null while unlinked
+    HashNode* lruNext;
+    size_t ttlIndex;    // bucket and position in TTLManager's wheel
+    uint32_t keyLength;
+    uint32_t evictionState; // owned by the eviction policy: reference bit, stamp, ...
+
+    static const size_t NOT_SCHEDULED = static_cast<size_t>(-1);
+
+    // Nodes with a key are made by HashTable; a bare node (empty key) is
+    // enough for list sentinels
+    HashNode(size_t h = 0, uint32_t keyLen = 0)
+        : expiryTime(-1), hash(h), lruPrev(nullptr), lruNext(nullptr),
+          ttlIndex(NOT_SCHEDULED), keyLength(keyLen), evictionState(0) {}
+
+    string_view key() const { return string_view(reinterpret_cast<const char*>(this + 1), keyLength); }
+    size_t allocSize() const { return sizeof(HashNode) + keyLength; }
+};
+
+// Table growth events. Only starting one stalls an operation (allocating
+// the new table, finishing a previous migration); the migration itself is
+// spread over later operations. reserve counts too, moving every node.
+struct ResizeStats {
+    long long resizes = 0;
+    long long lastMicros = 0;
+    long long maxMicros = 0;
+    long long totalMicros = 0;
 };
 
+// Open-addressing hash table in the style of Swiss tables. Every slot has a
+// control byte (empty, deleted, or 0x80 | 7 bits of the hash); lookups scan
+// a group of 16 control bytes at once with SSE2 and only dereference slots
+// whose control byte matches. Slots hold node pointers, so growing the table
+// moves pointers instead of copying keys and values. Nodes and values are
+// carved from the table's own SlabAllocator.
+//
+// Growing is incremental: when the load factor is exceeded a table of twice
+// the size is allocated and every subsequent mutation migrates a few groups
+// from the old table, so no single operation pays for the whole rehash.
 class HashTable {
 private:
-    vector<list<HashNode>> table;
-    size_t tableSize;
+    struct Table {
+        uint8_t* ctrl;
+        HashNode** slots;
+        size_t capacity;    // number of slots, a power of two >= GROUP_WIDTH
+        size_t used;        // full slots
+        size_t deleted;     // tombstones
+
+        Table() : ctrl(nullptr), slots(nullptr), capacity(0), used(0), deleted(0) {}
+        size_t numGroups() const { return capacity / GROUP_WIDTH; }
+    };
+
+    SlabAllocator slabs;    // declared first: outlives every node and value
+    Table table;        // receives every insert
+    Table oldTable;     // drained into table while rehashing
+    size_t rehashIndex; // next group of oldTable to migrate
     size_t numElements;
+    ResizeStats resizeStats;
+
+    static const size_t GROUP_WIDTH = 16;
     static const size_t INITIAL_SIZE = 16;
+    static const size_t REHASH_GROUPS_PER_STEP = 4;
     static const double LOAD_FACTOR_THRESHOLD;
-    
-    size_t hash(const string& key) const;
-    void resize();
-    
+
+    static void allocTable(Table& t, size_t capacity);
+    static void freeTable(Table& t);
+    static HashNode** findSlot(const Table& t, string_view key, size_t h);
+    static void placeNode(Table& t, HashNode* node);
+    static void eraseSlot(Table& t, HashNode** slot);
+
+    HashNode** lookup(string_view key, size_t h) const;
+    HashNode** lookupOwner(string_view key, size_t h, Table*& owner);
+    const HashNode* findLive(const string& key) const;
+    HashNode* createNode(string_view key, size_t h);
+    void destroyNode(HashNode* node);
+    void startRehash();
+    void rehashStep(size_t groups);
+    void recordResize(long long startNanos);
+    void deleteAllNodes();
+
 public:
     HashTable();
     ~HashTable();
-    
+    HashTable(const HashTable&) = delete;
+    HashTable& operator=(const HashTable&) = delete;
+
     bool insert(const string& key, const string& value, long long expiryTime = -1);
+    bool insert(const string& key, string&& value, long long expiryTime = -1);
     bool get(const string& key, string& value) const;
+    bool get(const string& key, ValueRef& value) const;   // no copy of the bytes
     bool remove(const string& key);
     bool exists(const string& key) const;
     bool updateExpiry(const string& key, long long expiryTime);
     void clear();
+
+    // Node-level access for Cache; find ignores expiry
+    HashNode* find(string_view key) const { return find(key, hashKey(key)); }
+    HashNode* find(string_view key, size_t h) const;
+    HashNode* upsert(string_view key, bool& created) { return upsert(key, hashKey(key), created); }
+    HashNode* upsert(string_view key, size_t h, bool& created);
+    void erase(HashNode* node);
+    
+    // Bulk loading: reserve sizes the table for count keys in one step
+    // rather than through repeated doubling, and insertUnique adds a key the
+    // caller knows is not present, skipping the lookup
+    void reserve(size_t count);
+    HashNode* insertUnique(string_view key, size_t h);
     
+    // Batch helpers: hash keys up front, then prefetch the probe group of a
+    // key a few iterations before looking it up
+    static size_t hashKey(string_view key);
+    void prefetch(size_t h) const;
+
     size_t size() const { return numElements; }
+    size_t capacity() const { return table.capacity; }
+    bool isRehashing() const { return oldTable.ctrl != nullptr; }
+    const ResizeStats& getResizeStats() const { return resizeStats; }
+    void resetResizeStats() { resizeStats = ResizeStats(); }
+    size_t memoryUsage() const;
+    SlabAllocator& allocator() { return slabs; }
+    
+    // Slot-order access for eviction policies that sweep or sample the
+    // table instead of keeping a list. Positions span both tables while
+    // rehashing and shift when the table grows; empty slots give null.
+    size_t slotCount() const { return table.capacity + oldTable.capacity; }
+    HashNode* slotNode(size_t position) const {
+        return position < table.capacity ? table.slots[position] : oldTable.slots[position - table.capacity];
+    }
+    const SlabAllocator& allocator() const { return slabs; }
     vector<string> getAllKeys() const;
     vector<string> getExpiredKeys(long long currentTime) const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,111 @@
+#ifndef HASHVALUE_HPP
+#define HASHVALUE_HPP
+
+#include "Value.hpp"
+#include "SlabAllocator.hpp"
+#include "Listpack.hpp"
+#include "RecordIndex.hpp"
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+using namespace std;
+
+// A hash of fields to values, the value of HSET and friends.
+//
+// Small hashes are a listpack: one buffer holding field, value, field,
+// value, ... back to back, each string behind a varint length, scanned in
+// insertion order. A field or value longer than MAX_LISTPACK_VALUE bytes,
+// or more than MAX_LISTPACK_ENTRIES fields, converts it once and for good
+// to a table: a RecordIndex over field records, each record one slab chunk
+// holding its field and value. Everything comes from the owning table's
+// SlabAllocator, so the cache's memory limit covers hashes like any other
+// value.
+//
+// The listpack layout is also the serialized form, whatever the encoding:
+// a snapshot of a small hash is a copy of its buffer.
+class HashValue : public CompoundValue {
+public:
+    static const ValueType TYPE = ValueType::HASH;
+    static const size_t MAX_LISTPACK_ENTRIES = 128;
+    static const size_t MAX_LISTPACK_VALUE = 64;
+
+private:
+    struct Field {
+        uint32_t hash;
+        uint32_t fieldLength;
+        uint32_t valueLength;
+
+        const char* bytes() const { return reinterpret_cast<const char*>(this + 1); }
+        char* bytes() { return reinterpret_cast<char*>(this + 1); }
+        string_view key() const { return string_view(bytes(), fieldLength); }
+        string_view value() const { return string_view(bytes() + fieldLength, valueLength); }
+        size_t allocSize() const { return sizeof(Field) + fieldLength + valueLength; }
+    };
+
+    SlabAllocator* slabs;
+    char* pack;             // listpack encoding, null while empty
+    RecordIndex<Field> fields;
+    bool table;             // encoded as fields rather than pack
+    uint32_t count;         // listpack fields
+    uint32_t packBytes;
+    uint32_t packCapacity;
+    size_t heapBytes;       // slab chunks held but the index's, see memoryUsage
+
+    // Listpack: where the entry for field starts, or packBytes
+    size_t packFind(string_view field, string_view* value = nullptr) const;
+    void packReserve(size_t bytes);
+    void packSet(size_t entry, string_view field, string_view value);
+    void packRemove(size_t entry);
+    void convertToTable(size_t fieldCount);
+
+    // Table
+    Field* newField(uint32_t h, string_view field, string_view value);
+    void freeField(Field* record);
+    bool tableSet(string_view field, string_view value);
+
+public:
+    explicit HashValue(SlabAllocator* owner);
+    // Rebuilds a hash from serialize's output, which isValid must accept
+    HashValue(SlabAllocator* owner, string_view serialized);
+    ~HashValue() override;
+    HashValue(const HashValue&) = delete;
+    HashValue& operator=(const HashValue&) = delete;
+
+    ValueType type() const override { return ValueType::HASH; }
+    size_t objectSize() const override { return sizeof(HashValue); }
+    size_t memoryUsage() const override { return heapBytes + fields.memoryUsage(slabs); }
+    const char* encoding() const override { return table ? "hashtable" : "listpack"; }
+
+    size_t size() const { return table ? fields.size() : count; }
+    // The view stays valid until the hash is next changed
+    bool get(string_view field, string_view& value) const;
+    bool exists(string_view field) const;
+    // True if field is new
+    bool set(string_view field, string_view value);
+    bool remove(string_view field);
+
+    // Calls visit(field, value) for every field: in insertion order for a
+    // listpack, table order otherwise
+    template <typename Visit>
+    void forEach(Visit&& visit) const {
+        if (!table) {
+            const char* pos = pack;
+            const char* end = pack + packBytes;
+            while (pos < end) {
+                string_view field, value;
+                pos = Listpack::readString(pos, end, field);
+                pos = Listpack::readString(pos, end, value);
+                visit(field, value);
+            }
+        } else {
+            fields.forEach([&](const Field* record) { visit(record->key(), record->value()); });
+        }
+    }
+
+    // Appends the listpack form of every field to out
+    void serialize(string& out) const override;
+    static bool isValid(string_view serialized);
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef LFUPOLICY_HPP
+#define LFUPOLICY_HPP
+
+#include "ApproximateLRU.hpp"
+#include <cstdint>
+
+using namespace std;
+
+// Approximated LFU in the style of Redis. Each entry keeps an 8-bit
+// logarithmic access counter and the decay period it was last touched in,
+// packed into evictionState; a counter loses one for every period the key
+// goes untouched, so keys that were hot long ago age out. Eviction samples
+// a few entries and takes the one with the lowest decayed count.
+//
+// Periods are counted in inserts rather than wall time, so replaying a
+// trace gives the same result however fast it runs.
+class LFUPolicy : public EvictionPolicy {
+private:
+    SlotSampler sampler;
+    size_t samples;
+    size_t decayInserts;
+    uint64_t inserts;
+    size_t count;
+    
+    uint32_t period() const { return static_cast<uint32_t>(inserts / decayInserts) & 0xFFFF; }
+    uint8_t decayedCount(const HashNode* node) const;
+    void store(HashNode* node, uint8_t counter) const { node->evictionState = (period() << 8) | counter; }
+    uint8_t logIncrement(uint8_t counter);
+    
+public:
+    static const size_t DEFAULT_SAMPLES = 5;
+    static const size_t DEFAULT_DECAY_INSERTS = 1024;
+    static const uint8_t INITIAL_COUNT = 5;    // so new keys outlive keys gone cold
+    static const unsigned LOG_FACTOR = 10;      // ~1M hits to saturate
+    
+    explicit LFUPolicy(HashTable& t, size_t sampleCount = DEFAULT_SAMPLES,
+                       size_t decayPeriod = DEFAULT_DECAY_INSERTS)
+        : sampler(t), samples(sampleCount), decayInserts(decayPeriod > 0 ? decayPeriod : 1),
+          inserts(0), count(0) {}
+    
+    void insert(HashNode* node) override;
+    void access(HashNode* node) override { store(node, logIncrement(decayedCount(node))); }
+    void remove(HashNode*) override { count--; }
+    HashNode* victim(const HashNode* keep) override;
+    void clear() override { count = 0; }
+    
+    size_t size() const override { return count; }
+    const char* name() const override { return "lfu"; }
+    
+    uint8_t frequency(const HashNode* node) const { return decayedCount(node); }
+};
+
+#endif
@@ -1,44 +1,43 @@
 #ifndef LRUCACHE_HPP
 #define LRUCACHE_HPP
 
-#include <string>
-#include <unordered_map>
+#include "EvictionPolicy.hpp"
 
 using namespace std;
 
-struct LRUNode {
-    string key;
-    LRUNode* prev;
-    LRUNode* next;
-    
-    LRUNode(const string& k) : key(k), prev(nullptr), next(nullptr) {}
-};
-
-class LRUCache {
+// Recency list threaded through the entries themselves (HashNode::lruPrev /
+// lruNext), so touching a key is a pointer splice with no lookup of its own.
+// The list never owns or frees nodes; the hash table does.
+class LRUCache : public EvictionPolicy {
 private:
-    unordered_map<string, LRUNode*> keyToNode;
-    LRUNode* head;
-    LRUNode* tail;
+    HashNode head;  // sentinels
+    HashNode tail;
     size_t capacity;
     size_t currentSize;
     
-    void addToHead(LRUNode* node);
-    void removeNode(LRUNode* node);
-    void moveToHead(LRUNode* node);
-    LRUNode* removeTail();
+    void addToHead(HashNode* node);
+    void removeNode(HashNode* node);
+    void moveToHead(HashNode* node);
+    HashNode* removeTail();
     
 public:
     LRUCache(size_t cap);
     ~LRUCache();
+    LRUCache(const LRUCache&) = delete;
+    LRUCache& operator=(const LRUCache&) = delete;
     
-    void access(const string& key);
-    string evictLRU();
-    void remove(const string& key);
-    void clear();
+    void insert(HashNode* node) override { access(node); }
+    void access(HashNode* node) override;       // link a new node or move it to the front
+    HashNode* evictLRU();                       // unlink and return the least recent node
+    HashNode* leastRecent() const { return currentSize > 0 ? tail.lruPrev : nullptr; }
+    HashNode* victim(const HashNode* keep) override;
+    void remove(HashNode* node) override;       // no-op if the node is not linked
+    void clear() override;
     
-    size_t size() const { return currentSize; }
+    size_t size() const override { return currentSize; }
+    const char* name() const override { return "lru"; }
     bool isFull() const { return currentSize >= capacity; }
     void setCapacity(size_t cap) { capacity = cap; }
 };
 
-#endif
\ No newline at end of file
+#endif
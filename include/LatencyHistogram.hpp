@@ -0,0 +1,55 @@
+#ifndef LATENCYHISTOGRAM_HPP
+#define LATENCYHISTOGRAM_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// HDR-style histogram of latencies in nanoseconds. Values below 32 get a
+// bucket each; above that, every power of two is split into 32 linear
+// sub-buckets, so a reported percentile is within about 3% of the true
+// value. Values of 2^37 ns (about two minutes) and more share the last
+// bucket, which keeps the whole histogram in a fixed 8 KB array: recording
+// is an index computation and an increment, with no allocation.
+class LatencyHistogram {
+private:
+    static const int SUB_BUCKET_BITS = 5;
+    static const uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 36;
+    // The linear range, then SUB_BUCKETS per exponent up to MAX_EXPONENT
+    static const size_t NUM_BUCKETS = SUB_BUCKETS * (MAX_EXPONENT - SUB_BUCKET_BITS + 2);
+
+    uint64_t counts[NUM_BUCKETS];
+    uint64_t total;
+    uint64_t sum;
+    uint64_t minValue;
+    uint64_t maxValue;
+
+    static size_t bucketOf(uint64_t value);
+    static uint64_t highestValueIn(size_t bucket);
+
+public:
+    LatencyHistogram() { reset(); }
+
+    // count samples of value nanoseconds
+    void record(uint64_t value, uint64_t count = 1) {
+        counts[bucketOf(value)] += count;
+        total += count;
+        sum += value * count;
+        if (value < minValue) minValue = value;
+        if (value > maxValue) maxValue = value;
+    }
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? minValue : 0; }
+    uint64_t max() const { return maxValue; }
+    double mean() const { return total ? double(sum) / total : 0; }
+    // Smallest bucket bound at or below which percentile% of samples fall,
+    // e.g. percentile(99.9); 0 when empty
+    uint64_t percentile(double percentile) const;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef LISTVALUE_HPP
+#define LISTVALUE_HPP
+
+#include "Value.hpp"
+#include "SlabAllocator.hpp"
+#include "Listpack.hpp"
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+using namespace std;
+
+// A list of strings, the value of LPUSH and friends: a quicklist, as in
+// Redis. Elements are packed into chunks of up to CHUNK_BYTES, each a
+// doubly-linked slab chunk holding a listpack of varint-length strings,
+// every one followed by its back length so a chunk can be popped from
+// either end. Pushes and pops touch only the end chunk, and an index skips
+// whole chunks by their counts, so per-element overhead is the two or
+// three length bytes rather than a node.
+//
+// An element larger than a chunk gets a chunk of its own. The serialized
+// form is the elements in order, each behind its varint length.
+class ListValue : public CompoundValue {
+public:
+    static const ValueType TYPE = ValueType::LIST;
+    // Redis's default list-max-listpack-size of -2
+    static const size_t CHUNK_BYTES = 8192;
+
+private:
+    // The listpack follows the header, capacity bytes of it
+    struct Chunk {
+        Chunk* prev;
+        Chunk* next;
+        uint32_t count;
+        uint32_t bytes;
+        uint32_t capacity;
+
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+        const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+    };
+
+    SlabAllocator* slabs;
+    Chunk* head;
+    Chunk* tail;
+    size_t count;
+    size_t chunks;
+    size_t heapBytes;       // slab chunks held, see memoryUsage
+
+    static size_t entryBytes(string_view value);
+    // Reads the entry at pos into value; returns where the next one starts
+    static const char* readEntry(const char* pos, string_view& value);
+    Chunk* newChunk(size_t bytes, Chunk* prev, Chunk* next);
+    Chunk* growChunk(Chunk* chunk, size_t bytes);
+    void freeChunk(Chunk* chunk);
+
+public:
+    explicit ListValue(SlabAllocator* owner);
+    // Rebuilds a list from serialize's output, which isValid must accept
+    ListValue(SlabAllocator* owner, string_view serialized);
+    ~ListValue() override;
+    ListValue(const ListValue&) = delete;
+    ListValue& operator=(const ListValue&) = delete;
+
+    ValueType type() const override { return ValueType::LIST; }
+    size_t objectSize() const override { return sizeof(ListValue); }
+    size_t memoryUsage() const override { return heapBytes; }
+    // One chunk reads as a listpack, as Redis reports small lists
+    const char* encoding() const override { return chunks > 1 ? "quicklist" : "listpack"; }
+
+    size_t size() const { return count; }
+    void push(string_view value, bool front);
+    // Takes the first (or last) element into value; false if empty
+    bool pop(bool front, string& value);
+
+    // Calls visit(element) for indexes start to stop, both included and
+    // already clamped to the list. Starts from whichever end is nearer.
+    template <typename Visit>
+    void forEachInRange(size_t start, size_t stop, Visit&& visit) const;
+    template <typename Visit>
+    void forEach(Visit&& visit) const { if (count) forEachInRange(0, count - 1, visit); }
+
+    void serialize(string& out) const override;
+    static bool isValid(string_view serialized);
+};
+
+template <typename Visit>
+void ListValue::forEachInRange(size_t start, size_t stop, Visit&& visit) const {
+    // Find the chunk holding start, counting from the nearer end
+    const Chunk* chunk;
+    size_t first;       // index of chunk's first element
+    if (start < count / 2) {
+        chunk = head;
+        first = 0;
+        while (start >= first + chunk->count) {
+            first += chunk->count;
+            chunk = chunk->next;
+        }
+    } else {
+        chunk = tail;
+        first = count - tail->count;
+        while (start < first) {
+            chunk = chunk->prev;
+            first -= chunk->count;
+        }
+    }
+
+    size_t index = first;
+    for (; chunk && index <= stop; chunk = chunk->next) {
+        const char* pos = chunk->data();
+        for (uint32_t i = 0; i < chunk->count && index <= stop; i++, index++) {
+            string_view value;
+            pos = readEntry(pos, value);
+            if (index >= start) {
+                visit(value);
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef LISTPACK_HPP
+#define LISTPACK_HPP
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+// Helpers shared by the compact encodings of the compound values: strings
+// packed back to back in one buffer, each behind a varint length of 7 bits
+// a byte, low group first. Encodings walked from either end follow each
+// entry with its size again as a back length, read from its last byte.
+namespace Listpack {
+    inline size_t lengthBytes(size_t length) {
+        size_t bytes = 1;
+        while (length >= 0x80) {
+            length >>= 7;
+            bytes++;
+        }
+        return bytes;
+    }
+
+    inline char* writeLength(char* out, size_t length) {
+        while (length >= 0x80) {
+            *out++ = static_cast<char>(length | 0x80);
+            length >>= 7;
+        }
+        *out++ = static_cast<char>(length);
+        return out;
+    }
+
+    // Null if the length runs past end or does not fit 32 bits
+    inline const char* readLength(const char* pos, const char* end, size_t& length) {
+        length = 0;
+        for (int shift = 0; pos < end && shift < 35; shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(*pos++);
+            length |= static_cast<size_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return length <= UINT32_MAX ? pos : nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    // The back length: the same groups, low group last, so it can be read
+    // backwards from the end of an entry
+    inline char* writeBackLength(char* out, size_t length) {
+        size_t bytes = lengthBytes(length);
+        for (size_t i = 0; i < bytes; i++) {
+            out[bytes - 1 - i] = static_cast<char>((length & 0x7F) | (i + 1 < bytes ? 0x80 : 0));
+            length >>= 7;
+        }
+        return out + bytes;
+    }
+
+    // Reads the back length ending at end; returns where it starts
+    inline const char* readBackLength(const char* end, size_t& length) {
+        length = 0;
+        int shift = 0;
+        uint8_t byte;
+        do {
+            byte = static_cast<uint8_t>(*--end);
+            length |= static_cast<size_t>(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        return end;
+    }
+
+    // A string with its length in front
+    inline size_t entryBytes(string_view str) { return lengthBytes(str.size()) + str.size(); }
+
+    inline char* writeString(char* out, string_view str) {
+        out = writeLength(out, str.size());
+        memcpy(out, str.data(), str.size());
+        return out + str.size();
+    }
+
+    // Reads the string at pos into str; null if it is cut off
+    inline const char* readString(const char* pos, const char* end, string_view& str) {
+        size_t length;
+        pos = readLength(pos, end, length);
+        if (!pos || static_cast<size_t>(end - pos) < length) {
+            return nullptr;
+        }
+        str = string_view(pos, length);
+        return pos + length;
+    }
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef RESP_HPP
+#define RESP_HPP
+
+#include "ReplyWriter.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Incremental parser for RESP2 requests: multi-bulk arrays from real clients
+// ("*2\r\n$3\r\nGET\r\n$3\r\nkey\r\n") and space-separated inline commands
+// as typed into telnet or netcat.
+//
+// Arguments are string_views into the buffer, so parsing copies and
+// allocates nothing once argv has grown; they stay valid until the buffer
+// is next modified. Multi-bulk arguments are binary safe. Inline arguments
+// may be quoted like redis-cli's ("a b", 'it''s', "\x00\n"), unescaped in
+// place over their own bytes, which is why the buffer is not const.
+class RESPParser {
+public:
+    enum Result { OK, INCOMPLETE, PROTOCOL_ERROR };
+    
+    static const size_t MAX_INLINE_LENGTH = 64 * 1024;
+    static const long long MAX_BULK_LENGTH = 512LL * 1024 * 1024;
+    static const long long MAX_MULTIBULK_LENGTH = 1024 * 1024;
+    
+    // Parses the command starting at pos. On OK, argv holds its arguments
+    // (empty for a blank inline line) and pos points past it. On INCOMPLETE
+    // nothing is consumed; on PROTOCOL_ERROR, error describes the problem.
+    static Result parseCommand(string& buffer, size_t& pos, vector<string_view>& argv, string& error);
+    
+    // Splits one inline line of length bytes, unescaping quoted arguments in
+    // place. False on unbalanced quotes or a closing quote not followed by a
+    // space.
+    static bool splitInline(char* line, size_t length, vector<string_view>& argv);
+    
+private:
+    static Result parseInline(string& buffer, size_t& pos, vector<string_view>& argv, string& error);
+    static Result parseMultiBulk(const string& buffer, size_t& pos, vector<string_view>& argv, string& error);
+    static bool parseLength(const string& buffer, size_t start, size_t end, long long& value);
+};
+
+// A value referenced by an output buffer instead of copied into it. Its
+// bytes belong at offset in the buffer and are sent straight from the
+// stored string, which the reference keeps alive until then.
+struct PinnedValue {
+    size_t offset;
+    ValueRef value;
+};
+
+// Encodes replies as RESP2 into a caller-owned output buffer. Given a pinned
+// list, stored values of at least ZERO_COPY_MIN_BYTES are appended to it
+// rather than copied; smaller ones are cheaper to copy than to send apart.
+class RESPWriter : public ReplyWriter {
+private:
+    string& out;
+    vector<PinnedValue>* pinned;
+    
+public:
+    static const size_t ZERO_COPY_MIN_BYTES = 4 * 1024;
+    
+    RESPWriter(string& buffer, vector<PinnedValue>* pinnedValues = nullptr)
+        : out(buffer), pinned(pinnedValues) {}
+    
+    void status(const string& message) override;
+    void error(const string& message) override;
+    void integer(long long value) override;
+    void bulk(const string& value) override;
+    void bulk(const ValueRef& value) override;
+    void nil() override;
+    void arrayHeader(size_t count) override;
+    void text(const string& value) override;
+};
+
+#endif
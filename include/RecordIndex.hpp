@@ -0,0 +1,147 @@
+#ifndef RECORDINDEX_HPP
+#define RECORDINDEX_HPP
+
+#include "SlabAllocator.hpp"
+#include <string_view>
+#include <functional>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+// Open-addressing index of records by key, the table encoding of the
+// compound values: a power-of-two array of pointers, probed linearly and
+// kept at most 3/4 full. Removal shifts the rest of a probe chain back, so
+// there are no tombstones and lookups never slow down with churn.
+//
+// A Record has a uint32_t hash (of its key, from hashKey) and a key()
+// returning a string_view. Records belong to the caller; the index only
+// holds pointers, and its slot array comes from the caller's SlabAllocator,
+// passed to every call that allocates so the index stays one pointer and
+// two counts.
+template <typename Record>
+class RecordIndex {
+private:
+    Record** slots;
+    uint32_t capacity;      // a power of two, or 0 while empty
+    uint32_t count;
+
+    static const size_t MIN_SIZE = 16;
+
+    void place(Record* record) {
+        size_t mask = capacity - 1;
+        size_t i = record->hash & mask;
+        while (slots[i]) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = record;
+    }
+
+    void resize(SlabAllocator* slabs, size_t newCapacity) {
+        Record** old = slots;
+        size_t oldCapacity = capacity;
+        slots = static_cast<Record**>(slabs->allocate(newCapacity * sizeof(Record*)));
+        memset(slots, 0, newCapacity * sizeof(Record*));
+        capacity = static_cast<uint32_t>(newCapacity);
+        if (old) {
+            for (size_t i = 0; i < oldCapacity; i++) {
+                if (old[i]) place(old[i]);
+            }
+            slabs->deallocate(old, oldCapacity * sizeof(Record*));
+        }
+    }
+
+public:
+    RecordIndex() : slots(nullptr), capacity(0), count(0) {}
+    RecordIndex(const RecordIndex&) = delete;
+    RecordIndex& operator=(const RecordIndex&) = delete;
+
+    static uint32_t hashKey(string_view key) {
+        std::hash<string_view> hasher;
+        return static_cast<uint32_t>(hasher(key));
+    }
+
+    // Frees the slot array, not the records
+    void release(SlabAllocator* slabs) {
+        if (slots) {
+            slabs->deallocate(slots, capacity * sizeof(Record*));
+        }
+        slots = nullptr;
+        capacity = 0;
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    size_t memoryUsage(const SlabAllocator* slabs) const {
+        return slots ? slabs->chunkSize(capacity * sizeof(Record*)) : 0;
+    }
+
+    // Room for records in all without growing
+    void reserve(SlabAllocator* slabs, size_t records) {
+        size_t newCapacity = capacity ? capacity : MIN_SIZE;
+        while (records * 4 > newCapacity * 3) newCapacity *= 2;
+        if (newCapacity != capacity) {
+            resize(slabs, newCapacity);
+        }
+    }
+
+    // The slot holding the record for key, null if there is none. The
+    // caller may store another record with the same key and hash there.
+    Record** findSlot(string_view key, uint32_t h) const {
+        if (!slots) {
+            return nullptr;
+        }
+        size_t mask = capacity - 1;
+        for (size_t i = h & mask; slots[i]; i = (i + 1) & mask) {
+            if (slots[i]->hash == h && slots[i]->key() == key) {
+                return &slots[i];
+            }
+        }
+        return nullptr;
+    }
+
+    Record* find(string_view key, uint32_t h) const {
+        Record** slot = findSlot(key, h);
+        return slot ? *slot : nullptr;
+    }
+
+    // Adds a record whose key is not in the index yet
+    void insert(SlabAllocator* slabs, Record* record) {
+        reserve(slabs, count + 1);
+        place(record);
+        count++;
+    }
+
+    // Takes the record for key out of the index and returns it, or null
+    Record* remove(string_view key, uint32_t h) {
+        Record** slot = findSlot(key, h);
+        if (!slot) {
+            return nullptr;
+        }
+        Record* record = *slot;
+        size_t mask = capacity - 1;
+        size_t hole = slot - slots;
+        slots[hole] = nullptr;
+        // Records after the hole move back unless their home slot lies after it
+        for (size_t i = (hole + 1) & mask; slots[i]; i = (i + 1) & mask) {
+            size_t home = slots[i]->hash & mask;
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                slots[hole] = slots[i];
+                slots[i] = nullptr;
+                hole = i;
+            }
+        }
+        count--;
+        return record;
+    }
+
+    // Calls visit(record) for every record, in slot order
+    template <typename Visit>
+    void forEach(Visit&& visit) const {
+        for (size_t i = 0; i < capacity; i++) {
+            if (slots[i]) visit(slots[i]);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef REPLYWRITER_HPP
+#define REPLYWRITER_HPP
+
+#include "Value.hpp"
+#include <string>
+
+using namespace std;
+
+// Sink for command replies. CommandProcessor only speaks in these types;
+// the CLI renders them like redis-cli and the server encodes them as RESP.
+class ReplyWriter {
+public:
+    virtual ~ReplyWriter() {}
+    
+    virtual void status(const string& message) = 0;     // +OK
+    virtual void error(const string& message) = 0;      // -ERR ...
+    virtual void integer(long long value) = 0;          // :1
+    virtual void bulk(const string& value) = 0;         // $5 hello
+    virtual void nil() = 0;                             // $-1
+    virtual void arrayHeader(size_t count) = 0;         // *N, followed by N replies
+    virtual void text(const string& value) = 0;         // human-readable multi-line text
+    
+    // A stored value; writers that can reference it instead of copying it
+    // override this
+    virtual void bulk(const ValueRef& value) { bulk(value.str()); }
+};
+
+#endif
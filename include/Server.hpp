@@ -0,0 +1,89 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "Cache.hpp"
+#include "CommandProcessor.hpp"
+#include "RESP.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+
+using namespace std;
+
+// Single-threaded RESP2 server on a non-blocking epoll event loop. Every
+// client shares the one Cache, so no locking is needed. Given an
+// AppendOnlyFile, writes are logged and committed once per loop iteration,
+// before that iteration's replies go out. Given a SnapshotManager, the cron
+// reaps its background saves.
+class Server {
+private:
+    struct Connection {
+        int fd;
+        string readBuffer;
+        size_t readOffset;      // start of the first unparsed command
+        string writeBuffer;     // replies accumulated during this tick
+        size_t writeOffset;     // bytes of writeBuffer already sent
+        vector<PinnedValue> pinned; // large values spliced into writeBuffer, by offset
+        size_t pinnedIndex;     // first pinned value not fully sent
+        size_t pinnedOffset;    // bytes of that value already sent
+        bool closeAfterWrite;   // set by QUIT or a protocol error
+        bool wantWrite;         // EPOLLOUT is registered
+        bool pendingWrite;      // queued in pendingWrites
+        
+        Connection(int f)
+            : fd(f), readOffset(0), writeOffset(0), pinnedIndex(0), pinnedOffset(0),
+              closeAfterWrite(false), wantWrite(false), pendingWrite(false) {}
+        
+        bool hasOutput() const { return writeOffset < writeBuffer.size() || pinnedIndex < pinned.size(); }
+    };
+    
+    Cache& cache;
+    AppendOnlyFile* aof;
+    SnapshotManager* snapshots;
+    CommandProcessor processor;
+    int port;
+    int listenFd;
+    int epollFd;
+    atomic<bool> running;
+    unordered_map<int, Connection*> connections;
+    vector<Connection*> pendingWrites;  // connections with replies to send this tick
+    vector<string_view> argv;           // views into readBuffer, reused
+    
+    static const int MAX_EVENTS = 128;
+    static const size_t READ_CHUNK = 16 * 1024;
+    static const int MAX_IOVECS = 64;
+    
+    // Idle-time housekeeping: expire keys nobody touches, capped at a
+    // quarter of each interval
+    static const int CRON_INTERVAL_MS = 100;
+    static const size_t CRON_EXPIRE_KEY_LIMIT = 100000;
+    static const long long CRON_EXPIRE_BUDGET_US = 25000;
+    
+    void acceptClients();
+    void handleReadable(Connection* conn);
+    void processCommands(Connection* conn);
+    void handlePendingWrites();
+    bool flushWrites(Connection* conn);
+    static int buildIovecs(const Connection* conn, struct iovec* iov);
+    static void consumeOutput(Connection* conn, size_t bytes);
+    void finishIO(Connection* conn, bool ok);
+    void updateInterest(Connection* conn, bool wantWrite);
+    void closeConnection(Connection* conn);
+    void serverCron();
+    
+public:
+    Server(Cache& c, int listenPort, AppendOnlyFile* log = nullptr, SnapshotManager* dumps = nullptr);
+    ~Server();
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+    
+    void start();   // binds and listens; throws runtime_error on failure
+    void run();     // event loop, returns after stop()
+    void stop() { running = false; }
+    
+    int getPort() const { return port; }    // actual port, after start()
+    size_t getClientCount() const { return connections.size(); }
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef SETVALUE_HPP
+#define SETVALUE_HPP
+
+#include "Value.hpp"
+#include "SlabAllocator.hpp"
+#include "Listpack.hpp"
+#include "RecordIndex.hpp"
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+
+using namespace std;
+
+// A set of strings, the value of SADD and friends.
+//
+// A set whose members are all integers in canonical decimal is an intset,
+// as in Redis: one sorted array of 2, 4 or 8-byte integers, as wide as the
+// widest member needs, searched by bisection. Up to MAX_INTSET_ENTRIES of
+// them cost their integer's width and nothing else. A member that is not
+// such an integer, or one past the limit, converts the set for good to a
+// RecordIndex over member records, each one slab chunk.
+//
+// The serialized form is every member behind its varint length.
+class SetValue : public CompoundValue {
+public:
+    static const ValueType TYPE = ValueType::SET;
+    static const size_t MAX_INTSET_ENTRIES = 512;
+
+private:
+    struct Member {
+        uint32_t hash;
+        uint32_t length;
+
+        const char* bytes() const { return reinterpret_cast<const char*>(this + 1); }
+        char* bytes() { return reinterpret_cast<char*>(this + 1); }
+        string_view key() const { return string_view(bytes(), length); }
+        size_t allocSize() const { return sizeof(Member) + length; }
+    };
+
+    SlabAllocator* slabs;
+    char* ints;             // intset encoding, null while empty
+    RecordIndex<Member> members;
+    bool table;             // encoded as members rather than ints
+    uint8_t width;          // bytes per intset integer
+    uint32_t count;         // intset integers
+    uint32_t intsCapacity;  // bytes
+    size_t heapBytes;       // slab chunks held but the index's, see memoryUsage
+
+    // Intset
+    static bool asInteger(string_view member, long long& value);
+    static uint8_t widthOf(long long value);
+    static long long readInt(const char* at, uint8_t width);
+    static void writeInt(char* at, uint8_t width, long long value);
+    long long intAt(size_t i) const { return readInt(ints + i * width, width); }
+    bool intFind(long long value, size_t& position) const;
+    void intReserve(size_t entries, uint8_t newWidth);
+    void convertToTable(size_t memberCount);
+
+    // Table
+    Member* newMember(uint32_t h, string_view member);
+    void freeMember(Member* record);
+
+public:
+    explicit SetValue(SlabAllocator* owner);
+    // Rebuilds a set from serialize's output, which isValid must accept
+    SetValue(SlabAllocator* owner, string_view serialized);
+    ~SetValue() override;
+    SetValue(const SetValue&) = delete;
+    SetValue& operator=(const SetValue&) = delete;
+
+    ValueType type() const override { return ValueType::SET; }
+    size_t objectSize() const override { return sizeof(SetValue); }
+    size_t memoryUsage() const override { return heapBytes + members.memoryUsage(slabs); }
+    const char* encoding() const override { return table ? "hashtable" : "intset"; }
+
+    size_t size() const { return table ? members.size() : count; }
+    bool contains(string_view member) const;
+    // True if member is new
+    bool add(string_view member);
+    bool remove(string_view member);
+
+    // Calls visit(member) for every member: in numeric order for an
+    // intset, table order otherwise
+    template <typename Visit>
+    void forEach(Visit&& visit) const {
+        if (!table) {
+            char digits[24];
+            for (size_t i = 0; i < count; i++) {
+                char* end = to_chars(digits, digits + sizeof(digits), intAt(i)).ptr;
+                visit(string_view(digits, end - digits));
+            }
+        } else {
+            members.forEach([&](const Member* record) { visit(record->key()); });
+        }
+    }
+
+    void serialize(string& out) const override;
+    static bool isValid(string_view serialized);
+};
+
+#endif
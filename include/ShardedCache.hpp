@@ -0,0 +1,68 @@
+#ifndef SHARDEDCACHE_HPP
+#define SHARDEDCACHE_HPP
+
+#include "Cache.hpp"
+#include <string>
+#include <string_view>
+#include <functional>
+#include <mutex>
+
+using namespace std;
+
+// Thread-safe cache that partitions keys across independent Cache shards.
+// Each shard has its own table, eviction policy, TTL wheel and lock, so threads
+// working on different shards never contend. Memory and key limits are
+// split evenly between shards.
+class ShardedCache {
+private:
+    // Padded to a cache line so neighbouring shard locks do not false-share
+    struct alignas(64) Shard {
+        mutex lock;
+        Cache* cache;
+    };
+    
+    Shard* shards;
+    size_t numShards;
+    
+    Shard& shardFor(string_view key) const;
+    
+public:
+    ShardedCache(size_t shardCount = 16, size_t maxMem = 1024 * 1024 * 100, size_t maxKeysLimit = 10000,
+                 EvictionType evictionType = EvictionType::LRU);
+    ~ShardedCache();
+    ShardedCache(const ShardedCache&) = delete;
+    ShardedCache& operator=(const ShardedCache&) = delete;
+    
+    bool set(const string& key, const string& value, int ttlSeconds = -1);
+    bool set(const string& key, string&& value, int ttlSeconds = -1);
+    bool get(const string& key, string& value);
+    bool get(const string& key, ValueRef& value);     // stays valid after the lock is released
+    bool del(const string& key);
+    bool exists(const string& key);
+    bool expire(const string& key, int seconds);
+    bool psetex(const string& key, const string& value, long long ttlMs);
+    bool psetex(const string& key, string&& value, long long ttlMs);
+    bool pexpire(const string& key, long long ms);
+    long long pttl(const string& key);
+    long long ttl(const string& key);
+    void flush();
+    
+    // Bulk loading and walking, as for Cache. loadKey locks one shard per
+    // key, so several threads can load at once; reserve spreads count over
+    // the shards. Each part of forEachEntry walks its slot range of every
+    // shard in turn, under that shard's lock, starting at a different shard
+    // per part so concurrent walkers rarely wait on each other.
+    void reserve(size_t count);
+    void loadKey(string_view key, string_view value, long long ttlMs, ValueType type = ValueType::STRING);
+    void forEachEntry(const function<void(string_view key, const ValueRef& value, long long ttlMs)>& visit,
+                      size_t part = 0, size_t parts = 1) const;
+    
+    // Status and metrics, aggregated over all shards
+    void showStats() const;
+    CacheStats getStats() const;
+    void resetStats();
+    size_t getKeyCount() const;
+    size_t getShardCount() const { return numShards; }
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef SLABALLOCATOR_HPP
+#define SLABALLOCATOR_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// Per-size-class counters, as reported by STATS SLABS
+struct SlabClassStats {
+    size_t chunkSize = 0;
+    size_t pages = 0;
+    size_t totalChunks = 0;     // carved from pages so far
+    size_t usedChunks = 0;
+    size_t requestedBytes = 0;  // sum of the sizes asked for by used chunks
+};
+
+// Size-class slab allocator in the style of memcached. Memory is taken from
+// the system in 1 MB pages, each dedicated to one size class and carved
+// into equal chunks; freed chunks go onto their class's free list, so an
+// allocation is normally a free-list pop. Chunk sizes grow by 1.25x from
+// 32 bytes, which bounds internal waste to about 20% and makes the bytes a
+// key costs known exactly. Pages are kept for reuse rather than returned.
+//
+// Requests over MAX_CHUNK_SIZE fall through to malloc and are counted as
+// large allocations.
+//
+// The allocator belongs to one thread (or one lock holder), except that
+// deallocateShared may be called from any thread: those chunks go onto a
+// lock-free per-class list that the owner drains when its free list runs
+// dry. Stored values use it, since a reader may drop the last reference to
+// a value after releasing the shard lock.
+class SlabAllocator {
+private:
+    // A freed chunk doubles as its list node. Shared frees also record the
+    // size that was asked for, so the owner can settle its counters.
+    struct FreeChunk {
+        FreeChunk* next;
+        size_t bytes;
+    };
+
+    struct SlabClass {
+        size_t chunkSize;
+        FreeChunk* freeList;
+        char* carveNext;        // unused tail of the newest page
+        char* carveEnd;
+        size_t pages;
+        size_t totalChunks;
+        size_t usedChunks;
+        size_t requestedBytes;
+
+        // Chunks released by deallocateShared, not yet drained
+        atomic<FreeChunk*> sharedFree;
+        atomic<size_t> sharedFreeChunks;
+        atomic<size_t> sharedFreeBytes;
+    };
+
+    SlabClass* classes;
+    size_t numClasses;
+    vector<char*> pages;
+    size_t chunkBytes;                  // chunks handed out, pending shared frees included
+    atomic<size_t> sharedFreeTotal;     // chunk bytes of those pending shared frees
+    atomic<size_t> largeBytes;
+    atomic<size_t> largeAllocs;
+    atomic<size_t> externalBytes;
+
+    // Class index for every size up to SMALL_LOOKUP_LIMIT, in 8-byte steps
+    static const size_t SMALL_LOOKUP_LIMIT = 2048;
+    uint8_t smallClass[SMALL_LOOKUP_LIMIT / 8 + 1];
+
+    size_t classFor(size_t bytes) const;
+    void* refill(SlabClass& slab);
+
+public:
+    static const size_t PAGE_SIZE = 1024 * 1024;
+    static const size_t MIN_CHUNK_SIZE = 32;
+    static const size_t MAX_CHUNK_SIZE = PAGE_SIZE / 2;
+    static const size_t CHUNK_ALIGN = 8;
+    static const double GROWTH_FACTOR;
+
+    SlabAllocator();
+    ~SlabAllocator();
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    void* allocate(size_t bytes);
+    void deallocate(void* ptr, size_t bytes);           // owner only
+    void deallocateShared(void* ptr, size_t bytes);     // any thread
+
+    // Bytes actually reserved for an allocation of this size
+    size_t chunkSize(size_t bytes) const;
+
+    // Buffers allocated elsewhere but owned by this allocator's user (adopted
+    // strings), counted so that usage covers them too. Any thread.
+    void addExternal(size_t bytes) { externalBytes.fetch_add(bytes, memory_order_relaxed); }
+    void removeExternal(size_t bytes) { externalBytes.fetch_sub(bytes, memory_order_relaxed); }
+
+    size_t pageBytes() const { return pages.size() * PAGE_SIZE; }
+    // Chunks in use plus large allocations, in O(1) so it can gate every write
+    size_t usedBytes() const {
+        return chunkBytes - sharedFreeTotal.load(memory_order_relaxed) + largeBytes.load(memory_order_relaxed);
+    }
+    size_t requestedBytes() const;  // sum of the sizes asked for by chunks in use
+    size_t getLargeBytes() const { return largeBytes.load(memory_order_relaxed); }
+    size_t getLargeAllocs() const { return largeAllocs.load(memory_order_relaxed); }
+    size_t getExternalBytes() const { return externalBytes.load(memory_order_relaxed); }
+    vector<SlabClassStats> classStats() const;  // classes that own at least one page
+};
+
+#endif
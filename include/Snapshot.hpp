@@ -0,0 +1,132 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <sys/types.h>
+
+using namespace std;
+
+class Cache;
+class ShardedCache;
+
+// Streaming 64-bit checksum over snapshot entries: four independent
+// multiply-rotate lanes over 32-byte stripes (the xxHash64 round), so it
+// runs at memory speed instead of a byte at a time
+class SnapshotChecksum {
+private:
+    uint64_t lanes[4];
+    char pending[32];
+    size_t pendingBytes;
+    uint64_t totalBytes;
+
+    void stripe(const char* data);
+
+public:
+    SnapshotChecksum();
+    void update(const char* data, size_t size);
+    uint64_t digest() const;
+};
+
+// Point-in-time dump of a Cache, written by SAVE and BGSAVE.
+//
+// Layout, in host byte order:
+//   header   magic "MREDISDB", uint32 version, uint32 flags,
+//            uint64 entry count, int64 creation time (unix ms)
+//   entries  uint8 value type (from version 2), uint32 key length,
+//            uint32 value length, int64 expiry (unix ms, -1 for none),
+//            key bytes, value bytes
+//   footer   uint64 checksum of the entry bytes (0 without FLAG_CHECKSUM),
+//            end magic "MRDB_EOF"
+//
+// Values other than strings are stored in their serialized form, see
+// HashValue::serialize. Version 1 files, which hold only strings, still
+// load.
+//
+// Expiry times are absolute, so keys keep expiring while the server is
+// down and those already expired are skipped on load.
+//
+// A snapshot saved in segments is split by slot range of the hash table,
+// one file and one writer thread per range. Each segment is a complete file
+// as above, named PATH.GENERATION.INDEX; PATH itself is then a manifest
+// with FLAG_SEGMENTED set, the total entry count, the generation in place
+// of the creation time, and a body of uint64 segment count followed by each
+// segment's entry count.
+namespace Snapshot {
+    const uint32_t VERSION = 2;
+    const uint32_t FLAG_CHECKSUM = 1;
+    const uint32_t FLAG_SEGMENTED = 2;
+
+    // Writes cache to a temporary file next to path, syncs it and renames it
+    // over path; with segments > 1, writes that many segment files in
+    // parallel first. Throws runtime_error on failure, leaving the previous
+    // snapshot untouched. Returns the bytes written.
+    size_t save(const Cache& cache, const string& path, bool checksum = true, size_t segments = 1);
+    size_t save(const ShardedCache& cache, const string& path, bool checksum = true, size_t segments = 1);
+
+    // Maps path and loads its live keys into cache, which must be empty,
+    // with the hash tables sized for the entry count up front. Segments are
+    // read and verified by one thread each; a Cache is then filled from
+    // this thread, while a ShardedCache is filled by the segment threads
+    // themselves. Throws runtime_error if a file cannot be read, is
+    // malformed or fails its checksum; the cache is left empty then.
+    // Returns the keys loaded.
+    size_t load(Cache& cache, const string& path);
+    size_t load(ShardedCache& cache, const string& path);
+
+    // Bytes on disk, segments included; remove deletes path and its segments
+    size_t diskUsage(const string& path);
+    void remove(const string& path);
+}
+
+// Counters for the snapshot file, as reported by STATS
+struct SnapshotStats {
+    long long lastSaveTime = 0;     // unix seconds of the last successful save, or load
+    bool lastSaveOk = true;
+    bool saveInProgress = false;
+    long long saves = 0;
+    long long failedSaves = 0;
+    size_t lastSaveBytes = 0;
+    long long lastSaveMillis = 0;
+};
+
+// SAVE, BGSAVE and LASTSAVE for one snapshot file. A background save forks
+// a child that writes the keyspace it inherited, copy-on-write keeping it
+// consistent while the parent goes on serving; the server reaps it from
+// its cron. Command thread only.
+class SnapshotManager {
+private:
+    string path;
+    bool checksum;
+    size_t segments;
+    pid_t savePid;              // -1 when no child is running
+    long long saveStartMs;
+    SnapshotStats stats;
+
+public:
+    SnapshotManager(const string& filePath, bool withChecksum = true, size_t segmentCount = 1);
+    ~SnapshotManager();     // waits for a running background save
+    SnapshotManager(const SnapshotManager&) = delete;
+    SnapshotManager& operator=(const SnapshotManager&) = delete;
+
+    // Loads the file if it exists; false if it does not. Throws like
+    // Snapshot::load.
+    bool load(Cache& cache);
+
+    // Saves in the foreground; false (logged) on failure or while a
+    // background save runs
+    bool save(const Cache& cache);
+    // Forks the save child; false if one is already running or fork failed
+    bool startBackgroundSave(const Cache& cache);
+    bool isSaving() const { return savePid != -1; }
+    // Reaps a finished save child; with wait, blocks until it finishes
+    void cron(bool wait = false);
+
+    SnapshotStats getStats() const;
+    static void printStats(const SnapshotStats& stats, ostream& out = cout);
+    const string& getPath() const { return path; }
+};
+
+#endif
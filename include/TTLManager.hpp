@@ -1,39 +1,64 @@
 #ifndef TTLMANAGER_HPP
 #define TTLMANAGER_HPP
 
-#include <string>
-#include <queue>
+#include "HashTable.hpp"
 #include <vector>
+#include <cstdint>
 
 using namespace std;
 
-struct TTLEntry {
-    string key;
-    long long expiryTime;
-    
-    TTLEntry(const string& k, long long exp) : key(k), expiryTime(exp) {}
-    
-    // For min-heap (priority queue)
-    bool operator>(const TTLEntry& other) const {
-        return expiryTime > other.expiryTime;
-    }
-};
-
+// Hierarchical timing wheel of entries ordered by expiryTime, in whatever
+// unit expiryTime uses. Level 0 has one slot per tick for the current block
+// of 64 ticks, level 1 one slot per 64 ticks for the current block of 4096,
+// and so on; an entry sits at the lowest level whose block contains its
+// expiry, and is moved down a level each time the wheel enters its slot.
+// Expiries past the top level wait in an overflow bucket.
+//
+// Each entry records its bucket and position (HashNode::ttlIndex), and
+// buckets are unordered, so schedule, reschedule and cancel are O(1) swaps.
+// Advancing costs O(1) per level plus the entries that expire or cascade;
+// a bitmap of occupied slots per level lets it jump over empty stretches.
 class TTLManager {
 private:
-    priority_queue<TTLEntry, vector<TTLEntry>, greater<TTLEntry>> minHeap;
+    static const int SLOT_BITS = 6;
+    static const size_t SLOTS = size_t(1) << SLOT_BITS;
+    static const int LEVELS = 6;
+    static const size_t OVERFLOW_BUCKET = LEVELS * SLOTS;
+    static const size_t READY_BUCKET = OVERFLOW_BUCKET + 1;     // expired, not yet popped
+    static const size_t NUM_BUCKETS = READY_BUCKET + 1;
+    
+    vector<HashNode*> buckets[NUM_BUCKETS];
+    uint64_t occupied[LEVELS];  // non-empty slots per level
+    long long current;          // next tick to process; every earlier one is done
+    size_t count;
+    size_t slotCapacity;        // pointers allocated across all buckets
+    
+    size_t bucketFor(long long expiryTime) const;
+    void append(size_t bucket, HashNode* node);
+    void detach(HashNode* node);
+    void moveAll(size_t bucket);
+    void advanceTo(long long tick);
+    long long nextEventAfter(long long tick) const;
     
 public:
-    TTLManager();
+    explicit TTLManager(long long startTime = 0);
     ~TTLManager();
+    TTLManager(const TTLManager&) = delete;
+    TTLManager& operator=(const TTLManager&) = delete;
+    
+    // Adds the node, or moves it after its expiryTime changed
+    void schedule(HashNode* node);
+    void cancel(HashNode* node);        // no-op if the node has no TTL
     
-    void addKey(const string& key, long long expiryTime);
-    vector<string> getExpiredKeys(long long currentTime);
-    void removeExpiredKeys(long long currentTime);
+    // Whether some node expired before currentTime; advances the wheel
+    bool hasExpired(long long currentTime);
+    // A node that expired before currentTime, else null
+    HashNode* popExpired(long long currentTime);
     
-    size_t size() const { return minHeap.size(); }
-    bool empty() const { return minHeap.empty(); }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t memoryUsage() const { return slotCapacity * sizeof(HashNode*); }
     void clear();
 };
 
-#endif
\ No newline at end of file
+#endif
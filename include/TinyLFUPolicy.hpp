@@ -0,0 +1,69 @@
+#ifndef TINYLFUPOLICY_HPP
+#define TINYLFUPOLICY_HPP
+
+#include "LRUCache.hpp"
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Approximate access counts for any number of keys in fixed space: four
+// rows of 4-bit counters, a key's estimate being the smallest of its four.
+// Every time the sample size worth of increments has been recorded, all
+// counters are halved, so old popularity fades.
+class CountMinSketch {
+private:
+    vector<uint64_t> table;     // 16 counters per word
+    size_t wordMask;
+    size_t additions;
+    size_t sampleSize;
+    
+    static uint64_t rowHash(size_t h, int row);
+    void halve();
+    
+public:
+    explicit CountMinSketch(size_t expectedKeys);
+    
+    void increment(size_t h);
+    unsigned frequency(size_t h) const;
+    void clear();
+    size_t memoryUsage() const { return table.capacity() * sizeof(uint64_t); }
+};
+
+// W-TinyLFU, as in Caffeine. New keys enter a small LRU window (1% of the
+// keys); the main space is a segmented LRU whose protected segment holds
+// keys hit again while on probation. When the window overflows, its oldest
+// key is admitted to probation only if the sketch says it is accessed more
+// often than the key probation would evict, so a scan cannot flush the hot
+// set. The three segments are LRUCache lists through the entries' links;
+// evictionState records which one an entry is on.
+class TinyLFUPolicy : public EvictionPolicy {
+private:
+    enum Segment : uint32_t { WINDOW = 1, PROBATION = 2, PROTECTED = 3 };
+    
+    CountMinSketch sketch;
+    LRUCache window;
+    LRUCache probation;
+    LRUCache protectedList;
+    
+    LRUCache& listFor(const HashNode* node);
+    static HashNode* tailExcept(const LRUCache& list, const HashNode* keep);
+    
+public:
+    static const size_t WINDOW_PERCENT = 1;
+    static const size_t PROTECTED_PERCENT = 80;    // of the main space
+    
+    explicit TinyLFUPolicy(size_t expectedKeys);
+    
+    void insert(HashNode* node) override;
+    void access(HashNode* node) override;
+    void remove(HashNode* node) override;
+    HashNode* victim(const HashNode* keep) override;
+    void clear() override;
+    
+    size_t size() const override { return window.size() + probation.size() + protectedList.size(); }
+    size_t memoryUsage() const override { return sketch.memoryUsage(); }
+    const char* name() const override { return "w-tinylfu"; }
+};
+
+#endif
@@ -0,0 +1,288 @@
+#ifndef VALUE_HPP
+#define VALUE_HPP
+
+#include "SlabAllocator.hpp"
+#include "utils.hpp"
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cassert>
+#include <charconv>
+#include <new>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+
+using namespace std;
+
+// What a key holds. Strings are the plain values below; every other type is
+// a CompoundValue.
+enum class ValueType : uint8_t {
+    STRING = 0,
+    HASH = 1,
+    ZSET = 2,
+    LIST = 3,
+    SET = 4,
+};
+
+// Base of the values that are not plain strings. Unlike strings they are
+// changed in place by their commands, so a stored one belongs to its entry
+// alone: it is never handed to readers outside the command (or shard lock)
+// that looks it up, and its internals may use the owner-only side of the
+// table's SlabAllocator.
+class CompoundValue {
+public:
+    virtual ~CompoundValue() {}
+    virtual ValueType type() const = 0;
+    // sizeof the concrete class, which lives inside the ValueRef's block
+    virtual size_t objectSize() const = 0;
+    // Heap bytes the value points to, its object excluded
+    virtual size_t memoryUsage() const = 0;
+    // Name of the current encoding, as OBJECT ENCODING reports it
+    virtual const char* encoding() const = 0;
+    // Appends the form snapshots store; the type's constructor from a
+    // string_view reads it back
+    virtual void serialize(string& out) const = 0;
+};
+
+// Handle to an immutable, reference-counted stored value. A reader holding a
+// ValueRef keeps the bytes alive even if the key is overwritten, deleted or
+// evicted in the meantime (with ShardedCache, by another thread), so a hit
+// hands out a pointer instead of copying the value.
+//
+// A handle is one pointer. Small values live in the same allocation as the
+// count; large strings passed by rvalue are adopted whole, so their bytes
+// are never copied. Counts are atomic since handles cross ShardedCache's
+// locks.
+//
+// Blocks come from the owning table's SlabAllocator when one is given (and
+// from malloc otherwise), so a ValueRef must not outlive its Cache.
+//
+// A ValueRef can also hold a CompoundValue, built inside its block by make.
+// data, size and view are for strings only.
+//
+// A string that is a canonical decimal integer within 63 bits takes no block
+// at all: the integer is kept in the pointer itself, tagged by its low bit
+// (blocks are at least 8-byte aligned), like Redis's int encoding. INCR
+// rewrites only the entry, and the text exists only while a reply or a dump
+// formats it. data and view() assert they are not given an integer;
+// view(digits) and str() work for any string.
+class ValueRef {
+private:
+    struct Block {
+        atomic<uint32_t> refs;
+        uint32_t length;        // bytes stored after the header, ADOPTED or COMPOUND
+        SlabAllocator* owner;   // null for malloc
+
+        char* payload() { return reinterpret_cast<char*>(this + 1); }
+        string* adopted() { return reinterpret_cast<string*>(this + 1); }
+        CompoundValue* compound() { return reinterpret_cast<CompoundValue*>(this + 1); }
+    };
+
+    static const uint32_t ADOPTED = UINT32_MAX;
+    static const uint32_t COMPOUND = UINT32_MAX - 1;
+
+    Block* block;
+
+    explicit ValueRef(Block* b) : block(b) {}
+
+    static const long long INLINE_MIN = -(1LL << 62);
+    static const long long INLINE_MAX = (1LL << 62) - 1;
+
+    bool hasBlock() const { return block && !isInteger(); }
+
+    void retain() const {
+        if (hasBlock()) block->refs.fetch_add(1, memory_order_relaxed);
+    }
+
+    static Block* allocBlock(SlabAllocator* owner, size_t payloadBytes) {
+        size_t bytes = sizeof(Block) + payloadBytes;
+        Block* b = static_cast<Block*>(owner ? owner->allocate(bytes) : malloc(bytes));
+        if (!b) throw bad_alloc();
+        new (&b->refs) atomic<uint32_t>(1);
+        b->owner = owner;
+        return b;
+    }
+
+    size_t blockBytes() const {
+        if (block->length == COMPOUND) {
+            return sizeof(Block) + block->compound()->objectSize();
+        }
+        return sizeof(Block) + (block->length == ADOPTED ? sizeof(string) : block->length);
+    }
+
+    // What malloc really set aside for an adopted string's buffer
+    static size_t bufferBytes(const string& s) {
+        return malloc_usable_size(const_cast<char*>(s.data()));
+    }
+
+public:
+    // Strings at least this long are adopted rather than copied when moved in
+    static const size_t ADOPT_MIN_BYTES = 1024;
+    // Room view(digits) needs for an integer's text
+    static const size_t MAX_DIGITS = 24;
+
+    ValueRef() : block(nullptr) {}
+    ValueRef(nullptr_t) : block(nullptr) {}
+    ValueRef(const ValueRef& other) : block(other.block) { retain(); }
+    ValueRef(ValueRef&& other) noexcept : block(other.block) { other.block = nullptr; }
+    ~ValueRef() { reset(); }
+
+    ValueRef& operator=(const ValueRef& other) {
+        other.retain();
+        reset();
+        block = other.block;
+        return *this;
+    }
+
+    ValueRef& operator=(ValueRef&& other) noexcept {
+        if (this != &other) {
+            reset();
+            block = other.block;
+            other.block = nullptr;
+        }
+        return *this;
+    }
+
+    // Integers in canonical form are stored inline rather than copied
+    static ValueRef copyOf(string_view bytes, SlabAllocator* owner = nullptr) {
+        long long value;
+        if (bytes.size() < MAX_DIGITS && Utils::parseCanonicalInteger(bytes, value)
+            && value >= INLINE_MIN && value <= INLINE_MAX) {
+            return fromInteger(value);
+        }
+        Block* b = allocBlock(owner, bytes.size());
+        b->length = static_cast<uint32_t>(bytes.size());
+        memcpy(b->payload(), bytes.data(), bytes.size());
+        return ValueRef(b);
+    }
+
+    // value inline, or as its text where it needs all 64 bits
+    static ValueRef fromInteger(long long value, SlabAllocator* owner = nullptr) {
+        if (value < INLINE_MIN || value > INLINE_MAX) {
+            char digits[MAX_DIGITS];
+            char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+            return copyOf(string_view(digits, end - digits), owner);
+        }
+        return ValueRef(reinterpret_cast<Block*>((static_cast<uintptr_t>(value) << 1) | 1));
+    }
+
+    static ValueRef adopt(string&& bytes, SlabAllocator* owner = nullptr) {
+        if (bytes.size() < ADOPT_MIN_BYTES) {
+            return copyOf(bytes, owner);
+        }
+        Block* b = allocBlock(owner, sizeof(string));
+        b->length = ADOPTED;
+        new (b->adopted()) string(move(bytes));
+        if (owner) {
+            owner->addExternal(bufferBytes(*b->adopted()));
+        }
+        return ValueRef(b);
+    }
+
+    // A new T, built in the block with args. T derives from CompoundValue,
+    // as its first and only base.
+    template <typename T, typename... Args>
+    static ValueRef make(SlabAllocator* owner, Args&&... args) {
+        Block* b = allocBlock(owner, sizeof(T));
+        b->length = COMPOUND;
+        try {
+            new (b->payload()) T(forward<Args>(args)...);
+        } catch (...) {
+            owner ? owner->deallocate(b, sizeof(Block) + sizeof(T)) : free(b);
+            throw;
+        }
+        return ValueRef(b);
+    }
+
+    void reset() {
+        if (hasBlock() && block->refs.fetch_sub(1, memory_order_acq_rel) == 1) {
+            size_t bytes = blockBytes();
+            if (block->length == ADOPTED) {
+                if (block->owner) {
+                    block->owner->removeExternal(bufferBytes(*block->adopted()));
+                }
+                block->adopted()->~string();
+            } else if (block->length == COMPOUND) {
+                block->compound()->~CompoundValue();
+            }
+            // The last reference may be dropped by any thread
+            if (block->owner) {
+                block->owner->deallocateShared(block, bytes);
+            } else {
+                free(block);
+            }
+        }
+        block = nullptr;
+    }
+
+    bool isInteger() const { return reinterpret_cast<uintptr_t>(block) & 1; }
+    // The inline integer; arithmetic shift keeps the sign
+    long long integer() const { return static_cast<long long>(reinterpret_cast<intptr_t>(block) >> 1); }
+
+    const char* data() const {
+        assert(!isInteger());
+        return block->length == ADOPTED ? block->adopted()->data() : block->payload();
+    }
+    // An integer's size is that of its text
+    size_t size() const {
+        if (isInteger()) {
+            char digits[MAX_DIGITS];
+            return view(digits).size();
+        }
+        return block->length == ADOPTED ? block->adopted()->size() : block->length;
+    }
+    string_view view() const {
+        assert(!isInteger());
+        return string_view(data(), size());
+    }
+    // The string's bytes; an integer is formatted into digits, which must
+    // hold MAX_DIGITS bytes and outlive the view
+    string_view view(char* digits) const {
+        if (isInteger()) {
+            return string_view(digits, to_chars(digits, digits + MAX_DIGITS, integer()).ptr - digits);
+        }
+        return view();
+    }
+    string str() const {
+        char digits[MAX_DIGITS];
+        return string(view(digits));
+    }
+
+    ValueType type() const {
+        return hasBlock() && block->length == COMPOUND ? block->compound()->type() : ValueType::STRING;
+    }
+    // As OBJECT ENCODING names it: inline integers are "int", strings copied
+    // into their block "embstr", adopted ones "raw"
+    const char* encoding() const {
+        if (isInteger()) return "int";
+        if (block->length == COMPOUND) return block->compound()->encoding();
+        return block->length == ADOPTED ? "raw" : "embstr";
+    }
+    // The compound value held, null for a string
+    CompoundValue* compound() const {
+        return hasBlock() && block->length == COMPOUND ? block->compound() : nullptr;
+    }
+
+    // Heap bytes behind this value: its block (a whole slab chunk) plus
+    // the usable size of an adopted string's buffer, or what a compound
+    // value points to; nothing for an inline integer
+    size_t memoryUsage() const {
+        if (!hasBlock()) return 0;
+        size_t bytes = block->owner ? block->owner->chunkSize(blockBytes()) : blockBytes();
+        if (block->length == ADOPTED) {
+            bytes += bufferBytes(*block->adopted());
+        } else if (block->length == COMPOUND) {
+            bytes += block->compound()->memoryUsage();
+        }
+        return bytes;
+    }
+
+    explicit operator bool() const { return block != nullptr; }
+    bool operator==(const ValueRef& other) const { return block == other.block; }
+    bool operator!=(const ValueRef& other) const { return block != other.block; }
+};
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef ZSETVALUE_HPP
+#define ZSETVALUE_HPP
+
+#include "Value.hpp"
+#include "SlabAllocator.hpp"
+#include "Listpack.hpp"
+#include "RecordIndex.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Bounds of a score range, as ZRANGEBYSCORE takes them: "(" before a bound
+// excludes it, and -inf / +inf are open ends
+struct ScoreRange {
+    double min;
+    double max;
+    bool minExclusive = false;
+    bool maxExclusive = false;
+
+    bool aboveMin(double score) const { return minExclusive ? score > min : score >= min; }
+    bool belowMax(double score) const { return maxExclusive ? score < max : score <= max; }
+    bool contains(double score) const { return aboveMin(score) && belowMax(score); }
+    bool empty() const { return min > max || (min == max && (minExclusive || maxExclusive)); }
+};
+
+// A sorted set of members ordered by score, then by member bytes: the value
+// of ZADD and friends.
+//
+// Small sets are a listpack: entries of an 8-byte score and a varint-length
+// member, kept in order in one buffer, so lookups scan it. Past
+// MAX_LISTPACK_ENTRIES members, or with a member longer than
+// MAX_LISTPACK_VALUE bytes, a set converts for good to a skiplist with
+// rank spans, as in Redis, plus a RecordIndex from member to node: ZSCORE
+// is one hash lookup, and rank, range and update are O(log N). Nodes are
+// single slab chunks holding their levels and member, allocated from the
+// owning table's SlabAllocator.
+//
+// The listpack layout is also the serialized form.
+class ZSetValue : public CompoundValue {
+public:
+    static const ValueType TYPE = ValueType::ZSET;
+    static const size_t MAX_LISTPACK_ENTRIES = 128;
+    static const size_t MAX_LISTPACK_VALUE = 64;
+
+    // ZADD options
+    enum AddFlags : uint32_t {
+        ADD_NX = 1 << 0,    // only add new members
+        ADD_XX = 1 << 1,    // only update existing ones
+        ADD_GT = 1 << 2,    // only update to a greater score
+        ADD_LT = 1 << 3,    // only update to a lesser score
+        ADD_INCR = 1 << 4,  // add the score to the current one
+    };
+    enum AddOutcome { ADDED, UPDATED, UNCHANGED, SKIPPED, NOT_A_NUMBER };
+
+private:
+    struct Node;
+    struct Level {
+        Node* forward;
+        size_t span;        // nodes skipped to reach forward
+    };
+    // levels[height], then the member bytes
+    struct Node {
+        double score;
+        Node* backward;
+        uint32_t hash;
+        uint32_t memberLength;
+        uint32_t height;
+
+        Level* levels() { return reinterpret_cast<Level*>(this + 1); }
+        const Level* levels() const { return reinterpret_cast<const Level*>(this + 1); }
+        char* bytes() { return reinterpret_cast<char*>(levels() + height); }
+        const char* bytes() const { return reinterpret_cast<const char*>(levels() + height); }
+        string_view key() const { return string_view(bytes(), memberLength); }
+        size_t allocSize() const { return sizeof(Node) + height * sizeof(Level) + memberLength; }
+    };
+
+    static const int MAX_LEVEL = 32;
+    static const size_t SCORE_BYTES = sizeof(double);
+
+    SlabAllocator* slabs;
+    char* pack;             // listpack encoding
+    Node* head;             // skiplist encoding, null while a listpack
+    Node* tail;
+    RecordIndex<Node> members;
+    uint32_t count;
+    uint32_t packBytes;
+    uint32_t packCapacity;
+    int level;              // skiplist levels in use
+    size_t heapBytes;       // slab chunks held but the index's, see memoryUsage
+
+    // Whether node sorts before score and member
+    static bool nodeBefore(const Node* node, double score, string_view member) {
+        return node->score < score || (node->score == score && node->key() < member);
+    }
+
+    // Listpack
+    size_t packFind(string_view member, double* score = nullptr) const;
+    size_t packPosition(double score, string_view member) const;
+    void packReserve(size_t bytes);
+    void packInsert(size_t at, double score, string_view member);
+    void packRemove(size_t entry);
+    // Offsets of every entry, in order
+    void packEntries(vector<uint32_t>& offsets) const;
+    static const char* packRead(const char* pos, const char* end, double& score, string_view& member);
+    void convertToSkiplist(size_t memberCount);
+
+    // Skiplist
+    static int randomLevel();
+    Node* newNode(int height, double score, string_view member, uint32_t h);
+    void freeNode(Node* node);
+    void linkNode(Node* node, size_t length);
+    void unlinkNode(Node* node);
+    Node* nodeByRank(size_t rank) const;   // 1-based
+    size_t nodeRank(const Node* node) const;
+    Node* firstInRange(const ScoreRange& range) const;
+    Node* lastInRange(const ScoreRange& range) const;
+
+    void setScore(string_view member, double score);
+    bool insertNew(string_view member, double score);
+
+public:
+    explicit ZSetValue(SlabAllocator* owner);
+    // Rebuilds a set from serialize's output, which isValid must accept
+    ZSetValue(SlabAllocator* owner, string_view serialized);
+    ~ZSetValue() override;
+    ZSetValue(const ZSetValue&) = delete;
+    ZSetValue& operator=(const ZSetValue&) = delete;
+
+    ValueType type() const override { return ValueType::ZSET; }
+    size_t objectSize() const override { return sizeof(ZSetValue); }
+    size_t memoryUsage() const override { return heapBytes + members.memoryUsage(slabs); }
+    const char* encoding() const override { return head ? "skiplist" : "listpack"; }
+
+    size_t size() const { return count; }
+    bool score(string_view member, double& score) const;
+    // Adds or updates member as ZADD does with flags; newScore is what the
+    // member holds afterwards (unless SKIPPED or NOT_A_NUMBER)
+    AddOutcome add(string_view member, double score, uint32_t flags, double& newScore);
+    bool remove(string_view member);
+    // 0-based position in score order, or from the top with reverse; -1 if
+    // member is missing
+    long long rank(string_view member, bool reverse = false) const;
+    // Members with scores in range
+    size_t countInRange(const ScoreRange& range) const;
+
+    // Calls visit(member, score) for ranks start to stop, both included and
+    // already clamped to the set; with reverse, ranks count from the top
+    template <typename Visit>
+    void forEachInRanks(size_t start, size_t stop, bool reverse, Visit&& visit) const;
+    // Calls visit(member, score) for the members in range, lowest first (or
+    // highest with reverse), skipping offset of them and stopping after
+    // limit (-1 for no limit)
+    template <typename Visit>
+    void forEachInRange(const ScoreRange& range, bool reverse, size_t offset, long long limit,
+                        Visit&& visit) const;
+    // Every member, in order
+    template <typename Visit>
+    void forEach(Visit&& visit) const { if (count) forEachInRanks(0, count - 1, false, visit); }
+
+    // Appends the listpack form of every member to out
+    void serialize(string& out) const override;
+    static bool isValid(string_view serialized);
+};
+
+template <typename Visit>
+void ZSetValue::forEachInRanks(size_t start, size_t stop, bool reverse, Visit&& visit) const {
+    if (!head) {
+        vector<uint32_t> offsets;
+        packEntries(offsets);
+        for (size_t i = start; i <= stop; i++) {
+            double value;
+            string_view member;
+            packRead(pack + offsets[reverse ? count - 1 - i : i], pack + packBytes, value, member);
+            visit(member, value);
+        }
+        return;
+    }
+    const Node* node = nodeByRank(reverse ? count - start : start + 1);
+    for (size_t i = start; i <= stop; i++) {
+        visit(node->key(), node->score);
+        node = reverse ? node->backward : node->levels()[0].forward;
+    }
+}
+
+template <typename Visit>
+void ZSetValue::forEachInRange(const ScoreRange& range, bool reverse, size_t offset, long long limit,
+                               Visit&& visit) const {
+    if (range.empty() || limit == 0) {
+        return;
+    }
+    if (!head) {
+        vector<uint32_t> offsets;
+        packEntries(offsets);
+        for (size_t n = 0; n < offsets.size() && limit != 0; n++) {
+            double value;
+            string_view member;
+            packRead(pack + offsets[reverse ? count - 1 - n : n], pack + packBytes, value, member);
+            if (!range.contains(value)) {
+                if (reverse ? value < range.min : value > range.max) break;
+                continue;
+            }
+            if (offset > 0) {
+                offset--;
+                continue;
+            }
+            visit(member, value);
+            if (limit > 0) limit--;
+        }
+        return;
+    }
+    const Node* node = reverse ? lastInRange(range) : firstInRange(range);
+    for (; node && offset > 0; offset--) {
+        node = reverse ? node->backward : node->levels()[0].forward;
+    }
+    for (; node && limit != 0 && range.contains(node->score); limit--) {
+        visit(node->key(), node->score);
+        node = reverse ? node->backward : node->levels()[0].forward;
+    }
+}
+
+#endif
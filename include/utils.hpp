@@ -3,6 +3,7 @@
 
 #include <chrono>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace std;
@@ -10,9 +11,23 @@ using namespace std;
 class Utils {
 public:
     static long long getCurrentTimestamp();
+    static long long getCurrentTimeMillis();    // wall clock, for anything persisted
+    // Milliseconds on a clock that never jumps back; expiry times use it
+    static long long monotonicMillis();
     static vector<string> splitString(const string& str, char delimiter);
+    // Whole-string base 10 long long, as Redis's string2ll: no spaces or '+'
+    static bool parseInteger(string_view str, long long& value);
+    // As parseInteger, for only the text value formats back to: no "-0",
+    // leading zeros or sign on zero, so the text can be rebuilt exactly
+    static bool parseCanonicalInteger(string_view str, long long& value);
+    // Whole-string double for scores: "inf", "+inf" and "-inf" too, never NaN
+    static bool parseDouble(string_view str, double& value);
+    // Shortest text that parses back to value, "inf" and "-inf" for infinities
+    static string formatDouble(double value);
     static void logMessage(const string& message);
     static string formatMemorySize(size_t bytes);
+    // fsyncs the directory holding path, making a rename into it durable
+    static void syncParentDirectory(const string& path);
 };
 
 #endif
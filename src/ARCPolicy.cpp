@@ -0,0 +1,112 @@
+#include "../include/ARCPolicy.hpp"
+#include <algorithm>
+
+using namespace std;
+
+void ARCPolicy::forgetGhost(unordered_map<size_t, Ghost>::iterator it) {
+    (it->second.side == T1 ? b1 : b2).erase(it->second.position);
+    ghosts.erase(it);
+}
+
+void ARCPolicy::insert(HashNode* node) {
+    lastFromB2 = false;
+    auto it = ghosts.find(node->hash);
+    if (it == ghosts.end()) {
+        node->evictionState = T1;
+        t1.access(node);
+        return;
+    }
+    
+    // Evicted too early: grow the side it was evicted from
+    size_t capacity = size() + 1;
+    if (it->second.side == T1) {
+        size_t step = max<size_t>(1, b2.size() / b1.size());
+        target = min(capacity, target + step);
+    } else {
+        size_t step = max<size_t>(1, b1.size() / b2.size());
+        target = target > step ? target - step : 0;
+        lastFromB2 = true;
+    }
+    forgetGhost(it);
+    
+    node->evictionState = T2;
+    t2.access(node);
+}
+
+void ARCPolicy::access(HashNode* node) {
+    if (node->evictionState == T1) {
+        t1.remove(node);
+        node->evictionState = T2;
+    }
+    t2.access(node);
+}
+
+void ARCPolicy::remove(HashNode* node) {
+    if (node->evictionState == 0) return;
+    
+    Side from = static_cast<Side>(node->evictionState);
+    (from == T1 ? t1 : t2).remove(node);
+    node->evictionState = 0;
+    
+    // Only evictions leave a ghost; deleted and expired keys are just gone
+    if (node == evicting) {
+        evicting = nullptr;
+        auto it = ghosts.find(node->hash);
+        if (it != ghosts.end()) {
+            forgetGhost(it);
+        }
+        list<size_t>& ghostList = from == T1 ? b1 : b2;
+        ghostList.push_front(node->hash);
+        ghosts[node->hash] = Ghost{from, ghostList.begin()};
+        trimGhosts();
+    }
+}
+
+// |T1| + |B1| and the ghosts as a whole stay within the cache size
+void ARCPolicy::trimGhosts() {
+    size_t capacity = size();
+    while (!b1.empty() && t1.size() + b1.size() > capacity) {
+        ghosts.erase(b1.back());
+        b1.pop_back();
+    }
+    while (!b2.empty() && b1.size() + b2.size() > capacity) {
+        ghosts.erase(b2.back());
+        b2.pop_back();
+    }
+}
+
+// ARC's REPLACE: take from T1 while it is over its target, else from T2
+HashNode* ARCPolicy::victim(const HashNode* keep) {
+    bool fromT1 = t1.size() > 0 && (t1.size() > target || (t1.size() == target && lastFromB2));
+    LRUCache& first = fromT1 ? t1 : t2;
+    LRUCache& second = fromT1 ? t2 : t1;
+    
+    HashNode* node = first.leastRecent();
+    if (!node || node == keep) {
+        node = second.leastRecent();
+    }
+    if (node == keep) {
+        node = nullptr;
+    }
+    evicting = node;
+    return node;
+}
+
+void ARCPolicy::clear() {
+    t1.clear();
+    t2.clear();
+    b1.clear();
+    b2.clear();
+    ghosts.clear();
+    target = 0;
+    lastFromB2 = false;
+    evicting = nullptr;
+}
+
+// Ghost list nodes and hash map nodes and buckets, approximately as
+// libstdc++ lays them out
+size_t ARCPolicy::memoryUsage() const {
+    size_t listNode = sizeof(size_t) + 2 * sizeof(void*);
+    size_t mapNode = sizeof(void*) + sizeof(pair<const size_t, Ghost>) + sizeof(size_t);
+    return ghosts.size() * (listNode + mapNode) + ghosts.bucket_count() * sizeof(void*);
+}
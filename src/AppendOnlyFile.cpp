@@ -0,0 +1,556 @@
+#include "../include/AppendOnlyFile.hpp"
+#include "../include/CommandProcessor.hpp"
+#include "../include/Cache.hpp"
+#include "../include/RESP.hpp"
+#include "../include/utils.hpp"
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+namespace {
+
+// Replies to replayed commands go nowhere
+class DiscardReplyWriter : public ReplyWriter {
+public:
+    using ReplyWriter::bulk;
+
+    void status(const string&) override {}
+    void error(const string&) override {}
+    void integer(long long) override {}
+    void bulk(const string&) override {}
+    void nil() override {}
+    void arrayHeader(size_t) override {}
+    void text(const string&) override {}
+};
+
+} // namespace
+
+bool parseFsyncPolicy(const string& name, FsyncPolicy& policy) {
+    if (name == "always") {
+        policy = FsyncPolicy::ALWAYS;
+    } else if (name == "everysec") {
+        policy = FsyncPolicy::EVERYSEC;
+    } else if (name == "no") {
+        policy = FsyncPolicy::NO;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* fsyncPolicyName(FsyncPolicy policy) {
+    switch (policy) {
+        case FsyncPolicy::ALWAYS: return "always";
+        case FsyncPolicy::EVERYSEC: return "everysec";
+        case FsyncPolicy::NO: return "no";
+    }
+    return "";
+}
+
+AppendOnlyFile::AppendOnlyFile(const string& filePath, FsyncPolicy fsyncPolicy)
+    : path(filePath), policy(fsyncPolicy), fd(-1), appendedBytes(0), writtenBytes(0), syncedBytes(0),
+      fileBytes(0), fsyncs(0), writeErrors(0), failing(false), stopping(false),
+      rewriteTee(false), rewriteReady(false), rewriteBaseBytes(0), rewrites(0), rewritePid(-1),
+      autoRewritePercentage(DEFAULT_REWRITE_PERCENTAGE), autoRewriteMinBytes(DEFAULT_REWRITE_MIN_BYTES) {}
+
+AppendOnlyFile::~AppendOnlyFile() {
+    // An unfinished rewrite is abandoned; the current file is complete
+    if (rewritePid != -1) {
+        kill(rewritePid, SIGKILL);
+        waitpid(rewritePid, nullptr, 0);
+        unlink(rewritePath().c_str());
+    }
+    if (writer.joinable()) {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+    }
+    if (fd >= 0) close(fd);
+}
+
+size_t AppendOnlyFile::load(CommandProcessor& processor) {
+    int in = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        if (errno == ENOENT) return 0;
+        throw runtime_error("open " + path + ": " + strerror(errno));
+    }
+
+    DiscardReplyWriter reply;
+    vector<string_view> argv;
+    string data, error;
+    size_t pos = 0;
+    size_t consumed = 0;    // file offset of data[0]
+    size_t commands = 0;
+    vector<char> chunk(READ_CHUNK);
+
+    while (true) {
+        ssize_t n = read(in, chunk.data(), chunk.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int err = errno;
+            close(in);
+            throw runtime_error("read " + path + ": " + strerror(err));
+        }
+        if (n == 0) break;
+        data.append(chunk.data(), n);
+
+        while (true) {
+            RESPParser::Result result = RESPParser::parseCommand(data, pos, argv, error);
+            if (result == RESPParser::INCOMPLETE) break;
+            if (result == RESPParser::PROTOCOL_ERROR) {
+                close(in);
+                throw runtime_error(path + " is corrupt at offset " + to_string(consumed + pos) + ": " + error);
+            }
+            if (!argv.empty()) {
+                processor.execute(argv, reply);
+                commands++;
+            }
+        }
+
+        consumed += pos;
+        data.erase(0, pos);
+        pos = 0;
+    }
+    close(in);
+
+    // A crash mid-write leaves part of a command behind; drop it so new
+    // appends start on a command boundary
+    if (!data.empty()) {
+        Utils::logMessage("AOF: dropping " + to_string(data.size()) + " bytes of incomplete command at the end of " + path);
+        if (truncate(path.c_str(), consumed) < 0) {
+            throw runtime_error("truncate " + path + ": " + strerror(errno));
+        }
+    }
+    return commands;
+}
+
+void AppendOnlyFile::start() {
+    fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw runtime_error("open " + path + ": " + strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0) {
+        fileBytes = st.st_size;
+        rewriteBaseBytes = fileBytes;
+    }
+    writer = thread(&AppendOnlyFile::writerLoop, this);
+}
+
+void AppendOnlyFile::encodeHeader(string& out, size_t argc) {
+    out += '*';
+    out += to_string(argc);
+    out += "\r\n";
+}
+
+void AppendOnlyFile::encodeArg(string& out, string_view arg) {
+    out += '$';
+    out += to_string(arg.size());
+    out += "\r\n";
+    out.append(arg.data(), arg.size());
+    out += "\r\n";
+}
+
+void AppendOnlyFile::encode(string& out, initializer_list<string_view> argv) {
+    encodeHeader(out, argv.size());
+    for (string_view arg : argv) {
+        encodeArg(out, arg);
+    }
+}
+
+// Counts the record just encoded at the end of buffer, and keeps a copy
+// for the new file while a rewrite runs
+void AppendOnlyFile::appended(size_t before) {
+    appendedBytes += buffer.size() - before;
+    if (rewriteTee) {
+        rewriteBuffer.append(buffer, before, string::npos);
+    }
+}
+
+void AppendOnlyFile::append(initializer_list<string_view> argv) {
+    lock_guard<mutex> guard(lock);
+    size_t before = buffer.size();
+    encode(buffer, argv);
+    appended(before);
+}
+
+void AppendOnlyFile::append(const vector<string_view>& argv) {
+    lock_guard<mutex> guard(lock);
+    size_t before = buffer.size();
+    encodeHeader(buffer, argv.size());
+    for (string_view arg : argv) {
+        encodeArg(buffer, arg);
+    }
+    appended(before);
+}
+
+void AppendOnlyFile::commit() {
+    unique_lock<mutex> guard(lock);
+    if (!buffer.empty()) {
+        wake.notify_one();
+    }
+    if (policy == FsyncPolicy::ALWAYS) {
+        uint64_t target = appendedBytes;
+        durable.wait(guard, [this, target] { return syncedBytes >= target || failing; });
+    }
+}
+
+// Writes data out, erasing what was written; false (with errno set) on an
+// I/O error
+bool AppendOnlyFile::writeAll(int out, string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(out, data.data() + done, data.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int err = errno;
+            data.erase(0, done);
+            errno = err;
+            return false;
+        }
+        done += n;
+    }
+    data.clear();
+    return true;
+}
+
+void AppendOnlyFile::writerLoop() {
+    string writing;     // taken from buffer; keeps what a failed write left
+    long long lastFsync = Utils::monotonicMillis();
+    unique_lock<mutex> guard(lock);
+
+    while (true) {
+        wake.wait_for(guard, chrono::milliseconds(WRITER_IDLE_MS),
+                      [this] { return stopping || rewriteReady || !buffer.empty(); });
+        if (rewriteReady) {
+            rewriteReady = false;
+            if (swapInRewrite()) {
+                // Anything not yet written is in the new file already
+                writing.clear();
+                failing = false;
+                durable.notify_all();
+            }
+        }
+        bool stop = stopping;
+        if (writing.empty()) {
+            writing.swap(buffer);
+        } else {
+            writing += buffer;
+            buffer.clear();
+        }
+        uint64_t taken = appendedBytes - buffer.size();
+        uint64_t synced = syncedBytes;
+        guard.unlock();
+
+        int err = 0;
+        bool ok = writeAll(fd, writing);
+        if (!ok) err = errno;
+        uint64_t written = taken - writing.size();
+
+        long long now = Utils::monotonicMillis();
+        bool syncDue = policy == FsyncPolicy::ALWAYS || stop ||
+                       (policy == FsyncPolicy::EVERYSEC && now - lastFsync >= EVERYSEC_INTERVAL_MS);
+        bool didSync = false;
+        if (written > synced && syncDue) {
+            if (fdatasync(fd) == 0) {
+                didSync = true;
+            } else {
+                ok = false;
+                err = errno;
+            }
+            lastFsync = now;
+        }
+
+        guard.lock();
+        if (!ok) {
+            // Logged once per outage rather than on every retry
+            if (!failing) {
+                Utils::logMessage("AOF: writing " + path + " failed: " + strerror(err));
+            }
+            writeErrors++;
+        }
+        failing = !ok;
+        fileBytes += written - writtenBytes;
+        writtenBytes = written;
+        if (didSync) {
+            syncedBytes = written;
+            fsyncs++;
+        }
+        durable.notify_all();
+
+        if (stop && (buffer.empty() || failing)) {
+            break;
+        }
+    }
+}
+
+bool AppendOnlyFile::startRewrite(const Cache& cache) {
+    if (rewritePid != -1 || fd < 0) {
+        return false;
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        if (rewriteTee) {
+            return false;   // the writer has not swapped the last one in yet
+        }
+        rewriteTee = true;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // The child owns a copy-on-write snapshot of the keyspace as of the
+        // fork; the parent's threads and locks are not used here. An
+        // exception must not unwind into the parent's copied stack, where
+        // it would run the server's destructors in this process.
+        bool ok = false;
+        try {
+            int out = open(rewritePath().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            ok = out >= 0 && writeKeyspace(cache, out);
+        } catch (...) {
+            ok = false;
+        }
+        _exit(ok ? 0 : 1);
+    }
+    if (pid < 0) {
+        Utils::logMessage(string("AOF: cannot fork for rewrite: ") + strerror(errno));
+        lock_guard<mutex> guard(lock);
+        rewriteTee = false;
+        return false;
+    }
+
+    rewritePid = pid;
+    Utils::logMessage("AOF: background rewrite started by pid " + to_string(pid));
+    return true;
+}
+
+// The HSET commands that rebuild hash, REWRITE_ITEMS_PER_COMMAND fields at
+// a time
+void AppendOnlyFile::encodeHash(string& out, string_view key, const HashValue& hash) {
+    size_t left = hash.size();
+    size_t batch = 0;
+    hash.forEach([&](string_view field, string_view value) {
+        if (batch == 0) {
+            batch = left < REWRITE_ITEMS_PER_COMMAND ? left : REWRITE_ITEMS_PER_COMMAND;
+            left -= batch;
+            encodeHeader(out, 2 + 2 * batch);
+            encodeArg(out, "HSET");
+            encodeArg(out, key);
+        }
+        encodeArg(out, field);
+        encodeArg(out, value);
+        batch--;
+    });
+}
+
+// The ZADD commands that rebuild zset, lowest scores first, with scores
+// written to round-trip exactly
+void AppendOnlyFile::encodeZSet(string& out, string_view key, const ZSetValue& zset) {
+    size_t left = zset.size();
+    size_t batch = 0;
+    zset.forEach([&](string_view member, double score) {
+        if (batch == 0) {
+            batch = left < REWRITE_ITEMS_PER_COMMAND ? left : REWRITE_ITEMS_PER_COMMAND;
+            left -= batch;
+            encodeHeader(out, 2 + 2 * batch);
+            encodeArg(out, "ZADD");
+            encodeArg(out, key);
+        }
+        encodeArg(out, Utils::formatDouble(score));
+        encodeArg(out, member);
+        batch--;
+    });
+}
+
+// The RPUSH commands that rebuild list, front to back
+void AppendOnlyFile::encodeList(string& out, string_view key, const ListValue& list) {
+    size_t left = list.size();
+    size_t batch = 0;
+    list.forEach([&](string_view value) {
+        if (batch == 0) {
+            batch = left < REWRITE_ITEMS_PER_COMMAND ? left : REWRITE_ITEMS_PER_COMMAND;
+            left -= batch;
+            encodeHeader(out, 2 + batch);
+            encodeArg(out, "RPUSH");
+            encodeArg(out, key);
+        }
+        encodeArg(out, value);
+        batch--;
+    });
+}
+
+// The SADD commands that rebuild set
+void AppendOnlyFile::encodeSet(string& out, string_view key, const SetValue& set) {
+    size_t left = set.size();
+    size_t batch = 0;
+    set.forEach([&](string_view member) {
+        if (batch == 0) {
+            batch = left < REWRITE_ITEMS_PER_COMMAND ? left : REWRITE_ITEMS_PER_COMMAND;
+            left -= batch;
+            encodeHeader(out, 2 + batch);
+            encodeArg(out, "SADD");
+            encodeArg(out, key);
+        }
+        encodeArg(out, member);
+        batch--;
+    });
+}
+
+// Runs in the rewrite child: one SET (or HSET, ZADD, RPUSH, SADD) per live
+// key, with a PEXPIREAT for those with a TTL
+bool AppendOnlyFile::writeKeyspace(const Cache& cache, int out) {
+    string chunk;
+    bool ok = true;
+    long long now = Utils::getCurrentTimeMillis();
+    cache.forEachEntry([&](string_view key, const ValueRef& value, long long ttlMs) {
+        switch (value.type()) {
+            case ValueType::HASH:
+                encodeHash(chunk, key, static_cast<const HashValue&>(*value.compound()));
+                break;
+            case ValueType::ZSET:
+                encodeZSet(chunk, key, static_cast<const ZSetValue&>(*value.compound()));
+                break;
+            case ValueType::LIST:
+                encodeList(chunk, key, static_cast<const ListValue&>(*value.compound()));
+                break;
+            case ValueType::SET:
+                encodeSet(chunk, key, static_cast<const SetValue&>(*value.compound()));
+                break;
+            default: {
+                char digits[ValueRef::MAX_DIGITS];
+                encode(chunk, {"SET", key, value.view(digits)});
+                break;
+            }
+        }
+        if (ttlMs >= 0) {
+            encode(chunk, {"PEXPIREAT", key, to_string(now + ttlMs)});
+        }
+        if (chunk.size() >= REWRITE_CHUNK) {
+            ok = ok && writeAll(out, chunk);
+            chunk.clear();
+        }
+    });
+    return ok && writeAll(out, chunk) && fsync(out) == 0;
+}
+
+// Writer thread, under lock: completes the child's file with the records
+// appended since the fork and renames it over the log. Holding the lock
+// keeps new appends out until the swap is done. On failure the old file
+// stays in use.
+bool AppendOnlyFile::swapInRewrite() {
+    string temp = rewritePath();
+    int out = open(temp.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    bool ok = out >= 0 && writeAll(out, rewriteBuffer) && fsync(out) == 0 &&
+              rename(temp.c_str(), path.c_str()) == 0;
+    int err = errno;
+    rewriteTee = false;
+    string().swap(rewriteBuffer);
+
+    if (!ok) {
+        Utils::logMessage("AOF: finishing rewrite of " + path + " failed: " + strerror(err));
+        if (out >= 0) close(out);
+        unlink(temp.c_str());
+        return false;
+    }
+
+    // Make the rename itself durable
+    Utils::syncParentDirectory(path);
+
+    struct stat st;
+    fstat(out, &st);
+    close(fd);
+    fd = out;
+    fileBytes = st.st_size;
+    rewriteBaseBytes = fileBytes;
+    rewrites++;
+
+    // Everything appended so far is in the new file, synced
+    buffer.clear();
+    writtenBytes = appendedBytes;
+    syncedBytes = appendedBytes;
+    Utils::logMessage("AOF: rewrite done, " + path + " is now " + Utils::formatMemorySize(fileBytes));
+    return true;
+}
+
+void AppendOnlyFile::cron(const Cache& cache) {
+    if (rewritePid != -1) {
+        int status;
+        pid_t done = waitpid(rewritePid, &status, WNOHANG);
+        if (done == 0) {
+            return;
+        }
+        bool ok = done == rewritePid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        rewritePid = -1;
+
+        lock_guard<mutex> guard(lock);
+        if (ok) {
+            rewriteReady = true;
+            wake.notify_one();
+        } else {
+            Utils::logMessage("AOF: background rewrite failed");
+            rewriteTee = false;
+            string().swap(rewriteBuffer);
+            unlink(rewritePath().c_str());
+        }
+        return;
+    }
+
+    if (autoRewritePercentage <= 0) {
+        return;
+    }
+    size_t size, base;
+    {
+        lock_guard<mutex> guard(lock);
+        if (rewriteTee) return;
+        size = fileBytes;
+        base = rewriteBaseBytes;
+    }
+    if (size >= autoRewriteMinBytes && size >= base + base * autoRewritePercentage / 100) {
+        Utils::logMessage("AOF: " + Utils::formatMemorySize(size) + " log has grown past " +
+                          to_string(autoRewritePercentage) + "% of " + Utils::formatMemorySize(base) + ", rewriting");
+        startRewrite(cache);
+    }
+}
+
+bool AppendOnlyFile::isRewriting() {
+    lock_guard<mutex> guard(lock);
+    return rewriteTee;
+}
+
+AOFStats AppendOnlyFile::getStats() {
+    lock_guard<mutex> guard(lock);
+    AOFStats stats;
+    stats.policy = policy;
+    stats.fileBytes = fileBytes;
+    stats.bufferedBytes = appendedBytes - writtenBytes;
+    stats.unsyncedBytes = writtenBytes - syncedBytes;
+    stats.fsyncs = fsyncs;
+    stats.writeErrors = writeErrors;
+    stats.rewriteInProgress = rewriteTee;
+    stats.rewrites = rewrites;
+    stats.rewriteBaseBytes = rewriteBaseBytes;
+    return stats;
+}
+
+void AppendOnlyFile::printStats(const AOFStats& stats, ostream& out) {
+    out << "=== PERSISTENCE ===\n";
+    out << "AOF Size: " << Utils::formatMemorySize(stats.fileBytes)
+        << " (fsync " << fsyncPolicyName(stats.policy) << ")\n";
+    out << "  Buffered: " << Utils::formatMemorySize(stats.bufferedBytes) << "\n";
+    out << "  Not Synced: " << Utils::formatMemorySize(stats.unsyncedBytes) << "\n";
+    out << "  Fsyncs: " << stats.fsyncs << "\n";
+    out << "  Write Errors: " << stats.writeErrors << "\n";
+    out << "  Rewrites: " << stats.rewrites << (stats.rewriteInProgress ? " (one in progress)" : "")
+        << ", size after last: " << Utils::formatMemorySize(stats.rewriteBaseBytes) << "\n";
+    out << "========================\n\n";
+}
@@ -0,0 +1,50 @@
+#include "../include/ApproximateLRU.hpp"
+
+using namespace std;
+
+HashNode* ClockPolicy::victim(const HashNode* keep) {
+    // The first sweep may only clear bits; the second then finds one clear
+    size_t slots = table.slotCount();
+    for (size_t step = 0; step < 2 * slots; step++) {
+        hand = hand + 1 < slots ? hand + 1 : 0;
+        HashNode* node = table.slotNode(hand);
+        if (!node || node == keep) continue;
+        
+        if (node->evictionState) {
+            node->evictionState = 0;
+            continue;
+        }
+        return node;
+    }
+    return nullptr;
+}
+
+HashNode* SlotSampler::sample(const HashNode* keep) {
+    size_t slots = table.slotCount();
+    size_t position = random() % slots;
+    for (size_t step = 0; step < slots; step++) {
+        HashNode* node = table.slotNode(position);
+        if (node && node != keep) {
+            return node;
+        }
+        position = position + 1 < slots ? position + 1 : 0;
+    }
+    return nullptr;
+}
+
+HashNode* SampledLRUPolicy::victim(const HashNode* keep) {
+    HashNode* oldest = nullptr;
+    uint32_t oldestAge = 0;
+    for (size_t i = 0; i < samples; i++) {
+        HashNode* node = sampler.sample(keep);
+        if (!node) break;
+        
+        // Unsigned distance, so the tick may wrap
+        uint32_t age = tick - node->evictionState;
+        if (!oldest || age > oldestAge) {
+            oldest = node;
+            oldestAge = age;
+        }
+    }
+    return oldest;
+}
@@ -1,163 +1,1032 @@
 #include "../include/Cache.hpp"
 #include "../include/utils.hpp"
 #include <iostream>
+#include <iomanip>
 #include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cmath>
 
 using namespace std;
 
-Cache::Cache(size_t maxMem, size_t maxKeysLimit) 
-    : maxMemoryBytes(maxMem), currentMemoryBytes(0), maxKeys(maxKeysLimit), totalOperations(0) {
+Cache::Cache(size_t maxMem, size_t maxKeysLimit, EvictionType evictionType) 
+    : maxMemoryBytes(maxMem), maxKeys(maxKeysLimit), entryBytes(0), valueBytes(0),
+      clockMs(Utils::monotonicMillis()), clockPinned(false), totalOperations(0),
+      expiredKeys(0), evictedKeys(0), expireCycles(0), lastCycleExpired(0), lastCycleMicros(0),
+      totalCycleMicros(0), keyspaceHits(0), keyspaceMisses(0) {
     
     hashTable = new HashTable();
-    lruCache = new LRUCache(maxKeys);
-    ttlManager = new TTLManager();
+    eviction = createEvictionPolicy(evictionType, *hashTable, maxKeys);
+    ttlManager = new TTLManager(clockMs);
     startTime = chrono::high_resolution_clock::now();
 }
 
 Cache::~Cache() {
-    delete hashTable;
-    delete lruCache;
+    // The eviction policy and TTL wheel point into nodes owned by the table
+    delete eviction;
     delete ttlManager;
+    delete hashTable;
 }
 
-void Cache::cleanupExpiredKeys() {
-    long long currentTime = Utils::getCurrentTimestamp();
-    vector<string> expiredKeys = hashTable->getExpiredKeys(currentTime);
+// Looks up a key, lazily deleting it if its TTL has passed
+HashNode* Cache::lookupKey(string_view key, size_t h) {
+    HashNode* node = hashTable->find(key, h);
+    if (!node) {
+        return nullptr;
+    }
+    
+    if (node->expiryTime != -1 && clockMs > node->expiryTime) {
+        removeKey(node);
+        expiredKeys++;
+        return nullptr;
+    }
     
-    for (const string& key : expiredKeys) {
-        string value;
-        if (hashTable->get(key, value)) {
-            currentMemoryBytes -= estimateKeyMemory(key, value);
+    return node;
+}
+
+void Cache::removeKey(HashNode* node) {
+    entryBytes -= entryMemory(node);
+    valueBytes -= node->value.memoryUsage();
+    eviction->remove(node);
+    ttlManager->cancel(node);
+    hashTable->erase(node);
+}
+
+void Cache::setClock(long long nowMs) {
+    clockMs = nowMs;
+    clockPinned = true;
+}
+
+// Every command starts here, so this is where an unpinned clock is read
+void Cache::activeExpireCycle(size_t keyLimit, long long budgetMicros) {
+    if (!clockPinned) {
+        clockMs = Utils::monotonicMillis();
+    }
+    long long currentTime = clockMs;
+    if (!ttlManager->hasExpired(currentTime)) {
+        return;
+    }
+    
+    auto cycleStart = chrono::steady_clock::now();
+    size_t expired = 0;
+    
+    while (expired < keyLimit) {
+        HashNode* node = ttlManager->popExpired(currentTime);
+        if (!node) break;
+        
+        removeKey(node);
+        expired++;
+        
+        if ((expired & 15) == 0 &&
+            chrono::steady_clock::now() - cycleStart >= chrono::microseconds(budgetMicros)) {
+            break;
         }
-        hashTable->remove(key);
-        lruCache->remove(key);
     }
     
-    ttlManager->removeExpiredKeys(currentTime);
+    auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - cycleStart);
+    expiredKeys += expired;
+    expireCycles++;
+    lastCycleExpired = expired;
+    lastCycleMicros = elapsed.count();
+    totalCycleMicros += lastCycleMicros;
+}
+
+// Evicts the policy's victims until back under the limits, sparing the key
+// that is being written
+void Cache::evictIfNeeded(const HashNode* keep) {
+    while (getMemoryUsage() > maxMemoryBytes || hashTable->size() > maxKeys) {
+        HashNode* victim = eviction->victim(keep);
+        if (!victim) break;
+        
+        removeKey(victim);
+        evictedKeys++;
+    }
+}
+
+// Everything the cache holds from the heap: slab chunks in use (values
+// pinned by readers included), large allocations, adopted buffers, the index
+// arrays and the TTL wheel. Free chunks in pages already reserved are not
+// counted; they are reused before another page is taken.
+size_t Cache::getMemoryUsage() const {
+    const SlabAllocator& slabs = hashTable->allocator();
+    return slabs.usedBytes() + slabs.getExternalBytes() + hashTable->memoryUsage() + ttlManager->memoryUsage()
+         + eviction->memoryUsage();
+}
+
+// The slab chunk holding a key's entry, key included
+size_t Cache::entryMemory(const HashNode* node) const {
+    return hashTable->allocator().chunkSize(node->allocSize());
+}
+
+void Cache::setKey(string_view key, size_t h, ValueRef value, long long ttlMs) {
+    bool created;
+    HashNode* node = hashTable->upsert(key, h, created);
+    if (created) {
+        entryBytes += entryMemory(node);
+    } else {
+        valueBytes -= node->value.memoryUsage();
+    }
+    
+    node->value = move(value);
+    valueBytes += node->value.memoryUsage();
+    
+    // Set expiry time
+    if (ttlMs > 0) {
+        node->expiryTime = clockMs + ttlMs;
+        ttlManager->schedule(node);
+    } else {
+        node->expiryTime = -1;
+        ttlManager->cancel(node);
+    }
+    
+    if (created) {
+        eviction->insert(node);
+    } else {
+        eviction->access(node);
+    }
+    
+    // Evict if necessary
+    evictIfNeeded(node);
 }
 
-void Cache::evictIfNeeded() {
-    while ((currentMemoryBytes > maxMemoryBytes || lruCache->isFull()) && lruCache->size() > 0) {
-        string evictedKey = lruCache->evictLRU();
-        if (!evictedKey.empty()) {
-            string value;
-            if (hashTable->get(evictedKey, value)) {
-                currentMemoryBytes -= estimateKeyMemory(evictedKey, value);
-            }
-            hashTable->remove(evictedKey);
+void Cache::reserve(size_t count) {
+    // Expiry times of loaded keys are relative to the clock
+    if (!clockPinned) {
+        clockMs = Utils::monotonicMillis();
+    }
+    hashTable->reserve(hashTable->size() + count);
+}
+
+void Cache::loadKey(string_view key, string_view value, long long ttlMs, ValueType type) {
+    loadKey(key, HashTable::hashKey(key), value, ttlMs, type);
+}
+
+void Cache::loadKeys(const LoadEntry* entries, size_t count) {
+    batchHashes.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        batchHashes[i] = HashTable::hashKey(entries[i].key);
+    }
+    for (size_t i = 0; i < count && i < BATCH_PREFETCH_DISTANCE; i++) {
+        hashTable->prefetch(batchHashes[i]);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (i + BATCH_PREFETCH_DISTANCE < count) {
+            hashTable->prefetch(batchHashes[i + BATCH_PREFETCH_DISTANCE]);
         }
+        loadKey(entries[i].key, batchHashes[i], entries[i].value, entries[i].ttlMs, entries[i].type);
+    }
+}
+
+void Cache::loadKey(string_view key, size_t h, string_view value, long long ttlMs, ValueType type) {
+    SlabAllocator* slabs = &hashTable->allocator();
+    HashNode* node = hashTable->insertUnique(key, h);
+    entryBytes += entryMemory(node);
+    switch (type) {
+        case ValueType::HASH:
+            node->value = ValueRef::make<HashValue>(slabs, slabs, value);
+            break;
+        case ValueType::ZSET:
+            node->value = ValueRef::make<ZSetValue>(slabs, slabs, value);
+            break;
+        case ValueType::LIST:
+            node->value = ValueRef::make<ListValue>(slabs, slabs, value);
+            break;
+        case ValueType::SET:
+            node->value = ValueRef::make<SetValue>(slabs, slabs, value);
+            break;
+        default:
+            node->value = ValueRef::copyOf(value, slabs);
+            break;
+    }
+    valueBytes += node->value.memoryUsage();
+    
+    if (ttlMs >= 0) {
+        node->expiryTime = clockMs + ttlMs;
+        ttlManager->schedule(node);
+    }
+    eviction->insert(node);
+    evictIfNeeded(node);
+}
+
+bool Cache::set(string_view key, string_view value, int ttlSeconds) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    setKey(key, HashTable::hashKey(key), ValueRef::copyOf(value, &hashTable->allocator()), ttlSeconds * 1000LL);
+    return true;
+}
+
+bool Cache::set(string_view key, string&& value, int ttlSeconds) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    setKey(key, HashTable::hashKey(key), ValueRef::adopt(move(value), &hashTable->allocator()), ttlSeconds * 1000LL);
+    return true;
+}
+
+bool Cache::psetex(string_view key, string_view value, long long ttlMs) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    setKey(key, HashTable::hashKey(key), ValueRef::copyOf(value, &hashTable->allocator()), ttlMs);
+    return true;
+}
+
+bool Cache::psetex(string_view key, string&& value, long long ttlMs) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    setKey(key, HashTable::hashKey(key), ValueRef::adopt(move(value), &hashTable->allocator()), ttlMs);
+    return true;
+}
+
+// Copies without pinning, see HashTable::get
+bool Cache::get(string_view key, string& value) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    Result result;
+    HashNode* node = readKey(key, ValueType::STRING, result);
+    if (!node) {
+        return false;
     }
+    char digits[ValueRef::MAX_DIGITS];
+    value.assign(node->value.view(digits));
+    return true;
 }
 
-size_t Cache::estimateKeyMemory(const string& key, const string& value) const {
-    return key.size() + value.size() + sizeof(HashNode) + sizeof(LRUNode);
+bool Cache::get(string_view key, ValueRef& value) {
+    return getString(key, value) == OK;
 }
 
-bool Cache::set(const string& key, const string& value, int ttlSeconds) {
+Cache::Result Cache::getString(string_view key, ValueRef& value) {
     totalOperations++;
-    cleanupExpiredKeys();
+    activeExpireCycle();
     
-    // Calculate memory needed
-    size_t memoryNeeded = estimateKeyMemory(key, value);
+    Result result;
+    HashNode* node = readKey(key, ValueType::STRING, result);
+    if (node) {
+        value = node->value;
+    }
+    return result;
+}
+
+Cache::Result Cache::incrby(string_view key, long long increment, long long& value) {
+    totalOperations++;
+    activeExpireCycle();
     
-    // Check if key already exists
-    string oldValue;
-    bool keyExists = hashTable->get(key, oldValue);
-    if (keyExists) {
-        currentMemoryBytes -= estimateKeyMemory(key, oldValue);
+    size_t h = HashTable::hashKey(key);
+    HashNode* node = lookupKey(key, h);
+    long long current = 0;
+    if (node) {
+        if (node->value.type() != ValueType::STRING) {
+            return WRONG_TYPE;
+        }
+        // Parsed only for a string INCR has not rewritten yet
+        if (node->value.isInteger()) {
+            current = node->value.integer();
+        } else if (!Utils::parseCanonicalInteger(node->value.view(), current)) {
+            return NOT_INTEGER;
+        }
+    }
+    if ((increment > 0 && current > LLONG_MAX - increment) || (increment < 0 && current < LLONG_MIN - increment)) {
+        return OUT_OF_RANGE;
     }
     
-    // Add memory for new value
-    currentMemoryBytes += memoryNeeded;
+    value = current + increment;
+    SlabAllocator* slabs = &hashTable->allocator();
+    if (!node) {
+        setKey(key, h, ValueRef::fromInteger(value, slabs), -1);
+        return OK;
+    }
+    size_t oldBytes = node->value.memoryUsage();
+    node->value = ValueRef::fromInteger(value, slabs);
+    valueChanged(node, oldBytes, false);
+    return OK;
+}
+
+Cache::Result Cache::incrbyfloat(string_view key, double increment, double& value, long long& ttlMs) {
+    totalOperations++;
+    activeExpireCycle();
     
-    // Evict if necessary
-    evictIfNeeded();
+    size_t h = HashTable::hashKey(key);
+    HashNode* node = lookupKey(key, h);
+    double current = 0;
+    if (node) {
+        if (node->value.type() != ValueType::STRING) {
+            return WRONG_TYPE;
+        }
+        if (node->value.isInteger()) {
+            current = static_cast<double>(node->value.integer());
+        } else if (!Utils::parseDouble(node->value.view(), current)) {
+            return NOT_A_NUMBER;
+        }
+    }
+    value = current + increment;
+    if (!isfinite(value)) {
+        return OUT_OF_RANGE;
+    }
     
-    // Set expiry time
-    long long expiryTime = -1;
-    if (ttlSeconds > 0) {
-        expiryTime = Utils::getCurrentTimestamp() + ttlSeconds;
-        ttlManager->addKey(key, expiryTime);
+    // Stored as text, unless the sum is a whole number copyOf keeps inline
+    ValueRef stored = ValueRef::copyOf(Utils::formatDouble(value), &hashTable->allocator());
+    if (!node) {
+        setKey(key, h, move(stored), -1);
+        ttlMs = -1;
+        return OK;
+    }
+    ttlMs = node->expiryTime == -1 ? -1 : node->expiryTime - clockMs;
+    size_t oldBytes = node->value.memoryUsage();
+    node->value = move(stored);
+    valueChanged(node, oldBytes, false);
+    return OK;
+}
+
+HashNode* Cache::readKey(string_view key, ValueType type, Result& result) {
+    HashNode* node = lookupKey(key);
+    if (!node) {
+        keyspaceMisses++;
+        result = NOT_FOUND;
+        return nullptr;
     }
     
-    // Insert/update in hash table
-    bool success = hashTable->insert(key, value, expiryTime);
+    eviction->access(node);
+    keyspaceHits++;
+    if (node->value.type() != type) {
+        result = WRONG_TYPE;
+        return nullptr;
+    }
+    result = OK;
+    return node;
+}
+
+template <typename T>
+HashNode* Cache::writeKey(string_view key, Result& result, bool& created) {
+    size_t h = HashTable::hashKey(key);
+    HashNode* node = lookupKey(key, h);
+    created = node == nullptr;
+    if (created) {
+        SlabAllocator* slabs = &hashTable->allocator();
+        node = hashTable->upsert(key, h, created);
+        entryBytes += entryMemory(node);
+        node->value = ValueRef::make<T>(slabs, slabs);
+        valueBytes += node->value.memoryUsage();
+        eviction->insert(node);
+    } else if (node->value.type() != T::TYPE) {
+        result = WRONG_TYPE;
+        return nullptr;
+    }
+    result = OK;
+    return node;
+}
+
+// After a change to a compound value: oldBytes is what it used before
+void Cache::valueChanged(HashNode* node, size_t oldBytes, bool created) {
+    valueBytes += node->value.memoryUsage() - oldBytes;
+    if (!created) {
+        eviction->access(node);
+    }
+    evictIfNeeded(node);
+}
+
+bool Cache::type(string_view key, ValueType& type) {
+    totalOperations++;
+    activeExpireCycle();
     
-    if (success) {
-        // Update LRU
-        lruCache->access(key);
-        return true;
+    HashNode* node = lookupKey(key);
+    if (node) {
+        type = node->value.type();
     }
+    return node != nullptr;
+}
+
+const char* Cache::encoding(string_view key) {
+    totalOperations++;
+    activeExpireCycle();
     
-    return false;
+    HashNode* node = lookupKey(key);
+    return node ? node->value.encoding() : nullptr;
 }
 
-bool Cache::get(const string& key, string& value) {
+const HashValue* Cache::readHash(string_view key, Result& result) {
     totalOperations++;
-    cleanupExpiredKeys();
+    activeExpireCycle();
     
-    if (hashTable->get(key, value)) {
-        lruCache->access(key);
-        return true;
+    HashNode* node = readKey(key, ValueType::HASH, result);
+    return node ? static_cast<const HashValue*>(node->value.compound()) : nullptr;
+}
+
+Cache::Result Cache::hset(string_view key, const string_view* fieldsAndValues, size_t pairCount, size_t& added) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    Result result;
+    bool created;
+    HashNode* node = writeKey<HashValue>(key, result, created);
+    if (!node) {
+        return result;
     }
     
-    return false;
+    HashValue* hash = static_cast<HashValue*>(node->value.compound());
+    size_t oldBytes = node->value.memoryUsage();
+    added = 0;
+    for (size_t i = 0; i < pairCount; i++) {
+        added += hash->set(fieldsAndValues[2 * i], fieldsAndValues[2 * i + 1]);
+    }
+    valueChanged(node, oldBytes, created);
+    return OK;
+}
+
+Cache::Result Cache::hdel(string_view key, const string_view* fields, size_t count, size_t& removed) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    removed = 0;
+    HashNode* node = lookupKey(key);
+    if (!node) {
+        return NOT_FOUND;
+    }
+    if (node->value.type() != ValueType::HASH) {
+        return WRONG_TYPE;
+    }
+    
+    HashValue* hash = static_cast<HashValue*>(node->value.compound());
+    size_t oldBytes = node->value.memoryUsage();
+    for (size_t i = 0; i < count; i++) {
+        removed += hash->remove(fields[i]);
+    }
+    if (hash->size() == 0) {
+        // Settle what the removals freed; the rest goes with the key
+        valueBytes -= oldBytes - node->value.memoryUsage();
+        removeKey(node);
+    } else {
+        valueChanged(node, oldBytes, false);
+    }
+    return OK;
+}
+
+Cache::Result Cache::hincrby(string_view key, string_view field, long long increment, long long& value) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    Result result;
+    bool created;
+    HashNode* node = writeKey<HashValue>(key, result, created);
+    if (!node) {
+        return result;
+    }
+    
+    // A new key has no fields, so neither check below can fail for it
+    HashValue* hash = static_cast<HashValue*>(node->value.compound());
+    long long current = 0;
+    string_view text;
+    if (hash->get(field, text) && !Utils::parseInteger(text, current)) {
+        return NOT_INTEGER;
+    }
+    if ((increment > 0 && current > LLONG_MAX - increment) || (increment < 0 && current < LLONG_MIN - increment)) {
+        return OUT_OF_RANGE;
+    }
+    
+    value = current + increment;
+    char digits[24];
+    char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+    size_t oldBytes = node->value.memoryUsage();
+    hash->set(field, string_view(digits, end - digits));
+    valueChanged(node, oldBytes, created);
+    return OK;
+}
+
+const ZSetValue* Cache::readZSet(string_view key, Result& result) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    HashNode* node = readKey(key, ValueType::ZSET, result);
+    return node ? static_cast<const ZSetValue*>(node->value.compound()) : nullptr;
 }
 
-bool Cache::del(const string& key) {
+Cache::Result Cache::zadd(string_view key, const double* scores, const string_view* members, size_t count,
+                          uint32_t flags, size_t& added, size_t& updated, double& score) {
     totalOperations++;
-    cleanupExpiredKeys();
+    activeExpireCycle();
     
+    added = 0;
+    updated = 0;
+    score = NAN;
+    Result result;
+    bool created;
+    HashNode* node = writeKey<ZSetValue>(key, result, created);
+    if (!node) {
+        return result;
+    }
+    
+    ZSetValue* zset = static_cast<ZSetValue*>(node->value.compound());
+    size_t oldBytes = node->value.memoryUsage();
+    for (size_t i = 0; i < count; i++) {
+        double newScore = NAN;
+        switch (zset->add(members[i], scores[i], flags, newScore)) {
+            case ZSetValue::ADDED:
+                added++;
+                break;
+            case ZSetValue::UPDATED:
+                updated++;
+                break;
+            case ZSetValue::NOT_A_NUMBER:
+                result = NOT_A_NUMBER;
+                break;
+            default:
+                break;
+        }
+        score = newScore;
+    }
+    if (zset->size() == 0) {
+        // Only XX or NX can leave a new key empty
+        valueBytes -= oldBytes - node->value.memoryUsage();
+        removeKey(node);
+    } else {
+        valueChanged(node, oldBytes, created);
+    }
+    return result;
+}
+
+Cache::Result Cache::zrem(string_view key, const string_view* members, size_t count, size_t& removed) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    removed = 0;
+    HashNode* node = lookupKey(key);
+    if (!node) {
+        return NOT_FOUND;
+    }
+    if (node->value.type() != ValueType::ZSET) {
+        return WRONG_TYPE;
+    }
+    
+    ZSetValue* zset = static_cast<ZSetValue*>(node->value.compound());
+    size_t oldBytes = node->value.memoryUsage();
+    for (size_t i = 0; i < count; i++) {
+        removed += zset->remove(members[i]);
+    }
+    if (zset->size() == 0) {
+        valueBytes -= oldBytes - node->value.memoryUsage();
+        removeKey(node);
+    } else {
+        valueChanged(node, oldBytes, false);
+    }
+    return OK;
+}
+
+const ListValue* Cache::readList(string_view key, Result& result) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    HashNode* node = readKey(key, ValueType::LIST, result);
+    return node ? static_cast<const ListValue*>(node->value.compound()) : nullptr;
+}
+
+Cache::Result Cache::push(string_view key, const string_view* values, size_t count, bool front, size_t& length) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    Result result;
+    bool created;
+    HashNode* node = writeKey<ListValue>(key, result, created);
+    if (!node) {
+        return result;
+    }
+    
+    ListValue* list = static_cast<ListValue*>(node->value.compound());
+    size_t oldBytes = node->value.memoryUsage();
+    for (size_t i = 0; i < count; i++) {
+        list->push(values[i], front);
+    }
+    length = list->size();
+    valueChanged(node, oldBytes, created);
+    return OK;
+}
+
+Cache::Result Cache::pop(string_view key, bool front, size_t count, vector<string>& values) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    values.clear();
+    Result result;
+    HashNode* node = readKey(key, ValueType::LIST, result);
+    if (!node) {
+        return result;
+    }
+    
+    ListValue* list = static_cast<ListValue*>(node->value.compound());
+    size_t oldBytes = node->value.memoryUsage();
     string value;
-    if (hashTable->get(key, value)) {
-        currentMemoryBytes -= estimateKeyMemory(key, value);
-        hashTable->remove(key);
-        lruCache->remove(key);
+    while (values.size() < count && list->pop(front, value)) {
+        values.push_back(move(value));
+    }
+    if (list->size() == 0) {
+        valueBytes -= oldBytes - node->value.memoryUsage();
+        removeKey(node);
+    } else {
+        valueChanged(node, oldBytes, false);
+    }
+    return OK;
+}
+
+const SetValue* Cache::readSet(string_view key, Result& result) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    HashNode* node = readKey(key, ValueType::SET, result);
+    return node ? static_cast<const SetValue*>(node->value.compound()) : nullptr;
+}
+
+// One expiry cycle for all keys, so none of the sets returned can expire
+// before the caller is done with them
+Cache::Result Cache::readSets(const string_view* keys, size_t count, vector<const SetValue*>& sets) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    sets.assign(count, nullptr);
+    for (size_t i = 0; i < count; i++) {
+        Result result;
+        HashNode* node = readKey(keys[i], ValueType::SET, result);
+        if (result == WRONG_TYPE) {
+            return WRONG_TYPE;
+        }
+        if (node) {
+            sets[i] = static_cast<const SetValue*>(node->value.compound());
+        }
+    }
+    return OK;
+}
+
+Cache::Result Cache::sadd(string_view key, const string_view* members, size_t count, size_t& added) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    Result result;
+    bool created;
+    HashNode* node = writeKey<SetValue>(key, result, created);
+    if (!node) {
+        return result;
+    }
+    
+    SetValue* set = static_cast<SetValue*>(node->value.compound());
+    size_t oldBytes = node->value.memoryUsage();
+    added = 0;
+    for (size_t i = 0; i < count; i++) {
+        added += set->add(members[i]);
+    }
+    valueChanged(node, oldBytes, created);
+    return OK;
+}
+
+Cache::Result Cache::srem(string_view key, const string_view* members, size_t count, size_t& removed) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    removed = 0;
+    HashNode* node = lookupKey(key);
+    if (!node) {
+        return NOT_FOUND;
+    }
+    if (node->value.type() != ValueType::SET) {
+        return WRONG_TYPE;
+    }
+    
+    SetValue* set = static_cast<SetValue*>(node->value.compound());
+    size_t oldBytes = node->value.memoryUsage();
+    for (size_t i = 0; i < count; i++) {
+        removed += set->remove(members[i]);
+    }
+    if (set->size() == 0) {
+        valueBytes -= oldBytes - node->value.memoryUsage();
+        removeKey(node);
+    } else {
+        valueChanged(node, oldBytes, false);
+    }
+    return OK;
+}
+
+bool Cache::del(string_view key) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    HashNode* node = lookupKey(key);
+    if (node) {
+        removeKey(node);
         return true;
     }
     
     return false;
 }
 
-bool Cache::exists(const string& key) {
+bool Cache::exists(string_view key) {
     totalOperations++;
-    cleanupExpiredKeys();
-    return hashTable->exists(key);
+    activeExpireCycle();
+    return lookupKey(key) != nullptr;
+}
+
+bool Cache::expire(string_view key, int seconds) {
+    return pexpire(key, seconds * 1000LL);
 }
 
-bool Cache::expire(const string& key, int seconds) {
+bool Cache::pexpire(string_view key, long long ms) {
     totalOperations++;
-    cleanupExpiredKeys();
+    activeExpireCycle();
     
-    if (!hashTable->exists(key)) {
+    HashNode* node = lookupKey(key);
+    if (!node) {
         return false;
     }
     
-    long long expiryTime = Utils::getCurrentTimestamp() + seconds;
-    ttlManager->addKey(key, expiryTime);
-    return hashTable->updateExpiry(key, expiryTime);
+    node->expiryTime = clockMs + ms;
+    ttlManager->schedule(node);
+    return true;
+}
+
+long long Cache::pttl(string_view key) {
+    totalOperations++;
+    activeExpireCycle();
+    
+    HashNode* node = lookupKey(key);
+    if (!node) {
+        return -2;
+    }
+    if (node->expiryTime == -1) {
+        return -1;
+    }
+    return node->expiryTime - clockMs;
+}
+
+long long Cache::ttl(string_view key) {
+    long long ms = pttl(key);
+    return ms < 0 ? ms : (ms + 500) / 1000;
+}
+
+// Hashes every stride-th string starting at keys into batchHashes
+template <typename Key>
+void Cache::hashBatch(const Key* keys, size_t count, size_t stride) {
+    batchHashes.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        batchHashes[i] = HashTable::hashKey(keys[i * stride]);
+    }
+    for (size_t i = 0; i < count && i < BATCH_PREFETCH_DISTANCE; i++) {
+        hashTable->prefetch(batchHashes[i]);
+    }
+}
+
+template <typename Key>
+void Cache::mgetKeys(const Key* keys, size_t count, vector<ValueRef>& values) {
+    totalOperations += count;
+    activeExpireCycle();
+    
+    values.assign(count, nullptr);
+    hashBatch(keys, count, 1);
+    
+    for (size_t i = 0; i < count; i++) {
+        if (i + BATCH_PREFETCH_DISTANCE < count) {
+            hashTable->prefetch(batchHashes[i + BATCH_PREFETCH_DISTANCE]);
+        }
+        
+        HashNode* node = lookupKey(keys[i], batchHashes[i]);
+        if (node && node->value.type() == ValueType::STRING) {
+            values[i] = node->value;
+            eviction->access(node);
+            keyspaceHits++;
+        } else {
+            keyspaceMisses++;
+        }
+    }
+}
+
+template <typename Key>
+void Cache::msetKeys(const Key* keysAndValues, size_t pairCount, int ttlSeconds) {
+    totalOperations += pairCount;
+    activeExpireCycle();
+    
+    hashBatch(keysAndValues, pairCount, 2);
+    
+    for (size_t i = 0; i < pairCount; i++) {
+        if (i + BATCH_PREFETCH_DISTANCE < pairCount) {
+            hashTable->prefetch(batchHashes[i + BATCH_PREFETCH_DISTANCE]);
+        }
+        setKey(keysAndValues[2 * i], batchHashes[i], ValueRef::copyOf(keysAndValues[2 * i + 1], &hashTable->allocator()),
+               ttlSeconds * 1000LL);
+    }
+}
+
+template <typename Key>
+size_t Cache::mdelKeys(const Key* keys, size_t count) {
+    totalOperations += count;
+    activeExpireCycle();
+    
+    hashBatch(keys, count, 1);
+    size_t deleted = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        if (i + BATCH_PREFETCH_DISTANCE < count) {
+            hashTable->prefetch(batchHashes[i + BATCH_PREFETCH_DISTANCE]);
+        }
+        
+        HashNode* node = lookupKey(keys[i], batchHashes[i]);
+        if (node) {
+            removeKey(node);
+            deleted++;
+        }
+    }
+    
+    return deleted;
+}
+
+void Cache::mget(const string* keys, size_t count, vector<ValueRef>& values) {
+    mgetKeys(keys, count, values);
+}
+
+void Cache::mget(const string_view* keys, size_t count, vector<ValueRef>& values) {
+    mgetKeys(keys, count, values);
+}
+
+void Cache::mset(const string* keysAndValues, size_t pairCount, int ttlSeconds) {
+    msetKeys(keysAndValues, pairCount, ttlSeconds);
+}
+
+void Cache::mset(const string_view* keysAndValues, size_t pairCount, int ttlSeconds) {
+    msetKeys(keysAndValues, pairCount, ttlSeconds);
+}
+
+size_t Cache::mdel(const string* keys, size_t count) {
+    return mdelKeys(keys, count);
+}
+
+size_t Cache::mdel(const string_view* keys, size_t count) {
+    return mdelKeys(keys, count);
 }
 
 void Cache::flush() {
     totalOperations++;
     
-    hashTable->clear();
-    lruCache->clear();
+    eviction->clear();
     ttlManager->clear();
-    currentMemoryBytes = 0;
+    hashTable->clear();
+    entryBytes = 0;
+    valueBytes = 0;
+}
+
+void Cache::forEachEntry(const function<void(string_view, const ValueRef&, long long)>& visit,
+                         size_t part, size_t parts) const {
+    long long now = Utils::monotonicMillis();
+    size_t slots = hashTable->slotCount();
+    size_t end = slots * (part + 1) / parts;
+    for (size_t i = slots * part / parts; i < end; i++) {
+        const HashNode* node = hashTable->slotNode(i);
+        if (!node) continue;
+        if (node->expiryTime != -1 && now > node->expiryTime) continue;
+        visit(node->key(), node->value, node->expiryTime == -1 ? -1 : node->expiryTime - now);
+    }
+}
+
+void CacheStats::merge(const CacheStats& other) {
+    keys += other.keys;
+    memoryBytes += other.memoryBytes;
+    maxMemoryBytes += other.maxMemoryBytes;
+    keyBytes += other.keyBytes;
+    valueBytes += other.valueBytes;
+    indexBytes += other.indexBytes;
+    evictionBytes += other.evictionBytes;
+    ttlBytes += other.ttlBytes;
+    pinnedBytes += other.pinnedBytes;
+    fragmentationBytes += other.fragmentationBytes;
+    totalOperations += other.totalOperations;
+    opsPerSecond += other.opsPerSecond;
+    evictionPolicy = other.evictionPolicy;
+    trackedKeys += other.trackedKeys;
+    maxKeys += other.maxKeys;
+    ttlEntries += other.ttlEntries;
+    evictedKeys += other.evictedKeys;
+    expiredKeys += other.expiredKeys;
+    expireCycles += other.expireCycles;
+    lastCycleExpired += other.lastCycleExpired;
+    lastCycleMicros = max(lastCycleMicros, other.lastCycleMicros);
+    totalCycleMicros += other.totalCycleMicros;
+    keyspaceHits += other.keyspaceHits;
+    keyspaceMisses += other.keyspaceMisses;
+    resizes += other.resizes;
+    lastResizeMicros = max(lastResizeMicros, other.lastResizeMicros);
+    maxResizeMicros = max(maxResizeMicros, other.maxResizeMicros);
+    totalResizeMicros += other.totalResizeMicros;
+    slabPageBytes += other.slabPageBytes;
+    slabUsedBytes += other.slabUsedBytes;
+}
+
+CacheStats Cache::getStats() const {
+    CacheStats stats;
+    stats.keys = getKeyCount();
+    stats.memoryBytes = getMemoryUsage();
+    stats.maxMemoryBytes = maxMemoryBytes;
+    
+    const SlabAllocator& slabs = hashTable->allocator();
+    size_t heldBytes = slabs.usedBytes() + slabs.getExternalBytes();
+    size_t linkBytes = getKeyCount() * 2 * sizeof(HashNode*);
+    stats.evictionBytes = linkBytes + eviction->memoryUsage();
+    stats.keyBytes = entryBytes - linkBytes;
+    stats.valueBytes = valueBytes;
+    stats.indexBytes = hashTable->memoryUsage();
+    stats.ttlBytes = ttlManager->memoryUsage();
+    stats.pinnedBytes = heldBytes > entryBytes + valueBytes ? heldBytes - (entryBytes + valueBytes) : 0;
+    stats.fragmentationBytes = slabs.pageBytes() - slabs.requestedBytes();
+    stats.totalOperations = totalOperations;
+    stats.opsPerSecond = getOpsPerSecond();
+    stats.evictionPolicy = eviction->name();
+    stats.trackedKeys = eviction->size();
+    stats.maxKeys = maxKeys;
+    stats.ttlEntries = ttlManager->size();
+    stats.evictedKeys = evictedKeys;
+    stats.expiredKeys = expiredKeys;
+    stats.expireCycles = expireCycles;
+    stats.lastCycleExpired = lastCycleExpired;
+    stats.lastCycleMicros = lastCycleMicros;
+    stats.totalCycleMicros = totalCycleMicros;
+    stats.keyspaceHits = keyspaceHits;
+    stats.keyspaceMisses = keyspaceMisses;
+    const ResizeStats& resize = hashTable->getResizeStats();
+    stats.resizes = resize.resizes;
+    stats.lastResizeMicros = resize.lastMicros;
+    stats.maxResizeMicros = resize.maxMicros;
+    stats.totalResizeMicros = resize.totalMicros;
+    stats.slabPageBytes = slabs.pageBytes();
+    stats.slabUsedBytes = slabs.usedBytes();
+    return stats;
 }
 
 void Cache::showStats() const {
-    cout << "\n=== CACHE STATISTICS ===" << endl;
-    cout << "Total Keys: " << getKeyCount() << endl;
-    cout << "Memory Usage: " << Utils::formatMemorySize(currentMemoryBytes) 
-         << " / " << Utils::formatMemorySize(maxMemoryBytes) << endl;
-    cout << "Memory Usage %: " << (double(currentMemoryBytes) / maxMemoryBytes * 100) << "%" << endl;
-    cout << "Total Operations: " << totalOperations << endl;
-    cout << "Operations/sec: " << getOpsPerSecond() << endl;
-    cout << "LRU Cache Size: " << lruCache->size() << " / " << maxKeys << endl;
-    cout << "TTL Entries: " << ttlManager->size() << endl;
-    cout << "========================\n" << endl;
+    printStats(getStats());
+}
+
+void Cache::printStats(const CacheStats& stats, ostream& out) {
+    out << "\n=== CACHE STATISTICS ===\n";
+    if (stats.shards > 1) {
+        out << "Shards: " << stats.shards << "\n";
+    }
+    out << "Total Keys: " << stats.keys << "\n";
+    out << "Memory Usage: " << Utils::formatMemorySize(stats.memoryBytes) 
+         << " / " << Utils::formatMemorySize(stats.maxMemoryBytes) << "\n";
+    out << "Memory Usage %: " << (double(stats.memoryBytes) / stats.maxMemoryBytes * 100) << "%" << "\n";
+    out << "  Keys: " << Utils::formatMemorySize(stats.keyBytes) << "\n";
+    out << "  Values: " << Utils::formatMemorySize(stats.valueBytes) << "\n";
+    out << "  Index: " << Utils::formatMemorySize(stats.indexBytes) << "\n";
+    out << "  Eviction: " << Utils::formatMemorySize(stats.evictionBytes) << "\n";
+    out << "  TTL Wheel: " << Utils::formatMemorySize(stats.ttlBytes) << "\n";
+    out << "  Pinned Values: " << Utils::formatMemorySize(stats.pinnedBytes) << "\n";
+    out << "Slab Memory: " << Utils::formatMemorySize(stats.slabUsedBytes) << " used / "
+         << Utils::formatMemorySize(stats.slabPageBytes) << " in pages" << "\n";
+    out << "Fragmentation: " << Utils::formatMemorySize(stats.fragmentationBytes)
+         << " (" << (stats.slabPageBytes > 0 ? double(stats.fragmentationBytes) / stats.slabPageBytes * 100 : 0)
+         << "% of slab pages)" << "\n";
+    out << "Total Operations: " << stats.totalOperations << "\n";
+    out << "Operations/sec: " << stats.opsPerSecond << "\n";
+    long long lookups = stats.keyspaceHits + stats.keyspaceMisses;
+    out << "Keyspace Hits: " << stats.keyspaceHits << " / " << lookups << " lookups ("
+         << (lookups > 0 ? double(stats.keyspaceHits) / lookups * 100 : 0) << "%)" << "\n";
+    out << "Eviction Policy: " << stats.evictionPolicy << " (" << stats.trackedKeys << " / " << stats.maxKeys << " keys)" << "\n";
+    out << "TTL Entries: " << stats.ttlEntries << "\n";
+    out << "Evicted Keys: " << stats.evictedKeys << "\n";
+    out << "Expired Keys: " << stats.expiredKeys << "\n";
+    out << "Expire Cycles: " << stats.expireCycles << "\n";
+    out << "Last Expire Cycle: " << stats.lastCycleExpired << " keys in " << stats.lastCycleMicros << " us" << "\n";
+    out << "Avg Expire Cycle Time: "
+         << (stats.expireCycles > 0 ? double(stats.totalCycleMicros) / stats.expireCycles : 0) << " us" << "\n";
+    out << "Index Resizes: " << stats.resizes << " (last " << stats.lastResizeMicros << " us, max "
+         << stats.maxResizeMicros << " us, total " << stats.totalResizeMicros << " us)" << "\n";
+    out << "========================\n\n";
+}
+
+// One line per size class in use, like memcached's "stats slabs"
+void Cache::printSlabStats(const vector<SlabClassStats>& classes, ostream& out) {
+    out << "\n=== SLAB CLASSES ===\n";
+    out << setw(10) << "chunk" << setw(8) << "pages" << setw(12) << "chunks"
+        << setw(12) << "used" << setw(14) << "requested" << setw(10) << "waste" << "\n";
+    for (const SlabClassStats& slab : classes) {
+        size_t usedBytes = slab.usedChunks * slab.chunkSize;
+        double waste = usedBytes > 0 ? 100.0 * (usedBytes - slab.requestedBytes) / usedBytes : 0;
+        out << setw(10) << slab.chunkSize << setw(8) << slab.pages << setw(12) << slab.totalChunks
+            << setw(12) << slab.usedChunks << setw(14) << slab.requestedBytes
+            << setw(9) << fixed << setprecision(1) << waste << "%" << "\n";
+        out.unsetf(ios::fixed);
+    }
+    out << "====================\n\n";
+}
+
+void Cache::resetStats() {
+    totalOperations = 0;
+    startTime = chrono::high_resolution_clock::now();
+    expiredKeys = 0;
+    evictedKeys = 0;
+    expireCycles = 0;
+    lastCycleExpired = 0;
+    lastCycleMicros = 0;
+    totalCycleMicros = 0;
+    keyspaceHits = 0;
+    keyspaceMisses = 0;
+    hashTable->resetResizeStats();
 }
 
 double Cache::getOpsPerSecond() const {
@@ -170,4 +1039,4 @@ double Cache::getOpsPerSecond() const {
 
 size_t Cache::getKeyCount() const {
     return hashTable->size();
-}
\ No newline at end of file
+}
@@ -0,0 +1,1517 @@
+#include "../include/CommandProcessor.hpp"
+#include "../include/utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+// Passes replies through, noting whether one was an error
+class ErrorTrackingWriter : public ReplyWriter {
+private:
+    ReplyWriter& out;
+
+public:
+    bool failed = false;
+    
+    explicit ErrorTrackingWriter(ReplyWriter& writer) : out(writer) {}
+    
+    void status(const string& message) override { out.status(message); }
+    void error(const string& message) override { failed = true; out.error(message); }
+    void integer(long long value) override { out.integer(value); }
+    void bulk(const string& value) override { out.bulk(value); }
+    void bulk(const ValueRef& value) override { out.bulk(value); }
+    void nil() override { out.nil(); }
+    void arrayHeader(size_t count) override { out.arrayHeader(count); }
+    void text(const string& value) override { out.text(value); }
+};
+
+long long nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+constexpr char lowerAscii(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+string toLower(string_view str) {
+    string result(str);
+    for (char& c : result) c = lowerAscii(c);
+    return result;
+}
+
+bool equalsIgnoreCase(string_view a, string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (lowerAscii(a[i]) != lowerAscii(b[i])) return false;
+    }
+    return true;
+}
+
+// FNV-1a over the lower-cased name, from a seed chosen for the table
+constexpr uint32_t hashName(string_view name, uint32_t seed) {
+    uint32_t h = seed;
+    for (char c : name) {
+        h = (h ^ static_cast<uint8_t>(lowerAscii(c))) * 16777619u;
+    }
+    return h;
+}
+
+// A ZRANGEBYSCORE bound: a score, -inf or +inf, with "(" in front to
+// exclude it
+bool parseScoreBound(string_view arg, double& value, bool& exclusive) {
+    exclusive = !arg.empty() && arg[0] == '(';
+    if (exclusive) {
+        arg.remove_prefix(1);
+    }
+    return Utils::parseDouble(arg, value);
+}
+
+} // namespace
+
+// flags, first key, last key, key step
+#define KEYS_NONE 0, 0, 0
+#define KEY_FIRST 1, 1, 1
+#define KEYS_ALL 1, -1, 1
+
+constexpr CommandProcessor::CommandSpec CommandProcessor::COMMAND_TABLE[] = {
+    {"SET", &CommandProcessor::handleSetCommand, -3, CMD_WRITE, KEY_FIRST},
+    {"GET", &CommandProcessor::handleGetCommand, 2, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"INCR", &CommandProcessor::handleIncrCommand, 2, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"DECR", &CommandProcessor::handleDecrCommand, 2, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"INCRBY", &CommandProcessor::handleIncrByCommand, 3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"DECRBY", &CommandProcessor::handleDecrByCommand, 3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"INCRBYFLOAT", &CommandProcessor::handleIncrByFloatCommand, 3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"DEL", &CommandProcessor::handleDeleteCommand, -2, CMD_WRITE, KEYS_ALL},
+    {"DELETE", &CommandProcessor::handleDeleteCommand, -2, CMD_WRITE, KEYS_ALL},
+    {"MGET", &CommandProcessor::handleMGetCommand, -2, CMD_READONLY | CMD_FAST, KEYS_ALL},
+    {"MSET", &CommandProcessor::handleMSetCommand, -3, CMD_WRITE, 1, -1, 2},
+    {"EXISTS", &CommandProcessor::handleExistsCommand, 2, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"EXPIRE", &CommandProcessor::handleExpireCommand, 3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"PEXPIRE", &CommandProcessor::handlePExpireCommand, 3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"PEXPIREAT", &CommandProcessor::handlePExpireAtCommand, 3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"PSETEX", &CommandProcessor::handlePSetExCommand, 4, CMD_WRITE, KEY_FIRST},
+    {"TTL", &CommandProcessor::handleTTLCommand, 2, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"PTTL", &CommandProcessor::handlePTTLCommand, 2, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"FLUSH", &CommandProcessor::handleFlushCommand, -1, CMD_WRITE, KEYS_NONE},
+    {"FLUSHALL", &CommandProcessor::handleFlushCommand, -1, CMD_WRITE, KEYS_NONE},
+    {"FLUSHDB", &CommandProcessor::handleFlushCommand, -1, CMD_WRITE, KEYS_NONE},
+    {"BGREWRITEAOF", &CommandProcessor::handleBgRewriteAofCommand, 1, CMD_ADMIN, KEYS_NONE},
+    {"SAVE", &CommandProcessor::handleSaveCommand, 1, CMD_ADMIN, KEYS_NONE},
+    {"BGSAVE", &CommandProcessor::handleBgSaveCommand, -1, CMD_ADMIN, KEYS_NONE},
+    {"LASTSAVE", &CommandProcessor::handleLastSaveCommand, 1, CMD_FAST, KEYS_NONE},
+    {"STATS", &CommandProcessor::handleStatsCommand, -1, 0, KEYS_NONE},
+    {"INFO", &CommandProcessor::handleInfoCommand, -1, 0, KEYS_NONE},
+    {"DBSIZE", &CommandProcessor::handleDbSizeCommand, 1, CMD_READONLY | CMD_FAST, KEYS_NONE},
+    {"PING", &CommandProcessor::handlePingCommand, -1, CMD_FAST, KEYS_NONE},
+    {"ECHO", &CommandProcessor::handleEchoCommand, 2, CMD_FAST, KEYS_NONE},
+    {"COMMAND", &CommandProcessor::handleCommandCommand, -1, 0, KEYS_NONE},
+    {"CONFIG", &CommandProcessor::handleConfigCommand, -1, CMD_ADMIN, KEYS_NONE},
+    {"QUIT", &CommandProcessor::handleQuitCommand, -1, CMD_FAST, KEYS_NONE},
+    {"TYPE", &CommandProcessor::handleTypeCommand, 2, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"OBJECT", &CommandProcessor::handleObjectCommand, -2, CMD_READONLY, 2, 2, 1},
+    {"HSET", &CommandProcessor::handleHSetCommand, -4, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"HGET", &CommandProcessor::handleHGetCommand, 3, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"HMGET", &CommandProcessor::handleHMGetCommand, -3, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"HDEL", &CommandProcessor::handleHDelCommand, -3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"HLEN", &CommandProcessor::handleHLenCommand, 2, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"HEXISTS", &CommandProcessor::handleHExistsCommand, 3, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"HGETALL", &CommandProcessor::handleHGetAllCommand, 2, CMD_READONLY, KEY_FIRST},
+    {"HINCRBY", &CommandProcessor::handleHIncrByCommand, 4, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"ZADD", &CommandProcessor::handleZAddCommand, -4, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"ZINCRBY", &CommandProcessor::handleZIncrByCommand, 4, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"ZREM", &CommandProcessor::handleZRemCommand, -3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"ZCARD", &CommandProcessor::handleZCardCommand, 2, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"ZSCORE", &CommandProcessor::handleZScoreCommand, 3, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"ZRANK", &CommandProcessor::handleZRankCommand, 3, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"ZREVRANK", &CommandProcessor::handleZRevRankCommand, 3, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"ZRANGE", &CommandProcessor::handleZRangeCommand, -4, CMD_READONLY, KEY_FIRST},
+    {"ZREVRANGE", &CommandProcessor::handleZRevRangeCommand, -4, CMD_READONLY, KEY_FIRST},
+    {"ZRANGEBYSCORE", &CommandProcessor::handleZRangeByScoreCommand, -4, CMD_READONLY, KEY_FIRST},
+    {"ZREVRANGEBYSCORE", &CommandProcessor::handleZRevRangeByScoreCommand, -4, CMD_READONLY, KEY_FIRST},
+    {"ZCOUNT", &CommandProcessor::handleZCountCommand, 4, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"LPUSH", &CommandProcessor::handleLPushCommand, -3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"RPUSH", &CommandProcessor::handleRPushCommand, -3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"LPOP", &CommandProcessor::handleLPopCommand, -2, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"RPOP", &CommandProcessor::handleRPopCommand, -2, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"LLEN", &CommandProcessor::handleLLenCommand, 2, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"LRANGE", &CommandProcessor::handleLRangeCommand, 4, CMD_READONLY, KEY_FIRST},
+    {"SADD", &CommandProcessor::handleSAddCommand, -3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"SREM", &CommandProcessor::handleSRemCommand, -3, CMD_WRITE | CMD_FAST, KEY_FIRST},
+    {"SISMEMBER", &CommandProcessor::handleSIsMemberCommand, 3, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"SCARD", &CommandProcessor::handleSCardCommand, 2, CMD_READONLY | CMD_FAST, KEY_FIRST},
+    {"SMEMBERS", &CommandProcessor::handleSMembersCommand, 2, CMD_READONLY, KEY_FIRST},
+    {"SINTER", &CommandProcessor::handleSInterCommand, -2, CMD_READONLY, KEYS_ALL},
+};
+
+#undef KEYS_NONE
+#undef KEY_FIRST
+#undef KEYS_ALL
+
+constexpr size_t CommandProcessor::COMMAND_COUNT = sizeof(COMMAND_TABLE) / sizeof(COMMAND_TABLE[0]);
+
+// Perfect hash of the command names: the seed is searched at compile time
+// until every name lands in a slot of its own, so a lookup is one hash and
+// one compare. Slots hold the table index plus one; zero is empty.
+struct CommandProcessor::CommandIndex {
+    static const size_t SLOTS = 512;
+    uint32_t seed;
+    uint8_t slots[SLOTS];
+};
+
+// A name listed twice never hashes apart, so the search fails to compile.
+constexpr CommandProcessor::CommandIndex CommandProcessor::buildCommandIndex() {
+    static_assert(COMMAND_COUNT < 256, "command index slots are one byte");
+    for (uint32_t seed = 2166136261u;; seed++) {
+        CommandIndex index{seed, {}};
+        bool perfect = true;
+        for (size_t i = 0; i < COMMAND_COUNT && perfect; i++) {
+            size_t slot = hashName(COMMAND_TABLE[i].name, seed) & (CommandIndex::SLOTS - 1);
+            perfect = index.slots[slot] == 0;
+            index.slots[slot] = static_cast<uint8_t>(i + 1);
+        }
+        if (perfect) {
+            return index;
+        }
+    }
+}
+
+constexpr CommandProcessor::CommandIndex CommandProcessor::COMMAND_INDEX = CommandProcessor::buildCommandIndex();
+
+const CommandProcessor::CommandSpec* CommandProcessor::lookupCommand(string_view name) {
+    uint8_t entry = COMMAND_INDEX.slots[hashName(name, COMMAND_INDEX.seed) & (CommandIndex::SLOTS - 1)];
+    if (entry == 0 || !equalsIgnoreCase(COMMAND_TABLE[entry - 1].name, name)) {
+        return nullptr;
+    }
+    return &COMMAND_TABLE[entry - 1];
+}
+
+CommandProcessor::CommandProcessor(Cache& c, AppendOnlyFile* log, SnapshotManager* dumps)
+    : cache(c), aof(log), snapshots(dumps), closeRequested(false), commandStats(COMMAND_COUNT),
+      unknownCommands(0) {}
+
+void CommandProcessor::logSet(string_view key, string_view value, long long ttlMs) {
+    aof->append({"SET", key, value});
+    if (ttlMs > 0) {
+        logExpiry(key, ttlMs);
+    }
+}
+
+void CommandProcessor::logExpiry(string_view key, long long ttlMs) {
+    aof->append({"PEXPIREAT", key, to_string(Utils::getCurrentTimeMillis() + ttlMs)});
+}
+
+void CommandProcessor::wrongArity(string_view command, ReplyWriter& reply) {
+    reply.error("ERR wrong number of arguments for '" + toLower(command) + "' command");
+}
+
+void CommandProcessor::wrongType(ReplyWriter& reply) {
+    reply.error("WRONGTYPE Operation against a key holding the wrong kind of value");
+}
+
+// Largest TTL accepted, in milliseconds; keeps now + ttl far from overflow
+static const long long MAX_TTL_MS = 0x7FFFFFFFLL * 1000;
+
+// SET key value [ttl], SET key value EX seconds or SET key value PX milliseconds
+void CommandProcessor::handleSetCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    if (argv.size() > 5) {
+        wrongArity("set", reply);
+        return;
+    }
+    
+    long long ttlMs = -1;
+    if (argv.size() == 4 || argv.size() == 5) {
+        string_view ttlArg = argv.size() == 5 ? argv[4] : argv[3];
+        long long unit = 1000;
+        if (argv.size() == 5) {
+            if (equalsIgnoreCase(argv[3], "PX")) {
+                unit = 1;
+            } else if (!equalsIgnoreCase(argv[3], "EX")) {
+                reply.error("ERR syntax error");
+                return;
+            }
+        }
+        if (!Utils::parseInteger(ttlArg, ttlMs)) {
+            reply.error("ERR value is not an integer or out of range");
+            return;
+        }
+        if (ttlMs <= 0 || ttlMs > MAX_TTL_MS / unit) {
+            reply.error("ERR invalid expire time in 'set' command");
+            return;
+        }
+        ttlMs *= unit;
+    }
+    
+    if (aof) {
+        logSet(argv[1], argv[2], ttlMs);
+    }
+    if (cache.psetex(argv[1], argv[2], ttlMs)) {
+        reply.status("OK");
+    } else {
+        reply.error("ERR failed to set key");
+    }
+}
+
+void CommandProcessor::handleGetCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    ValueRef value;
+    Cache::Result result = cache.getString(argv[1], value);
+    if (result == Cache::OK) {
+        reply.bulk(value);
+    } else if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+    } else {
+        reply.nil();
+    }
+}
+
+void CommandProcessor::handleIncrCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    incrementBy(argv, 1, reply);
+}
+
+void CommandProcessor::handleDecrCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    incrementBy(argv, -1, reply);
+}
+
+void CommandProcessor::handleIncrByCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    long long increment;
+    if (!Utils::parseInteger(argv[2], increment)) {
+        reply.error("ERR value is not an integer or out of range");
+        return;
+    }
+    incrementBy(argv, increment, reply);
+}
+
+void CommandProcessor::handleDecrByCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    long long decrement;
+    if (!Utils::parseInteger(argv[2], decrement)) {
+        reply.error("ERR value is not an integer or out of range");
+        return;
+    }
+    if (decrement == LLONG_MIN) {
+        reply.error("ERR decrement would overflow");
+        return;
+    }
+    incrementBy(argv, -decrement, reply);
+}
+
+// INCR, DECR, INCRBY and DECRBY. Logged as given: replay starts from the
+// same value, and an INCR is shorter than the SET of its result.
+void CommandProcessor::incrementBy(const vector<string_view>& argv, long long increment, ReplyWriter& reply) {
+    long long value;
+    switch (cache.incrby(argv[1], increment, value)) {
+        case Cache::OK:
+            if (aof) {
+                aof->append(argv);
+            }
+            reply.integer(value);
+            break;
+        case Cache::WRONG_TYPE:
+            wrongType(reply);
+            break;
+        case Cache::NOT_INTEGER:
+            reply.error("ERR value is not an integer or out of range");
+            break;
+        default:
+            reply.error("ERR increment or decrement would overflow");
+            break;
+    }
+}
+
+// INCRBYFLOAT key increment. Logged as a SET of the result, as Redis
+// propagates it, so replay never depends on float formatting.
+void CommandProcessor::handleIncrByFloatCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    double increment;
+    if (!Utils::parseDouble(argv[2], increment)) {
+        reply.error("ERR value is not a valid float");
+        return;
+    }
+    
+    double value;
+    long long ttlMs;
+    switch (cache.incrbyfloat(argv[1], increment, value, ttlMs)) {
+        case Cache::OK: {
+            string text = Utils::formatDouble(value);
+            if (aof) {
+                logSet(argv[1], text, ttlMs);
+            }
+            reply.bulk(text);
+            break;
+        }
+        case Cache::WRONG_TYPE:
+            wrongType(reply);
+            break;
+        case Cache::NOT_A_NUMBER:
+            reply.error("ERR value is not a valid float");
+            break;
+        default:
+            reply.error("ERR increment would produce NaN or Infinity");
+            break;
+    }
+}
+
+// DEL key [key ...]
+void CommandProcessor::handleDeleteCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    size_t deleted;
+    if (argv.size() == 2) {
+        deleted = cache.del(argv[1]) ? 1 : 0;
+    } else {
+        deleted = cache.mdel(&argv[1], argv.size() - 1);
+    }
+    if (aof && deleted > 0) {
+        aof->append(argv);
+    }
+    reply.integer(static_cast<long long>(deleted));
+}
+
+// MGET key [key ...]
+void CommandProcessor::handleMGetCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    size_t count = argv.size() - 1;
+    cache.mget(&argv[1], count, batchValues);
+    
+    reply.arrayHeader(count);
+    for (size_t i = 0; i < count; i++) {
+        if (batchValues[i]) {
+            reply.bulk(batchValues[i]);
+        } else {
+            reply.nil();
+        }
+    }
+    
+    // Do not keep values alive until the next MGET
+    batchValues.clear();
+}
+
+// MSET key value [key value ...]
+void CommandProcessor::handleMSetCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    if (argv.size() % 2 == 0) {
+        wrongArity("mset", reply);
+        return;
+    }
+    
+    cache.mset(&argv[1], (argv.size() - 1) / 2);
+    if (aof) {
+        aof->append(argv);
+    }
+    reply.status("OK");
+}
+
+void CommandProcessor::handleExistsCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    reply.integer(cache.exists(argv[1]) ? 1 : 0);
+}
+
+void CommandProcessor::handleExpireCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    expireKey(argv, reply, false);
+}
+
+void CommandProcessor::handlePExpireCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    expireKey(argv, reply, true);
+}
+
+// EXPIRE key seconds or PEXPIRE key milliseconds
+void CommandProcessor::expireKey(const vector<string_view>& argv, ReplyWriter& reply, bool millis) {
+    const char* name = millis ? "pexpire" : "expire";
+    long long ttl;
+    long long unit = millis ? 1 : 1000;
+    if (!Utils::parseInteger(argv[2], ttl)) {
+        reply.error("ERR value is not an integer or out of range");
+        return;
+    }
+    if (ttl <= 0 || ttl > MAX_TTL_MS / unit) {
+        reply.error(string("ERR invalid expire time in '") + name + "' command");
+        return;
+    }
+    
+    bool updated = cache.pexpire(argv[1], ttl * unit);
+    if (aof && updated) {
+        logExpiry(argv[1], ttl * unit);
+    }
+    reply.integer(updated ? 1 : 0);
+}
+
+// PEXPIREAT key unix-time-milliseconds. How the log records expiry; a time
+// already past deletes the key.
+void CommandProcessor::handlePExpireAtCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    long long when;
+    if (!Utils::parseInteger(argv[2], when)) {
+        reply.error("ERR value is not an integer or out of range");
+        return;
+    }
+    
+    // Compare before subtracting: a time near LLONG_MIN would overflow
+    long long now = Utils::getCurrentTimeMillis();
+    if (when <= now) {
+        bool deleted = cache.del(argv[1]);
+        if (aof && deleted) {
+            aof->append({"DEL", argv[1]});
+        }
+        reply.integer(deleted ? 1 : 0);
+        return;
+    }
+    
+    long long ttlMs = when - now;
+    if (ttlMs > MAX_TTL_MS) {
+        reply.error("ERR invalid expire time in 'pexpireat' command");
+        return;
+    }
+    
+    bool updated = cache.pexpire(argv[1], ttlMs);
+    if (aof && updated) {
+        aof->append(argv);
+    }
+    reply.integer(updated ? 1 : 0);
+}
+
+// PSETEX key milliseconds value
+void CommandProcessor::handlePSetExCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    long long ttlMs;
+    if (!Utils::parseInteger(argv[2], ttlMs)) {
+        reply.error("ERR value is not an integer or out of range");
+        return;
+    }
+    if (ttlMs <= 0 || ttlMs > MAX_TTL_MS) {
+        reply.error("ERR invalid expire time in 'psetex' command");
+        return;
+    }
+    
+    if (aof) {
+        logSet(argv[1], argv[3], ttlMs);
+    }
+    cache.psetex(argv[1], argv[3], ttlMs);
+    reply.status("OK");
+}
+
+void CommandProcessor::handleTTLCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    reply.integer(cache.ttl(argv[1]));
+}
+
+void CommandProcessor::handlePTTLCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    reply.integer(cache.pttl(argv[1]));
+}
+
+void CommandProcessor::handleTypeCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    ValueType type;
+    if (!cache.type(argv[1], type)) {
+        reply.status("none");
+    } else if (type == ValueType::HASH) {
+        reply.status("hash");
+    } else if (type == ValueType::ZSET) {
+        reply.status("zset");
+    } else if (type == ValueType::LIST) {
+        reply.status("list");
+    } else if (type == ValueType::SET) {
+        reply.status("set");
+    } else {
+        reply.status("string");
+    }
+}
+
+// OBJECT ENCODING key; no other subcommand is kept
+void CommandProcessor::handleObjectCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    if (!equalsIgnoreCase(argv[1], "ENCODING")) {
+        reply.error("ERR unknown subcommand '" + string(argv[1]) + "'. Try OBJECT ENCODING.");
+        return;
+    }
+    if (argv.size() != 3) {
+        wrongArity("object|encoding", reply);
+        return;
+    }
+    const char* encoding = cache.encoding(argv[2]);
+    if (encoding) {
+        reply.bulk(encoding);
+    } else {
+        reply.nil();
+    }
+}
+
+// HSET key field value [field value ...]
+void CommandProcessor::handleHSetCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    if (argv.size() % 2 == 1) {
+        wrongArity("hset", reply);
+        return;
+    }
+    
+    size_t added;
+    if (cache.hset(argv[1], &argv[2], (argv.size() - 2) / 2, added) == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    if (aof) {
+        aof->append(argv);
+    }
+    reply.integer(static_cast<long long>(added));
+}
+
+void CommandProcessor::handleHGetCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    Cache::Result result;
+    const HashValue* hash = cache.readHash(argv[1], result);
+    string_view value;
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+    } else if (hash && hash->get(argv[2], value)) {
+        reply.bulk(string(value));
+    } else {
+        reply.nil();
+    }
+}
+
+// HMGET key field [field ...]
+void CommandProcessor::handleHMGetCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    Cache::Result result;
+    const HashValue* hash = cache.readHash(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    
+    reply.arrayHeader(argv.size() - 2);
+    for (size_t i = 2; i < argv.size(); i++) {
+        string_view value;
+        if (hash && hash->get(argv[i], value)) {
+            reply.bulk(string(value));
+        } else {
+            reply.nil();
+        }
+    }
+}
+
+// HDEL key field [field ...]
+void CommandProcessor::handleHDelCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    size_t removed;
+    if (cache.hdel(argv[1], &argv[2], argv.size() - 2, removed) == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    if (aof && removed > 0) {
+        aof->append(argv);
+    }
+    reply.integer(static_cast<long long>(removed));
+}
+
+void CommandProcessor::handleHLenCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    Cache::Result result;
+    const HashValue* hash = cache.readHash(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+    } else {
+        reply.integer(hash ? static_cast<long long>(hash->size()) : 0);
+    }
+}
+
+void CommandProcessor::handleHExistsCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    Cache::Result result;
+    const HashValue* hash = cache.readHash(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+    } else {
+        reply.integer(hash && hash->exists(argv[2]) ? 1 : 0);
+    }
+}
+
+// Fields and values interleaved, as Redis replies
+void CommandProcessor::handleHGetAllCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    Cache::Result result;
+    const HashValue* hash = cache.readHash(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    if (!hash) {
+        reply.arrayHeader(0);
+        return;
+    }
+    
+    reply.arrayHeader(2 * hash->size());
+    hash->forEach([&](string_view field, string_view value) {
+        reply.bulk(string(field));
+        reply.bulk(string(value));
+    });
+}
+
+// HINCRBY key field increment. Logged as an HSET of the result, so replay
+// does not depend on what the field held.
+void CommandProcessor::handleHIncrByCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    long long increment;
+    if (!Utils::parseInteger(argv[3], increment)) {
+        reply.error("ERR value is not an integer or out of range");
+        return;
+    }
+    
+    long long value;
+    switch (cache.hincrby(argv[1], argv[2], increment, value)) {
+        case Cache::OK:
+            if (aof) {
+                aof->append({"HSET", argv[1], argv[2], to_string(value)});
+            }
+            reply.integer(value);
+            break;
+        case Cache::WRONG_TYPE:
+            wrongType(reply);
+            break;
+        case Cache::NOT_INTEGER:
+            reply.error("ERR hash value is not an integer");
+            break;
+        default:
+            reply.error("ERR increment or decrement would overflow");
+            break;
+    }
+}
+
+// ZADD key [NX|XX] [GT|LT] [CH] [INCR] score member [score member ...].
+// Logged as given when anything changed; with INCR, as for ZINCRBY.
+void CommandProcessor::handleZAddCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    uint32_t flags = 0;
+    bool changedCount = false;
+    size_t i = 2;
+    for (; i < argv.size(); i++) {
+        if (equalsIgnoreCase(argv[i], "NX")) {
+            flags |= ZSetValue::ADD_NX;
+        } else if (equalsIgnoreCase(argv[i], "XX")) {
+            flags |= ZSetValue::ADD_XX;
+        } else if (equalsIgnoreCase(argv[i], "GT")) {
+            flags |= ZSetValue::ADD_GT;
+        } else if (equalsIgnoreCase(argv[i], "LT")) {
+            flags |= ZSetValue::ADD_LT;
+        } else if (equalsIgnoreCase(argv[i], "CH")) {
+            changedCount = true;
+        } else if (equalsIgnoreCase(argv[i], "INCR")) {
+            flags |= ZSetValue::ADD_INCR;
+        } else {
+            break;
+        }
+    }
+    
+    size_t pairCount = (argv.size() - i) / 2;
+    if (pairCount == 0 || (argv.size() - i) % 2 != 0) {
+        reply.error("ERR syntax error");
+        return;
+    }
+    if ((flags & ZSetValue::ADD_NX) && (flags & ZSetValue::ADD_XX)) {
+        reply.error("ERR XX and NX options at the same time are not compatible");
+        return;
+    }
+    if (((flags & ZSetValue::ADD_GT) && (flags & ZSetValue::ADD_LT)) ||
+        ((flags & ZSetValue::ADD_NX) && (flags & (ZSetValue::ADD_GT | ZSetValue::ADD_LT)))) {
+        reply.error("ERR GT, LT, and/or NX options at the same time are not compatible");
+        return;
+    }
+    if ((flags & ZSetValue::ADD_INCR) && pairCount > 1) {
+        reply.error("ERR INCR option supports a single increment-element pair");
+        return;
+    }
+    
+    vector<double> scores(pairCount);
+    vector<string_view> members(pairCount);
+    for (size_t pair = 0; pair < pairCount; pair++) {
+        if (!Utils::parseDouble(argv[i + 2 * pair], scores[pair])) {
+            reply.error("ERR value is not a valid float");
+            return;
+        }
+        members[pair] = argv[i + 2 * pair + 1];
+    }
+    if (flags & ZSetValue::ADD_INCR) {
+        zaddIncrement(argv[1], scores[0], members[0], flags, reply);
+        return;
+    }
+    
+    size_t added, updated;
+    double score;
+    if (cache.zadd(argv[1], scores.data(), members.data(), pairCount, flags, added, updated, score) ==
+        Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    if (aof && added + updated > 0) {
+        aof->append(argv);
+    }
+    reply.integer(static_cast<long long>(changedCount ? added + updated : added));
+}
+
+// ZINCRBY key increment member
+void CommandProcessor::handleZIncrByCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    double increment;
+    if (!Utils::parseDouble(argv[2], increment)) {
+        reply.error("ERR value is not a valid float");
+        return;
+    }
+    zaddIncrement(argv[1], increment, argv[3], ZSetValue::ADD_INCR, reply);
+}
+
+// Replies with the new score, or nil if flags skipped the member. Logged
+// as a ZADD of the new score, so replay does not depend on the old one.
+void CommandProcessor::zaddIncrement(string_view key, double increment, string_view member, uint32_t flags,
+                                     ReplyWriter& reply) {
+    size_t added, updated;
+    double score;
+    switch (cache.zadd(key, &increment, &member, 1, flags, added, updated, score)) {
+        case Cache::OK:
+            if (isnan(score)) {
+                reply.nil();
+                break;
+            }
+            if (aof && added + updated > 0) {
+                aof->append({"ZADD", key, Utils::formatDouble(score), member});
+            }
+            reply.bulk(Utils::formatDouble(score));
+            break;
+        case Cache::WRONG_TYPE:
+            wrongType(reply);
+            break;
+        default:
+            reply.error("ERR resulting score is not a number (NaN)");
+            break;
+    }
+}
+
+// ZREM key member [member ...]
+void CommandProcessor::handleZRemCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    size_t removed;
+    if (cache.zrem(argv[1], &argv[2], argv.size() - 2, removed) == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    if (aof && removed > 0) {
+        aof->append(argv);
+    }
+    reply.integer(static_cast<long long>(removed));
+}
+
+void CommandProcessor::handleZCardCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    Cache::Result result;
+    const ZSetValue* zset = cache.readZSet(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+    } else {
+        reply.integer(zset ? static_cast<long long>(zset->size()) : 0);
+    }
+}
+
+void CommandProcessor::handleZScoreCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    Cache::Result result;
+    const ZSetValue* zset = cache.readZSet(argv[1], result);
+    double score;
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+    } else if (zset && zset->score(argv[2], score)) {
+        reply.bulk(Utils::formatDouble(score));
+    } else {
+        reply.nil();
+    }
+}
+
+void CommandProcessor::handleZRankCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    zsetRank(argv, reply, false);
+}
+
+void CommandProcessor::handleZRevRankCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    zsetRank(argv, reply, true);
+}
+
+// ZRANK or ZREVRANK key member
+void CommandProcessor::zsetRank(const vector<string_view>& argv, ReplyWriter& reply, bool reverse) {
+    Cache::Result result;
+    const ZSetValue* zset = cache.readZSet(argv[1], result);
+    long long rank = zset ? zset->rank(argv[2], reverse) : -1;
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+    } else if (rank >= 0) {
+        reply.integer(rank);
+    } else {
+        reply.nil();
+    }
+}
+
+// ZRANGE key start stop [REV] [WITHSCORES]. Only ranks: ZRANGEBYSCORE
+// covers scores, and BYSCORE / BYLEX are not taken here.
+void CommandProcessor::handleZRangeCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    bool reverse = false;
+    bool withScores = false;
+    for (size_t i = 4; i < argv.size(); i++) {
+        if (equalsIgnoreCase(argv[i], "REV")) {
+            reverse = true;
+        } else if (equalsIgnoreCase(argv[i], "WITHSCORES")) {
+            withScores = true;
+        } else {
+            reply.error("ERR syntax error");
+            return;
+        }
+    }
+    zrangeByRank(argv, reply, reverse, withScores);
+}
+
+// ZREVRANGE key start stop [WITHSCORES]
+void CommandProcessor::handleZRevRangeCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    if (argv.size() > 5 || (argv.size() == 5 && !equalsIgnoreCase(argv[4], "WITHSCORES"))) {
+        reply.error("ERR syntax error");
+        return;
+    }
+    zrangeByRank(argv, reply, true, argv.size() == 5);
+}
+
+// Ranks count from 0, or back from the end when negative, and are clamped
+// to the set, as in Redis
+void CommandProcessor::zrangeByRank(const vector<string_view>& argv, ReplyWriter& reply, bool reverse,
+                                    bool withScores) {
+    long long start, stop;
+    if (!Utils::parseInteger(argv[2], start) || !Utils::parseInteger(argv[3], stop)) {
+        reply.error("ERR value is not an integer or out of range");
+        return;
+    }
+    Cache::Result result;
+    const ZSetValue* zset = cache.readZSet(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    
+    long long size = zset ? static_cast<long long>(zset->size()) : 0;
+    if (start < 0) start = max(start + size, 0LL);
+    if (stop < 0) stop += size;
+    if (stop >= size) stop = size - 1;
+    if (start > stop) {
+        reply.arrayHeader(0);
+        return;
+    }
+    
+    reply.arrayHeader((withScores ? 2 : 1) * (stop - start + 1));
+    zset->forEachInRanks(start, stop, reverse, [&](string_view member, double score) {
+        reply.bulk(string(member));
+        if (withScores) {
+            reply.bulk(Utils::formatDouble(score));
+        }
+    });
+}
+
+void CommandProcessor::handleZRangeByScoreCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    zrangeByScore(argv, reply, false);
+}
+
+void CommandProcessor::handleZRevRangeByScoreCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    zrangeByScore(argv, reply, true);
+}
+
+// ZRANGEBYSCORE key min max [WITHSCORES] [LIMIT offset count], or
+// ZREVRANGEBYSCORE key max min ...
+void CommandProcessor::zrangeByScore(const vector<string_view>& argv, ReplyWriter& reply, bool reverse) {
+    ScoreRange range;
+    string_view minArg = reverse ? argv[3] : argv[2];
+    string_view maxArg = reverse ? argv[2] : argv[3];
+    if (!parseScoreBound(minArg, range.min, range.minExclusive) ||
+        !parseScoreBound(maxArg, range.max, range.maxExclusive)) {
+        reply.error("ERR min or max is not a float");
+        return;
+    }
+    
+    bool withScores = false;
+    long long offset = 0;
+    long long limit = -1;
+    for (size_t i = 4; i < argv.size(); i++) {
+        if (equalsIgnoreCase(argv[i], "WITHSCORES")) {
+            withScores = true;
+        } else if (equalsIgnoreCase(argv[i], "LIMIT") && i + 2 < argv.size()) {
+            if (!Utils::parseInteger(argv[i + 1], offset) || !Utils::parseInteger(argv[i + 2], limit)) {
+                reply.error("ERR value is not an integer or out of range");
+                return;
+            }
+            i += 2;
+        } else {
+            reply.error("ERR syntax error");
+            return;
+        }
+    }
+    
+    Cache::Result result;
+    const ZSetValue* zset = cache.readZSet(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    // A negative offset matches nothing, as in Redis
+    if (!zset || offset < 0) {
+        reply.arrayHeader(0);
+        return;
+    }
+    
+    vector<pair<string_view, double>> matches;
+    zset->forEachInRange(range, reverse, offset, limit < 0 ? -1 : limit, [&](string_view member, double score) {
+        matches.emplace_back(member, score);
+    });
+    reply.arrayHeader((withScores ? 2 : 1) * matches.size());
+    for (const auto& match : matches) {
+        reply.bulk(string(match.first));
+        if (withScores) {
+            reply.bulk(Utils::formatDouble(match.second));
+        }
+    }
+}
+
+// ZCOUNT key min max
+void CommandProcessor::handleZCountCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    ScoreRange range;
+    if (!parseScoreBound(argv[2], range.min, range.minExclusive) ||
+        !parseScoreBound(argv[3], range.max, range.maxExclusive)) {
+        reply.error("ERR min or max is not a float");
+        return;
+    }
+    Cache::Result result;
+    const ZSetValue* zset = cache.readZSet(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+    } else {
+        reply.integer(zset && !range.empty() ? static_cast<long long>(zset->countInRange(range)) : 0);
+    }
+}
+
+void CommandProcessor::handleLPushCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    pushList(argv, reply, true);
+}
+
+void CommandProcessor::handleRPushCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    pushList(argv, reply, false);
+}
+
+// LPUSH or RPUSH key element [element ...]
+void CommandProcessor::pushList(const vector<string_view>& argv, ReplyWriter& reply, bool front) {
+    size_t length;
+    if (cache.push(argv[1], &argv[2], argv.size() - 2, front, length) == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    if (aof) {
+        aof->append(argv);
+    }
+    reply.integer(static_cast<long long>(length));
+}
+
+void CommandProcessor::handleLPopCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    popList(argv, reply, true);
+}
+
+void CommandProcessor::handleRPopCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    popList(argv, reply, false);
+}
+
+// LPOP or RPOP key [count]: one element, or with a count an array of up to
+// that many
+void CommandProcessor::popList(const vector<string_view>& argv, ReplyWriter& reply, bool front) {
+    if (argv.size() > 3) {
+        wrongArity(argv[0], reply);
+        return;
+    }
+    long long count = 1;
+    if (argv.size() == 3 && (!Utils::parseInteger(argv[2], count) || count < 0)) {
+        reply.error("ERR value is out of range, must be positive");
+        return;
+    }
+    
+    Cache::Result result = cache.pop(argv[1], front, count, poppedValues);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    if (aof && !poppedValues.empty()) {
+        aof->append(argv);
+    }
+    if (result == Cache::NOT_FOUND) {
+        reply.nil();
+    } else if (argv.size() == 2) {
+        reply.bulk(poppedValues[0]);
+    } else {
+        reply.arrayHeader(poppedValues.size());
+        for (const string& value : poppedValues) {
+            reply.bulk(value);
+        }
+    }
+    poppedValues.clear();
+}
+
+void CommandProcessor::handleLLenCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    Cache::Result result;
+    const ListValue* list = cache.readList(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+    } else {
+        reply.integer(list ? static_cast<long long>(list->size()) : 0);
+    }
+}
+
+// LRANGE key start stop, with ranks as ZRANGE takes them
+void CommandProcessor::handleLRangeCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    long long start, stop;
+    if (!Utils::parseInteger(argv[2], start) || !Utils::parseInteger(argv[3], stop)) {
+        reply.error("ERR value is not an integer or out of range");
+        return;
+    }
+    Cache::Result result;
+    const ListValue* list = cache.readList(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    
+    long long size = list ? static_cast<long long>(list->size()) : 0;
+    if (start < 0) start = max(start + size, 0LL);
+    if (stop < 0) stop += size;
+    if (stop >= size) stop = size - 1;
+    if (start > stop) {
+        reply.arrayHeader(0);
+        return;
+    }
+    
+    reply.arrayHeader(stop - start + 1);
+    list->forEachInRange(start, stop, [&](string_view value) { reply.bulk(string(value)); });
+}
+
+// SADD key member [member ...]
+void CommandProcessor::handleSAddCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    size_t added;
+    if (cache.sadd(argv[1], &argv[2], argv.size() - 2, added) == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    if (aof && added > 0) {
+        aof->append(argv);
+    }
+    reply.integer(static_cast<long long>(added));
+}
+
+// SREM key member [member ...]
+void CommandProcessor::handleSRemCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    size_t removed;
+    if (cache.srem(argv[1], &argv[2], argv.size() - 2, removed) == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    if (aof && removed > 0) {
+        aof->append(argv);
+    }
+    reply.integer(static_cast<long long>(removed));
+}
+
+void CommandProcessor::handleSIsMemberCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    Cache::Result result;
+    const SetValue* set = cache.readSet(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+    } else {
+        reply.integer(set && set->contains(argv[2]) ? 1 : 0);
+    }
+}
+
+void CommandProcessor::handleSCardCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    Cache::Result result;
+    const SetValue* set = cache.readSet(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+    } else {
+        reply.integer(set ? static_cast<long long>(set->size()) : 0);
+    }
+}
+
+void CommandProcessor::handleSMembersCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    Cache::Result result;
+    const SetValue* set = cache.readSet(argv[1], result);
+    if (result == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    reply.arrayHeader(set ? set->size() : 0);
+    if (set) {
+        set->forEach([&](string_view member) { reply.bulk(string(member)); });
+    }
+}
+
+// SINTER key [key ...]: walks the smallest set, probing the others, so the
+// cost follows the smallest one; a missing key makes the result empty
+void CommandProcessor::handleSInterCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    if (cache.readSets(&argv[1], argv.size() - 1, batchSets) == Cache::WRONG_TYPE) {
+        wrongType(reply);
+        return;
+    }
+    if (find(batchSets.begin(), batchSets.end(), nullptr) != batchSets.end()) {
+        reply.arrayHeader(0);
+        return;
+    }
+    
+    sort(batchSets.begin(), batchSets.end(),
+         [](const SetValue* a, const SetValue* b) { return a->size() < b->size(); });
+    vector<string>& members = interMembers;
+    batchSets[0]->forEach([&](string_view member) {
+        for (size_t i = 1; i < batchSets.size(); i++) {
+            if (!batchSets[i]->contains(member)) return;
+        }
+        members.emplace_back(member);
+    });
+    batchSets.clear();
+    
+    reply.arrayHeader(members.size());
+    for (const string& member : members) {
+        reply.bulk(member);
+    }
+    members.clear();
+}
+
+// FLUSH, FLUSHALL and FLUSHDB
+void CommandProcessor::handleFlushCommand(const vector<string_view>&, ReplyWriter& reply) {
+    cache.flush();
+    if (aof) {
+        aof->append({"FLUSHALL"});
+    }
+    reply.status("OK");
+}
+
+void CommandProcessor::handleBgRewriteAofCommand(const vector<string_view>&, ReplyWriter& reply) {
+    if (!aof) {
+        reply.error("ERR append only file is not enabled");
+    } else if (aof->isRewriting()) {
+        reply.error("ERR Background append only file rewriting already in progress");
+    } else if (aof->startRewrite(cache)) {
+        reply.status("Background append only file rewriting started");
+    } else {
+        reply.error("ERR Background append only file rewriting failed to start");
+    }
+}
+
+void CommandProcessor::handleSaveCommand(const vector<string_view>&, ReplyWriter& reply) {
+    if (!snapshots) {
+        reply.error("ERR snapshots are not enabled");
+    } else if (snapshots->isSaving()) {
+        reply.error("ERR Background save already in progress");
+    } else if (snapshots->save(cache)) {
+        reply.status("OK");
+    } else {
+        reply.error("ERR saving " + snapshots->getPath() + " failed");
+    }
+}
+
+void CommandProcessor::handleBgSaveCommand(const vector<string_view>&, ReplyWriter& reply) {
+    if (!snapshots) {
+        reply.error("ERR snapshots are not enabled");
+    } else if (snapshots->isSaving()) {
+        reply.error("ERR Background save already in progress");
+    } else if (snapshots->startBackgroundSave(cache)) {
+        reply.status("Background saving started");
+    } else {
+        reply.error("ERR Background save failed to start");
+    }
+}
+
+void CommandProcessor::handleLastSaveCommand(const vector<string_view>&, ReplyWriter& reply) {
+    if (!snapshots) {
+        reply.error("ERR snapshots are not enabled");
+    } else {
+        reply.integer(snapshots->getStats().lastSaveTime);
+    }
+}
+
+void CommandProcessor::handleDbSizeCommand(const vector<string_view>&, ReplyWriter& reply) {
+    reply.integer(static_cast<long long>(cache.getKeyCount()));
+}
+
+// PING [message]
+void CommandProcessor::handlePingCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    if (argv.size() > 2) {
+        wrongArity("ping", reply);
+    } else if (argv.size() == 2) {
+        reply.bulk(string(argv[1]));
+    } else {
+        reply.status("PONG");
+    }
+}
+
+void CommandProcessor::handleEchoCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    reply.bulk(string(argv[1]));
+}
+
+// One COMMAND entry, in the Redis 6 layout: name, arity, flags, first key,
+// last key, key step
+void CommandProcessor::describeCommand(const CommandSpec& command, ReplyWriter& reply) {
+    static const pair<uint32_t, const char*> FLAG_NAMES[] = {
+        {CMD_WRITE, "write"}, {CMD_READONLY, "readonly"}, {CMD_ADMIN, "admin"}, {CMD_FAST, "fast"},
+    };
+    
+    reply.arrayHeader(6);
+    reply.bulk(toLower(command.name));
+    reply.integer(command.arity);
+    size_t flags = 0;
+    for (const auto& flag : FLAG_NAMES) {
+        if (command.flags & flag.first) flags++;
+    }
+    reply.arrayHeader(flags);
+    for (const auto& flag : FLAG_NAMES) {
+        if (command.flags & flag.first) reply.status(flag.second);
+    }
+    reply.integer(command.firstKey);
+    reply.integer(command.lastKey);
+    reply.integer(command.keyStep);
+}
+
+// COMMAND, COMMAND COUNT or COMMAND INFO name [name ...]. Anything else,
+// such as the COMMAND DOCS newer clients probe with, gets an empty array.
+void CommandProcessor::handleCommandCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    if (argv.size() == 1) {
+        reply.arrayHeader(COMMAND_COUNT);
+        for (size_t i = 0; i < COMMAND_COUNT; i++) {
+            describeCommand(COMMAND_TABLE[i], reply);
+        }
+    } else if (argv.size() == 2 && equalsIgnoreCase(argv[1], "COUNT")) {
+        reply.integer(static_cast<long long>(COMMAND_COUNT));
+    } else if (equalsIgnoreCase(argv[1], "INFO")) {
+        reply.arrayHeader(argv.size() - 2);
+        for (size_t i = 2; i < argv.size(); i++) {
+            const CommandSpec* command = lookupCommand(argv[i]);
+            if (command) {
+                describeCommand(*command, reply);
+            } else {
+                reply.nil();
+            }
+        }
+    } else {
+        reply.arrayHeader(0);
+    }
+}
+
+// CONFIG RESETSTAT; other subcommands, probed by redis-benchmark on
+// connect, get an empty array
+void CommandProcessor::handleConfigCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    if (argv.size() == 2 && equalsIgnoreCase(argv[1], "RESETSTAT")) {
+        resetStats();
+        reply.status("OK");
+    } else {
+        reply.arrayHeader(0);
+    }
+}
+
+void CommandProcessor::handleQuitCommand(const vector<string_view>&, ReplyWriter& reply) {
+    reply.status("OK");
+    closeRequested = true;
+}
+
+void CommandProcessor::resetStats() {
+    for (CommandStats& stats : commandStats) {
+        stats = CommandStats();
+    }
+    unknownCommands = 0;
+    cache.resetStats();
+}
+
+const CommandStats* CommandProcessor::getCommandStats(string_view command) const {
+    const CommandSpec* spec = lookupCommand(command);
+    return spec ? &commandStats[spec - COMMAND_TABLE] : nullptr;
+}
+
+// Table indexes of the commands that ran at least once, by name
+vector<size_t> CommandProcessor::commandsByName() const {
+    vector<size_t> used;
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        if (commandStats[i].calls > 0) used.push_back(i);
+    }
+    sort(used.begin(), used.end(), [](size_t a, size_t b) { return COMMAND_TABLE[a].name < COMMAND_TABLE[b].name; });
+    return used;
+}
+
+// Latencies in microseconds
+void CommandProcessor::printCommandStats(ostream& out) const {
+    out << "=== COMMANDS ===\n";
+    out << left << setw(14) << "command" << right << setw(10) << "calls" << setw(8) << "failed"
+        << setw(10) << "mean us" << setw(10) << "p50" << setw(10) << "p99" << setw(10) << "p99.9"
+        << setw(10) << "max" << "\n";
+    out << fixed << setprecision(1);
+    for (size_t i : commandsByName()) {
+        const CommandStats& stats = commandStats[i];
+        const LatencyHistogram& latency = stats.latency;
+        out << left << setw(14) << COMMAND_TABLE[i].name << right << setw(10) << stats.calls
+            << setw(8) << stats.failedCalls << setw(10) << latency.mean() / 1000
+            << setw(10) << latency.percentile(50) / 1000.0 << setw(10) << latency.percentile(99) / 1000.0
+            << setw(10) << latency.percentile(99.9) / 1000.0 << setw(10) << latency.max() / 1000.0 << "\n";
+    }
+    out.unsetf(ios::fixed);
+    if (unknownCommands > 0) {
+        out << "Unknown Commands: " << unknownCommands << "\n";
+    }
+    out << "================\n\n";
+}
+
+// STATS [SLABS | RESET]
+void CommandProcessor::handleStatsCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    string_view option = argv.size() > 1 ? argv[1] : "";
+    if (equalsIgnoreCase(option, "RESET")) {
+        resetStats();
+        reply.status("OK");
+        return;
+    }
+    
+    stringstream ss;
+    if (equalsIgnoreCase(option, "SLABS")) {
+        Cache::printSlabStats(cache.getSlabStats(), ss);
+    } else {
+        Cache::printStats(cache.getStats(), ss);
+        printCommandStats(ss);
+        if (aof) {
+            AppendOnlyFile::printStats(aof->getStats(), ss);
+        }
+        if (snapshots) {
+            SnapshotManager::printStats(snapshots->getStats(), ss);
+        }
+    }
+    reply.text(ss.str());
+}
+
+// INFO [section]: memory, stats, persistence, commandstats, latencystats,
+// keyspace, or all of them. Latencies are in microseconds, as in Redis.
+void CommandProcessor::handleInfoCommand(const vector<string_view>& argv, ReplyWriter& reply) {
+    if (argv.size() > 2) {
+        wrongArity("info", reply);
+        return;
+    }
+    string section = argv.size() > 1 ? toLower(argv[1]) : "all";
+    bool all = section == "all" || section == "everything" || section == "default";
+    CacheStats stats = cache.getStats();
+    stringstream ss;
+    ss << fixed << setprecision(3);
+    
+    if (all || section == "memory") {
+        ss << "# Memory\r\n";
+        ss << "used_memory:" << stats.memoryBytes << "\r\n";
+        ss << "used_memory_keys:" << stats.keyBytes << "\r\n";
+        ss << "used_memory_values:" << stats.valueBytes << "\r\n";
+        ss << "used_memory_index:" << stats.indexBytes << "\r\n";
+        ss << "used_memory_eviction:" << stats.evictionBytes << "\r\n";
+        ss << "used_memory_ttl:" << stats.ttlBytes << "\r\n";
+        ss << "used_memory_pinned:" << stats.pinnedBytes << "\r\n";
+        ss << "slab_page_bytes:" << stats.slabPageBytes << "\r\n";
+        ss << "slab_fragmentation_bytes:" << stats.fragmentationBytes << "\r\n";
+        ss << "maxmemory:" << stats.maxMemoryBytes << "\r\n";
+        ss << "maxmemory_policy:" << stats.evictionPolicy << "\r\n";
+        ss << "\r\n";
+    }
+    
+    if (all || section == "stats") {
+        long long commands = 0;
+        long long failed = 0;
+        for (const CommandStats& command : commandStats) {
+            commands += command.calls;
+            failed += command.failedCalls;
+        }
+        ss << "# Stats\r\n";
+        ss << "total_commands_processed:" << commands << "\r\n";
+        ss << "total_error_replies:" << failed + unknownCommands << "\r\n";
+        ss << "unknown_commands:" << unknownCommands << "\r\n";
+        ss << "total_operations:" << stats.totalOperations << "\r\n";
+        ss << "ops_per_sec:" << stats.opsPerSecond << "\r\n";
+        ss << "keyspace_hits:" << stats.keyspaceHits << "\r\n";
+        ss << "keyspace_misses:" << stats.keyspaceMisses << "\r\n";
+        ss << "expired_keys:" << stats.expiredKeys << "\r\n";
+        ss << "evicted_keys:" << stats.evictedKeys << "\r\n";
+        ss << "expire_cycles:" << stats.expireCycles << "\r\n";
+        ss << "expire_cycle_last_usec:" << stats.lastCycleMicros << "\r\n";
+        ss << "expire_cycle_total_usec:" << stats.totalCycleMicros << "\r\n";
+        ss << "index_resizes:" << stats.resizes << "\r\n";
+        ss << "index_resize_last_usec:" << stats.lastResizeMicros << "\r\n";
+        ss << "index_resize_max_usec:" << stats.maxResizeMicros << "\r\n";
+        ss << "index_resize_total_usec:" << stats.totalResizeMicros << "\r\n";
+        ss << "\r\n";
+    }
+    
+    if ((all || section == "persistence") && (aof || snapshots)) {
+        ss << "# Persistence\r\n";
+        ss << "aof_enabled:" << (aof ? 1 : 0) << "\r\n";
+        if (aof) {
+            AOFStats log = aof->getStats();
+            ss << "aof_current_size:" << log.fileBytes << "\r\n";
+            ss << "aof_base_size:" << log.rewriteBaseBytes << "\r\n";
+            ss << "aof_buffer_length:" << log.bufferedBytes << "\r\n";
+            ss << "aof_rewrite_in_progress:" << (log.rewriteInProgress ? 1 : 0) << "\r\n";
+            ss << "aof_rewrites:" << log.rewrites << "\r\n";
+            ss << "aof_fsyncs:" << log.fsyncs << "\r\n";
+            ss << "aof_write_errors:" << log.writeErrors << "\r\n";
+        }
+        if (snapshots) {
+            SnapshotStats dumps = snapshots->getStats();
+            ss << "rdb_bgsave_in_progress:" << (dumps.saveInProgress ? 1 : 0) << "\r\n";
+            ss << "rdb_last_save_time:" << dumps.lastSaveTime << "\r\n";
+            ss << "rdb_last_bgsave_status:" << (dumps.lastSaveOk ? "ok" : "err") << "\r\n";
+            ss << "rdb_saves:" << dumps.saves << "\r\n";
+            ss << "rdb_last_save_bytes:" << dumps.lastSaveBytes << "\r\n";
+            ss << "rdb_last_save_time_ms:" << dumps.lastSaveMillis << "\r\n";
+        }
+        ss << "\r\n";
+    }
+    
+    vector<size_t> used = commandsByName();
+    
+    if (all || section == "commandstats") {
+        ss << "# Commandstats\r\n";
+        for (size_t i : used) {
+            const CommandStats& command = commandStats[i];
+            double usec = command.latency.mean() * command.latency.count() / 1000;
+            ss << "cmdstat_" << toLower(COMMAND_TABLE[i].name) << ":calls=" << command.calls
+               << ",usec=" << setprecision(0) << usec << ",usec_per_call=" << setprecision(3) << usec / command.calls
+               << ",failed_calls=" << command.failedCalls << "\r\n";
+        }
+        ss << "\r\n";
+    }
+    
+    if (all || section == "latencystats") {
+        ss << "# Latencystats\r\n";
+        for (size_t i : used) {
+            const LatencyHistogram& latency = commandStats[i].latency;
+            ss << "latency_percentiles_usec_" << toLower(COMMAND_TABLE[i].name) << ":p50="
+               << latency.percentile(50) / 1000.0 << ",p99=" << latency.percentile(99) / 1000.0
+               << ",p99.9=" << latency.percentile(99.9) / 1000.0 << ",max=" << latency.max() / 1000.0 << "\r\n";
+        }
+        ss << "\r\n";
+    }
+    
+    if (all || section == "keyspace") {
+        ss << "# Keyspace\r\n";
+        if (stats.keys > 0) {
+            ss << "db0:keys=" << stats.keys << ",expires=" << stats.ttlEntries << "\r\n";
+        }
+        ss << "\r\n";
+    }
+    
+    reply.text(ss.str());
+}
+
+bool CommandProcessor::execute(const vector<string_view>& argv, ReplyWriter& reply) {
+    if (argv.empty()) {
+        reply.error("ERR empty command");
+        return true;
+    }
+    
+    const CommandSpec* command = lookupCommand(argv[0]);
+    if (!command) {
+        unknownCommands++;
+        reply.error("ERR unknown command '" + string(argv[0]) + "'");
+        return true;
+    }
+    
+    CommandStats& stats = commandStats[command - COMMAND_TABLE];
+    ErrorTrackingWriter tracked(reply);
+    long long start = nowNanos();
+    int argc = static_cast<int>(argv.size());
+    if (command->arity >= 0 ? argc != command->arity : argc < -command->arity) {
+        wrongArity(command->name, tracked);
+    } else {
+        (this->*command->handler)(argv, tracked);
+    }
+    stats.latency.record(nowNanos() - start);
+    stats.calls++;
+    if (tracked.failed) {
+        stats.failedCalls++;
+    }
+    
+    bool keepOpen = !closeRequested;
+    closeRequested = false;
+    return keepOpen;
+}
+
+bool CommandProcessor::execute(const vector<string>& argv, ReplyWriter& reply) {
+    vector<string_view> views(argv.begin(), argv.end());
+    return execute(views, reply);
+}
@@ -0,0 +1,57 @@
+#include "../include/EvictionPolicy.hpp"
+#include "../include/LRUCache.hpp"
+#include "../include/ApproximateLRU.hpp"
+#include "../include/LFUPolicy.hpp"
+#include "../include/TinyLFUPolicy.hpp"
+#include "../include/ARCPolicy.hpp"
+#include <algorithm>
+
+using namespace std;
+
+EvictionPolicy* createEvictionPolicy(EvictionType type, HashTable& table, size_t capacity) {
+    switch (type) {
+        case EvictionType::CLOCK:
+            return new ClockPolicy(table);
+        case EvictionType::SAMPLED_LRU:
+            return new SampledLRUPolicy(table);
+        case EvictionType::LFU:
+            // A key untouched for a cache's worth of inserts loses one count
+            return new LFUPolicy(table, LFUPolicy::DEFAULT_SAMPLES, capacity);
+        case EvictionType::TINY_LFU:
+            return new TinyLFUPolicy(capacity);
+        case EvictionType::ARC:
+            return new ARCPolicy();
+        case EvictionType::LRU:
+        default:
+            return new LRUCache(capacity);
+    }
+}
+
+bool parseEvictionType(const string& name, EvictionType& type) {
+    string lower = name;
+    transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "lru") {
+        type = EvictionType::LRU;
+    } else if (lower == "clock") {
+        type = EvictionType::CLOCK;
+    } else if (lower == "sampled-lru" || lower == "sampled") {
+        type = EvictionType::SAMPLED_LRU;
+    } else if (lower == "lfu") {
+        type = EvictionType::LFU;
+    } else if (lower == "w-tinylfu" || lower == "tinylfu") {
+        type = EvictionType::TINY_LFU;
+    } else if (lower == "arc") {
+        type = EvictionType::ARC;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const vector<EvictionType>& allEvictionTypes() {
+    static const vector<EvictionType> types = {
+        EvictionType::LRU, EvictionType::CLOCK, EvictionType::SAMPLED_LRU,
+        EvictionType::LFU, EvictionType::TINY_LFU, EvictionType::ARC
+    };
+    return types;
+}
@@ -2,158 +2,470 @@
 #include "../include/utils.hpp"
 #include <functional>
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
-const double HashTable::LOAD_FACTOR_THRESHOLD = 0.75;
+const double HashTable::LOAD_FACTOR_THRESHOLD = 0.875;
+
+namespace {
+
+// Control bytes. Empty is zero so fresh tables can come straight from calloc,
+// which lets the OS hand out zeroed pages lazily instead of us memset-ing a
+// multi-gigabyte table in one go.
+const uint8_t CTRL_EMPTY = 0x00;
+const uint8_t CTRL_DELETED = 0x01;
+
+inline uint8_t ctrlTag(size_t h) {
+    return 0x80 | (h & 0x7F);
+}
+
+// Bitmask of the slots in a 16-slot group whose control byte equals b
+inline uint32_t matchByte(const uint8_t* group, uint8_t b) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(b)))));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < 16; i++) {
+        if (group[i] == b) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+// Bitmask of the slots in a group that are empty or deleted (high bit clear)
+inline uint32_t matchFree(const uint8_t* group) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return ~static_cast<uint32_t>(_mm_movemask_epi8(ctrl)) & 0xFFFF;
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < 16; i++) {
+        if (!(group[i] & 0x80)) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+} // namespace
 
-HashTable::HashTable() : tableSize(INITIAL_SIZE), numElements(0) {
-    table.resize(tableSize);
+HashTable::HashTable() : rehashIndex(0), numElements(0) {
+    allocTable(table, INITIAL_SIZE);
 }
 
 HashTable::~HashTable() {
-    clear();
+    deleteAllNodes();
+    freeTable(table);
+    freeTable(oldTable);
 }
 
-size_t HashTable::hash(const string& key) const {
-    std::hash<std::string> hasher;
-    return hasher(key) % tableSize;
+// Same value as std::hash<std::string>, which ShardedCache also uses
+size_t HashTable::hashKey(string_view key) {
+    std::hash<string_view> hasher;
+    return hasher(key);
 }
 
-void HashTable::resize() {
-    vector<list<HashNode>> oldTable = move(table);
-    size_t oldSize = tableSize;
-    
-    tableSize *= 2;
-    table.clear();
-    table.resize(tableSize);
-    numElements = 0;
-    
-    // Rehash all elements
-    for (const auto& bucket : oldTable) {
-        for (const auto& node : bucket) {
-            insert(node.key, node.value, node.expiryTime);
+void HashTable::allocTable(Table& t, size_t capacity) {
+    t.ctrl = static_cast<uint8_t*>(calloc(capacity, sizeof(uint8_t)));
+    t.slots = static_cast<HashNode**>(calloc(capacity, sizeof(HashNode*)));
+    if (!t.ctrl || !t.slots) {
+        free(t.ctrl);
+        free(t.slots);
+        throw bad_alloc();
+    }
+    t.capacity = capacity;
+    t.used = 0;
+    t.deleted = 0;
+}
+
+void HashTable::freeTable(Table& t) {
+    free(t.ctrl);
+    free(t.slots);
+    t = Table();
+}
+
+// Probes groups in triangular order (g, g+1, g+3, g+6, ...), which visits
+// every group of a power-of-two table. A group with an empty slot ends the
+// probe since an insert would have stopped there.
+HashNode** HashTable::findSlot(const Table& t, string_view key, size_t h) {
+    size_t numGroups = t.numGroups();
+    size_t mask = numGroups - 1;
+    size_t group = (h >> 7) & mask;
+    uint8_t tag = ctrlTag(h);
+
+    for (size_t probe = 1; ; probe++) {
+        const uint8_t* ctrl = t.ctrl + group * GROUP_WIDTH;
+        uint32_t matches = matchByte(ctrl, tag);
+
+        while (matches) {
+            size_t index = group * GROUP_WIDTH + __builtin_ctz(matches);
+            HashNode* node = t.slots[index];
+            // Slots of the old table that were already migrated are null
+            if (node && node->hash == h && node->key() == key) {
+                return &t.slots[index];
+            }
+            matches &= matches - 1;
+        }
+
+        if (matchByte(ctrl, CTRL_EMPTY) || probe >= numGroups) {
+            return nullptr;
         }
+        group = (group + probe) & mask;
     }
 }
 
-bool HashTable::insert(const string& key, const string& value, long long expiryTime) {
-    // Check if key already exists and update
-    size_t index = hash(key);
-    auto& bucket = table[index];
-    
-    for (auto& node : bucket) {
-        if (node.key == key) {
-            node.value = value;
-            node.expiryTime = expiryTime;
-            return true;
+void HashTable::placeNode(Table& t, HashNode* node) {
+    size_t mask = t.numGroups() - 1;
+    size_t group = (node->hash >> 7) & mask;
+
+    for (size_t probe = 1; ; probe++) {
+        uint32_t freeSlots = matchFree(t.ctrl + group * GROUP_WIDTH);
+        if (freeSlots) {
+            size_t index = group * GROUP_WIDTH + __builtin_ctz(freeSlots);
+            if (t.ctrl[index] == CTRL_DELETED) {
+                t.deleted--;
+            }
+            t.ctrl[index] = ctrlTag(node->hash);
+            t.slots[index] = node;
+            t.used++;
+            return;
         }
+        group = (group + probe) & mask;
+    }
+}
+
+void HashTable::eraseSlot(Table& t, HashNode** slot) {
+    size_t index = slot - t.slots;
+    const uint8_t* group = t.ctrl + (index & ~(GROUP_WIDTH - 1));
+
+    // A group that still has an empty slot has never been full, so no probe
+    // ever continued past it and the slot can go straight back to empty.
+    if (matchByte(group, CTRL_EMPTY)) {
+        t.ctrl[index] = CTRL_EMPTY;
+    } else {
+        t.ctrl[index] = CTRL_DELETED;
+        t.deleted++;
+    }
+    t.slots[index] = nullptr;
+    t.used--;
+}
+
+HashNode** HashTable::lookup(string_view key, size_t h) const {
+    HashNode** slot = findSlot(table, key, h);
+    if (!slot && isRehashing()) {
+        slot = findSlot(oldTable, key, h);
+    }
+    return slot;
+}
+
+HashNode** HashTable::lookupOwner(string_view key, size_t h, Table*& owner) {
+    owner = &table;
+    HashNode** slot = findSlot(table, key, h);
+    if (!slot && isRehashing()) {
+        owner = &oldTable;
+        slot = findSlot(oldTable, key, h);
+    }
+    return slot;
+}
+
+static long long nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void HashTable::recordResize(long long startNanos) {
+    long long micros = (nowNanos() - startNanos) / 1000;
+    resizeStats.resizes++;
+    resizeStats.lastMicros = micros;
+    resizeStats.maxMicros = max(resizeStats.maxMicros, micros);
+    resizeStats.totalMicros += micros;
+}
+
+void HashTable::startRehash() {
+    long long start = nowNanos();
+
+    // The new table is sized so the old one drains long before it fills up,
+    // but finish any leftover migration rather than nesting rehashes.
+    if (isRehashing()) {
+        rehashStep(oldTable.numGroups());
+    }
+
+    // Grow when live entries dominate, otherwise just purge tombstones
+    size_t newCapacity = table.capacity;
+    if (table.used * 2 >= table.capacity * LOAD_FACTOR_THRESHOLD) {
+        newCapacity *= 2;
+    }
+
+    oldTable = table;
+    table = Table();
+    allocTable(table, newCapacity);
+    rehashIndex = 0;
+    recordResize(start);
+}
+
+void HashTable::rehashStep(size_t groups) {
+    size_t numGroups = oldTable.numGroups();
+
+    while (groups-- > 0 && rehashIndex < numGroups && oldTable.used > 0) {
+        size_t end = (rehashIndex + 1) * GROUP_WIDTH;
+        for (size_t i = rehashIndex * GROUP_WIDTH; i < end; i++) {
+            HashNode* node = oldTable.slots[i];
+            if (node) {
+                // Keep the control byte so probes through this group still
+                // behave as before; the null slot marks it as migrated.
+                placeNode(table, node);
+                oldTable.slots[i] = nullptr;
+                oldTable.used--;
+            }
+        }
+        rehashIndex++;
+    }
+
+    if (rehashIndex >= numGroups || oldTable.used == 0) {
+        freeTable(oldTable);
+        rehashIndex = 0;
+    }
+}
+
+// One slab chunk holds the node and, right behind it, the key's bytes
+HashNode* HashTable::createNode(string_view key, size_t h) {
+    void* memory = slabs.allocate(sizeof(HashNode) + key.size());
+    HashNode* node = new (memory) HashNode(h, static_cast<uint32_t>(key.size()));
+    memcpy(reinterpret_cast<char*>(node + 1), key.data(), key.size());
+    return node;
+}
+
+void HashTable::destroyNode(HashNode* node) {
+    size_t bytes = node->allocSize();
+    node->~HashNode();
+    slabs.deallocate(node, bytes);
+}
+
+HashNode* HashTable::upsert(string_view key, size_t h, bool& created) {
+    if (isRehashing()) {
+        rehashStep(REHASH_GROUPS_PER_STEP);
+    }
+
+    HashNode** slot = lookup(key, h);
+    if (slot) {
+        created = false;
+        return *slot;
+    }
+
+    // Tombstones count towards the load since they lengthen probes
+    if (table.used + table.deleted + 1 > table.capacity * LOAD_FACTOR_THRESHOLD) {
+        startRehash();
     }
-    
-    // Add new node
-    bucket.emplace_back(key, value, expiryTime);
+
+    HashNode* node = createNode(key, h);
+    placeNode(table, node);
     numElements++;
-    
-    // Check if resize is needed
-    if (static_cast<double>(numElements) / tableSize > LOAD_FACTOR_THRESHOLD) {
-        resize();
+    created = true;
+    return node;
+}
+
+void HashTable::reserve(size_t count) {
+    size_t capacity = table.capacity;
+    while (count > capacity * LOAD_FACTOR_THRESHOLD) {
+        capacity *= 2;
     }
-    
+    if (capacity == table.capacity) {
+        return;
+    }
+
+    // Moves every node now instead of incrementally: this is a one-off
+    // before a bulk load, when the table is usually still empty
+    long long start = nowNanos();
+    if (isRehashing()) {
+        rehashStep(oldTable.numGroups());
+    }
+    oldTable = table;
+    table = Table();
+    allocTable(table, capacity);
+    rehashIndex = 0;
+    rehashStep(oldTable.numGroups());
+    recordResize(start);
+}
+
+HashNode* HashTable::insertUnique(string_view key, size_t h) {
+    if (isRehashing()) {
+        rehashStep(REHASH_GROUPS_PER_STEP);
+    }
+    if (table.used + table.deleted + 1 > table.capacity * LOAD_FACTOR_THRESHOLD) {
+        startRehash();
+    }
+
+    HashNode* node = createNode(key, h);
+    placeNode(table, node);
+    numElements++;
+    return node;
+}
+
+bool HashTable::insert(const string& key, const string& value, long long expiryTime) {
+    return insert(key, string(value), expiryTime);
+}
+
+bool HashTable::insert(const string& key, string&& value, long long expiryTime) {
+    bool created;
+    HashNode* node = upsert(key, created);
+    node->value = ValueRef::adopt(move(value), &slabs);
+    node->expiryTime = expiryTime;
     return true;
 }
 
+const HashNode* HashTable::findLive(const string& key) const {
+    HashNode** slot = lookup(key, hashKey(key));
+    if (!slot) {
+        return nullptr;
+    }
+
+    // Check if expired
+    const HashNode* node = *slot;
+    if (node->expiryTime != -1 && Utils::monotonicMillis() > node->expiryTime) {
+        return nullptr;
+    }
+    return node;
+}
+
+// Copies straight from the stored bytes; taking a reference first would
+// cost two atomic updates on a line that is usually a cache miss
 bool HashTable::get(const string& key, string& value) const {
-    size_t index = hash(key);
-    const auto& bucket = table[index];
-    long long currentTime = Utils::getCurrentTimestamp();
-    
-    for (const auto& node : bucket) {
-        if (node.key == key) {
-            // Check if expired
-            if (node.expiryTime != -1 && currentTime > node.expiryTime) {
-                return false;
-            }
-            value = node.value;
-            return true;
-        }
+    const HashNode* node = findLive(key);
+    if (!node) {
+        return false;
     }
-    
-    return false;
+    char digits[ValueRef::MAX_DIGITS];
+    value.assign(node->value.view(digits));
+    return true;
+}
+
+bool HashTable::get(const string& key, ValueRef& value) const {
+    const HashNode* node = findLive(key);
+    if (!node) {
+        return false;
+    }
+    value = node->value;
+    return true;
+}
+
+HashNode* HashTable::find(string_view key, size_t h) const {
+    HashNode** slot = lookup(key, h);
+    return slot ? *slot : nullptr;
+}
+
+void HashTable::prefetch(size_t h) const {
+    size_t group = (h >> 7) & (table.numGroups() - 1);
+    __builtin_prefetch(table.ctrl + group * GROUP_WIDTH);
+    __builtin_prefetch(table.slots + group * GROUP_WIDTH);
 }
 
 bool HashTable::remove(const string& key) {
-    size_t index = hash(key);
-    auto& bucket = table[index];
-    
-    auto it = find_if(bucket.begin(), bucket.end(),
-        [&key](const HashNode& node) { return node.key == key; });
-    
-    if (it != bucket.end()) {
-        bucket.erase(it);
+    HashNode* node = find(key);
+    if (!node) {
+        return false;
+    }
+
+    erase(node);
+    return true;
+}
+
+void HashTable::erase(HashNode* node) {
+    if (isRehashing()) {
+        rehashStep(REHASH_GROUPS_PER_STEP);
+    }
+
+    Table* owner;
+    HashNode** slot = lookupOwner(node->key(), node->hash, owner);
+    if (slot) {
+        eraseSlot(*owner, slot);
+        destroyNode(node);
         numElements--;
-        return true;
     }
-    
-    return false;
 }
 
 bool HashTable::exists(const string& key) const {
-    string dummy;
-    return get(key, dummy);
+    return findLive(key) != nullptr;
 }
 
 bool HashTable::updateExpiry(const string& key, long long expiryTime) {
-    size_t index = hash(key);
-    auto& bucket = table[index];
-    
-    for (auto& node : bucket) {
-        if (node.key == key) {
-            // Check if not already expired
-            long long currentTime = Utils::getCurrentTimestamp();
-            if (node.expiryTime != -1 && currentTime > node.expiryTime) {
-                return false;
+    if (isRehashing()) {
+        rehashStep(REHASH_GROUPS_PER_STEP);
+    }
+
+    HashNode** slot = lookup(key, hashKey(key));
+    if (!slot) {
+        return false;
+    }
+
+    // Check if not already expired
+    HashNode* node = *slot;
+    long long currentTime = Utils::monotonicMillis();
+    if (node->expiryTime != -1 && currentTime > node->expiryTime) {
+        return false;
+    }
+    node->expiryTime = expiryTime;
+    return true;
+}
+
+size_t HashTable::memoryUsage() const {
+    size_t slotBytes = sizeof(uint8_t) + sizeof(HashNode*);
+    return (table.capacity + oldTable.capacity) * slotBytes;
+}
+
+void HashTable::deleteAllNodes() {
+    for (Table* t : {&table, &oldTable}) {
+        for (size_t i = 0; i < t->capacity; i++) {
+            if (t->slots[i]) {
+                destroyNode(t->slots[i]);
             }
-            node.expiryTime = expiryTime;
-            return true;
         }
     }
-    
-    return false;
 }
 
 void HashTable::clear() {
-    for (auto& bucket : table) {
-        bucket.clear();
-    }
+    deleteAllNodes();
+    freeTable(table);
+    freeTable(oldTable);
+    allocTable(table, INITIAL_SIZE);
+    rehashIndex = 0;
     numElements = 0;
 }
 
 vector<string> HashTable::getAllKeys() const {
     vector<string> keys;
-    long long currentTime = Utils::getCurrentTimestamp();
-    
-    for (const auto& bucket : table) {
-        for (const auto& node : bucket) {
+    long long currentTime = Utils::monotonicMillis();
+
+    for (const Table* t : {&table, &oldTable}) {
+        for (size_t i = 0; i < t->capacity; i++) {
+            const HashNode* node = t->slots[i];
             // Only include non-expired keys
-            if (node.expiryTime == -1 || currentTime <= node.expiryTime) {
-                keys.push_back(node.key);
+            if (node && (node->expiryTime == -1 || currentTime <= node->expiryTime)) {
+                keys.emplace_back(node->key());
             }
         }
     }
-    
+
     return keys;
 }
 
 vector<string> HashTable::getExpiredKeys(long long currentTime) const {
     vector<string> expiredKeys;
-    
-    for (const auto& bucket : table) {
-        for (const auto& node : bucket) {
-            if (node.expiryTime != -1 && currentTime > node.expiryTime) {
-                expiredKeys.push_back(node.key);
+
+    for (const Table* t : {&table, &oldTable}) {
+        for (size_t i = 0; i < t->capacity; i++) {
+            const HashNode* node = t->slots[i];
+            if (node && node->expiryTime != -1 && currentTime > node->expiryTime) {
+                expiredKeys.emplace_back(node->key());
             }
         }
     }
-    
+
     return expiredKeys;
-}
\ No newline at end of file
+}
@@ -0,0 +1,243 @@
+#include "../include/HashValue.hpp"
+
+using namespace std;
+
+HashValue::HashValue(SlabAllocator* owner)
+    : slabs(owner), pack(nullptr), table(false), count(0), packBytes(0), packCapacity(0), heapBytes(0) {}
+
+HashValue::HashValue(SlabAllocator* owner, string_view serialized) : HashValue(owner) {
+    size_t entries = 0;
+    bool compact = true;
+    const char* pos = serialized.data();
+    const char* end = pos + serialized.size();
+    while (pos < end) {
+        string_view field, value;
+        pos = Listpack::readString(pos, end, field);
+        pos = Listpack::readString(pos, end, value);
+        compact = compact && field.size() <= MAX_LISTPACK_VALUE && value.size() <= MAX_LISTPACK_VALUE;
+        entries++;
+    }
+
+    if (compact && entries <= MAX_LISTPACK_ENTRIES) {
+        packReserve(serialized.size());
+        memcpy(pack, serialized.data(), serialized.size());
+        packBytes = static_cast<uint32_t>(serialized.size());
+        count = static_cast<uint32_t>(entries);
+        return;
+    }
+
+    table = true;
+    fields.reserve(slabs, entries);
+    pos = serialized.data();
+    while (pos < end) {
+        string_view field, value;
+        pos = Listpack::readString(pos, end, field);
+        pos = Listpack::readString(pos, end, value);
+        fields.insert(slabs, newField(RecordIndex<Field>::hashKey(field), field, value));
+    }
+}
+
+HashValue::~HashValue() {
+    fields.forEach([&](Field* record) { freeField(record); });
+    fields.release(slabs);
+    if (pack) {
+        slabs->deallocate(pack, packCapacity);
+    }
+}
+
+bool HashValue::isValid(string_view serialized) {
+    const char* pos = serialized.data();
+    const char* end = pos + serialized.size();
+    if (pos == end) {
+        return false;   // hashes are never empty
+    }
+    while (pos < end) {
+        string_view field, value;
+        pos = Listpack::readString(pos, end, field);
+        pos = pos ? Listpack::readString(pos, end, value) : nullptr;
+        if (!pos) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t HashValue::packFind(string_view field, string_view* value) const {
+    const char* pos = pack;
+    const char* end = pack + packBytes;
+    while (pos < end) {
+        const char* entry = pos;
+        string_view name, data;
+        pos = Listpack::readString(pos, end, name);
+        pos = Listpack::readString(pos, end, data);
+        if (name == field) {
+            if (value) *value = data;
+            return entry - pack;
+        }
+    }
+    return packBytes;
+}
+
+// Grows the buffer to a whole slab chunk of at least bytes, so appends
+// fill the chunk before moving again
+void HashValue::packReserve(size_t bytes) {
+    if (bytes <= packCapacity) {
+        return;
+    }
+    size_t newCapacity = slabs->chunkSize(bytes);
+    char* grown = static_cast<char*>(slabs->allocate(newCapacity));
+    if (pack) {
+        memcpy(grown, pack, packBytes);
+        slabs->deallocate(pack, packCapacity);
+    }
+    heapBytes += newCapacity - packCapacity;
+    pack = grown;
+    packCapacity = static_cast<uint32_t>(newCapacity);
+}
+
+// Writes field and value over the entry at offset entry, or appends them
+// when entry is packBytes, moving what follows
+void HashValue::packSet(size_t entry, string_view field, string_view value) {
+    size_t oldBytes = 0;
+    if (entry < packBytes) {
+        const char* end = pack + packBytes;
+        string_view oldField, oldValue;
+        const char* pos = Listpack::readString(pack + entry, end, oldField);
+        pos = Listpack::readString(pos, end, oldValue);
+        oldBytes = pos - (pack + entry);
+    }
+    size_t newBytes = Listpack::entryBytes(field) + Listpack::entryBytes(value);
+    size_t total = packBytes - oldBytes + newBytes;
+    packReserve(total);
+
+    char* at = pack + entry;
+    memmove(at + newBytes, at + oldBytes, packBytes - entry - oldBytes);
+    at = Listpack::writeString(at, field);
+    Listpack::writeString(at, value);
+    packBytes = static_cast<uint32_t>(total);
+}
+
+void HashValue::packRemove(size_t entry) {
+    const char* end = pack + packBytes;
+    string_view field, value;
+    const char* pos = Listpack::readString(pack + entry, end, field);
+    pos = Listpack::readString(pos, end, value);
+    memmove(pack + entry, pos, end - pos);
+    packBytes -= static_cast<uint32_t>(pos - (pack + entry));
+}
+
+// fieldCount is how many fields the table should have room for
+void HashValue::convertToTable(size_t fieldCount) {
+    fields.reserve(slabs, fieldCount);
+    forEach([&](string_view field, string_view value) {
+        fields.insert(slabs, newField(RecordIndex<Field>::hashKey(field), field, value));
+    });
+    table = true;
+
+    if (pack) {
+        slabs->deallocate(pack, packCapacity);
+        heapBytes -= packCapacity;
+    }
+    pack = nullptr;
+    count = 0;
+    packBytes = 0;
+    packCapacity = 0;
+}
+
+HashValue::Field* HashValue::newField(uint32_t h, string_view field, string_view value) {
+    size_t bytes = sizeof(Field) + field.size() + value.size();
+    Field* record = static_cast<Field*>(slabs->allocate(bytes));
+    record->hash = h;
+    record->fieldLength = static_cast<uint32_t>(field.size());
+    record->valueLength = static_cast<uint32_t>(value.size());
+    memcpy(record->bytes(), field.data(), field.size());
+    memcpy(record->bytes() + field.size(), value.data(), value.size());
+    heapBytes += slabs->chunkSize(bytes);
+    return record;
+}
+
+void HashValue::freeField(Field* record) {
+    size_t bytes = record->allocSize();
+    heapBytes -= slabs->chunkSize(bytes);
+    slabs->deallocate(record, bytes);
+}
+
+// True if field is new
+bool HashValue::tableSet(string_view field, string_view value) {
+    uint32_t h = RecordIndex<Field>::hashKey(field);
+    Field** slot = fields.findSlot(field, h);
+    if (!slot) {
+        fields.insert(slabs, newField(h, field, value));
+        return true;
+    }
+    Field* record = *slot;
+    if (record->valueLength == value.size()) {
+        memcpy(record->bytes() + record->fieldLength, value.data(), value.size());
+    } else {
+        *slot = newField(h, field, value);
+        freeField(record);
+    }
+    return false;
+}
+
+bool HashValue::get(string_view field, string_view& value) const {
+    if (!table) {
+        return packFind(field, &value) != packBytes;
+    }
+    const Field* record = fields.find(field, RecordIndex<Field>::hashKey(field));
+    if (record) {
+        value = record->value();
+    }
+    return record != nullptr;
+}
+
+bool HashValue::exists(string_view field) const {
+    string_view value;
+    return get(field, value);
+}
+
+bool HashValue::set(string_view field, string_view value) {
+    if (!table) {
+        bool fits = field.size() <= MAX_LISTPACK_VALUE && value.size() <= MAX_LISTPACK_VALUE;
+        size_t entry = packFind(field);
+        bool created = entry == packBytes;
+        if (fits && (!created || count < MAX_LISTPACK_ENTRIES)) {
+            packSet(entry, field, value);
+            if (created) count++;
+            return created;
+        }
+        convertToTable(count + 1);
+    }
+    return tableSet(field, value);
+}
+
+bool HashValue::remove(string_view field) {
+    if (table) {
+        Field* record = fields.remove(field, RecordIndex<Field>::hashKey(field));
+        if (record) {
+            freeField(record);
+        }
+        return record != nullptr;
+    }
+    size_t entry = packFind(field);
+    if (entry == packBytes) {
+        return false;
+    }
+    packRemove(entry);
+    count--;
+    return true;
+}
+
+void HashValue::serialize(string& out) const {
+    if (!table) {
+        out.append(pack, packBytes);
+        return;
+    }
+    char length[10];
+    forEach([&](string_view field, string_view value) {
+        out.append(length, Listpack::writeLength(length, field.size()) - length);
+        out.append(field);
+        out.append(length, Listpack::writeLength(length, value.size()) - length);
+        out.append(value);
+    });
+}
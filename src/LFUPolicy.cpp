@@ -0,0 +1,45 @@
+#include "../include/LFUPolicy.hpp"
+
+using namespace std;
+
+uint8_t LFUPolicy::decayedCount(const HashNode* node) const {
+    uint8_t counter = node->evictionState & 0xFF;
+    uint32_t touched = node->evictionState >> 8;
+    uint32_t elapsed = (period() - touched) & 0xFFFF;   // the period wraps
+    return elapsed >= counter ? 0 : static_cast<uint8_t>(counter - elapsed);
+}
+
+// Counts up with probability 1 / ((counter - INITIAL_COUNT) * LOG_FACTOR + 1),
+// so 8 bits cover millions of hits
+uint8_t LFUPolicy::logIncrement(uint8_t counter) {
+    if (counter == 255) return counter;
+    
+    double base = counter > INITIAL_COUNT ? counter - INITIAL_COUNT : 0;
+    double r = double(sampler.random() >> 11) / double(1ULL << 53);
+    if (r < 1.0 / (base * LOG_FACTOR + 1)) {
+        counter++;
+    }
+    return counter;
+}
+
+void LFUPolicy::insert(HashNode* node) {
+    inserts++;
+    store(node, INITIAL_COUNT);
+    count++;
+}
+
+HashNode* LFUPolicy::victim(const HashNode* keep) {
+    HashNode* coldest = nullptr;
+    uint8_t coldestCount = 0;
+    for (size_t i = 0; i < samples; i++) {
+        HashNode* node = sampler.sample(keep);
+        if (!node) break;
+        
+        uint8_t counter = decayedCount(node);
+        if (!coldest || counter < coldestCount) {
+            coldest = node;
+            coldestCount = counter;
+        }
+    }
+    return coldest;
+}
@@ -2,106 +2,70 @@
 
 using namespace std;
 
-LRUCache::LRUCache(size_t cap) : capacity(cap), currentSize(0) {
-    head = new LRUNode("");
-    tail = new LRUNode("");
-    head->next = tail;
-    tail->prev = head;
+LRUCache::LRUCache(size_t cap) : head(), tail(), capacity(cap), currentSize(0) {
+    head.lruNext = &tail;
+    tail.lruPrev = &head;
 }
 
 LRUCache::~LRUCache() {
     clear();
-    delete head;
-    delete tail;
 }
 
-void LRUCache::addToHead(LRUNode* node) {
-    node->prev = head;
-    node->next = head->next;
-    head->next->prev = node;
-    head->next = node;
+void LRUCache::addToHead(HashNode* node) {
+    node->lruPrev = &head;
+    node->lruNext = head.lruNext;
+    head.lruNext->lruPrev = node;
+    head.lruNext = node;
 }
 
-void LRUCache::removeNode(LRUNode* node) {
-    node->prev->next = node->next;
-    node->next->prev = node->prev;
+void LRUCache::removeNode(HashNode* node) {
+    node->lruPrev->lruNext = node->lruNext;
+    node->lruNext->lruPrev = node->lruPrev;
+    node->lruPrev = nullptr;
+    node->lruNext = nullptr;
 }
 
-void LRUCache::moveToHead(LRUNode* node) {
+void LRUCache::moveToHead(HashNode* node) {
+    if (head.lruNext == node) return;
     removeNode(node);
     addToHead(node);
 }
 
-// LRUNode* LRUCache::removeTail() {
-//     LRUNode* lastNode = tail->prev;
-//     removeNode(lastNode);
-//     return lastNode;
-// }
-
-LRUNode* LRUCache::removeTail() {
-    if (tail->prev == head) return nullptr;  // list empty
-    LRUNode* lastNode = tail->prev;
+HashNode* LRUCache::removeTail() {
+    if (tail.lruPrev == &head) return nullptr;  // list empty
+    HashNode* lastNode = tail.lruPrev;
     removeNode(lastNode);
     return lastNode;
 }
 
-
-// void LRUCache::access(const string& key) {
-//     auto it = keyToNode.find(key);
-    
-//     if (it != keyToNode.end()) {
-//         // Key exists, move to head
-//         moveToHead(it->second);
-//     } else {
-//         // New key, add to head
-//         LRUNode* newNode = new LRUNode(key);
-//         keyToNode[key] = newNode;
-//         addToHead(newNode);
-//         currentSize++;
-//     }
-// }
-
-void LRUCache::access(const string& key) {
-    auto it = keyToNode.find(key);
-    
-    if (it != keyToNode.end()) {
-        // Key exists, move to head
-        moveToHead(it->second);
+void LRUCache::access(HashNode* node) {
+    if (node->lruPrev) {
+        // Already linked, move to head
+        moveToHead(node);
     } else {
-        // If full, evict the least recently used node first
-        if (currentSize >= capacity) {
-            evictLRU();
-        }
-        // Now add new node
-        LRUNode* newNode = new LRUNode(key);
-        keyToNode[key] = newNode;
-        addToHead(newNode);
+        addToHead(node);
         currentSize++;
     }
 }
 
-
-string LRUCache::evictLRU() {
-    if (currentSize == 0) {
-        return "";
+HashNode* LRUCache::evictLRU() {
+    HashNode* lruNode = removeTail();
+    if (lruNode) {
+        currentSize--;
     }
-    
-    LRUNode* lruNode = removeTail();
-    string evictedKey = lruNode->key;
-    keyToNode.erase(evictedKey);
-    delete lruNode;
-    currentSize--;
-    
-    return evictedKey;
+    return lruNode;
+}
+
+// The newly written key is at the front, so it is only the least recent
+// when it is the only one
+HashNode* LRUCache::victim(const HashNode* keep) {
+    HashNode* node = leastRecent();
+    return node == keep ? nullptr : node;
 }
 
-void LRUCache::remove(const string& key) {
-    auto it = keyToNode.find(key);
-    if (it != keyToNode.end()) {
-        LRUNode* node = it->second;
+void LRUCache::remove(HashNode* node) {
+    if (node->lruPrev) {
         removeNode(node);
-        keyToNode.erase(key);
-        delete node;
         currentSize--;
     }
 }
@@ -110,4 +74,4 @@ void LRUCache::clear() {
     while (currentSize > 0) {
         evictLRU();
     }
-}
\ No newline at end of file
+}
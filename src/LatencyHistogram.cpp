@@ -0,0 +1,67 @@
+#include "../include/LatencyHistogram.hpp"
+#include <cstring>
+
+using namespace std;
+
+size_t LatencyHistogram::bucketOf(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return value;
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent > MAX_EXPONENT) {
+        return NUM_BUCKETS - 1;
+    }
+    // value >> shift keeps the top SUB_BUCKET_BITS + 1 bits, the leading one
+    // included, so it lies in [SUB_BUCKETS, 2 * SUB_BUCKETS)
+    int shift = exponent - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::highestValueIn(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = bucket / SUB_BUCKETS - 1;
+    uint64_t lowest = (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    return lowest + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    if (other.total && other.minValue < minValue) minValue = other.minValue;
+    if (other.maxValue > maxValue) maxValue = other.maxValue;
+}
+
+void LatencyHistogram::reset() {
+    memset(counts, 0, sizeof(counts));
+    total = 0;
+    sum = 0;
+    minValue = UINT64_MAX;
+    maxValue = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double percentile) const {
+    if (total == 0) {
+        return 0;
+    }
+    // The rank of the sample asked for, 1-based, rounded up
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * total + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            // Never above the largest value actually recorded, which is
+            // also the best answer for the open-ended last bucket
+            uint64_t bound = highestValueIn(i);
+            return bound < maxValue && i < NUM_BUCKETS - 1 ? bound : maxValue;
+        }
+    }
+    return maxValue;
+}
@@ -0,0 +1,159 @@
+#include "../include/ListValue.hpp"
+
+using namespace std;
+
+ListValue::ListValue(SlabAllocator* owner)
+    : slabs(owner), head(nullptr), tail(nullptr), count(0), chunks(0), heapBytes(0) {}
+
+ListValue::ListValue(SlabAllocator* owner, string_view serialized) : ListValue(owner) {
+    const char* pos = serialized.data();
+    const char* end = pos + serialized.size();
+    while (pos < end) {
+        string_view value;
+        pos = Listpack::readString(pos, end, value);
+        push(value, false);
+    }
+}
+
+ListValue::~ListValue() {
+    while (head) {
+        freeChunk(head);
+    }
+}
+
+bool ListValue::isValid(string_view serialized) {
+    const char* pos = serialized.data();
+    const char* end = pos + serialized.size();
+    if (pos == end) {
+        return false;   // lists are never empty
+    }
+    while (pos < end) {
+        string_view value;
+        pos = Listpack::readString(pos, end, value);
+        if (!pos) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The string behind its length, then the back length of both
+size_t ListValue::entryBytes(string_view value) {
+    size_t bytes = Listpack::entryBytes(value);
+    return bytes + Listpack::lengthBytes(bytes);
+}
+
+const char* ListValue::readEntry(const char* pos, string_view& value) {
+    size_t length;
+    const char* start = pos;
+    pos = Listpack::readLength(pos, pos + 10, length);
+    value = string_view(pos, length);
+    return pos + length + Listpack::lengthBytes(pos + length - start);
+}
+
+// A chunk with room for bytes of entries, linked in between prev and next
+ListValue::Chunk* ListValue::newChunk(size_t bytes, Chunk* prev, Chunk* next) {
+    size_t allocation = slabs->chunkSize(sizeof(Chunk) + bytes);
+    Chunk* chunk = static_cast<Chunk*>(slabs->allocate(allocation));
+    chunk->prev = prev;
+    chunk->next = next;
+    chunk->count = 0;
+    chunk->bytes = 0;
+    chunk->capacity = static_cast<uint32_t>(allocation - sizeof(Chunk));
+    (prev ? prev->next : head) = chunk;
+    (next ? next->prev : tail) = chunk;
+    heapBytes += allocation;
+    chunks++;
+    return chunk;
+}
+
+// Moves chunk to a larger allocation holding at least bytes of entries,
+// doubling up to CHUNK_BYTES so each entry is copied O(1) times
+ListValue::Chunk* ListValue::growChunk(Chunk* chunk, size_t bytes) {
+    if (bytes <= chunk->capacity) {
+        return chunk;
+    }
+    size_t target = 2 * static_cast<size_t>(chunk->capacity);
+    if (target > CHUNK_BYTES) target = CHUNK_BYTES;
+    if (target < bytes) target = bytes;
+    Chunk* grown = newChunk(target, chunk->prev, chunk->next);
+    grown->count = chunk->count;
+    grown->bytes = chunk->bytes;
+    memcpy(grown->data(), chunk->data(), chunk->bytes);
+    chunk->next = nullptr;      // already relinked around grown
+    chunk->prev = nullptr;
+    size_t allocation = sizeof(Chunk) + chunk->capacity;
+    slabs->deallocate(chunk, allocation);
+    heapBytes -= allocation;
+    chunks--;
+    return grown;
+}
+
+void ListValue::freeChunk(Chunk* chunk) {
+    (chunk->prev ? chunk->prev->next : head) = chunk->next;
+    (chunk->next ? chunk->next->prev : tail) = chunk->prev;
+    size_t allocation = sizeof(Chunk) + chunk->capacity;
+    slabs->deallocate(chunk, allocation);
+    heapBytes -= allocation;
+    chunks--;
+}
+
+void ListValue::push(string_view value, bool front) {
+    size_t bytes = entryBytes(value);
+    Chunk* chunk = front ? head : tail;
+    if (!chunk || chunk->bytes + bytes > CHUNK_BYTES) {
+        chunk = front ? newChunk(bytes, nullptr, head) : newChunk(bytes, tail, nullptr);
+    }
+    chunk = growChunk(chunk, chunk->bytes + bytes);
+
+    char* at = chunk->data();
+    if (front) {
+        memmove(at + bytes, at, chunk->bytes);
+    } else {
+        at += chunk->bytes;
+    }
+    char* end = Listpack::writeString(at, value);
+    Listpack::writeBackLength(end, end - at);
+    chunk->bytes += static_cast<uint32_t>(bytes);
+    chunk->count++;
+    count++;
+}
+
+bool ListValue::pop(bool front, string& value) {
+    Chunk* chunk = front ? head : tail;
+    if (!chunk) {
+        return false;
+    }
+
+    const char* entry;
+    if (front) {
+        entry = chunk->data();
+    } else {
+        size_t length;
+        const char* backLength = Listpack::readBackLength(chunk->data() + chunk->bytes, length);
+        entry = backLength - length;
+    }
+    string_view element;
+    const char* next = readEntry(entry, element);
+    value.assign(element);
+
+    size_t bytes = next - entry;
+    if (front) {
+        memmove(chunk->data(), next, chunk->bytes - bytes);
+    }
+    chunk->bytes -= static_cast<uint32_t>(bytes);
+    chunk->count--;
+    count--;
+    if (chunk->count == 0) {
+        freeChunk(chunk);
+    }
+    return true;
+}
+
+void ListValue::serialize(string& out) const {
+    char length[10];
+    forEach([&](string_view value) {
+        out.append(length, Listpack::writeLength(length, value.size()) - length);
+        out.append(value);
+    });
+}
@@ -0,0 +1,246 @@
+#include "../include/RESP.hpp"
+
+using namespace std;
+
+RESPParser::Result RESPParser::parseCommand(string& buffer, size_t& pos, vector<string_view>& argv,
+                                            string& error) {
+    if (pos >= buffer.size()) {
+        return INCOMPLETE;
+    }
+    
+    if (buffer[pos] == '*') {
+        return parseMultiBulk(buffer, pos, argv, error);
+    }
+    return parseInline(buffer, pos, argv, error);
+}
+
+bool RESPParser::parseLength(const string& buffer, size_t start, size_t end, long long& value) {
+    if (start >= end) {
+        return false;
+    }
+    
+    bool negative = buffer[start] == '-';
+    if (negative) {
+        start++;
+        if (start >= end) return false;
+    }
+    
+    value = 0;
+    for (size_t i = start; i < end; i++) {
+        char c = buffer[i];
+        if (c < '0' || c > '9' || value > MAX_BULK_LENGTH) {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+    }
+    
+    if (negative) value = -value;
+    return true;
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// The rules of sdssplitargs: inside double quotes \n, \r, \t, \b, \a,
+// \xHH and \<char> are escapes; inside single quotes only \'. Unescaped
+// bytes are never longer than their source, so they are written back over
+// it and each argument stays one contiguous range of line.
+bool RESPParser::splitInline(char* line, size_t length, vector<string_view>& argv) {
+    argv.clear();
+    char* p = line;
+    char* end = line + length;
+    
+    while (true) {
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        if (p == end) return true;
+        
+        char* start = p;
+        char* out = p;
+        if (*p != '"' && *p != '\'') {
+            while (p < end && *p != ' ' && *p != '\t') p++;
+            argv.emplace_back(start, p - start);
+            continue;
+        }
+        
+        char quote = *p++;
+        while (true) {
+            if (p == end) {
+                return false;       // unbalanced quotes
+            }
+            char c = *p++;
+            if (c == quote) {
+                break;
+            }
+            if (c == '\\' && p < end) {
+                if (quote == '\'') {
+                    if (*p == '\'') c = *p++;
+                } else if (*p == 'x' && end - p >= 3 && hexDigit(p[1]) >= 0 && hexDigit(p[2]) >= 0) {
+                    c = static_cast<char>(hexDigit(p[1]) * 16 + hexDigit(p[2]));
+                    p += 3;
+                } else {
+                    switch (*p) {
+                        case 'n': c = '\n'; break;
+                        case 'r': c = '\r'; break;
+                        case 't': c = '\t'; break;
+                        case 'b': c = '\b'; break;
+                        case 'a': c = '\a'; break;
+                        default: c = *p; break;
+                    }
+                    p++;
+                }
+            }
+            *out++ = c;
+        }
+        
+        // "foo"bar is an error, as in redis-cli
+        if (p < end && *p != ' ' && *p != '\t') {
+            return false;
+        }
+        argv.emplace_back(start, out - start);
+    }
+}
+
+RESPParser::Result RESPParser::parseInline(string& buffer, size_t& pos, vector<string_view>& argv,
+                                           string& error) {
+    size_t newline = buffer.find('\n', pos);
+    if (newline == string::npos) {
+        if (buffer.size() - pos > MAX_INLINE_LENGTH) {
+            error = "Protocol error: too big inline request";
+            return PROTOCOL_ERROR;
+        }
+        return INCOMPLETE;
+    }
+    
+    size_t end = newline;
+    if (end > pos && buffer[end - 1] == '\r') {
+        end--;
+    }
+    
+    if (!splitInline(&buffer[pos], end - pos, argv)) {
+        error = "Protocol error: unbalanced quotes in request";
+        return PROTOCOL_ERROR;
+    }
+    
+    pos = newline + 1;
+    return OK;
+}
+
+RESPParser::Result RESPParser::parseMultiBulk(const string& buffer, size_t& pos, vector<string_view>& argv,
+                                              string& error) {
+    size_t lineEnd = buffer.find("\r\n", pos);
+    if (lineEnd == string::npos) {
+        if (buffer.size() - pos > MAX_INLINE_LENGTH) {
+            error = "Protocol error: too big mbulk count string";
+            return PROTOCOL_ERROR;
+        }
+        return INCOMPLETE;
+    }
+    
+    long long count;
+    if (!parseLength(buffer, pos + 1, lineEnd, count) || count > MAX_MULTIBULK_LENGTH) {
+        error = "Protocol error: invalid multibulk length";
+        return PROTOCOL_ERROR;
+    }
+    
+    argv.clear();
+    size_t cursor = lineEnd + 2;
+    
+    for (long long i = 0; i < count; i++) {
+        if (cursor >= buffer.size()) {
+            return INCOMPLETE;
+        }
+        if (buffer[cursor] != '$') {
+            error = string("Protocol error: expected '$', got '") + buffer[cursor] + "'";
+            return PROTOCOL_ERROR;
+        }
+        
+        lineEnd = buffer.find("\r\n", cursor);
+        if (lineEnd == string::npos) {
+            if (buffer.size() - cursor > MAX_INLINE_LENGTH) {
+                error = "Protocol error: too big bulk count string";
+                return PROTOCOL_ERROR;
+            }
+            return INCOMPLETE;
+        }
+        
+        long long length;
+        if (!parseLength(buffer, cursor + 1, lineEnd, length) || length < 0 || length > MAX_BULK_LENGTH) {
+            error = "Protocol error: invalid bulk length";
+            return PROTOCOL_ERROR;
+        }
+        
+        size_t dataStart = lineEnd + 2;
+        if (buffer.size() < dataStart + length + 2) {
+            return INCOMPLETE;
+        }
+        if (buffer[dataStart + length] != '\r' || buffer[dataStart + length + 1] != '\n') {
+            error = "Protocol error: bulk string not terminated by CRLF";
+            return PROTOCOL_ERROR;
+        }
+        
+        argv.emplace_back(buffer.data() + dataStart, length);
+        cursor = dataStart + length + 2;
+    }
+    
+    pos = cursor;
+    return OK;
+}
+
+void RESPWriter::status(const string& message) {
+    out += '+';
+    out += message;
+    out += "\r\n";
+}
+
+void RESPWriter::error(const string& message) {
+    out += '-';
+    out += message;
+    out += "\r\n";
+}
+
+void RESPWriter::integer(long long value) {
+    out += ':';
+    out += to_string(value);
+    out += "\r\n";
+}
+
+void RESPWriter::bulk(const string& value) {
+    out += '$';
+    out += to_string(value.size());
+    out += "\r\n";
+    out += value;
+    out += "\r\n";
+}
+
+// An inline integer is formatted here, the only time GET needs its text
+void RESPWriter::bulk(const ValueRef& value) {
+    char digits[ValueRef::MAX_DIGITS];
+    string_view bytes = value.view(digits);
+    out += '$';
+    out += to_string(bytes.size());
+    out += "\r\n";
+    if (pinned && bytes.size() >= ZERO_COPY_MIN_BYTES) {
+        pinned->push_back({out.size(), value});
+    } else {
+        out.append(bytes);
+    }
+    out += "\r\n";
+}
+
+void RESPWriter::nil() {
+    out += "$-1\r\n";
+}
+
+void RESPWriter::arrayHeader(size_t count) {
+    out += '*';
+    out += to_string(count);
+    out += "\r\n";
+}
+
+void RESPWriter::text(const string& value) {
+    bulk(value);
+}
@@ -0,0 +1,330 @@
+#include "../include/Server.hpp"
+#include "../include/RESP.hpp"
+#include "../include/utils.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+Server::Server(Cache& c, int listenPort, AppendOnlyFile* log, SnapshotManager* dumps)
+    : cache(c), aof(log), snapshots(dumps), processor(c, log, dumps), port(listenPort), listenFd(-1), epollFd(-1), running(false) {}
+
+Server::~Server() {
+    while (!connections.empty()) {
+        closeConnection(connections.begin()->second);
+    }
+    if (listenFd >= 0) close(listenFd);
+    if (epollFd >= 0) close(epollFd);
+}
+
+void Server::start() {
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        throw runtime_error(string("socket: ") + strerror(errno));
+    }
+    
+    int yes = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        throw runtime_error("bind port " + to_string(port) + ": " + strerror(errno));
+    }
+    if (listen(listenFd, 511) < 0) {
+        throw runtime_error(string("listen: ") + strerror(errno));
+    }
+    
+    // Report the real port when asked for an ephemeral one (port 0)
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+    port = ntohs(addr.sin_port);
+    
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw runtime_error(string("epoll_create1: ") + strerror(errno));
+    }
+    
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;  // the listener is the only event without a connection
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    
+    running = true;
+}
+
+void Server::run() {
+    epoll_event events[MAX_EVENTS];
+    long long lastCron = Utils::monotonicMillis();
+    
+    while (running) {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, CRON_INTERVAL_MS);
+        if (count < 0 && errno != EINTR) {
+            throw runtime_error(string("epoll_wait: ") + strerror(errno));
+        }
+        
+        // The only clock read per iteration; every command this tick and
+        // the cron below see the same time
+        long long now = Utils::monotonicMillis();
+        cache.setClock(now);
+        
+        for (int i = 0; i < count; i++) {
+            Connection* conn = static_cast<Connection*>(events[i].data.ptr);
+            if (!conn) {
+                acceptClients();
+                continue;
+            }
+            
+            uint32_t flags = events[i].events;
+            if (flags & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                // Read even on HUP/ERR so the final commands and the EOF or
+                // error are observed through read()
+                handleReadable(conn);
+            } else if (flags & EPOLLOUT) {
+                finishIO(conn, flushWrites(conn));
+            }
+        }
+        
+        // Group commit: one AOF write (and fsync, if always) for the whole
+        // tick, before any of its replies are sent
+        if (aof) {
+            aof->commit();
+        }
+        
+        // One write per connection per tick, however many commands it sent
+        handlePendingWrites();
+        
+        if (now - lastCron >= CRON_INTERVAL_MS) {
+            serverCron();
+            lastCron = now;
+        }
+    }
+}
+
+void Server::acceptClients() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            // EAGAIN: backlog drained; anything else (e.g. EMFILE) is retried
+            // on the next wakeup
+            return;
+        }
+        
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        
+        Connection* conn = new Connection(fd);
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = conn;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            delete conn;
+            continue;
+        }
+        connections[fd] = conn;
+    }
+}
+
+void Server::handleReadable(Connection* conn) {
+    char buffer[READ_CHUNK];
+    ssize_t n = read(conn->fd, buffer, sizeof(buffer));
+    
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        closeConnection(conn);
+        return;
+    }
+    if (n < 0) {
+        return;
+    }
+    
+    conn->readBuffer.append(buffer, n);
+    processCommands(conn);
+}
+
+// Runs every complete command in the read buffer, in order. Replies pile
+// up in the connection's output buffer and go out in a single send at the
+// end of the tick, so a pipeline of N commands costs one write, not N.
+void Server::processCommands(Connection* conn) {
+    size_t pendingBefore = conn->writeBuffer.size();
+    RESPWriter reply(conn->writeBuffer, &conn->pinned);
+    string error;
+    
+    while (!conn->closeAfterWrite) {
+        RESPParser::Result result = RESPParser::parseCommand(conn->readBuffer, conn->readOffset, argv, error);
+        if (result == RESPParser::INCOMPLETE) {
+            break;
+        }
+        
+        if (result == RESPParser::PROTOCOL_ERROR) {
+            reply.error("ERR " + error);
+            conn->closeAfterWrite = true;
+        } else if (!argv.empty() && !processor.execute(argv, reply)) {
+            conn->closeAfterWrite = true;
+        }
+    }
+    
+    // Drop consumed input; a partial command stays for the next read
+    if (conn->readOffset == conn->readBuffer.size()) {
+        conn->readBuffer.clear();
+        conn->readOffset = 0;
+    } else if (conn->readOffset > 0) {
+        conn->readBuffer.erase(0, conn->readOffset);
+        conn->readOffset = 0;
+    }
+    
+    if (conn->writeBuffer.size() > pendingBefore && !conn->pendingWrite) {
+        conn->pendingWrite = true;
+        pendingWrites.push_back(conn);
+    }
+}
+
+void Server::handlePendingWrites() {
+    for (Connection* conn : pendingWrites) {
+        conn->pendingWrite = false;
+        finishIO(conn, flushWrites(conn));
+    }
+    pendingWrites.clear();
+}
+
+// Gathers the unsent output in stream order: slices of writeBuffer with the
+// pinned values in between, each sent from the stored string itself
+int Server::buildIovecs(const Connection* conn, struct iovec* iov) {
+    int count = 0;
+    size_t bufferPos = conn->writeOffset;
+    size_t valuePos = conn->pinnedOffset;
+    
+    size_t i = conn->pinnedIndex;
+    for (; i < conn->pinned.size() && count + 2 <= MAX_IOVECS; i++) {
+        const PinnedValue& pin = conn->pinned[i];
+        if (pin.offset > bufferPos) {
+            iov[count].iov_base = const_cast<char*>(conn->writeBuffer.data() + bufferPos);
+            iov[count].iov_len = pin.offset - bufferPos;
+            count++;
+        }
+        iov[count].iov_base = const_cast<char*>(pin.value.data() + valuePos);
+        iov[count].iov_len = pin.value.size() - valuePos;
+        count++;
+        bufferPos = pin.offset;
+        valuePos = 0;
+    }
+    
+    // The rest of the buffer, once every pinned value is in
+    if (i == conn->pinned.size() && bufferPos < conn->writeBuffer.size()) {
+        iov[count].iov_base = const_cast<char*>(conn->writeBuffer.data() + bufferPos);
+        iov[count].iov_len = conn->writeBuffer.size() - bufferPos;
+        count++;
+    }
+    return count;
+}
+
+// Advances the send position by bytes through the same sequence
+void Server::consumeOutput(Connection* conn, size_t bytes) {
+    while (bytes > 0) {
+        if (conn->pinnedIndex < conn->pinned.size() &&
+            conn->writeOffset == conn->pinned[conn->pinnedIndex].offset) {
+            const ValueRef& value = conn->pinned[conn->pinnedIndex].value;
+            size_t taken = min(bytes, value.size() - conn->pinnedOffset);
+            conn->pinnedOffset += taken;
+            bytes -= taken;
+            if (conn->pinnedOffset == value.size()) {
+                // Release the value as soon as it is on the wire
+                conn->pinned[conn->pinnedIndex].value.reset();
+                conn->pinnedIndex++;
+                conn->pinnedOffset = 0;
+            }
+        } else {
+            size_t end = conn->pinnedIndex < conn->pinned.size()
+                       ? conn->pinned[conn->pinnedIndex].offset : conn->writeBuffer.size();
+            size_t taken = min(bytes, end - conn->writeOffset);
+            conn->writeOffset += taken;
+            bytes -= taken;
+        }
+    }
+}
+
+// Sends as much pending output as the socket takes. Returns false on a
+// write error; leftovers wait for EPOLLOUT.
+bool Server::flushWrites(Connection* conn) {
+    struct iovec iov[MAX_IOVECS];
+    
+    while (conn->hasOutput()) {
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = buildIovecs(conn, iov);
+        
+        ssize_t n = sendmsg(conn->fd, &msg, MSG_NOSIGNAL);
+        if (n > 0) {
+            consumeOutput(conn, n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            updateInterest(conn, true);
+            return true;
+        } else {
+            return false;
+        }
+    }
+    
+    conn->writeBuffer.clear();
+    conn->writeOffset = 0;
+    conn->pinned.clear();
+    conn->pinnedIndex = 0;
+    conn->pinnedOffset = 0;
+    updateInterest(conn, false);
+    return true;
+}
+
+// Closes the connection after a write error, or once a QUIT / protocol
+// error reply has been fully sent
+void Server::finishIO(Connection* conn, bool ok) {
+    if (!ok || (conn->closeAfterWrite && conn->writeBuffer.empty())) {
+        closeConnection(conn);
+    }
+}
+
+void Server::updateInterest(Connection* conn, bool wantWrite) {
+    if (conn->wantWrite == wantWrite) {
+        return;
+    }
+    
+    epoll_event ev;
+    ev.events = wantWrite ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.ptr = conn;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, conn->fd, &ev);
+    conn->wantWrite = wantWrite;
+}
+
+void Server::closeConnection(Connection* conn) {
+    if (conn->pendingWrite) {
+        pendingWrites.erase(find(pendingWrites.begin(), pendingWrites.end(), conn));
+    }
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+    close(conn->fd);
+    connections.erase(conn->fd);
+    delete conn;
+}
+
+void Server::serverCron() {
+    cache.activeExpireCycle(CRON_EXPIRE_KEY_LIMIT, CRON_EXPIRE_BUDGET_US);
+    if (aof) {
+        aof->cron(cache);
+    }
+    if (snapshots) {
+        snapshots->cron();
+    }
+}
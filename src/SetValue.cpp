@@ -0,0 +1,245 @@
+#include "../include/SetValue.hpp"
+#include "../include/utils.hpp"
+
+using namespace std;
+
+SetValue::SetValue(SlabAllocator* owner)
+    : slabs(owner), ints(nullptr), table(false), width(2), count(0), intsCapacity(0), heapBytes(0) {}
+
+// Sized up front: a set too large for an intset, or with a member that is
+// not an integer, starts as a table with room for all of it
+SetValue::SetValue(SlabAllocator* owner, string_view serialized) : SetValue(owner) {
+    size_t entries = 0;
+    bool integers = true;
+    const char* pos = serialized.data();
+    const char* end = pos + serialized.size();
+    while (pos < end) {
+        string_view member;
+        long long value;
+        pos = Listpack::readString(pos, end, member);
+        integers = integers && asInteger(member, value);
+        entries++;
+    }
+    if (!integers || entries > MAX_INTSET_ENTRIES) {
+        convertToTable(entries);
+    }
+
+    pos = serialized.data();
+    while (pos < end) {
+        string_view member;
+        pos = Listpack::readString(pos, end, member);
+        add(member);
+    }
+}
+
+SetValue::~SetValue() {
+    members.forEach([&](Member* record) { freeMember(record); });
+    members.release(slabs);
+    if (ints) {
+        slabs->deallocate(ints, intsCapacity);
+    }
+}
+
+bool SetValue::isValid(string_view serialized) {
+    const char* pos = serialized.data();
+    const char* end = pos + serialized.size();
+    if (pos == end) {
+        return false;   // sets are never empty
+    }
+    while (pos < end) {
+        string_view member;
+        pos = Listpack::readString(pos, end, member);
+        if (!pos) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Only the text an integer formats back to, so "007" or "+7" stays a
+// string member as in Redis
+bool SetValue::asInteger(string_view member, long long& value) {
+    return Utils::parseCanonicalInteger(member, value);
+}
+
+uint8_t SetValue::widthOf(long long value) {
+    if (value >= INT16_MIN && value <= INT16_MAX) return 2;
+    if (value >= INT32_MIN && value <= INT32_MAX) return 4;
+    return 8;
+}
+
+long long SetValue::readInt(const char* at, uint8_t width) {
+    switch (width) {
+        case 2: {
+            int16_t value;
+            memcpy(&value, at, 2);
+            return value;
+        }
+        case 4: {
+            int32_t value;
+            memcpy(&value, at, 4);
+            return value;
+        }
+        default: {
+            int64_t value;
+            memcpy(&value, at, 8);
+            return value;
+        }
+    }
+}
+
+void SetValue::writeInt(char* at, uint8_t width, long long value) {
+    switch (width) {
+        case 2: {
+            int16_t narrow = static_cast<int16_t>(value);
+            memcpy(at, &narrow, 2);
+            break;
+        }
+        case 4: {
+            int32_t narrow = static_cast<int32_t>(value);
+            memcpy(at, &narrow, 4);
+            break;
+        }
+        default: {
+            int64_t wide = value;
+            memcpy(at, &wide, 8);
+            break;
+        }
+    }
+}
+
+// Bisection; position is where value is, or where it would go
+bool SetValue::intFind(long long value, size_t& position) const {
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        long long found = intAt(middle);
+        if (found == value) {
+            position = middle;
+            return true;
+        }
+        if (found < value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    position = low;
+    return false;
+}
+
+// Room for entries integers of newWidth; widening rewrites every integer
+void SetValue::intReserve(size_t entries, uint8_t newWidth) {
+    size_t bytes = entries * newWidth;
+    if (newWidth == width && bytes <= intsCapacity) {
+        return;
+    }
+    size_t newCapacity = slabs->chunkSize(bytes);
+    char* grown = static_cast<char*>(slabs->allocate(newCapacity));
+    if (ints) {
+        for (size_t i = 0; i < count; i++) {
+            writeInt(grown + i * newWidth, newWidth, intAt(i));
+        }
+        slabs->deallocate(ints, intsCapacity);
+    }
+    heapBytes += newCapacity - intsCapacity;
+    ints = grown;
+    width = newWidth;
+    intsCapacity = static_cast<uint32_t>(newCapacity);
+}
+
+void SetValue::convertToTable(size_t memberCount) {
+    members.reserve(slabs, memberCount);
+    forEach([&](string_view member) {
+        members.insert(slabs, newMember(RecordIndex<Member>::hashKey(member), member));
+    });
+    table = true;
+
+    if (ints) {
+        slabs->deallocate(ints, intsCapacity);
+        heapBytes -= intsCapacity;
+    }
+    ints = nullptr;
+    count = 0;
+    intsCapacity = 0;
+}
+
+SetValue::Member* SetValue::newMember(uint32_t h, string_view member) {
+    size_t bytes = sizeof(Member) + member.size();
+    Member* record = static_cast<Member*>(slabs->allocate(bytes));
+    record->hash = h;
+    record->length = static_cast<uint32_t>(member.size());
+    memcpy(record->bytes(), member.data(), member.size());
+    heapBytes += slabs->chunkSize(bytes);
+    return record;
+}
+
+void SetValue::freeMember(Member* record) {
+    size_t bytes = record->allocSize();
+    heapBytes -= slabs->chunkSize(bytes);
+    slabs->deallocate(record, bytes);
+}
+
+bool SetValue::contains(string_view member) const {
+    if (!table) {
+        long long value;
+        size_t position;
+        return asInteger(member, value) && intFind(value, position);
+    }
+    return members.find(member, RecordIndex<Member>::hashKey(member)) != nullptr;
+}
+
+bool SetValue::add(string_view member) {
+    if (!table) {
+        long long value;
+        if (asInteger(member, value)) {
+            size_t position;
+            if (intFind(value, position)) {
+                return false;
+            }
+            if (count < MAX_INTSET_ENTRIES) {
+                uint8_t needed = widthOf(value);
+                intReserve(count + 1, needed > width ? needed : width);
+                memmove(ints + (position + 1) * width, ints + position * width, (count - position) * width);
+                writeInt(ints + position * width, width, value);
+                count++;
+                return true;
+            }
+        }
+        convertToTable(count + 1);
+    }
+
+    uint32_t h = RecordIndex<Member>::hashKey(member);
+    if (members.find(member, h)) {
+        return false;
+    }
+    members.insert(slabs, newMember(h, member));
+    return true;
+}
+
+bool SetValue::remove(string_view member) {
+    if (table) {
+        Member* record = members.remove(member, RecordIndex<Member>::hashKey(member));
+        if (record) {
+            freeMember(record);
+        }
+        return record != nullptr;
+    }
+    long long value;
+    size_t position;
+    if (!asInteger(member, value) || !intFind(value, position)) {
+        return false;
+    }
+    memmove(ints + position * width, ints + (position + 1) * width, (count - position - 1) * width);
+    count--;
+    return true;
+}
+
+void SetValue::serialize(string& out) const {
+    char length[10];
+    forEach([&](string_view member) {
+        out.append(length, Listpack::writeLength(length, member.size()) - length);
+        out.append(member);
+    });
+}
@@ -0,0 +1,165 @@
+#include "../include/ShardedCache.hpp"
+#include <functional>
+
+using namespace std;
+
+ShardedCache::ShardedCache(size_t shardCount, size_t maxMem, size_t maxKeysLimit, EvictionType evictionType)
+    : numShards(shardCount > 0 ? shardCount : 1) {
+    
+    shards = new Shard[numShards];
+    for (size_t i = 0; i < numShards; i++) {
+        shards[i].cache = new Cache(maxMem / numShards, maxKeysLimit / numShards + (maxKeysLimit % numShards != 0),
+                                   evictionType);
+    }
+}
+
+ShardedCache::~ShardedCache() {
+    for (size_t i = 0; i < numShards; i++) {
+        delete shards[i].cache;
+    }
+    delete[] shards;
+}
+
+// Uses the top bits of the hash; the shard's own table indexes by the low
+// bits, so keys sharing a shard still spread evenly over its table
+ShardedCache::Shard& ShardedCache::shardFor(string_view key) const {
+    std::hash<string_view> hasher;
+    size_t h = hasher(key);
+    return shards[(h >> 32) % numShards];
+}
+
+bool ShardedCache::set(const string& key, const string& value, int ttlSeconds) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->set(key, value, ttlSeconds);
+}
+
+bool ShardedCache::set(const string& key, string&& value, int ttlSeconds) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->set(key, move(value), ttlSeconds);
+}
+
+bool ShardedCache::get(const string& key, string& value) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->get(key, value);
+}
+
+bool ShardedCache::get(const string& key, ValueRef& value) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->get(key, value);
+}
+
+bool ShardedCache::del(const string& key) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->del(key);
+}
+
+bool ShardedCache::exists(const string& key) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->exists(key);
+}
+
+bool ShardedCache::expire(const string& key, int seconds) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->expire(key, seconds);
+}
+
+bool ShardedCache::psetex(const string& key, const string& value, long long ttlMs) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->psetex(key, value, ttlMs);
+}
+
+bool ShardedCache::psetex(const string& key, string&& value, long long ttlMs) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->psetex(key, move(value), ttlMs);
+}
+
+bool ShardedCache::pexpire(const string& key, long long ms) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->pexpire(key, ms);
+}
+
+long long ShardedCache::pttl(const string& key) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->pttl(key);
+}
+
+long long ShardedCache::ttl(const string& key) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    return shard.cache->ttl(key);
+}
+
+// Shards are flushed one at a time, so concurrent writers may land in an
+// already-flushed shard; like Redis FLUSHALL this is not a global barrier
+void ShardedCache::flush() {
+    for (size_t i = 0; i < numShards; i++) {
+        lock_guard<mutex> guard(shards[i].lock);
+        shards[i].cache->flush();
+    }
+}
+
+void ShardedCache::reserve(size_t count) {
+    // Keys never split perfectly evenly; leave some room
+    size_t perShard = count / numShards + count / numShards / 16 + 1;
+    for (size_t i = 0; i < numShards; i++) {
+        lock_guard<mutex> guard(shards[i].lock);
+        shards[i].cache->reserve(perShard);
+    }
+}
+
+void ShardedCache::loadKey(string_view key, string_view value, long long ttlMs, ValueType type) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    shard.cache->loadKey(key, value, ttlMs, type);
+}
+
+void ShardedCache::forEachEntry(const function<void(string_view, const ValueRef&, long long)>& visit,
+                                size_t part, size_t parts) const {
+    size_t first = part * numShards / parts;
+    for (size_t n = 0; n < numShards; n++) {
+        Shard& shard = shards[(first + n) % numShards];
+        lock_guard<mutex> guard(shard.lock);
+        shard.cache->forEachEntry(visit, part, parts);
+    }
+}
+
+CacheStats ShardedCache::getStats() const {
+    CacheStats total;
+    for (size_t i = 0; i < numShards; i++) {
+        lock_guard<mutex> guard(shards[i].lock);
+        total.merge(shards[i].cache->getStats());
+    }
+    total.shards = numShards;
+    return total;
+}
+
+void ShardedCache::resetStats() {
+    for (size_t i = 0; i < numShards; i++) {
+        lock_guard<mutex> guard(shards[i].lock);
+        shards[i].cache->resetStats();
+    }
+}
+
+void ShardedCache::showStats() const {
+    Cache::printStats(getStats());
+}
+
+size_t ShardedCache::getKeyCount() const {
+    size_t total = 0;
+    for (size_t i = 0; i < numShards; i++) {
+        lock_guard<mutex> guard(shards[i].lock);
+        total += shards[i].cache->getKeyCount();
+    }
+    return total;
+}
@@ -0,0 +1,206 @@
+#include "../include/SlabAllocator.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+const double SlabAllocator::GROWTH_FACTOR = 1.25;
+
+namespace {
+
+inline size_t alignUp(size_t n, size_t align) {
+    return (n + align - 1) / align * align;
+}
+
+} // namespace
+
+SlabAllocator::SlabAllocator()
+    : chunkBytes(0), sharedFreeTotal(0), largeBytes(0), largeAllocs(0), externalBytes(0) {
+    vector<size_t> sizes;
+    size_t size = MIN_CHUNK_SIZE, largest = MAX_CHUNK_SIZE;
+    while (size < largest) {
+        sizes.push_back(size);
+        size = max(size + CHUNK_ALIGN, alignUp(static_cast<size_t>(size * GROWTH_FACTOR), CHUNK_ALIGN));
+    }
+    sizes.push_back(largest);
+
+    numClasses = sizes.size();
+    classes = new SlabClass[numClasses];
+    for (size_t i = 0; i < numClasses; i++) {
+        SlabClass& slab = classes[i];
+        slab.chunkSize = sizes[i];
+        slab.freeList = nullptr;
+        slab.carveNext = nullptr;
+        slab.carveEnd = nullptr;
+        slab.pages = 0;
+        slab.totalChunks = 0;
+        slab.usedChunks = 0;
+        slab.requestedBytes = 0;
+        slab.sharedFree.store(nullptr);
+        slab.sharedFreeChunks.store(0);
+        slab.sharedFreeBytes.store(0);
+    }
+
+    size_t cls = 0;
+    for (size_t i = 0; i <= SMALL_LOOKUP_LIMIT / 8; i++) {
+        while (classes[cls].chunkSize < i * 8) cls++;
+        smallClass[i] = static_cast<uint8_t>(cls);
+    }
+}
+
+SlabAllocator::~SlabAllocator() {
+    for (char* page : pages) {
+        free(page);
+    }
+    delete[] classes;
+}
+
+size_t SlabAllocator::classFor(size_t bytes) const {
+    if (bytes <= SMALL_LOOKUP_LIMIT) {
+        return smallClass[(bytes + 7) / 8];
+    }
+
+    size_t lo = smallClass[SMALL_LOOKUP_LIMIT / 8], hi = numClasses - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (classes[mid].chunkSize < bytes) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t SlabAllocator::chunkSize(size_t bytes) const {
+    return bytes > MAX_CHUNK_SIZE ? bytes : classes[classFor(bytes)].chunkSize;
+}
+
+void* SlabAllocator::allocate(size_t bytes) {
+    if (bytes > MAX_CHUNK_SIZE) {
+        void* ptr = malloc(bytes);
+        if (!ptr) throw bad_alloc();
+        largeBytes.fetch_add(bytes, memory_order_relaxed);
+        largeAllocs.fetch_add(1, memory_order_relaxed);
+        return ptr;
+    }
+
+    SlabClass& slab = classes[classFor(bytes)];
+    void* ptr;
+    if (slab.freeList) {
+        ptr = slab.freeList;
+        slab.freeList = slab.freeList->next;
+    } else {
+        ptr = refill(slab);
+    }
+
+    slab.usedChunks++;
+    slab.requestedBytes += bytes;
+    chunkBytes += slab.chunkSize;
+    return ptr;
+}
+
+// Slow path once the free list is empty: take back chunks freed by other
+// threads, otherwise carve a new chunk, starting a new page if needed
+void* SlabAllocator::refill(SlabClass& slab) {
+    FreeChunk* shared = slab.sharedFree.exchange(nullptr, memory_order_acquire);
+    if (shared) {
+        size_t chunks = 0, bytes = 0;
+        for (FreeChunk* c = shared; c; c = c->next) {
+            chunks++;
+            bytes += c->bytes;
+        }
+        slab.usedChunks -= chunks;
+        slab.requestedBytes -= bytes;
+        chunkBytes -= chunks * slab.chunkSize;
+        slab.sharedFreeChunks.fetch_sub(chunks, memory_order_relaxed);
+        slab.sharedFreeBytes.fetch_sub(bytes, memory_order_relaxed);
+        sharedFreeTotal.fetch_sub(chunks * slab.chunkSize, memory_order_relaxed);
+
+        slab.freeList = shared->next;
+        return shared;
+    }
+
+    if (slab.carveNext == slab.carveEnd) {
+        char* page = static_cast<char*>(malloc(PAGE_SIZE));
+        if (!page) throw bad_alloc();
+        pages.push_back(page);
+        slab.pages++;
+        slab.carveNext = page;
+        slab.carveEnd = page + PAGE_SIZE / slab.chunkSize * slab.chunkSize;
+    }
+
+    void* ptr = slab.carveNext;
+    slab.carveNext += slab.chunkSize;
+    slab.totalChunks++;
+    return ptr;
+}
+
+void SlabAllocator::deallocate(void* ptr, size_t bytes) {
+    if (bytes > MAX_CHUNK_SIZE) {
+        free(ptr);
+        largeBytes.fetch_sub(bytes, memory_order_relaxed);
+        largeAllocs.fetch_sub(1, memory_order_relaxed);
+        return;
+    }
+
+    SlabClass& slab = classes[classFor(bytes)];
+    FreeChunk* chunk = static_cast<FreeChunk*>(ptr);
+    chunk->next = slab.freeList;
+    slab.freeList = chunk;
+    slab.usedChunks--;
+    slab.requestedBytes -= bytes;
+    chunkBytes -= slab.chunkSize;
+}
+
+void SlabAllocator::deallocateShared(void* ptr, size_t bytes) {
+    if (bytes > MAX_CHUNK_SIZE) {
+        free(ptr);
+        largeBytes.fetch_sub(bytes, memory_order_relaxed);
+        largeAllocs.fetch_sub(1, memory_order_relaxed);
+        return;
+    }
+
+    SlabClass& slab = classes[classFor(bytes)];
+    FreeChunk* chunk = static_cast<FreeChunk*>(ptr);
+    chunk->bytes = bytes;
+
+    // Counted before it becomes visible, so a drain never subtracts more
+    // than was added
+    slab.sharedFreeChunks.fetch_add(1, memory_order_relaxed);
+    slab.sharedFreeBytes.fetch_add(bytes, memory_order_relaxed);
+    sharedFreeTotal.fetch_add(slab.chunkSize, memory_order_relaxed);
+
+    // The owner only ever takes the whole list, so a plain push is ABA-safe
+    FreeChunk* head = slab.sharedFree.load(memory_order_relaxed);
+    do {
+        chunk->next = head;
+    } while (!slab.sharedFree.compare_exchange_weak(head, chunk, memory_order_release, memory_order_relaxed));
+}
+
+size_t SlabAllocator::requestedBytes() const {
+    size_t total = 0;
+    for (size_t i = 0; i < numClasses; i++) {
+        const SlabClass& slab = classes[i];
+        total += slab.requestedBytes - slab.sharedFreeBytes.load(memory_order_relaxed);
+    }
+    return total;
+}
+
+vector<SlabClassStats> SlabAllocator::classStats() const {
+    vector<SlabClassStats> result;
+    for (size_t i = 0; i < numClasses; i++) {
+        const SlabClass& slab = classes[i];
+        if (slab.pages == 0) continue;
+
+        SlabClassStats stats;
+        stats.chunkSize = slab.chunkSize;
+        stats.pages = slab.pages;
+        stats.totalChunks = slab.totalChunks;
+        stats.usedChunks = slab.usedChunks - slab.sharedFreeChunks.load(memory_order_relaxed);
+        stats.requestedBytes = slab.requestedBytes - slab.sharedFreeBytes.load(memory_order_relaxed);
+        result.push_back(stats);
+    }
+    return result;
+}
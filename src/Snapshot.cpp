@@ -0,0 +1,842 @@
+#include "../include/Snapshot.hpp"
+#include "../include/Cache.hpp"
+#include "../include/ShardedCache.hpp"
+#include "../include/utils.hpp"
+#include <stdexcept>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+namespace {
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t entries;
+    int64_t createdMs;
+};
+
+struct EntryHeader {
+    uint32_t keyLength;
+    uint32_t valueLength;
+    int64_t expiresAt;
+};
+
+struct FileFooter {
+    uint64_t checksum;
+    char magic[8];
+};
+
+static_assert(sizeof(FileHeader) == 32 && sizeof(EntryHeader) == 16 && sizeof(FileFooter) == 16,
+              "snapshot records must have no padding");
+
+const char HEADER_MAGIC[8] = {'M', 'R', 'E', 'D', 'I', 'S', 'D', 'B'};
+const char FOOTER_MAGIC[8] = {'M', 'R', 'D', 'B', '_', 'E', 'O', 'F'};
+
+// Entries are buffered and written in chunks of about this size
+const size_t WRITE_CHUNK = 1024 * 1024;
+// The loader checksums what it has parsed in steps of this size, while
+// those pages are still in cache
+const size_t VERIFY_STEP = 256 * 1024;
+// Entries handed to the cache at a time, so it can hash and prefetch ahead
+const size_t LOAD_BATCH = 256;
+
+const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+inline uint64_t read64(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t mixRound(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    return rotl(acc, 31) * PRIME1;
+}
+
+bool writeAll(int out, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(out, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+} // namespace
+
+SnapshotChecksum::SnapshotChecksum() : pendingBytes(0), totalBytes(0) {
+    lanes[0] = PRIME1 + PRIME2;
+    lanes[1] = PRIME2;
+    lanes[2] = 0;
+    lanes[3] = 0 - PRIME1;
+}
+
+void SnapshotChecksum::stripe(const char* data) {
+    for (int i = 0; i < 4; i++) {
+        lanes[i] = mixRound(lanes[i], read64(data + 8 * i));
+    }
+}
+
+void SnapshotChecksum::update(const char* data, size_t size) {
+    totalBytes += size;
+    if (pendingBytes > 0) {
+        size_t take = min(size, sizeof(pending) - pendingBytes);
+        memcpy(pending + pendingBytes, data, take);
+        pendingBytes += take;
+        data += take;
+        size -= take;
+        if (pendingBytes < sizeof(pending)) {
+            return;
+        }
+        stripe(pending);
+        pendingBytes = 0;
+    }
+    for (; size >= sizeof(pending); data += sizeof(pending), size -= sizeof(pending)) {
+        stripe(data);
+    }
+    memcpy(pending, data, size);
+    pendingBytes = size;
+}
+
+uint64_t SnapshotChecksum::digest() const {
+    uint64_t h;
+    if (totalBytes >= sizeof(pending)) {
+        h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+        for (int i = 0; i < 4; i++) {
+            h = (h ^ mixRound(0, lanes[i])) * PRIME1 + PRIME4;
+        }
+    } else {
+        h = PRIME5;
+    }
+    h += totalBytes;
+
+    // The tail that did not fill a stripe
+    size_t i = 0;
+    for (; i + 8 <= pendingBytes; i += 8) {
+        h = rotl(h ^ mixRound(0, read64(pending + i)), 27) * PRIME1 + PRIME4;
+    }
+    if (i + 4 <= pendingBytes) {
+        uint32_t word;
+        memcpy(&word, pending + i, sizeof(word));
+        h = rotl(h ^ (word * PRIME1), 23) * PRIME2 + PRIME3;
+        i += 4;
+    }
+    for (; i < pendingBytes; i++) {
+        h = rotl(h ^ (static_cast<unsigned char>(pending[i]) * PRIME5), 11) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+namespace {
+
+using EntryVisitor = function<void(string_view, const ValueRef&, long long)>;
+// Walks one of parts slices of a keyspace, see Cache::forEachEntry
+using PartWalker = function<void(const EntryVisitor& visit, size_t part, size_t parts)>;
+
+string segmentPath(const string& path, int64_t generation, size_t index) {
+    return path + "." + to_string(generation) + "." + to_string(index);
+}
+
+struct WrittenFile {
+    size_t bytes;
+    uint64_t entries;
+};
+
+// Writes one slice of the keyspace as a complete single-file snapshot and
+// syncs it. Throws runtime_error on failure, removing the file.
+WrittenFile writeSnapshotFile(const PartWalker& walk, size_t part, size_t parts, const string& filePath,
+                         bool checksum) {
+    int out = open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        throw runtime_error("open " + filePath + ": " + strerror(errno));
+    }
+
+    FileHeader header;
+    memcpy(header.magic, HEADER_MAGIC, sizeof(header.magic));
+    header.version = Snapshot::VERSION;
+    header.flags = checksum ? Snapshot::FLAG_CHECKSUM : 0;
+    header.entries = 0;     // filled in once known
+    header.createdMs = Utils::getCurrentTimeMillis();
+
+    string chunk;
+    chunk.reserve(WRITE_CHUNK + WRITE_CHUNK / 4);
+    chunk.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    size_t checksumFrom = sizeof(header);
+    SnapshotChecksum sum;
+    size_t fileBytes = 0;
+    bool ok = true;
+
+    auto flush = [&]() {
+        if (checksum) {
+            sum.update(chunk.data() + checksumFrom, chunk.size() - checksumFrom);
+        }
+        ok = ok && writeAll(out, chunk.data(), chunk.size());
+        fileBytes += chunk.size();
+        chunk.clear();
+        checksumFrom = 0;
+    };
+
+    long long now = header.createdMs;
+    string serialized;
+    walk([&](string_view key, const ValueRef& value, long long ttlMs) {
+        ValueType type = value.type();
+        string_view bytes;
+        char digits[ValueRef::MAX_DIGITS];
+        if (type != ValueType::STRING) {
+            serialized.clear();
+            value.compound()->serialize(serialized);
+            bytes = serialized;
+        } else {
+            bytes = value.view(digits);
+        }
+        uint8_t typeByte = static_cast<uint8_t>(type);
+        EntryHeader entry;
+        entry.keyLength = key.size();
+        entry.valueLength = bytes.size();
+        entry.expiresAt = ttlMs >= 0 ? now + ttlMs : -1;
+        chunk.push_back(static_cast<char>(typeByte));
+        chunk.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        chunk.append(key);
+        chunk.append(bytes);
+        header.entries++;
+        if (chunk.size() >= WRITE_CHUNK) {
+            flush();
+        }
+    }, part, parts);
+    flush();
+
+    FileFooter footer;
+    footer.checksum = checksum ? sum.digest() : 0;
+    memcpy(footer.magic, FOOTER_MAGIC, sizeof(footer.magic));
+    ok = ok && writeAll(out, reinterpret_cast<const char*>(&footer), sizeof(footer));
+    fileBytes += sizeof(footer);
+
+    ok = ok && pwrite(out, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+         fsync(out) == 0;
+    int err = errno;
+    if (close(out) != 0 && ok) {
+        ok = false;
+        err = errno;
+    }
+    if (!ok) {
+        unlink(filePath.c_str());
+        throw runtime_error("write " + filePath + ": " + strerror(err));
+    }
+    return {fileBytes, header.entries};
+}
+
+// A snapshot file or manifest, mapped read-only for the life of the object
+class MappedFile {
+public:
+    const char* base;
+    size_t size;
+    FileHeader header;
+    FileFooter footer;
+
+    explicit MappedFile(const string& path) : base(nullptr), size(0) {
+        int in = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            throw runtime_error("open " + path + ": " + strerror(errno));
+        }
+        struct stat st;
+        if (fstat(in, &st) != 0) {
+            int err = errno;
+            close(in);
+            throw runtime_error("stat " + path + ": " + strerror(err));
+        }
+        size = st.st_size;
+        if (size < sizeof(FileHeader) + sizeof(FileFooter)) {
+            close(in);
+            throw runtime_error(path + " is too short to be a snapshot");
+        }
+
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, in, 0);
+        int err = errno;
+        close(in);
+        if (mapped == MAP_FAILED) {
+            throw runtime_error("mmap " + path + ": " + strerror(err));
+        }
+        // Read once, front to back: ask for aggressive readahead
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        madvise(mapped, size, MADV_WILLNEED);
+
+        base = static_cast<const char*>(mapped);
+        memcpy(&header, base, sizeof(header));
+        memcpy(&footer, base + size - sizeof(footer), sizeof(footer));
+    }
+
+    ~MappedFile() {
+        munmap(const_cast<char*>(base), size);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const { return base + sizeof(FileHeader); }
+    const char* end() const { return base + size - sizeof(FileFooter); }
+    bool segmented() const { return header.flags & Snapshot::FLAG_SEGMENTED; }
+    bool checksummed() const { return header.flags & Snapshot::FLAG_CHECKSUM; }
+
+    // What is wrong with the header or footer, or empty
+    string check() const {
+        if (memcmp(header.magic, HEADER_MAGIC, sizeof(header.magic)) != 0) {
+            return "not a snapshot";
+        }
+        if (header.version < 1 || header.version > Snapshot::VERSION) {
+            return "unsupported version " + to_string(header.version);
+        }
+        if (memcmp(footer.magic, FOOTER_MAGIC, sizeof(footer.magic)) != 0) {
+            return "incomplete, no end marker";
+        }
+        if (!segmented() && header.entries > static_cast<uint64_t>(end() - begin()) / sizeof(EntryHeader)) {
+            return "entry count does not fit the file";
+        }
+        return "";
+    }
+
+    bool checksumMatches() const {
+        SnapshotChecksum sum;
+        sum.update(begin(), end() - begin());
+        return sum.digest() == footer.checksum;
+    }
+};
+
+// Whether a loaded value of type can be rebuilt; any bytes make a string
+bool validValue(ValueType type, string_view value) {
+    switch (type) {
+        case ValueType::STRING:
+            return true;
+        case ValueType::HASH:
+            return HashValue::isValid(value);
+        case ValueType::ZSET:
+            return ZSetValue::isValid(value);
+        case ValueType::LIST:
+            return ListValue::isValid(value);
+        case ValueType::SET:
+            return SetValue::isValid(value);
+    }
+    return false;
+}
+
+// Calls load with batches of the live entries of a single-file snapshot;
+// with verify, checksums what it has parsed as it goes. Adds the entries
+// passed to loaded. Returns what is wrong with the file, or empty.
+template <typename Load>
+string parseEntries(const MappedFile& file, bool verify, size_t& loaded, Load&& load) {
+    LoadEntry batch[LOAD_BATCH];
+    size_t batched = 0;
+    SnapshotChecksum sum;
+    const char* pos = file.begin();
+    const char* end = file.end();
+    const char* verified = pos;
+    long long now = Utils::getCurrentTimeMillis();
+
+    bool typed = file.header.version >= 2;
+
+    for (uint64_t i = 0; i < file.header.entries; i++) {
+        EntryHeader entry;
+        if (static_cast<size_t>(end - pos) < sizeof(entry) + typed) {
+            return "entry " + to_string(i) + " is cut off";
+        }
+        ValueType type = ValueType::STRING;
+        if (typed) {
+            type = static_cast<ValueType>(static_cast<uint8_t>(*pos++));
+        }
+        memcpy(&entry, pos, sizeof(entry));
+        pos += sizeof(entry);
+        if (static_cast<size_t>(end - pos) < static_cast<size_t>(entry.keyLength) + entry.valueLength) {
+            return "entry " + to_string(i) + " is cut off";
+        }
+        string_view key(pos, entry.keyLength);
+        string_view value(pos + entry.keyLength, entry.valueLength);
+        pos += key.size() + value.size();
+        if (!validValue(type, value)) {
+            return "entry " + to_string(i) + " has a malformed value";
+        }
+
+        // Keys that expired while the server was down are not loaded
+        long long ttlMs = entry.expiresAt < 0 ? -1 : entry.expiresAt - now;
+        if (entry.expiresAt < 0 || ttlMs > 0) {
+            batch[batched++] = {key, value, ttlMs, type};
+            if (batched == LOAD_BATCH) {
+                load(batch, batched);
+                loaded += batched;
+                batched = 0;
+            }
+        }
+
+        if (verify && static_cast<size_t>(pos - verified) >= VERIFY_STEP) {
+            sum.update(verified, pos - verified);
+            verified = pos;
+        }
+    }
+    load(batch, batched);
+    loaded += batched;
+
+    if (pos != end) {
+        return "trailing bytes after the last entry";
+    }
+    if (verify) {
+        sum.update(verified, pos - verified);
+        if (sum.digest() != file.footer.checksum) {
+            return "checksum mismatch";
+        }
+    }
+    return "";
+}
+
+// The manifest body is the segment count, then each segment's entry count
+vector<uint64_t> readManifest(const MappedFile& manifest, string& error) {
+    vector<uint64_t> counts;
+    size_t bodyBytes = manifest.end() - manifest.begin();
+    uint64_t segments = 0;
+    if (bodyBytes >= sizeof(segments)) {
+        memcpy(&segments, manifest.begin(), sizeof(segments));
+    }
+    if (segments == 0 || bodyBytes != sizeof(uint64_t) * (segments + 1)) {
+        error = "bad segment table";
+    } else if (manifest.checksummed() && !manifest.checksumMatches()) {
+        error = "checksum mismatch";
+    } else {
+        counts.resize(segments);
+        memcpy(counts.data(), manifest.begin() + sizeof(segments), sizeof(uint64_t) * segments);
+        // The header is outside the checksum, and loaders reserve from its
+        // entry count, so it must agree with the segment table
+        uint64_t total = 0;
+        for (uint64_t count : counts) {
+            if (count > manifest.header.entries - total) {
+                total = UINT64_MAX;
+                break;
+            }
+            total += count;
+        }
+        if (total != manifest.header.entries) {
+            error = "entry count does not match the segment table";
+            counts.clear();
+        }
+    }
+    return counts;
+}
+
+// Maps segment index of a manifest and checks it from end to end, which
+// also pages it in. Returns what is wrong, or empty.
+string openSegment(const string& path, const MappedFile& manifest, size_t index, uint64_t entries,
+                   unique_ptr<MappedFile>& segment) {
+    string name = segmentPath(path, manifest.header.createdMs, index);
+    try {
+        segment.reset(new MappedFile(name));
+    } catch (const runtime_error& e) {
+        return e.what();
+    }
+    string error = segment->check();
+    if (error.empty() && (segment->segmented() || segment->header.entries != entries)) {
+        error = "does not match the manifest";
+    }
+    if (error.empty() && segment->checksummed() && !segment->checksumMatches()) {
+        error = "checksum mismatch";
+    }
+    return error.empty() ? "" : name + ": " + error;
+}
+
+// Generation and segment count of the segmented snapshot at path; zero
+// segments if it is a single file or missing
+void readGeneration(const string& path, int64_t& generation, size_t& segments) {
+    generation = -1;
+    segments = 0;
+    if (access(path.c_str(), F_OK) != 0) {
+        return;
+    }
+    try {
+        MappedFile current(path);
+        string error = current.check();
+        if (error.empty() && current.segmented()) {
+            vector<uint64_t> counts = readManifest(current, error);
+            generation = current.header.createdMs;
+            segments = counts.size();
+        }
+    } catch (const runtime_error&) {
+        // Unreadable: nothing of it to clean up
+    }
+}
+
+void removeSegments(const string& path, int64_t generation, size_t segments) {
+    for (size_t i = 0; i < segments; i++) {
+        unlink(segmentPath(path, generation, i).c_str());
+    }
+}
+
+// Single file: written under a temporary name and renamed over path.
+// Segmented: each thread writes one segment of a new generation; the
+// manifest naming them is renamed over path only once all are synced, so a
+// crash leaves the previous snapshot whole, and its segments go after.
+size_t saveKeyspace(const PartWalker& walk, const string& path, bool checksum, size_t segments) {
+    int64_t oldGeneration;
+    size_t oldSegments;
+    readGeneration(path, oldGeneration, oldSegments);
+
+    string temp = path + ".tmp";
+    size_t totalBytes = 0;
+    if (segments <= 1) {
+        totalBytes = writeSnapshotFile(walk, 0, 1, temp, checksum).bytes;
+    } else {
+        int64_t generation = max<int64_t>(Utils::getCurrentTimeMillis(), oldGeneration + 1);
+        vector<WrittenFile> written(segments);
+        vector<string> errors(segments);
+        vector<thread> writers;
+        for (size_t i = 0; i < segments; i++) {
+            writers.emplace_back([&, i]() {
+                try {
+                    written[i] = writeSnapshotFile(walk, i, segments, segmentPath(path, generation, i), checksum);
+                } catch (const runtime_error& e) {
+                    errors[i] = e.what();
+                }
+            });
+        }
+        for (thread& writer : writers) {
+            writer.join();
+        }
+        for (const string& error : errors) {
+            if (!error.empty()) {
+                removeSegments(path, generation, segments);
+                throw runtime_error(error);
+            }
+        }
+
+        string body;
+        uint64_t count = segments;
+        body.append(reinterpret_cast<const char*>(&count), sizeof(count));
+        uint64_t entries = 0;
+        for (const WrittenFile& segment : written) {
+            body.append(reinterpret_cast<const char*>(&segment.entries), sizeof(segment.entries));
+            entries += segment.entries;
+            totalBytes += segment.bytes;
+        }
+
+        FileHeader header;
+        memcpy(header.magic, HEADER_MAGIC, sizeof(header.magic));
+        header.version = Snapshot::VERSION;
+        header.flags = Snapshot::FLAG_SEGMENTED | (checksum ? Snapshot::FLAG_CHECKSUM : 0);
+        header.entries = entries;
+        header.createdMs = generation;
+        FileFooter footer;
+        SnapshotChecksum sum;
+        sum.update(body.data(), body.size());
+        footer.checksum = checksum ? sum.digest() : 0;
+        memcpy(footer.magic, FOOTER_MAGIC, sizeof(footer.magic));
+
+        string manifest(reinterpret_cast<const char*>(&header), sizeof(header));
+        manifest += body;
+        manifest.append(reinterpret_cast<const char*>(&footer), sizeof(footer));
+        int out = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        bool ok = out >= 0 && writeAll(out, manifest.data(), manifest.size()) && fsync(out) == 0;
+        int err = errno;
+        if (out >= 0) close(out);
+        if (!ok) {
+            unlink(temp.c_str());
+            removeSegments(path, generation, segments);
+            throw runtime_error("write " + temp + ": " + strerror(err));
+        }
+        totalBytes += manifest.size();
+    }
+
+    if (rename(temp.c_str(), path.c_str()) != 0) {
+        int err = errno;
+        unlink(temp.c_str());
+        throw runtime_error("rename " + temp + ": " + strerror(err));
+    }
+    Utils::syncParentDirectory(path);
+    removeSegments(path, oldGeneration, oldSegments);
+    return totalBytes;
+}
+
+} // namespace
+
+size_t Snapshot::save(const Cache& cache, const string& path, bool checksum, size_t segments) {
+    return saveKeyspace([&](const EntryVisitor& visit, size_t part, size_t parts) {
+        cache.forEachEntry(visit, part, parts);
+    }, path, checksum, segments);
+}
+
+size_t Snapshot::save(const ShardedCache& cache, const string& path, bool checksum, size_t segments) {
+    return saveKeyspace([&](const EntryVisitor& visit, size_t part, size_t parts) {
+        cache.forEachEntry(visit, part, parts);
+    }, path, checksum, segments);
+}
+
+size_t Snapshot::load(Cache& cache, const string& path) {
+    if (cache.getKeyCount() != 0) {
+        throw runtime_error("snapshot load needs an empty cache");
+    }
+
+    MappedFile file(path);
+    string error = file.check();
+    size_t loaded = 0;
+    auto insert = [&](const LoadEntry* batch, size_t count) {
+        cache.loadKeys(batch, count);
+    };
+
+    if (error.empty() && !file.segmented()) {
+        cache.reserve(file.header.entries);
+        error = parseEntries(file, file.checksummed(), loaded, insert);
+    } else if (error.empty()) {
+        vector<uint64_t> counts = readManifest(file, error);
+        if (error.empty()) {
+            cache.reserve(file.header.entries);
+
+            // One thread per segment maps and checksums it, paging it in.
+            // The table is built here, a segment at a time as each is ready,
+            // while the others are still being read.
+            size_t segments = counts.size();
+            vector<unique_ptr<MappedFile>> mapped(segments);
+            vector<string> errors(segments);
+            vector<thread> readers;
+            for (size_t i = 0; i < segments; i++) {
+                readers.emplace_back([&, i]() {
+                    errors[i] = openSegment(path, file, i, counts[i], mapped[i]);
+                });
+            }
+            for (size_t i = 0; i < segments; i++) {
+                readers[i].join();
+                if (error.empty()) {
+                    error = errors[i];
+                }
+                if (error.empty()) {
+                    error = parseEntries(*mapped[i], false, loaded, insert);
+                }
+                mapped[i].reset();
+            }
+        }
+    }
+
+    if (!error.empty()) {
+        cache.flush();
+        throw runtime_error(path + " is corrupt: " + error);
+    }
+    return loaded;
+}
+
+size_t Snapshot::load(ShardedCache& cache, const string& path) {
+    if (cache.getKeyCount() != 0) {
+        throw runtime_error("snapshot load needs an empty cache");
+    }
+
+    MappedFile file(path);
+    string error = file.check();
+    size_t loaded = 0;
+    auto insert = [&](const LoadEntry* batch, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            cache.loadKey(batch[i].key, batch[i].value, batch[i].ttlMs, batch[i].type);
+        }
+    };
+
+    if (error.empty() && !file.segmented()) {
+        cache.reserve(file.header.entries);
+        error = parseEntries(file, file.checksummed(), loaded, insert);
+    } else if (error.empty()) {
+        vector<uint64_t> counts = readManifest(file, error);
+        if (error.empty()) {
+            cache.reserve(file.header.entries);
+
+            // Shards lock independently, so each segment's thread inserts
+            // its own keys: the tables are built in parallel
+            size_t segments = counts.size();
+            vector<string> errors(segments);
+            vector<size_t> loadedBySegment(segments, 0);
+            vector<thread> loaders;
+            for (size_t i = 0; i < segments; i++) {
+                loaders.emplace_back([&, i]() {
+                    unique_ptr<MappedFile> segment;
+                    errors[i] = openSegment(path, file, i, counts[i], segment);
+                    if (errors[i].empty()) {
+                        errors[i] = parseEntries(*segment, false, loadedBySegment[i], insert);
+                    }
+                });
+            }
+            for (size_t i = 0; i < segments; i++) {
+                loaders[i].join();
+                if (error.empty()) {
+                    error = errors[i];
+                }
+                loaded += loadedBySegment[i];
+            }
+        }
+    }
+
+    if (!error.empty()) {
+        cache.flush();
+        throw runtime_error(path + " is corrupt: " + error);
+    }
+    return loaded;
+}
+
+size_t Snapshot::diskUsage(const string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return 0;
+    }
+    size_t total = st.st_size;
+    int64_t generation;
+    size_t segments;
+    readGeneration(path, generation, segments);
+    for (size_t i = 0; i < segments; i++) {
+        if (stat(segmentPath(path, generation, i).c_str(), &st) == 0) {
+            total += st.st_size;
+        }
+    }
+    return total;
+}
+
+void Snapshot::remove(const string& path) {
+    int64_t generation;
+    size_t segments;
+    readGeneration(path, generation, segments);
+    removeSegments(path, generation, segments);
+    unlink(path.c_str());
+}
+
+SnapshotManager::SnapshotManager(const string& filePath, bool withChecksum, size_t segmentCount)
+    : path(filePath), checksum(withChecksum), segments(segmentCount), savePid(-1), saveStartMs(0) {}
+
+SnapshotManager::~SnapshotManager() {
+    // A background save is allowed to finish; it may be the only copy
+    if (savePid != -1) {
+        waitpid(savePid, nullptr, 0);
+    }
+}
+
+bool SnapshotManager::load(Cache& cache) {
+    if (access(path.c_str(), F_OK) != 0) {
+        return false;
+    }
+    auto start = chrono::steady_clock::now();
+    size_t keys = Snapshot::load(cache, path);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    Utils::logMessage("Snapshot: loaded " + to_string(keys) + " keys from " + path + " in " +
+                      to_string(seconds) + " s");
+    stats.lastSaveTime = Utils::getCurrentTimestamp();
+    return true;
+}
+
+bool SnapshotManager::save(const Cache& cache) {
+    if (savePid != -1) {
+        return false;
+    }
+    long long start = Utils::monotonicMillis();
+    try {
+        stats.lastSaveBytes = Snapshot::save(cache, path, checksum, segments);
+    } catch (const runtime_error& e) {
+        Utils::logMessage(string("Snapshot: save failed: ") + e.what());
+        stats.lastSaveOk = false;
+        stats.failedSaves++;
+        return false;
+    }
+    stats.lastSaveMillis = Utils::monotonicMillis() - start;
+    stats.lastSaveTime = Utils::getCurrentTimestamp();
+    stats.lastSaveOk = true;
+    stats.saves++;
+    return true;
+}
+
+bool SnapshotManager::startBackgroundSave(const Cache& cache) {
+    if (savePid != -1) {
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // BGSAVE child: writes the keyspace as it stood at the fork, starting
+        // its own segment threads when segments > 1. Any failure, not just a
+        // write error, must end in _exit rather than unwind into the
+        // parent's copied stack and run the server's destructors here.
+        bool ok = true;
+        try {
+            Snapshot::save(cache, path, checksum, segments);
+        } catch (...) {
+            ok = false;
+        }
+        _exit(ok ? 0 : 1);
+    }
+    if (pid < 0) {
+        Utils::logMessage(string("Snapshot: cannot fork for background save: ") + strerror(errno));
+        return false;
+    }
+
+    savePid = pid;
+    saveStartMs = Utils::monotonicMillis();
+    Utils::logMessage("Snapshot: background save started by pid " + to_string(pid));
+    return true;
+}
+
+void SnapshotManager::cron(bool wait) {
+    if (savePid == -1) {
+        return;
+    }
+    int status;
+    pid_t done = waitpid(savePid, &status, wait ? 0 : WNOHANG);
+    if (done == 0) {
+        return;
+    }
+    bool ok = done == savePid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    savePid = -1;
+
+    stats.lastSaveOk = ok;
+    if (ok) {
+        stats.lastSaveBytes = Snapshot::diskUsage(path);
+        stats.lastSaveMillis = Utils::monotonicMillis() - saveStartMs;
+        stats.lastSaveTime = Utils::getCurrentTimestamp();
+        stats.saves++;
+        Utils::logMessage("Snapshot: background save done, " + path + " is " +
+                          Utils::formatMemorySize(stats.lastSaveBytes));
+    } else {
+        stats.failedSaves++;
+        Utils::logMessage("Snapshot: background save failed");
+    }
+}
+
+SnapshotStats SnapshotManager::getStats() const {
+    SnapshotStats current = stats;
+    current.saveInProgress = savePid != -1;
+    return current;
+}
+
+void SnapshotManager::printStats(const SnapshotStats& stats, ostream& out) {
+    out << "=== SNAPSHOTS ===\n";
+    out << "Saves: " << stats.saves << " (" << stats.failedSaves << " failed)"
+        << (stats.saveInProgress ? ", one in progress" : "") << "\n";
+    out << "  Last Save: " << (stats.lastSaveOk ? "ok" : "failed") << ", "
+        << Utils::formatMemorySize(stats.lastSaveBytes) << " in " << stats.lastSaveMillis << " ms\n";
+    out << "  Last Save Time: " << stats.lastSaveTime << "\n";
+    out << "========================\n\n";
+}
@@ -1,49 +1,203 @@
 #include "../include/TTLManager.hpp"
+#include <algorithm>
 
 using namespace std;
 
-TTLManager::TTLManager() {}
+namespace {
+
+const size_t POSITION_BITS = 32;
+const size_t POSITION_MASK = (size_t(1) << POSITION_BITS) - 1;
+
+inline size_t encode(size_t bucket, size_t position) {
+    return (bucket << POSITION_BITS) | position;
+}
+
+} // namespace
+
+TTLManager::TTLManager(long long startTime) : current(startTime), count(0), slotCapacity(0) {
+    for (int level = 0; level < LEVELS; level++) {
+        occupied[level] = 0;
+    }
+}
 
 TTLManager::~TTLManager() {
     clear();
 }
 
-void TTLManager::addKey(const string& key, long long expiryTime) {
-    minHeap.emplace(key, expiryTime);
+// The lowest level whose current block holds the expiry: level L when
+// expiry and current first differ in the L-th group of SLOT_BITS bits
+size_t TTLManager::bucketFor(long long expiryTime) const {
+    if (expiryTime < current) {
+        return READY_BUCKET;
+    }
+    
+    uint64_t differing = static_cast<uint64_t>(expiryTime) ^ static_cast<uint64_t>(current);
+    for (int level = 0; level < LEVELS; level++) {
+        if ((differing >> (SLOT_BITS * (level + 1))) == 0) {
+            return level * SLOTS + ((static_cast<uint64_t>(expiryTime) >> (SLOT_BITS * level)) & (SLOTS - 1));
+        }
+    }
+    return OVERFLOW_BUCKET;
+}
+
+void TTLManager::append(size_t bucket, HashNode* node) {
+    vector<HashNode*>& slot = buckets[bucket];
+    size_t before = slot.capacity();
+    slot.push_back(node);
+    slotCapacity += slot.capacity() - before;
+    node->ttlIndex = encode(bucket, slot.size() - 1);
+    
+    if (bucket < OVERFLOW_BUCKET) {
+        occupied[bucket / SLOTS] |= uint64_t(1) << (bucket % SLOTS);
+    }
 }
 
-vector<string> TTLManager::getExpiredKeys(long long currentTime) {
-    vector<string> expiredKeys;
+// Swap-removes the node from its bucket
+void TTLManager::detach(HashNode* node) {
+    size_t bucket = node->ttlIndex >> POSITION_BITS;
+    size_t position = node->ttlIndex & POSITION_MASK;
+    vector<HashNode*>& slot = buckets[bucket];
     
-    // Create a temporary copy to check expired keys without modifying original
-    auto tempHeap = minHeap;
+    HashNode* last = slot.back();
+    slot[position] = last;
+    last->ttlIndex = encode(bucket, position);
+    slot.pop_back();
+    node->ttlIndex = HashNode::NOT_SCHEDULED;
     
-    while (!tempHeap.empty() && tempHeap.top().expiryTime <= currentTime) {
-        expiredKeys.push_back(tempHeap.top().key);
-        tempHeap.pop();
+    // An emptied bucket gives its storage back, so rescheduling never
+    // leaves capacity behind in buckets that are not in use
+    if (slot.empty()) {
+        slotCapacity -= slot.capacity();
+        vector<HashNode*>().swap(slot);
+        if (bucket < OVERFLOW_BUCKET) {
+            occupied[bucket / SLOTS] &= ~(uint64_t(1) << (bucket % SLOTS));
+        }
+    }
+}
+
+void TTLManager::schedule(HashNode* node) {
+    size_t bucket = bucketFor(node->expiryTime);
+    if (node->ttlIndex != HashNode::NOT_SCHEDULED) {
+        if ((node->ttlIndex >> POSITION_BITS) == bucket) return;
+        detach(node);
+        count--;
+    }
+    append(bucket, node);
+    count++;
+}
+
+void TTLManager::cancel(HashNode* node) {
+    if (node->ttlIndex != HashNode::NOT_SCHEDULED) {
+        detach(node);
+        count--;
+    }
+}
+
+// Re-files every node of a bucket relative to the current tick
+void TTLManager::moveAll(size_t bucket) {
+    vector<HashNode*> nodes;
+    nodes.swap(buckets[bucket]);
+    slotCapacity -= nodes.capacity();
+    if (bucket < OVERFLOW_BUCKET) {
+        occupied[bucket / SLOTS] &= ~(uint64_t(1) << (bucket % SLOTS));
     }
     
-    return expiredKeys;
+    for (HashNode* node : nodes) {
+        append(bucketFor(node->expiryTime), node);
+    }
 }
 
-void TTLManager::removeExpiredKeys(long long currentTime) {
-    // Create new heap without expired keys
-    priority_queue<TTLEntry, vector<TTLEntry>, greater<TTLEntry>> newHeap;
+// The next tick after this one at which a slot needs processing. Lower
+// levels always fire first, so the first occupied level decides.
+long long TTLManager::nextEventAfter(long long tick) const {
+    uint64_t t = static_cast<uint64_t>(tick);
+    for (int level = 0; level < LEVELS; level++) {
+        int shift = SLOT_BITS * level;
+        uint64_t slot = (t >> shift) & (SLOTS - 1);
+        uint64_t later = slot + 1 < SLOTS ? occupied[level] & (~uint64_t(0) << (slot + 1)) : 0;
+        if (later) {
+            uint64_t blockStart = (t >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+            return static_cast<long long>(blockStart + (uint64_t(__builtin_ctzll(later)) << shift));
+        }
+    }
     
-    while (!minHeap.empty()) {
-        TTLEntry entry = minHeap.top();
-        minHeap.pop();
+    // Only overflow (or nothing) is left: wake when the top level wraps
+    int topShift = SLOT_BITS * LEVELS;
+    return static_cast<long long>(((t >> topShift) + 1) << topShift);
+}
+
+// Processes every tick up to and including this one
+void TTLManager::advanceTo(long long tick) {
+    while (current <= tick) {
+        // Entering a higher-level slot moves its nodes down, top level first
+        // so that they can keep falling
+        uint64_t t = static_cast<uint64_t>(current);
+        if ((t & ((uint64_t(1) << (SLOT_BITS * LEVELS)) - 1)) == 0 && !buckets[OVERFLOW_BUCKET].empty()) {
+            moveAll(OVERFLOW_BUCKET);
+        }
+        for (int level = LEVELS - 1; level >= 1; level--) {
+            if ((t & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) == 0) {
+                size_t bucket = level * SLOTS + ((t >> (SLOT_BITS * level)) & (SLOTS - 1));
+                if (!buckets[bucket].empty()) {
+                    moveAll(bucket);
+                }
+            }
+        }
         
-        if (entry.expiryTime > currentTime) {
-            newHeap.push(entry);
+        // Level 0 slots hold nodes expiring on exactly this tick
+        size_t bucket = t & (SLOTS - 1);
+        if (!buckets[bucket].empty()) {
+            for (HashNode* node : buckets[bucket]) {
+                append(READY_BUCKET, node);
+            }
+            slotCapacity -= buckets[bucket].capacity();
+            vector<HashNode*>().swap(buckets[bucket]);
+            occupied[0] &= ~(uint64_t(1) << bucket);
         }
+        
+        // Jump to the next slot with work, but never past the target: later
+        // schedules must still be filed relative to a tick not yet done
+        current = count > buckets[READY_BUCKET].size() ? min(nextEventAfter(current), tick + 1) : tick + 1;
+    }
+}
+
+bool TTLManager::hasExpired(long long currentTime) {
+    if (count == 0) {
+        // Nothing pending, so every earlier tick is trivially done
+        current = max(current, currentTime);
+        return false;
+    }
+    if (buckets[READY_BUCKET].empty()) {
+        advanceTo(currentTime - 1);
+    }
+    return !buckets[READY_BUCKET].empty();
+}
+
+HashNode* TTLManager::popExpired(long long currentTime) {
+    if (!hasExpired(currentTime)) {
+        return nullptr;
     }
     
-    minHeap = move(newHeap);
+    // Guards against the clock stepping back after a node became ready
+    HashNode* node = buckets[READY_BUCKET].back();
+    if (node->expiryTime >= currentTime) {
+        return nullptr;
+    }
+    detach(node);
+    count--;
+    return node;
 }
 
 void TTLManager::clear() {
-    while (!minHeap.empty()) {
-        minHeap.pop();
+    for (vector<HashNode*>& slot : buckets) {
+        for (HashNode* node : slot) {
+            node->ttlIndex = HashNode::NOT_SCHEDULED;
+        }
+        vector<HashNode*>().swap(slot);
     }
-}
\ No newline at end of file
+    for (int level = 0; level < LEVELS; level++) {
+        occupied[level] = 0;
+    }
+    count = 0;
+    slotCapacity = 0;
+}
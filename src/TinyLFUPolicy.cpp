@@ -0,0 +1,146 @@
+#include "../include/TinyLFUPolicy.hpp"
+#include <algorithm>
+
+using namespace std;
+
+CountMinSketch::CountMinSketch(size_t expectedKeys) : additions(0) {
+    // About one word (16 counters, four per row) per expected key
+    size_t words = 16;
+    size_t limit = min<size_t>(max<size_t>(expectedKeys, 1), size_t(1) << 24);
+    while (words < limit) words <<= 1;
+    
+    table.assign(words, 0);
+    wordMask = words - 1;
+    sampleSize = 10 * words;
+}
+
+uint64_t CountMinSketch::rowHash(size_t h, int row) {
+    static const uint64_t SEEDS[4] = {
+        0xC3A5C85C97CB3127ULL, 0xB492B66FBE98F273ULL, 0x9AE16A3B2F90404FULL, 0xCBF29CE484222325ULL
+    };
+    uint64_t x = (h + SEEDS[row]) * 0x9E3779B97F4A7C15ULL;
+    return x ^ (x >> 32);
+}
+
+void CountMinSketch::increment(size_t h) {
+    bool added = false;
+    for (int row = 0; row < 4; row++) {
+        uint64_t x = rowHash(h, row);
+        uint64_t& word = table[x & wordMask];
+        int shift = static_cast<int>((x >> 60) & 15) * 4;
+        if (((word >> shift) & 15) < 15) {
+            word += uint64_t(1) << shift;
+            added = true;
+        }
+    }
+    
+    if (added && ++additions >= sampleSize) {
+        halve();
+    }
+}
+
+unsigned CountMinSketch::frequency(size_t h) const {
+    unsigned estimate = 15;
+    for (int row = 0; row < 4; row++) {
+        uint64_t x = rowHash(h, row);
+        int shift = static_cast<int>((x >> 60) & 15) * 4;
+        estimate = min(estimate, static_cast<unsigned>((table[x & wordMask] >> shift) & 15));
+    }
+    return estimate;
+}
+
+void CountMinSketch::halve() {
+    for (uint64_t& word : table) {
+        word = (word >> 1) & 0x7777777777777777ULL;
+    }
+    additions /= 2;
+}
+
+void CountMinSketch::clear() {
+    fill(table.begin(), table.end(), 0);
+    additions = 0;
+}
+
+TinyLFUPolicy::TinyLFUPolicy(size_t expectedKeys)
+    : sketch(expectedKeys), window(0), probation(0), protectedList(0) {}
+
+LRUCache& TinyLFUPolicy::listFor(const HashNode* node) {
+    switch (node->evictionState) {
+        case WINDOW: return window;
+        case PROBATION: return probation;
+        default: return protectedList;
+    }
+}
+
+HashNode* TinyLFUPolicy::tailExcept(const LRUCache& list, const HashNode* keep) {
+    HashNode* node = list.leastRecent();
+    return node == keep ? nullptr : node;
+}
+
+void TinyLFUPolicy::insert(HashNode* node) {
+    sketch.increment(node->hash);
+    node->evictionState = WINDOW;
+    window.access(node);
+}
+
+void TinyLFUPolicy::access(HashNode* node) {
+    sketch.increment(node->hash);
+    if (node->evictionState != PROBATION) {
+        listFor(node).access(node);
+        return;
+    }
+    
+    // A second hit on probation earns protection; the protected segment's
+    // oldest key makes room by going back on probation
+    probation.remove(node);
+    node->evictionState = PROTECTED;
+    protectedList.access(node);
+    
+    size_t mainKeys = probation.size() + protectedList.size();
+    if (protectedList.size() > mainKeys * PROTECTED_PERCENT / 100) {
+        HashNode* demoted = protectedList.evictLRU();
+        demoted->evictionState = PROBATION;
+        probation.access(demoted);
+    }
+}
+
+void TinyLFUPolicy::remove(HashNode* node) {
+    if (node->evictionState == 0) return;
+    listFor(node).remove(node);
+    node->evictionState = 0;
+}
+
+HashNode* TinyLFUPolicy::victim(const HashNode* keep) {
+    // Keys leaving the window go on probation
+    size_t windowTarget = max<size_t>(1, size() * WINDOW_PERCENT / 100);
+    HashNode* candidate = nullptr;
+    while (window.size() > windowTarget) {
+        HashNode* node = tailExcept(window, keep);
+        if (!node) break;
+        
+        window.remove(node);
+        node->evictionState = PROBATION;
+        probation.access(node);
+        candidate = node;
+    }
+    
+    // The newest of them competes with the key probation would give up; the
+    // less frequent one is evicted, and ties keep the incumbent
+    HashNode* incumbent = tailExcept(probation, keep);
+    if (candidate && incumbent && candidate != incumbent) {
+        return sketch.frequency(candidate->hash) > sketch.frequency(incumbent->hash) ? incumbent : candidate;
+    }
+    
+    for (LRUCache* list : {&probation, &protectedList, &window}) {
+        HashNode* node = tailExcept(*list, keep);
+        if (node) return node;
+    }
+    return nullptr;
+}
+
+void TinyLFUPolicy::clear() {
+    window.clear();
+    probation.clear();
+    protectedList.clear();
+    sketch.clear();
+}
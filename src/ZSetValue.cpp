@@ -0,0 +1,493 @@
+#include "../include/ZSetValue.hpp"
+#include <cmath>
+
+using namespace std;
+
+ZSetValue::ZSetValue(SlabAllocator* owner)
+    : slabs(owner), pack(nullptr), head(nullptr), tail(nullptr), count(0), packBytes(0), packCapacity(0), level(1),
+      heapBytes(0) {}
+
+// Entries are added one by one, so duplicates and order need no checking;
+// a large set goes straight to a skiplist sized for all of them
+ZSetValue::ZSetValue(SlabAllocator* owner, string_view serialized) : ZSetValue(owner) {
+    const char* pos = serialized.data();
+    const char* end = pos + serialized.size();
+    size_t entries = 0;
+    bool compact = true;
+    while (pos < end) {
+        double score;
+        string_view member;
+        pos = packRead(pos, end, score, member);
+        compact = compact && member.size() <= MAX_LISTPACK_VALUE;
+        entries++;
+    }
+    if (!compact || entries > MAX_LISTPACK_ENTRIES) {
+        convertToSkiplist(entries);
+    }
+
+    pos = serialized.data();
+    while (pos < end) {
+        double score, added;
+        string_view member;
+        pos = packRead(pos, end, score, member);
+        add(member, score, 0, added);
+    }
+}
+
+ZSetValue::~ZSetValue() {
+    if (head) {
+        Node* node = head->levels()[0].forward;
+        while (node) {
+            Node* next = node->levels()[0].forward;
+            freeNode(node);
+            node = next;
+        }
+        freeNode(head);
+    }
+    members.release(slabs);
+    if (pack) {
+        slabs->deallocate(pack, packCapacity);
+    }
+}
+
+const char* ZSetValue::packRead(const char* pos, const char* end, double& score, string_view& member) {
+    if (static_cast<size_t>(end - pos) < SCORE_BYTES) {
+        return nullptr;
+    }
+    memcpy(&score, pos, SCORE_BYTES);
+    return Listpack::readString(pos + SCORE_BYTES, end, member);
+}
+
+bool ZSetValue::isValid(string_view serialized) {
+    const char* pos = serialized.data();
+    const char* end = pos + serialized.size();
+    if (pos == end) {
+        return false;   // sorted sets are never empty
+    }
+    while (pos < end) {
+        double score;
+        string_view member;
+        pos = packRead(pos, end, score, member);
+        if (!pos || isnan(score)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t ZSetValue::packFind(string_view member, double* score) const {
+    const char* pos = pack;
+    const char* end = pack + packBytes;
+    while (pos < end) {
+        const char* entry = pos;
+        double value;
+        string_view name;
+        pos = packRead(pos, end, value, name);
+        if (name == member) {
+            if (score) *score = value;
+            return entry - pack;
+        }
+    }
+    return packBytes;
+}
+
+// Offset of the first entry after score and member
+size_t ZSetValue::packPosition(double score, string_view member) const {
+    const char* pos = pack;
+    const char* end = pack + packBytes;
+    while (pos < end) {
+        double value;
+        string_view name;
+        const char* next = packRead(pos, end, value, name);
+        if (value > score || (value == score && name > member)) {
+            break;
+        }
+        pos = next;
+    }
+    return pos - pack;
+}
+
+void ZSetValue::packEntries(vector<uint32_t>& offsets) const {
+    offsets.reserve(count);
+    const char* pos = pack;
+    const char* end = pack + packBytes;
+    while (pos < end) {
+        offsets.push_back(static_cast<uint32_t>(pos - pack));
+        double score;
+        string_view member;
+        pos = packRead(pos, end, score, member);
+    }
+}
+
+// Grows the buffer to a whole slab chunk of at least bytes, as HashValue does
+void ZSetValue::packReserve(size_t bytes) {
+    if (bytes <= packCapacity) {
+        return;
+    }
+    size_t newCapacity = slabs->chunkSize(bytes);
+    char* grown = static_cast<char*>(slabs->allocate(newCapacity));
+    if (pack) {
+        memcpy(grown, pack, packBytes);
+        slabs->deallocate(pack, packCapacity);
+    }
+    heapBytes += newCapacity - packCapacity;
+    pack = grown;
+    packCapacity = static_cast<uint32_t>(newCapacity);
+}
+
+void ZSetValue::packInsert(size_t at, double score, string_view member) {
+    size_t bytes = SCORE_BYTES + Listpack::entryBytes(member);
+    packReserve(packBytes + bytes);
+    char* entry = pack + at;
+    memmove(entry + bytes, entry, packBytes - at);
+    memcpy(entry, &score, SCORE_BYTES);
+    Listpack::writeString(entry + SCORE_BYTES, member);
+    packBytes += static_cast<uint32_t>(bytes);
+}
+
+void ZSetValue::packRemove(size_t entry) {
+    const char* end = pack + packBytes;
+    double score;
+    string_view member;
+    const char* next = packRead(pack + entry, end, score, member);
+    memmove(pack + entry, next, end - next);
+    packBytes -= static_cast<uint32_t>(next - (pack + entry));
+}
+
+void ZSetValue::convertToSkiplist(size_t memberCount) {
+    head = newNode(MAX_LEVEL, 0, "", 0);
+    level = 1;
+    members.reserve(slabs, memberCount);
+
+    // Entries come in order, so each one links in at the tail
+    size_t linked = 0;
+    const char* pos = pack;
+    const char* end = pack + packBytes;
+    while (pos < end) {
+        double score;
+        string_view member;
+        pos = packRead(pos, end, score, member);
+        uint32_t h = RecordIndex<Node>::hashKey(member);
+        Node* node = newNode(randomLevel(), score, member, h);
+        linkNode(node, linked++);
+        members.insert(slabs, node);
+    }
+
+    if (pack) {
+        slabs->deallocate(pack, packCapacity);
+        heapBytes -= packCapacity;
+    }
+    pack = nullptr;
+    packBytes = 0;
+    packCapacity = 0;
+}
+
+// Levels with probability 1/4 each, as in Redis
+int ZSetValue::randomLevel() {
+    static thread_local uint64_t state = 0x9E3779B97F4A7C15ULL;
+    int height = 1;
+    for (;;) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        if ((state & 3) != 0 || height == MAX_LEVEL) {
+            return height;
+        }
+        height++;
+    }
+}
+
+ZSetValue::Node* ZSetValue::newNode(int height, double score, string_view member, uint32_t h) {
+    size_t bytes = sizeof(Node) + height * sizeof(Level) + member.size();
+    Node* node = static_cast<Node*>(slabs->allocate(bytes));
+    node->score = score;
+    node->backward = nullptr;
+    node->hash = h;
+    node->memberLength = static_cast<uint32_t>(member.size());
+    node->height = static_cast<uint32_t>(height);
+    for (int i = 0; i < height; i++) {
+        node->levels()[i] = {nullptr, 0};
+    }
+    memcpy(node->bytes(), member.data(), member.size());
+    heapBytes += slabs->chunkSize(bytes);
+    return node;
+}
+
+void ZSetValue::freeNode(Node* node) {
+    size_t bytes = node->allocSize();
+    heapBytes -= slabs->chunkSize(bytes);
+    slabs->deallocate(node, bytes);
+}
+
+// Links node into its place by score and member; length is how many nodes
+// are linked already
+void ZSetValue::linkNode(Node* node, size_t length) {
+    Node* update[MAX_LEVEL];
+    size_t rank[MAX_LEVEL];
+    Node* x = head;
+    for (int i = level - 1; i >= 0; i--) {
+        rank[i] = i == level - 1 ? 0 : rank[i + 1];
+        while (x->levels()[i].forward && nodeBefore(x->levels()[i].forward, node->score, node->key())) {
+            rank[i] += x->levels()[i].span;
+            x = x->levels()[i].forward;
+        }
+        update[i] = x;
+    }
+
+    int height = static_cast<int>(node->height);
+    if (height > level) {
+        for (int i = level; i < height; i++) {
+            rank[i] = 0;
+            update[i] = head;
+            head->levels()[i].span = length;
+        }
+        level = height;
+    }
+    for (int i = 0; i < height; i++) {
+        Level& before = update[i]->levels()[i];
+        node->levels()[i].forward = before.forward;
+        node->levels()[i].span = before.span - (rank[0] - rank[i]);
+        before.forward = node;
+        before.span = rank[0] - rank[i] + 1;
+    }
+    for (int i = height; i < level; i++) {
+        update[i]->levels()[i].span++;
+    }
+
+    node->backward = update[0] == head ? nullptr : update[0];
+    if (node->levels()[0].forward) {
+        node->levels()[0].forward->backward = node;
+    } else {
+        tail = node;
+    }
+}
+
+void ZSetValue::unlinkNode(Node* node) {
+    Node* update[MAX_LEVEL];
+    Node* x = head;
+    for (int i = level - 1; i >= 0; i--) {
+        while (x->levels()[i].forward && nodeBefore(x->levels()[i].forward, node->score, node->key())) {
+            x = x->levels()[i].forward;
+        }
+        update[i] = x;
+    }
+
+    for (int i = 0; i < level; i++) {
+        Level& before = update[i]->levels()[i];
+        if (before.forward == node) {
+            before.span += node->levels()[i].span - 1;
+            before.forward = node->levels()[i].forward;
+        } else {
+            before.span--;
+        }
+    }
+    if (node->levels()[0].forward) {
+        node->levels()[0].forward->backward = node->backward;
+    } else {
+        tail = node->backward;
+    }
+    while (level > 1 && !head->levels()[level - 1].forward) {
+        level--;
+    }
+}
+
+ZSetValue::Node* ZSetValue::nodeByRank(size_t rank) const {
+    Node* x = head;
+    size_t traversed = 0;
+    for (int i = level - 1; i >= 0; i--) {
+        while (x->levels()[i].forward && traversed + x->levels()[i].span <= rank) {
+            traversed += x->levels()[i].span;
+            x = x->levels()[i].forward;
+        }
+        if (traversed == rank) {
+            return x;
+        }
+    }
+    return nullptr;
+}
+
+// 1-based
+size_t ZSetValue::nodeRank(const Node* node) const {
+    Node* x = head;
+    size_t rank = 0;
+    for (int i = level - 1; i >= 0; i--) {
+        for (Node* next = x->levels()[i].forward;
+             next && (next == node || nodeBefore(next, node->score, node->key()));
+             next = x->levels()[i].forward) {
+            rank += x->levels()[i].span;
+            x = next;
+        }
+        if (x == node) {
+            return rank;
+        }
+    }
+    return 0;
+}
+
+ZSetValue::Node* ZSetValue::firstInRange(const ScoreRange& range) const {
+    Node* x = head;
+    for (int i = level - 1; i >= 0; i--) {
+        while (x->levels()[i].forward && !range.aboveMin(x->levels()[i].forward->score)) {
+            x = x->levels()[i].forward;
+        }
+    }
+    x = x->levels()[0].forward;
+    return x && range.belowMax(x->score) ? x : nullptr;
+}
+
+ZSetValue::Node* ZSetValue::lastInRange(const ScoreRange& range) const {
+    Node* x = head;
+    for (int i = level - 1; i >= 0; i--) {
+        while (x->levels()[i].forward && range.belowMax(x->levels()[i].forward->score)) {
+            x = x->levels()[i].forward;
+        }
+    }
+    return x != head && range.aboveMin(x->score) ? x : nullptr;
+}
+
+bool ZSetValue::score(string_view member, double& score) const {
+    if (!head) {
+        return packFind(member, &score) != packBytes;
+    }
+    const Node* node = members.find(member, RecordIndex<Node>::hashKey(member));
+    if (node) {
+        score = node->score;
+    }
+    return node != nullptr;
+}
+
+// Moves an existing member to score
+void ZSetValue::setScore(string_view member, double score) {
+    if (!head) {
+        packRemove(packFind(member));
+        packInsert(packPosition(score, member), score, member);
+        return;
+    }
+    Node* node = members.find(member, RecordIndex<Node>::hashKey(member));
+    Node* next = node->levels()[0].forward;
+    // In place when the order does not change
+    if ((!node->backward || nodeBefore(node->backward, score, member)) && (!next || !nodeBefore(next, score, member))) {
+        node->score = score;
+        return;
+    }
+    unlinkNode(node);
+    node->score = score;
+    linkNode(node, count - 1);
+}
+
+bool ZSetValue::insertNew(string_view member, double score) {
+    if (!head) {
+        if (member.size() <= MAX_LISTPACK_VALUE && count < MAX_LISTPACK_ENTRIES) {
+            packInsert(packPosition(score, member), score, member);
+            count++;
+            return true;
+        }
+        convertToSkiplist(count + 1);
+    }
+    uint32_t h = RecordIndex<Node>::hashKey(member);
+    Node* node = newNode(randomLevel(), score, member, h);
+    linkNode(node, count);
+    members.insert(slabs, node);
+    count++;
+    return true;
+}
+
+ZSetValue::AddOutcome ZSetValue::add(string_view member, double score, uint32_t flags, double& newScore) {
+    if (isnan(score)) {
+        return NOT_A_NUMBER;
+    }
+    double current;
+    if (!this->score(member, current)) {
+        if (flags & ADD_XX) {
+            return SKIPPED;
+        }
+        insertNew(member, score);
+        newScore = score;
+        return ADDED;
+    }
+
+    if (flags & ADD_NX) {
+        return SKIPPED;
+    }
+    if (flags & ADD_INCR) {
+        score += current;
+        if (isnan(score)) {
+            return NOT_A_NUMBER;
+        }
+    }
+    if (((flags & ADD_GT) && score <= current) || ((flags & ADD_LT) && score >= current)) {
+        return SKIPPED;
+    }
+    newScore = score;
+    if (score == current) {
+        return UNCHANGED;
+    }
+    setScore(member, score);
+    return UPDATED;
+}
+
+bool ZSetValue::remove(string_view member) {
+    if (!head) {
+        size_t entry = packFind(member);
+        if (entry == packBytes) {
+            return false;
+        }
+        packRemove(entry);
+        count--;
+        return true;
+    }
+    Node* node = members.remove(member, RecordIndex<Node>::hashKey(member));
+    if (!node) {
+        return false;
+    }
+    unlinkNode(node);
+    freeNode(node);
+    count--;
+    return true;
+}
+
+long long ZSetValue::rank(string_view member, bool reverse) const {
+    long long position = -1;
+    if (!head) {
+        long long i = 0;
+        forEach([&](string_view name, double) {
+            if (name == member) position = i;
+            i++;
+        });
+    } else {
+        const Node* node = members.find(member, RecordIndex<Node>::hashKey(member));
+        if (node) {
+            position = static_cast<long long>(nodeRank(node)) - 1;
+        }
+    }
+    if (position < 0) {
+        return -1;
+    }
+    return reverse ? count - 1 - position : position;
+}
+
+size_t ZSetValue::countInRange(const ScoreRange& range) const {
+    if (!head) {
+        size_t matches = 0;
+        forEachInRange(range, false, 0, -1, [&](string_view, double) { matches++; });
+        return matches;
+    }
+    const Node* first = firstInRange(range);
+    if (!first) {
+        return 0;
+    }
+    return nodeRank(lastInRange(range)) - nodeRank(first) + 1;
+}
+
+void ZSetValue::serialize(string& out) const {
+    if (!head) {
+        out.append(pack, packBytes);
+        return;
+    }
+    char length[10];
+    for (const Node* node = head->levels()[0].forward; node; node = node->levels()[0].forward) {
+        out.append(reinterpret_cast<const char*>(&node->score), SCORE_BYTES);
+        out.append(length, Listpack::writeLength(length, node->memberLength) - length);
+        out.append(node->key());
+    }
+}
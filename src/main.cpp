@@ -2,14 +2,99 @@
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <csignal>
+#include <cstring>
 #include "../include/Cache.hpp"
+#include "../include/CommandProcessor.hpp"
+#include "../include/Server.hpp"
+#include "../include/RESP.hpp"
+#include "../include/AppendOnlyFile.hpp"
 #include "../include/utils.hpp"
 
 using namespace std;
 
+// Renders replies the way redis-cli does
+class CLIReplyWriter : public ReplyWriter {
+private:
+    size_t arrayRemaining = 0;
+    size_t arrayIndex = 0;
+    
+    void prefix() {
+        if (arrayRemaining > 0) {
+            cout << ++arrayIndex << ") ";
+            arrayRemaining--;
+        }
+    }
+    
+public:
+    using ReplyWriter::bulk;
+    
+    void status(const string& message) override { prefix(); cout << message << "\n"; }
+    void error(const string& message) override { prefix(); cout << "(error) " << message << "\n"; }
+    void integer(long long value) override { prefix(); cout << "(integer) " << value << "\n"; }
+    void bulk(const string& value) override { prefix(); cout << "\"" << value << "\"\n"; }
+    void nil() override { prefix(); cout << "(nil)\n"; }
+    void text(const string& value) override { prefix(); cout << value; }
+    
+    void arrayHeader(size_t count) override {
+        prefix();
+        if (count == 0) {
+            cout << "(empty array)\n";
+        }
+        arrayRemaining = count;
+        arrayIndex = 0;
+    }
+};
+
+// Persistence settings from the command line; no path means no AOF, no
+// dbFilename no snapshots
+struct PersistenceOptions {
+    string path;
+    string dbFilename;
+    size_t snapshotSegments = 1;
+    FsyncPolicy fsyncPolicy = FsyncPolicy::EVERYSEC;
+    int rewritePercentage = AppendOnlyFile::DEFAULT_REWRITE_PERCENTAGE;
+    size_t rewriteMinBytes = AppendOnlyFile::DEFAULT_REWRITE_MIN_BYTES;
+};
+
+// Replays an existing log into cache, then starts appending to it
+static void openAppendOnlyFile(AppendOnlyFile& aof, const PersistenceOptions& options, Cache& cache) {
+    aof.setAutoRewrite(options.rewritePercentage, options.rewriteMinBytes);
+    CommandProcessor loader(cache);
+    size_t commands = aof.load(loader);
+    Utils::logMessage("AOF: replayed " + to_string(commands) + " commands from " + aof.getPath());
+    aof.start();
+}
+
+// Restores the keyspace on startup: from the AOF when there is one, since it
+// is the more recent, otherwise from the snapshot if one was saved
+static void restoreKeyspace(AppendOnlyFile* aof, SnapshotManager* snapshots, const PersistenceOptions& options,
+                            Cache& cache) {
+    if (aof) {
+        openAppendOnlyFile(*aof, options, cache);
+    } else if (snapshots) {
+        snapshots->load(cache);
+    }
+}
+
+// Without an AOF, the snapshot is the only copy: save one last time on the
+// way out
+static void saveOnShutdown(AppendOnlyFile* aof, SnapshotManager* snapshots, const Cache& cache) {
+    if (snapshots && !aof) {
+        snapshots->cron(true);
+        if (snapshots->save(cache)) {
+            Utils::logMessage("Snapshot: saved " + to_string(cache.getKeyCount()) + " keys to " + snapshots->getPath());
+        }
+    }
+}
+
 class MiniRedisCLI {
 private:
     Cache* cache;
+    AppendOnlyFile* aof;
+    SnapshotManager* snapshots;
+    CommandProcessor* processor;
+    CLIReplyWriter reply;
     bool running;
     
     void printWelcome() {
@@ -23,6 +108,8 @@ private:
         cout << "  DELETE key          - Remove key" << endl;
         cout << "  EXISTS key          - Check if key exists" << endl;
         cout << "  EXPIRE key seconds  - Set expiration time" << endl;
+        cout << "  PEXPIRE key ms      - Set expiration time in milliseconds" << endl;
+        cout << "  TTL / PTTL key      - Time left to live" << endl;
         cout << "  FLUSH               - Clear all data" << endl;
         cout << "  STATS               - Show cache statistics" << endl;
         cout << "  HELP                - Show this help" << endl;
@@ -37,8 +124,22 @@ private:
         cout << "DELETE key             Remove a key and its value" << endl;
         cout << "EXISTS key             Check if a key exists and is not expired" << endl;
         cout << "EXPIRE key seconds     Set expiration time for an existing key" << endl;
+        cout << "PEXPIRE key ms         Set expiration time in milliseconds" << endl;
+        cout << "PSETEX key ms value    Store a key-value pair with a TTL in milliseconds" << endl;
+        cout << "TTL key                Seconds left to live, -1 without TTL, -2 if missing" << endl;
+        cout << "PTTL key               Milliseconds left to live" << endl;
+        cout << "HSET key field value   Set hash fields (HGET, HMGET, HDEL, HLEN, HGETALL, HINCRBY)" << endl;
+        cout << "ZADD key score member  Add to a sorted set (ZSCORE, ZRANK, ZRANGE, ZRANGEBYSCORE, ...)" << endl;
+        cout << "INCR key               Add 1 to an integer value (DECR, INCRBY, DECRBY, INCRBYFLOAT)" << endl;
+        cout << "RPUSH key element      Append to a list (LPUSH, LPOP, RPOP, LLEN, LRANGE)" << endl;
+        cout << "SADD key member        Add to a set (SREM, SISMEMBER, SCARD, SMEMBERS, SINTER)" << endl;
+        cout << "TYPE key               Type of the value: string, hash, zset, list, set or none" << endl;
+        cout << "OBJECT ENCODING key    How the value is stored (embstr, listpack, ...)" << endl;
         cout << "FLUSH                  Clear the entire cache" << endl;
+        cout << "SAVE / BGSAVE          Write a snapshot (needs --dbfilename)" << endl;
         cout << "STATS                  Display cache statistics and performance metrics" << endl;
+        cout << "STATS RESET            Zero the counters and latency histograms" << endl;
+        cout << "INFO [section]         The same as field:value lines (stats, commandstats, ...)" << endl;
         cout << "HELP                   Show this help message" << endl;
         cout << "QUIT                   Exit the program" << endl;
         cout << "\nExamples:" << endl;
@@ -56,153 +157,18 @@ private:
         return result;
     }
     
-    void handleSetCommand(const vector<string>& tokens) {
-        if (tokens.size() < 3) {
-            cout << "Error: SET requires at least key and value" << endl;
-            cout << "Usage: SET key value [ttl]" << endl;
+    void processCommand(string& input) {
+        // Quoted arguments are unescaped in place, as redis-cli sends them
+        vector<string_view> tokens;
+        if (!RESPParser::splitInline(&input[0], input.size(), tokens)) {
+            cout << "(error) ERR Invalid argument(s)" << endl;
             return;
         }
-        
-        string key = tokens[1];
-        string value = tokens[2];
-        int ttl = -1;
-        
-        if (tokens.size() >= 4) {
-            try {
-                ttl = stoi(tokens[3]);
-                if (ttl <= 0) {
-                    cout << "Error: TTL must be positive" << endl;
-                    return;
-                }
-            } catch (const exception& e) {
-                cout << "Error: Invalid TTL value" << endl;
-                return;
-            }
-        }
-        
-        if (cache->set(key, value, ttl)) {
-            if (ttl > 0) {
-                cout << "OK (expires in " << ttl << " seconds)" << endl;
-            } else {
-                cout << "OK" << endl;
-            }
-        } else {
-            cout << "Error: Failed to set key" << endl;
-        }
-    }
-    
-    void handleGetCommand(const vector<string>& tokens) {
-        if (tokens.size() < 2) {
-            cout << "Error: GET requires a key" << endl;
-            cout << "Usage: GET key" << endl;
-            return;
-        }
-        
-        string key = tokens[1];
-        string value;
-        
-        if (cache->get(key, value)) {
-            cout << "\"" << value << "\"" << endl;
-        } else {
-            cout << "(nil)" << endl;
-        }
-    }
-    
-    void handleDeleteCommand(const vector<string>& tokens) {
-        if (tokens.size() < 2) {
-            cout << "Error: DELETE requires a key" << endl;
-            cout << "Usage: DELETE key" << endl;
-            return;
-        }
-        
-        string key = tokens[1];
-        
-        if (cache->del(key)) {
-            cout << "(integer) 1" << endl;
-        } else {
-            cout << "(integer) 0" << endl;
-        }
-    }
-    
-    void handleExistsCommand(const vector<string>& tokens) {
-        if (tokens.size() < 2) {
-            cout << "Error: EXISTS requires a key" << endl;
-            cout << "Usage: EXISTS key" << endl;
-            return;
-        }
-        
-        string key = tokens[1];
-        
-        if (cache->exists(key)) {
-            cout << "(integer) 1" << endl;
-        } else {
-            cout << "(integer) 0" << endl;
-        }
-    }
-    
-    void handleExpireCommand(const vector<string>& tokens) {
-        if (tokens.size() < 3) {
-            cout << "Error: EXPIRE requires key and seconds" << endl;
-            cout << "Usage: EXPIRE key seconds" << endl;
-            return;
-        }
-        
-        string key = tokens[1];
-        int seconds;
-        
-        try {
-            seconds = stoi(tokens[2]);
-            if (seconds <= 0) {
-                cout << "Error: Seconds must be positive" << endl;
-                return;
-            }
-        } catch (const exception& e) {
-            cout << "Error: Invalid seconds value" << endl;
-            return;
-        }
-        
-        if (cache->expire(key, seconds)) {
-            cout << "(integer) 1" << endl;
-        } else {
-            cout << "(integer) 0" << endl;
-        }
-    }
-    
-    void handleFlushCommand() {
-        cache->flush();
-        cout << "OK" << endl;
-    }
-    
-    void processCommand(const string& input) {
-        if (input.empty()) return;
-        
-        vector<string> tokens = Utils::splitString(input, ' ');
         if (tokens.empty()) return;
         
-        string command = toUpper(tokens[0]);
+        string command = toUpper(string(tokens[0]));
         
-        if (command == "SET") {
-            handleSetCommand(tokens);
-        }
-        else if (command == "GET") {
-            handleGetCommand(tokens);
-        }
-        else if (command == "DELETE" || command == "DEL") {
-            handleDeleteCommand(tokens);
-        }
-        else if (command == "EXISTS") {
-            handleExistsCommand(tokens);
-        }
-        else if (command == "EXPIRE") {
-            handleExpireCommand(tokens);
-        }
-        else if (command == "FLUSH") {
-            handleFlushCommand();
-        }
-        else if (command == "STATS") {
-            cache->showStats();
-        }
-        else if (command == "HELP") {
+        if (command == "HELP") {
             printHelp();
         }
         else if (command == "QUIT" || command == "EXIT") {
@@ -210,18 +176,32 @@ private:
             cout << "Goodbye!" << endl;
         }
         else {
-            cout << "Error: Unknown command '" << command << "'" << endl;
-            cout << "Type HELP for available commands" << endl;
+            processor->execute(tokens, reply);
+            if (aof) {
+                aof->commit();
+                aof->cron(*cache);
+            }
+            if (snapshots) {
+                snapshots->cron();
+            }
         }
     }
     
 public:
-    MiniRedisCLI() {
-        cache = new Cache();
+    MiniRedisCLI(EvictionType evictionType, const PersistenceOptions& options) {
+        cache = new Cache(1024 * 1024 * 100, 10000, evictionType);
+        aof = options.path.empty() ? nullptr : new AppendOnlyFile(options.path, options.fsyncPolicy);
+        snapshots = options.dbFilename.empty() ? nullptr : new SnapshotManager(options.dbFilename, true, options.snapshotSegments);
+        restoreKeyspace(aof, snapshots, options, *cache);
+        processor = new CommandProcessor(*cache, aof, snapshots);
         running = true;
     }
     
     ~MiniRedisCLI() {
+        saveOnShutdown(aof, snapshots, *cache);
+        delete processor;
+        delete snapshots;
+        delete aof;
         delete cache;
     }
     
@@ -231,7 +211,9 @@ public:
         string input;
         while (running) {
             cout << "mini-redis> ";
-            getline(cin, input);
+            if (!getline(cin, input)) {
+                break;
+            }
             
             // Trim whitespace
             input.erase(0, input.find_first_not_of(" \t"));
@@ -244,9 +226,98 @@ public:
     }
 };
 
-int main() {
+static Server* activeServer = nullptr;
+
+static void handleShutdownSignal(int) {
+    if (activeServer) {
+        activeServer->stop();
+    }
+}
+
+static void printUsage() {
+    cout << "Usage: mini-redis [--server] [--port N] [--eviction POLICY] [--appendonly FILE [--appendfsync WHEN]]"
+         << " [--dbfilename FILE [--snapshot-segments N]]" << endl;
+    cout << "  (no options)   Interactive CLI on stdin" << endl;
+    cout << "  --server       Serve RESP clients over TCP (default port 6379)" << endl;
+    cout << "  --port N       Listen on port N (implies --server)" << endl;
+    cout << "  --eviction P   lru (default), clock, sampled-lru, lfu, w-tinylfu or arc" << endl;
+    cout << "  --appendonly F Log writes to F and replay it on startup" << endl;
+    cout << "  --appendfsync W  always, everysec (default) or no" << endl;
+    cout << "  --auto-aof-rewrite-percentage N  Rewrite the AOF once it grows by N% (default 100, 0 = off)" << endl;
+    cout << "  --auto-aof-rewrite-min-size MB   ... and is at least MB megabytes (default 64)" << endl;
+    cout << "  --dbfilename F Snapshot file for SAVE and BGSAVE, loaded on startup without an AOF" << endl;
+    cout << "  --snapshot-segments N  Save snapshots as N files written and read in parallel (default 1)" << endl;
+}
+
+static int runServer(int port, EvictionType evictionType, const PersistenceOptions& options) {
+    Cache cache(1024 * 1024 * 100, 10000, evictionType);
+    AppendOnlyFile aofFile(options.path, options.fsyncPolicy);
+    SnapshotManager snapshotFile(options.dbFilename, true, options.snapshotSegments);
+    AppendOnlyFile* aof = options.path.empty() ? nullptr : &aofFile;
+    SnapshotManager* snapshots = options.dbFilename.empty() ? nullptr : &snapshotFile;
+    restoreKeyspace(aof, snapshots, options, cache);
+    Server server(cache, port, aof, snapshots);
+    server.start();
+    
+    activeServer = &server;
+    signal(SIGINT, handleShutdownSignal);
+    signal(SIGTERM, handleShutdownSignal);
+    
+    Utils::logMessage("Mini-Redis server listening on port " + to_string(server.getPort()));
+    server.run();
+    Utils::logMessage("Server shutting down");
+    saveOnShutdown(aof, snapshots, cache);
+    
+    activeServer = nullptr;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    bool serverMode = false;
+    int port = 6379;
+    EvictionType evictionType = EvictionType::LRU;
+    PersistenceOptions persistence;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--server") == 0) {
+            serverMode = true;
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            serverMode = true;
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--eviction") == 0 && i + 1 < argc) {
+            if (!parseEvictionType(argv[++i], evictionType)) {
+                cerr << "Unknown eviction policy: " << argv[i] << endl;
+                printUsage();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--appendonly") == 0 && i + 1 < argc) {
+            persistence.path = argv[++i];
+        } else if (strcmp(argv[i], "--appendfsync") == 0 && i + 1 < argc) {
+            if (!parseFsyncPolicy(argv[++i], persistence.fsyncPolicy)) {
+                cerr << "Unknown fsync policy: " << argv[i] << endl;
+                printUsage();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--auto-aof-rewrite-percentage") == 0 && i + 1 < argc) {
+            persistence.rewritePercentage = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--auto-aof-rewrite-min-size") == 0 && i + 1 < argc) {
+            persistence.rewriteMinBytes = strtoull(argv[++i], nullptr, 10) * 1024 * 1024;
+        } else if (strcmp(argv[i], "--dbfilename") == 0 && i + 1 < argc) {
+            persistence.dbFilename = argv[++i];
+        } else if (strcmp(argv[i], "--snapshot-segments") == 0 && i + 1 < argc) {
+            persistence.snapshotSegments = max(1, atoi(argv[++i]));
+        } else {
+            printUsage();
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    
     try {
-        MiniRedisCLI cli;
+        if (serverMode) {
+            return runServer(port, evictionType, persistence);
+        }
+        
+        MiniRedisCLI cli(evictionType, persistence);
         cli.run();
     } catch (const exception& e) {
         cerr << "Fatal error: " << e.what() << endl;
@@ -254,4 +325,4 @@ int main() {
     }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -2,6 +2,10 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <charconv>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -11,6 +15,16 @@ long long Utils::getCurrentTimestamp() {
     return timestamp.count();
 }
 
+long long Utils::getCurrentTimeMillis() {
+    auto now = chrono::system_clock::now();
+    return chrono::duration_cast<chrono::milliseconds>(now.time_since_epoch()).count();
+}
+
+long long Utils::monotonicMillis() {
+    auto now = chrono::steady_clock::now();
+    return chrono::duration_cast<chrono::milliseconds>(now.time_since_epoch()).count();
+}
+
 vector<string> Utils::splitString(const string& str, char delimiter) {
     vector<string> tokens;
     stringstream ss(str);
@@ -25,6 +39,40 @@ vector<string> Utils::splitString(const string& str, char delimiter) {
     return tokens;
 }
 
+bool Utils::parseInteger(string_view str, long long& value) {
+    const char* end = str.data() + str.size();
+    from_chars_result result = from_chars(str.data(), end, value);
+    return !str.empty() && result.ec == errc() && result.ptr == end;
+}
+
+// from_chars already refuses signs other than '-' and spaces; what remains
+// is a leading zero on anything but "0" itself
+bool Utils::parseCanonicalInteger(string_view str, long long& value) {
+    if (str.size() > 1 && (str[0] == '0' || (str[0] == '-' && str[1] == '0'))) {
+        return false;
+    }
+    return parseInteger(str, value);
+}
+
+bool Utils::parseDouble(string_view str, double& value) {
+    if (!str.empty() && str[0] == '+') {
+        str.remove_prefix(1);
+        if (!str.empty() && str[0] == '-') return false;
+    }
+    const char* end = str.data() + str.size();
+    from_chars_result result = from_chars(str.data(), end, value);
+    return !str.empty() && result.ec == errc() && result.ptr == end && !isnan(value);
+}
+
+string Utils::formatDouble(double value) {
+    if (isinf(value)) {
+        return value > 0 ? "inf" : "-inf";
+    }
+    char buffer[32];
+    to_chars_result result = to_chars(buffer, buffer + sizeof(buffer), value);
+    return string(buffer, result.ptr);
+}
+
 void Utils::logMessage(const string& message) {
     auto now = chrono::system_clock::now();
     auto time_t = chrono::system_clock::to_time_t(now);
@@ -44,4 +92,14 @@ string Utils::formatMemorySize(size_t bytes) {
     stringstream ss;
     ss << fixed << setprecision(2) << size << " " << units[unit];
     return ss.str();
-}
\ No newline at end of file
+}
+
+void Utils::syncParentDirectory(const string& path) {
+    size_t slash = path.rfind('/');
+    string dir = slash == string::npos ? "." : path.substr(0, slash + 1);
+    int dirFd = open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+}
@@ -0,0 +1,534 @@
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/AppendOnlyFile.hpp"
+#include "../include/CommandProcessor.hpp"
+#include "../include/utils.hpp"
+
+using namespace std;
+
+// Keeps the last reply, rendered like redis-cli
+class LastReplyWriter : public ReplyWriter {
+public:
+    string last;
+
+    using ReplyWriter::bulk;
+
+    void status(const string& message) override { last = message; }
+    void error(const string& message) override { last = "(error) " + message; }
+    void integer(long long value) override { last = "(integer) " + to_string(value); }
+    void bulk(const string& value) override { last = value; }
+    void nil() override { last = "(nil)"; }
+    void arrayHeader(size_t count) override { last = "*" + to_string(count); }
+    void text(const string& value) override { last = value; }
+};
+
+static string run(CommandProcessor& processor, vector<string> argv) {
+    LastReplyWriter reply;
+    processor.execute(argv, reply);
+    return reply.last;
+}
+
+static string tempPath(const string& name) {
+    string path = "/tmp/mini_redis_" + name + "_" + to_string(getpid()) + ".aof";
+    remove(path.c_str());
+    return path;
+}
+
+static size_t fileSize(const string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+void testAOFReplay() {
+    cout << "Testing AOF replay..." << endl;
+
+    string path = tempPath("replay");
+    {
+        Cache cache;
+        CommandProcessor loader(cache);
+        AppendOnlyFile aof(path, FsyncPolicy::ALWAYS);
+        assert(aof.load(loader) == 0);     // no file yet
+        aof.start();
+        CommandProcessor processor(cache, &aof);
+
+        run(processor, {"SET", "gone", "x"});
+        run(processor, {"FLUSHALL"});
+        run(processor, {"SET", "a", "1"});
+        run(processor, {"SET", "b", "2", "EX", "100"});
+        run(processor, {"MSET", "c", "3", "d", "4", "e", "5"});
+        run(processor, {"DEL", "c", "nope"});
+        run(processor, {"DEL", "nope"});     // changed nothing, not logged
+        run(processor, {"PEXPIRE", "d", "1"});
+        run(processor, {"PSETEX", "f", "100000", "value with spaces"});
+        run(processor, {"GET", "a"});        // reads are not logged
+        aof.commit();
+
+        AOFStats stats = aof.getStats();
+        assert(stats.bufferedBytes == 0 && stats.unsyncedBytes == 0);
+        assert(stats.fileBytes == fileSize(path));
+    }
+
+    this_thread::sleep_for(chrono::milliseconds(5));
+
+    Cache cache;
+    CommandProcessor loader(cache);
+    AppendOnlyFile aof(path);
+    // SET, FLUSHALL, SET, SET + PEXPIREAT, MSET, DEL, PEXPIREAT, PSETEX as SET + PEXPIREAT
+    assert(aof.load(loader) == 10);
+
+    assert(run(loader, {"GET", "a"}) == "1");
+    assert(run(loader, {"GET", "gone"}) == "(nil)");
+    assert(run(loader, {"GET", "c"}) == "(nil)");
+    assert(run(loader, {"GET", "d"}) == "(nil)");     // expired while "down"
+    assert(run(loader, {"GET", "e"}) == "5");
+    assert(run(loader, {"GET", "f"}) == "value with spaces");
+
+    // TTLs were logged as absolute times, so they kept running
+    long long ttl = cache.pttl("b");
+    assert(ttl > 99000 && ttl <= 100000);
+    assert(cache.pttl("a") == -1);
+
+    // A time long past deletes the key, however far back it is
+    assert(run(loader, {"PEXPIREAT", "a", "-9223372036854775808"}) == "(integer) 1");
+    assert(run(loader, {"GET", "a"}) == "(nil)");
+
+    remove(path.c_str());
+    cout << "✓ AOF replay test passed" << endl;
+}
+
+void testAOFTruncatedTail() {
+    cout << "Testing AOF truncated tail..." << endl;
+
+    string path = tempPath("truncated");
+    {
+        Cache cache;
+        AppendOnlyFile aof(path, FsyncPolicy::NO);
+        aof.start();
+        CommandProcessor processor(cache, &aof);
+        run(processor, {"SET", "a", "1"});
+        run(processor, {"SET", "b", "2"});
+    }
+    size_t complete = fileSize(path);
+
+    // A crash in the middle of writing a command
+    {
+        ofstream out(path, ios::app | ios::binary);
+        out << "*3\r\n$3\r\nSET\r\n$1\r\nc\r\n$10\r\nhal";
+    }
+    assert(fileSize(path) > complete);
+
+    {
+        Cache cache;
+        CommandProcessor loader(cache);
+        AppendOnlyFile aof(path);
+        assert(aof.load(loader) == 2);
+        assert(fileSize(path) == complete);
+        assert(cache.getKeyCount() == 2);
+
+        // New appends start on a command boundary
+        aof.start();
+        CommandProcessor processor(cache, &aof);
+        run(processor, {"SET", "c", "3"});
+    }
+
+    Cache cache;
+    CommandProcessor loader(cache);
+    AppendOnlyFile aof(path);
+    assert(aof.load(loader) == 3);
+    assert(run(loader, {"GET", "c"}) == "3");
+
+    // Garbage in the middle is not silently skipped
+    {
+        ofstream out(path, ios::app | ios::binary);
+        out << "*1\r\n#bad\r\n*1\r\n$4\r\nPING\r\n";
+    }
+    bool threw = false;
+    try {
+        AppendOnlyFile corrupt(path);
+        corrupt.load(loader);
+    } catch (const runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    remove(path.c_str());
+    cout << "✓ AOF truncated tail test passed" << endl;
+}
+
+void testAOFGroupCommit() {
+    cout << "Testing AOF group commit..." << endl;
+
+    for (FsyncPolicy policy : {FsyncPolicy::ALWAYS, FsyncPolicy::EVERYSEC, FsyncPolicy::NO}) {
+        string path = tempPath(fsyncPolicyName(policy));
+        Cache cache;
+        AppendOnlyFile aof(path, policy);
+        aof.start();
+        CommandProcessor processor(cache, &aof);
+
+        // A thousand writes in one tick cost one commit
+        for (int i = 0; i < 1000; i++) {
+            run(processor, {"SET", "key" + to_string(i), "value"});
+        }
+        aof.commit();
+
+        AOFStats stats = aof.getStats();
+        if (policy == FsyncPolicy::ALWAYS) {
+            assert(stats.bufferedBytes == 0 && stats.unsyncedBytes == 0);
+            assert(stats.fsyncs >= 1 && stats.fsyncs <= 5);
+            assert(stats.fileBytes == fileSize(path));
+        }
+        if (policy == FsyncPolicy::NO) {
+            this_thread::sleep_for(chrono::milliseconds(50));
+            assert(aof.getStats().fsyncs == 0);
+        }
+        assert(stats.writeErrors == 0);
+        remove(path.c_str());
+    }
+
+    cout << "✓ AOF group commit test passed" << endl;
+}
+
+// Runs the cron until the rewrite has been swapped in
+static void waitForRewrite(AppendOnlyFile& aof, const Cache& cache) {
+    for (int i = 0; i < 5000 && aof.isRewriting(); i++) {
+        aof.cron(cache);
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    assert(!aof.isRewriting());
+}
+
+void testAOFRewrite() {
+    cout << "Testing AOF rewrite..." << endl;
+
+    string path = tempPath("rewrite");
+    size_t keys;
+    {
+        Cache cache;
+        AppendOnlyFile aof(path, FsyncPolicy::ALWAYS);
+        aof.setAutoRewrite(0, 0);
+        aof.start();
+        CommandProcessor processor(cache, &aof);
+
+        for (int i = 0; i < 1000; i++) {
+            run(processor, {"SET", "counter", to_string(i)});
+        }
+        for (int i = 0; i < 100; i++) {
+            run(processor, {"SET", "k" + to_string(i), "v", "EX", "1000"});
+        }
+        run(processor, {"DEL", "k99"});
+        aof.commit();
+        size_t before = aof.getStats().fileBytes;
+
+        assert(run(processor, {"BGREWRITEAOF"}) == "Background append only file rewriting started");
+        assert(run(processor, {"BGREWRITEAOF"}).find("already in progress") != string::npos);
+
+        // Writes made while the child runs must survive the swap
+        run(processor, {"SET", "during", "x"});
+        run(processor, {"DEL", "k0"});
+        aof.commit();
+        waitForRewrite(aof, cache);
+
+        AOFStats stats = aof.getStats();
+        assert(stats.rewrites == 1 && stats.writeErrors == 0);
+        assert(stats.fileBytes < before / 4);
+        assert(stats.fileBytes == fileSize(path));
+
+        // and so must writes made after it
+        run(processor, {"SET", "after", "y"});
+        aof.commit();
+        keys = cache.getKeyCount();
+    }
+    assert(fileSize(path + ".rewrite") == 0);
+
+    Cache cache;
+    CommandProcessor loader(cache);
+    AppendOnlyFile aof(path);
+    aof.load(loader);
+    assert(cache.getKeyCount() == keys);
+    assert(run(loader, {"GET", "counter"}) == "999");
+    assert(run(loader, {"GET", "during"}) == "x");
+    assert(run(loader, {"GET", "after"}) == "y");
+    assert(run(loader, {"GET", "k0"}) == "(nil)");
+    assert(run(loader, {"GET", "k99"}) == "(nil)");
+    long long ttl = cache.pttl("k50");
+    assert(ttl > 990000 && ttl <= 1000000);
+
+    remove(path.c_str());
+    cout << "✓ AOF rewrite test passed" << endl;
+}
+
+void testAOFHashes() {
+    cout << "Testing AOF with hashes..." << endl;
+
+    string path = tempPath("hashes");
+    {
+        Cache cache;
+        AppendOnlyFile aof(path, FsyncPolicy::ALWAYS);
+        aof.setAutoRewrite(0, 0);
+        aof.start();
+        CommandProcessor processor(cache, &aof);
+
+        run(processor, {"HSET", "user", "name", "ada", "visits", "1"});
+        run(processor, {"HINCRBY", "user", "visits", "41"});
+        run(processor, {"HSET", "user", "tmp", "x"});
+        run(processor, {"HDEL", "user", "tmp", "nope"});
+        run(processor, {"HDEL", "user", "nope"});   // changed nothing, not logged
+        run(processor, {"HSET", "gone", "f", "v"});
+        run(processor, {"HDEL", "gone", "f"});
+        aof.commit();
+
+        Cache replayed;
+        CommandProcessor loader(replayed);
+        AppendOnlyFile copy(path);
+        assert(copy.load(loader) == 6);
+        assert(run(loader, {"HGET", "user", "visits"}) == "42");
+        assert(run(loader, {"HLEN", "user"}) == "(integer) 2");
+        assert(!replayed.exists("gone"));
+
+        // The rewrite splits a large hash over several HSETs
+        for (int i = 0; i < 300; i++) {
+            run(processor, {"HSET", "big", "field" + to_string(i), "value" + to_string(i)});
+        }
+        run(processor, {"PEXPIRE", "big", "1000000"});
+        aof.commit();
+        assert(run(processor, {"BGREWRITEAOF"}) == "Background append only file rewriting started");
+        waitForRewrite(aof, cache);
+        assert(aof.getStats().rewrites == 1);
+    }
+
+    Cache cache;
+    CommandProcessor loader(cache);
+    AppendOnlyFile aof(path);
+    // user and the five HSETs of big, plus its PEXPIREAT
+    assert(aof.load(loader) == 7);
+    assert(run(loader, {"HGET", "user", "name"}) == "ada");
+    assert(run(loader, {"HGET", "user", "visits"}) == "42");
+    assert(run(loader, {"HLEN", "big"}) == "(integer) 300");
+    assert(run(loader, {"HGET", "big", "field299"}) == "value299");
+    assert(run(loader, {"OBJECT", "ENCODING", "big"}) == "hashtable");
+    assert(cache.pttl("big") > 990000);
+
+    remove(path.c_str());
+    cout << "✓ AOF hashes test passed" << endl;
+}
+
+void testAOFZSets() {
+    cout << "Testing AOF with sorted sets..." << endl;
+
+    string path = tempPath("zsets");
+    {
+        Cache cache;
+        AppendOnlyFile aof(path, FsyncPolicy::ALWAYS);
+        aof.setAutoRewrite(0, 0);
+        aof.start();
+        CommandProcessor processor(cache, &aof);
+
+        run(processor, {"ZADD", "board", "1", "a", "2", "b"});
+        run(processor, {"ZADD", "board", "1", "a"});            // changed nothing, not logged
+        run(processor, {"ZINCRBY", "board", "0.1", "a"});       // logged as ZADD of the result
+        run(processor, {"ZADD", "board", "XX", "INCR", "1", "nope"});
+        run(processor, {"ZREM", "board", "b", "nope"});
+        run(processor, {"ZREM", "board", "nope"});
+        aof.commit();
+
+        Cache replayed;
+        CommandProcessor loader(replayed);
+        AppendOnlyFile copy(path);
+        assert(copy.load(loader) == 3);
+        assert(run(loader, {"ZSCORE", "board", "a"}) == "1.1");
+        assert(run(loader, {"ZCARD", "board"}) == "(integer) 1");
+
+        // The rewrite splits a large set over several ZADDs, scores exact
+        for (int i = 0; i < 300; i++) {
+            run(processor, {"ZADD", "big", Utils::formatDouble(i / 3.0), "member" + to_string(i)});
+        }
+        run(processor, {"PEXPIRE", "big", "1000000"});
+        aof.commit();
+        assert(run(processor, {"BGREWRITEAOF"}) == "Background append only file rewriting started");
+        waitForRewrite(aof, cache);
+        assert(aof.getStats().rewrites == 1);
+    }
+
+    Cache cache;
+    CommandProcessor loader(cache);
+    AppendOnlyFile aof(path);
+    // board and the five ZADDs of big, plus its PEXPIREAT
+    assert(aof.load(loader) == 7);
+    assert(run(loader, {"ZSCORE", "board", "a"}) == "1.1");
+    assert(run(loader, {"ZCARD", "big"}) == "(integer) 300");
+    assert(run(loader, {"ZSCORE", "big", "member1"}) == Utils::formatDouble(1 / 3.0));
+    assert(run(loader, {"ZRANK", "big", "member299"}) == "(integer) 299");
+    assert(run(loader, {"OBJECT", "ENCODING", "big"}) == "skiplist");
+    assert(cache.pttl("big") > 990000);
+
+    remove(path.c_str());
+    cout << "✓ AOF sorted sets test passed" << endl;
+}
+
+void testAOFListsAndSets() {
+    cout << "Testing AOF with lists and sets..." << endl;
+
+    string path = tempPath("collections");
+    {
+        Cache cache;
+        AppendOnlyFile aof(path, FsyncPolicy::ALWAYS);
+        aof.setAutoRewrite(0, 0);
+        aof.start();
+        CommandProcessor processor(cache, &aof);
+
+        run(processor, {"RPUSH", "queue", "a", "b", "c"});
+        run(processor, {"LPUSH", "queue", "z"});
+        run(processor, {"LPOP", "queue"});
+        run(processor, {"RPOP", "nope"});                      // popped nothing, not logged
+        run(processor, {"SADD", "tags", "1", "2", "red"});
+        run(processor, {"SADD", "tags", "1"});                 // added nothing, not logged
+        run(processor, {"SREM", "tags", "2", "nope"});
+        aof.commit();
+
+        Cache replayed;
+        CommandProcessor loader(replayed);
+        AppendOnlyFile copy(path);
+        assert(copy.load(loader) == 5);
+        assert(run(loader, {"LRANGE", "queue", "0", "0"}) == "a");
+        assert(run(loader, {"LLEN", "queue"}) == "(integer) 3");
+        assert(run(loader, {"SCARD", "tags"}) == "(integer) 2");
+        assert(run(loader, {"SISMEMBER", "tags", "red"}) == "(integer) 1");
+
+        // The rewrite splits large values over several RPUSHes and SADDs
+        for (int i = 0; i < 300; i++) {
+            run(processor, {"RPUSH", "long", "item" + to_string(i)});
+            run(processor, {"SADD", "ids", to_string(i)});
+        }
+        aof.commit();
+        assert(run(processor, {"BGREWRITEAOF"}) == "Background append only file rewriting started");
+        waitForRewrite(aof, cache);
+        assert(aof.getStats().rewrites == 1);
+    }
+
+    Cache cache;
+    CommandProcessor loader(cache);
+    AppendOnlyFile aof(path);
+    // queue and tags, then five RPUSHes of long and five SADDs of ids
+    assert(aof.load(loader) == 12);
+    assert(run(loader, {"LRANGE", "queue", "-1", "-1"}) == "c");
+    assert(run(loader, {"SISMEMBER", "tags", "1"}) == "(integer) 1");
+    assert(run(loader, {"LLEN", "long"}) == "(integer) 300");
+    assert(run(loader, {"LRANGE", "long", "299", "299"}) == "item299");
+    assert(run(loader, {"SCARD", "ids"}) == "(integer) 300");
+    assert(run(loader, {"OBJECT", "ENCODING", "ids"}) == "intset");
+
+    remove(path.c_str());
+    cout << "✓ AOF lists and sets test passed" << endl;
+}
+
+void testAOFCounters() {
+    cout << "Testing AOF with counters..." << endl;
+
+    string path = tempPath("counters");
+    {
+        Cache cache;
+        AppendOnlyFile aof(path, FsyncPolicy::ALWAYS);
+        aof.setAutoRewrite(0, 0);
+        aof.start();
+        CommandProcessor processor(cache, &aof);
+
+        run(processor, {"INCR", "hits"});
+        run(processor, {"INCRBY", "hits", "41"});
+        run(processor, {"DECR", "hits"});
+        run(processor, {"SET", "name", "ada"});
+        run(processor, {"INCR", "name"});                       // failed, not logged
+        run(processor, {"PSETEX", "temp", "100000", "1.5"});
+        run(processor, {"INCRBYFLOAT", "temp", "0.25"});        // logged as SET and PEXPIREAT
+        aof.commit();
+
+        Cache replayed;
+        CommandProcessor loader(replayed);
+        AppendOnlyFile copy(path);
+        assert(copy.load(loader) == 8);
+        assert(run(loader, {"GET", "hits"}) == "41");
+        assert(run(loader, {"OBJECT", "ENCODING", "hits"}) == "int");
+        assert(run(loader, {"GET", "temp"}) == "1.75");
+        assert(replayed.pttl("temp") > 99000);
+
+        // The rewrite formats inline integers back into SETs
+        assert(run(processor, {"BGREWRITEAOF"}) == "Background append only file rewriting started");
+        waitForRewrite(aof, cache);
+        assert(aof.getStats().rewrites == 1);
+    }
+
+    Cache cache;
+    CommandProcessor loader(cache);
+    AppendOnlyFile aof(path);
+    // Three SETs and the PEXPIREAT of temp
+    assert(aof.load(loader) == 4);
+    assert(run(loader, {"INCR", "hits"}) == "(integer) 42");
+    assert(run(loader, {"GET", "name"}) == "ada");
+    assert(run(loader, {"GET", "temp"}) == "1.75");
+
+    remove(path.c_str());
+    cout << "✓ AOF counters test passed" << endl;
+}
+
+void testAOFAutoRewrite() {
+    cout << "Testing automatic AOF rewrite..." << endl;
+
+    string path = tempPath("auto");
+    Cache cache;
+    AppendOnlyFile aof(path, FsyncPolicy::NO);
+    aof.setAutoRewrite(100, 16 * 1024);
+    aof.start();
+    CommandProcessor processor(cache, &aof);
+
+    // Too small to bother
+    run(processor, {"SET", "key", "value"});
+    aof.commit();
+    this_thread::sleep_for(chrono::milliseconds(20));
+    aof.cron(cache);
+    assert(!aof.isRewriting());
+
+    // One key overwritten until the log passes the minimum size
+    for (int i = 0; i < 2000; i++) {
+        run(processor, {"SET", "key", "value" + to_string(i)});
+    }
+    aof.commit();
+    for (int i = 0; i < 5000 && aof.getStats().rewrites == 0; i++) {
+        aof.cron(cache);
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    AOFStats stats = aof.getStats();
+    assert(stats.rewrites == 1);
+    assert(stats.fileBytes < 100 && stats.rewriteBaseBytes == stats.fileBytes);
+
+    remove(path.c_str());
+    cout << "✓ Automatic AOF rewrite test passed" << endl;
+}
+
+int main() {
+    cout << "=== APPEND-ONLY FILE TESTS ===" << endl << endl;
+
+    try {
+        testAOFReplay();
+        testAOFTruncatedTail();
+        testAOFGroupCommit();
+        testAOFRewrite();
+        testAOFHashes();
+        testAOFZSets();
+        testAOFListsAndSets();
+        testAOFCounters();
+        testAOFAutoRewrite();
+
+        cout << endl << "🎉 All append-only file tests passed!" << endl;
+    } catch (const exception& e) {
+        cerr << "❌ Append-only file test failed: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
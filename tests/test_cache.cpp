@@ -2,7 +2,12 @@
 #include <cassert>
 #include <thread>
 #include <chrono>
+#include <vector>
+#include <climits>
+#include <cmath>
+#include <functional>
 #include "../include/Cache.hpp"
+#include "../include/ShardedCache.hpp"
 
 using namespace std;
 
@@ -79,6 +84,149 @@ void testExpireCommand() {
     cout << "✓ EXPIRE command test passed" << endl;
 }
 
+void testActiveExpiry() {
+    cout << "Testing active expiry..." << endl;
+    
+    Cache cache;
+    
+    for (int i = 0; i < 100; i++) {
+        assert(cache.set("volatile_" + to_string(i), "value", 1));
+    }
+    assert(cache.set("persistent", "value"));
+    assert(cache.getKeyCount() == 101);
+    
+    // Wait for expiration
+    this_thread::sleep_for(chrono::milliseconds(2100));
+    
+    // Expired keys are reclaimed by later commands without being accessed,
+    // each command doing only a bounded amount of work
+    for (int i = 0; i < 10; i++) {
+        assert(cache.exists("persistent"));
+    }
+    assert(cache.getKeyCount() == 1);
+    assert(cache.getExpiredKeyCount() == 100);
+    
+    cout << "✓ Active expiry test passed" << endl;
+}
+
+void testMillisecondTTL() {
+    cout << "Testing millisecond TTLs..." << endl;
+    
+    Cache cache;
+    string value;
+    
+    assert(cache.pttl("missing") == -2 && cache.ttl("missing") == -2);
+    assert(cache.set("plain", "value"));
+    assert(cache.pttl("plain") == -1 && cache.ttl("plain") == -1);
+    
+    assert(cache.psetex("short", "value", 50));
+    long long left = cache.pttl("short");
+    assert(left > 0 && left <= 50);
+    assert(cache.ttl("short") == 0);
+    
+    assert(cache.pexpire("plain", 1500));
+    assert(cache.ttl("plain") == 2 || cache.ttl("plain") == 1);
+    assert(!cache.pexpire("missing", 100));
+    
+    this_thread::sleep_for(chrono::milliseconds(80));
+    assert(!cache.get("short", value));
+    assert(cache.pttl("short") == -2);
+    assert(cache.get("plain", value));
+    
+    cout << "✓ Millisecond TTL test passed" << endl;
+}
+
+void testPinnedClock() {
+    cout << "Testing pinned clock..." << endl;
+    
+    Cache cache;
+    string value;
+    const long long START = 1000000;
+    
+    // With the clock pinned, time only moves when the caller says so
+    cache.setClock(START);
+    assert(cache.psetex("a", "1", 10));
+    assert(cache.psetex("b", "2", 500));
+    this_thread::sleep_for(chrono::milliseconds(20));
+    assert(cache.get("a", value));
+    assert(cache.pttl("a") == 10);
+    
+    cache.setClock(START + 11);
+    assert(!cache.exists("a"));
+    assert(cache.pttl("b") == 489);
+    
+    // The wheel reclaims b without it being touched
+    cache.setClock(START + 501);
+    cache.activeExpireCycle();
+    assert(cache.getKeyCount() == 0);
+    assert(cache.getExpiredKeyCount() == 2);
+    
+    cout << "✓ Pinned clock test passed" << endl;
+}
+
+void testBatchOperations() {
+    cout << "Testing batch operations..." << endl;
+    
+    Cache cache;
+    vector<string> pairs;
+    for (int i = 0; i < 100; i++) {
+        pairs.push_back("batch" + to_string(i));
+        pairs.push_back("value" + to_string(i));
+    }
+    cache.mset(pairs.data(), 100);
+    assert(cache.getKeyCount() == 100);
+    
+    vector<string> keys = {"batch0", "missing", "batch99", "batch0"};
+    vector<ValueRef> values;
+    cache.mget(keys.data(), keys.size(), values);
+    assert(values.size() == 4);
+    assert(values[0] && values[0].str() == "value0");
+    assert(!values[1]);
+    assert(values[2] && values[2].str() == "value99");
+    assert(values[3] && values[3].str() == "value0");
+    
+    // Duplicates and missing keys only count once
+    vector<string> toDelete = {"batch1", "batch2", "batch1", "missing"};
+    assert(cache.mdel(toDelete.data(), toDelete.size()) == 2);
+    assert(cache.getKeyCount() == 98);
+    assert(!cache.exists("batch1"));
+    
+    cout << "✓ Batch operations test passed" << endl;
+}
+
+void testPinnedValues() {
+    cout << "Testing pinned values..." << endl;
+    
+    Cache cache(1024 * 1024, 2);
+    string payload(64 * 1024, 'p');
+    const char* bytes = payload.data();
+    
+    // An rvalue is moved into the cache, buffer and all
+    assert(cache.set("big", move(payload)));
+    ValueRef pinned;
+    assert(cache.get("big", pinned));
+    assert(pinned.data() == bytes);
+    
+    // A reader's reference outlives overwrite, delete and eviction
+    ValueRef again;
+    assert(cache.get("big", again) && again == pinned);
+    assert(cache.set("big", "replaced"));
+    assert(pinned.size() == 64 * 1024 && pinned.data()[0] == 'p');
+    assert(cache.get("big", again) && again.str() == "replaced");
+    
+    assert(cache.set("other", string(1000, 'o')));
+    assert(cache.get("other", pinned));
+    assert(cache.del("other"));
+    assert(pinned.size() == 1000);
+    
+    assert(cache.set("a", "1"));
+    assert(cache.set("b", "2"));
+    assert(!cache.exists("big"));
+    assert(again.str() == "replaced");
+    
+    cout << "✓ Pinned values test passed" << endl;
+}
+
 void testFlushOperation() {
     cout << "Testing FLUSH operation..." << endl;
     
@@ -124,6 +272,380 @@ void testMemoryEviction() {
     cout << "✓ Memory eviction test passed" << endl;
 }
 
+void testCompoundEviction() {
+    cout << "Testing compound value eviction..." << endl;
+
+    // Each type grows one element per write; the key written last must
+    // survive intact while older keys are evicted to stay under the limit
+    struct CompoundType {
+        const char* name;
+        function<void(Cache&, const string&, const string&)> add;
+        function<size_t(Cache&, const string&)> size;
+    };
+    const CompoundType types[] = {
+        {"hash",
+         [](Cache& cache, const string& key, const string& element) {
+             string_view pair[] = {element, string_view("a value of some length")};
+             size_t added;
+             cache.hset(key, pair, 1, added);
+         },
+         [](Cache& cache, const string& key) {
+             Cache::Result result;
+             const HashValue* hash = cache.readHash(key, result);
+             return hash ? hash->size() : 0;
+         }},
+        {"zset",
+         [](Cache& cache, const string& key, const string& element) {
+             string_view member = element;
+             double score = static_cast<double>(element.size());
+             size_t added, updated;
+             double result;
+             cache.zadd(key, &score, &member, 1, 0, added, updated, result);
+         },
+         [](Cache& cache, const string& key) {
+             Cache::Result result;
+             const ZSetValue* zset = cache.readZSet(key, result);
+             return zset ? zset->size() : 0;
+         }},
+        {"list",
+         [](Cache& cache, const string& key, const string& element) {
+             string_view value = element;
+             size_t length;
+             cache.push(key, &value, 1, false, length);
+         },
+         [](Cache& cache, const string& key) {
+             Cache::Result result;
+             const ListValue* list = cache.readList(key, result);
+             return list ? list->size() : 0;
+         }},
+        {"set",
+         [](Cache& cache, const string& key, const string& element) {
+             string_view member = element;
+             size_t added;
+             cache.sadd(key, &member, 1, added);
+         },
+         [](Cache& cache, const string& key) {
+             Cache::Result result;
+             const SetValue* s = cache.readSet(key, result);
+             return s ? s->size() : 0;
+         }},
+    };
+
+    for (const auto& type : types) {
+        Cache cache(512 * 1024, SIZE_MAX);
+        for (int k = 0; k < 200; k++) {
+            string key = string(type.name) + ":" + to_string(k);
+            for (int i = 0; i < 100; i++) {
+                type.add(cache, key, "element:" + to_string(i) + " of some length");
+            }
+        }
+        CacheStats stats = cache.getStats();
+        assert(stats.evictedKeys > 0);
+        assert(stats.memoryBytes <= 512 * 1024);
+        assert(stats.pinnedBytes == 0);
+        assert(type.size(cache, string(type.name) + ":199") == 100);
+    }
+
+    cout << "✓ Compound value eviction test passed" << endl;
+}
+
+void testMemoryAccounting() {
+    cout << "Testing memory accounting..." << endl;
+    
+    Cache cache;
+    // An empty cache still holds its index
+    size_t empty = cache.getMemoryUsage();
+    assert(empty == cache.getStats().indexBytes);
+    
+    assert(cache.set("key1", "short"));
+    size_t small = cache.getMemoryUsage();
+    assert(small > empty);
+    
+    // Overwriting with a larger value grows the footprint in place
+    assert(cache.set("key1", string(1000, 'x')));
+    assert(cache.getMemoryUsage() >= small + 1000 - 5);
+    
+    // Re-expiring a key repositions its TTL entry instead of adding another
+    assert(cache.expire("key1", 100));
+    size_t withTTL = cache.getMemoryUsage();
+    assert(cache.expire("key1", 200));
+    assert(cache.expire("key1", 50));
+    assert(cache.getMemoryUsage() == withTTL);
+    
+    assert(cache.del("key1"));
+    CacheStats stats = cache.getStats();
+    assert(stats.keyBytes == 0 && stats.valueBytes == 0 && stats.slabUsedBytes == 0);
+    assert(cache.getMemoryUsage() == stats.indexBytes + stats.ttlBytes);
+    
+    cout << "✓ Memory accounting test passed" << endl;
+}
+
+void testIntegerValues() {
+    cout << "Testing integer values..." << endl;
+    
+    // Canonical integers live in the handle itself, anything else in a block
+    ValueRef small = ValueRef::copyOf("12345");
+    assert(small.isInteger() && small.integer() == 12345);
+    assert(small.memoryUsage() == 0 && string(small.encoding()) == "int");
+    assert(small.str() == "12345" && small.size() == 5);
+    ValueRef negative = ValueRef::copyOf("-4611686018427387904");     // the smallest inline
+    assert(negative.isInteger() && negative.str() == "-4611686018427387904");
+    for (const char* text : {"007", "-0", "+1", " 1", "1.0", "", "9223372036854775807", "4611686018427387904"}) {
+        ValueRef ref = ValueRef::copyOf(text);
+        assert(!ref.isInteger() && ref.str() == text);
+    }
+    ValueRef wide = ValueRef::fromInteger(LLONG_MIN);
+    assert(!wide.isInteger() && wide.str() == to_string(LLONG_MIN));
+    ValueRef copy = small;
+    small.reset();
+    assert(copy.integer() == 12345 && copy.type() == ValueType::STRING && !copy.compound());
+    
+    Cache cache;
+    long long value;
+    assert(cache.incrby("hits", 1, value) == Cache::OK && value == 1);
+    assert(cache.incrby("hits", 41, value) == Cache::OK && value == 42);
+    assert(cache.incrby("hits", -50, value) == Cache::OK && value == -8);
+    string text;
+    assert(cache.get("hits", text) && text == "-8");
+    assert(string(cache.encoding("hits")) == "int");
+    
+    // A string SET as digits is stored inline too, and counts from there
+    cache.set("views", "100");
+    assert(string(cache.encoding("views")) == "int");
+    assert(cache.incrby("views", 1, value) == Cache::OK && value == 101);
+    
+    // Errors leave the value as it was
+    cache.set("name", "ada");
+    cache.set("padded", "007");
+    assert(cache.incrby("name", 1, value) == Cache::NOT_INTEGER);
+    assert(cache.incrby("padded", 1, value) == Cache::NOT_INTEGER);
+    cache.set("max", to_string(LLONG_MAX));
+    assert(cache.incrby("max", 1, value) == Cache::OUT_OF_RANGE);
+    assert(cache.get("max", text) && text == to_string(LLONG_MAX));
+    assert(cache.incrby("max", -1, value) == Cache::OK && value == LLONG_MAX - 1);
+    size_t added;
+    string_view pair[] = {"f", "v"};
+    cache.hset("hash", pair, 1, added);
+    assert(cache.incrby("hash", 1, value) == Cache::WRONG_TYPE);
+    
+    // A counter keeps its TTL
+    cache.psetex("limited", "5", 100000);
+    assert(cache.incrby("limited", 1, value) == Cache::OK && value == 6);
+    assert(cache.pttl("limited") > 99000);
+    
+    // Floats are stored as their shortest text, whole sums inline
+    double sum;
+    assert(cache.incrbyfloat("temp", 10.5, sum) == Cache::OK && sum == 10.5);
+    assert(cache.incrbyfloat("temp", 0.1, sum) == Cache::OK);
+    assert(cache.get("temp", text) && text == "10.6");
+    assert(cache.incrbyfloat("temp", -0.6, sum) == Cache::OK && sum == 10);
+    assert(string(cache.encoding("temp")) == "int");
+    assert(cache.incrbyfloat("hits", 0.5, sum) == Cache::OK && sum == -7.5);
+    assert(cache.incrbyfloat("name", 1, sum) == Cache::NOT_A_NUMBER);
+    assert(cache.incrbyfloat("temp", INFINITY, sum) == Cache::OUT_OF_RANGE);
+    assert(cache.incrbyfloat("hash", 1, sum) == Cache::WRONG_TYPE);
+    long long ttlMs;
+    assert(cache.incrbyfloat("temp", 1, sum, ttlMs) == Cache::OK && ttlMs == -1);
+    assert(cache.incrbyfloat("limited", 0.5, sum, ttlMs) == Cache::OK && sum == 6.5);
+    assert(ttlMs > 99000 && ttlMs <= 100000);
+    
+    // Inline values cost only their entry
+    assert(cache.del("hits") && cache.del("views") && cache.del("name") && cache.del("padded"));
+    assert(cache.del("max") && cache.del("hash") && cache.del("limited") && cache.del("temp"));
+    CacheStats stats = cache.getStats();
+    assert(stats.keyBytes == 0 && stats.valueBytes == 0 && stats.slabUsedBytes == 0);
+    for (int i = 0; i < 1000; i++) {
+        cache.incrby("counter:" + to_string(i), i, value);
+    }
+    assert(cache.getStats().valueBytes == 0);
+    
+    cout << "✓ Integer values test passed" << endl;
+}
+
+void testMemoryBreakdown() {
+    cout << "Testing memory breakdown..." << endl;
+    
+    Cache cache;
+    for (int i = 0; i < 1000; i++) {
+        cache.set("key" + to_string(i), "value" + to_string(i), i % 2 ? 100 : -1);
+    }
+    string large(100000, 'x');
+    assert(cache.set("large", move(large)));
+    
+    // The parts account for every byte, and the adopted buffer is counted
+    // at the size malloc really gave it
+    CacheStats stats = cache.getStats();
+    assert(stats.keyBytes + stats.valueBytes + stats.indexBytes + stats.evictionBytes
+           + stats.ttlBytes + stats.pinnedBytes == stats.memoryBytes);
+    assert(stats.evictionBytes == 1001 * 2 * sizeof(HashNode*));
+    assert(stats.ttlBytes >= 500 * sizeof(HashNode*));
+    assert(stats.valueBytes >= 100000 + 1000 * 32);
+    assert(stats.pinnedBytes == 0);
+    assert(stats.fragmentationBytes > 0 && stats.fragmentationBytes < stats.slabPageBytes);
+    
+    // A value held by a reader stays counted after its key is gone
+    ValueRef pinned;
+    assert(cache.get("large", pinned));
+    size_t before = cache.getMemoryUsage();
+    assert(cache.del("large"));
+    stats = cache.getStats();
+    assert(stats.pinnedBytes >= 100000);
+    assert(stats.memoryBytes < before);
+    pinned.reset();
+    assert(cache.getStats().pinnedBytes == 0);
+    
+    // Eviction enforces the same total the breakdown reports
+    Cache small(64 * 1024, 100000);
+    for (int i = 0; i < 10000; i++) {
+        small.set("key" + to_string(i), string(100, 'v'));
+    }
+    assert(small.getEvictedKeyCount() > 0);
+    assert(small.getMemoryUsage() <= 64 * 1024);
+    
+    cout << "✓ Memory breakdown test passed" << endl;
+}
+
+void testEvictionPolicies() {
+    cout << "Testing eviction policies..." << endl;
+    
+    for (EvictionType type : allEvictionTypes()) {
+        Cache cache(1024 * 1024 * 100, 100, type);
+        string hot;
+        for (int i = 0; i < 1000; i++) {
+            cache.set("key" + to_string(i), "value");
+            // A key read between every write is never the victim
+            assert(cache.get("key0", hot));
+            assert(cache.getKeyCount() <= 100);
+        }
+        assert(cache.getEvictedKeyCount() == 900);
+        assert(cache.exists("key999"));
+        
+        CacheStats stats = cache.getStats();
+        assert(stats.trackedKeys == 100);
+        
+        assert(cache.del("key0"));
+        cache.flush();
+        assert(cache.getStats().trackedKeys == 0);
+    }
+    
+    EvictionType type;
+    assert(parseEvictionType("CLOCK", type) && type == EvictionType::CLOCK);
+    assert(parseEvictionType("sampled-lru", type) && type == EvictionType::SAMPLED_LRU);
+    assert(parseEvictionType("W-TinyLFU", type) && type == EvictionType::TINY_LFU);
+    assert(parseEvictionType("arc", type) && type == EvictionType::ARC);
+    assert(!parseEvictionType("mru", type));
+    
+    cout << "✓ Eviction policies test passed" << endl;
+}
+
+void testScanResistance() {
+    cout << "Testing scan resistance..." << endl;
+    
+    // A hot set read repeatedly, then a one-off scan five times the cache size
+    for (EvictionType type : {EvictionType::TINY_LFU, EvictionType::ARC}) {
+        Cache cache(1024 * 1024 * 100, 1000, type);
+        string value;
+        for (int round = 0; round < 20; round++) {
+            for (int i = 0; i < 500; i++) {
+                string key = "hot" + to_string(i);
+                if (!cache.get(key, value)) cache.set(key, "v");
+            }
+        }
+        for (int i = 0; i < 5000; i++) {
+            cache.set("scan" + to_string(i), "v");
+        }
+        
+        int survivors = 0;
+        for (int i = 0; i < 500; i++) {
+            survivors += cache.exists("hot" + to_string(i));
+        }
+        assert(survivors >= 450);
+    }
+    
+    cout << "✓ Scan resistance test passed" << endl;
+}
+
+void testStatsCounters() {
+    cout << "Testing stats counters..." << endl;
+    
+    Cache cache(1024 * 1024 * 100, 100000);
+    string value;
+    for (int i = 0; i < 1000; i++) {
+        cache.set("key" + to_string(i), "value");
+    }
+    assert(cache.get("key1", value));
+    assert(!cache.get("missing", value));
+    vector<ValueRef> values;
+    string keys[] = {"key2", "nope", "key3"};
+    cache.mget(keys, 3, values);
+    
+    // A key of another type is found, whichever read looks it up
+    string_view pair[] = {"field", "value"};
+    size_t added;
+    cache.hset("hash", pair, 1, added);
+    ValueRef ref;
+    assert(!cache.get("hash", value));
+    assert(cache.getString("hash", ref) == Cache::WRONG_TYPE);
+    
+    CacheStats stats = cache.getStats();
+    assert(stats.keyspaceHits == 5);
+    assert(stats.keyspaceMisses == 2);
+    
+    // 1000 keys grew the index from 16 slots several times
+    assert(stats.resizes >= 6);
+    assert(stats.maxResizeMicros >= stats.lastResizeMicros);
+    assert(stats.totalResizeMicros >= stats.maxResizeMicros);
+    
+    // Reset zeroes the counters, not the data
+    cache.resetStats();
+    stats = cache.getStats();
+    assert(stats.keyspaceHits == 0 && stats.keyspaceMisses == 0);
+    assert(stats.resizes == 0 && stats.totalOperations == 0);
+    assert(stats.keys == 1001);
+    
+    cout << "✓ Stats counters test passed" << endl;
+}
+
+void testShardedCache() {
+    cout << "Testing sharded cache..." << endl;
+    
+    ShardedCache cache(8, 1024 * 1024 * 100, 100000);
+    const int NUM_THREADS = 8;
+    const int KEYS_PER_THREAD = 2000;
+    
+    // Each thread writes and reads back its own keys concurrently
+    vector<thread> threads;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        threads.emplace_back([&cache, t]() {
+            string value;
+            for (int i = 0; i < KEYS_PER_THREAD; i++) {
+                string key = "t" + to_string(t) + ":" + to_string(i);
+                cache.set(key, key);
+                assert(cache.get(key, value) && value == key);
+            }
+            for (int i = 0; i < KEYS_PER_THREAD; i += 2) {
+                assert(cache.del("t" + to_string(t) + ":" + to_string(i)));
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    
+    assert(cache.getKeyCount() == NUM_THREADS * KEYS_PER_THREAD / 2);
+    CacheStats stats = cache.getStats();
+    assert(stats.shards == 8);
+    assert(stats.keys == cache.getKeyCount());
+    
+    // Keys spread over every shard and flush clears all of them
+    assert(cache.exists("t0:1"));
+    assert(!cache.exists("t0:0"));
+    cache.flush();
+    assert(cache.getKeyCount() == 0);
+    
+    cout << "✓ Sharded cache test passed" << endl;
+}
+
 void testPerformance() {
     cout << "Testing performance..." << endl;
     
@@ -160,8 +682,21 @@ int main() {
         testBasicOperations();
         testTTLFunctionality();
         testExpireCommand();
+        testActiveExpiry();
+        testMillisecondTTL();
+        testPinnedClock();
+        testBatchOperations();
+        testPinnedValues();
         testFlushOperation();
         testMemoryEviction();
+        testCompoundEviction();
+        testMemoryAccounting();
+        testIntegerValues();
+        testMemoryBreakdown();
+        testEvictionPolicies();
+        testScanResistance();
+        testStatsCounters();
+        testShardedCache();
         testPerformance();
         
         cout << endl << "🎉 All tests passed!" << endl;
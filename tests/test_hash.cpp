@@ -0,0 +1,263 @@
+#include <iostream>
+#include <cassert>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <climits>
+#include "../include/HashValue.hpp"
+#include "../include/Cache.hpp"
+
+using namespace std;
+
+// Every field of hash, checked against what it should hold
+static void assertHolds(const HashValue& hash, const map<string, string>& expected) {
+    assert(hash.size() == expected.size());
+    size_t visited = 0;
+    hash.forEach([&](string_view field, string_view value) {
+        auto it = expected.find(string(field));
+        assert(it != expected.end() && it->second == value);
+        visited++;
+    });
+    assert(visited == expected.size());
+    for (const auto& entry : expected) {
+        string_view value;
+        assert(hash.get(entry.first, value) && value == entry.second);
+    }
+}
+
+void testHashListpack() {
+    cout << "Testing hash listpack encoding..." << endl;
+
+    SlabAllocator slabs;
+    {
+        HashValue hash(&slabs);
+        assert(hash.size() == 0 && string(hash.encoding()) == "listpack");
+        assert(hash.memoryUsage() == 0);
+
+        assert(hash.set("name", "ada"));
+        assert(hash.set("born", "1815"));
+        assert(!hash.set("name", "ada lovelace"));    // grows in place
+        assert(hash.set("", ""));                     // empty field and value
+        assertHolds(hash, {{"name", "ada lovelace"}, {"born", "1815"}, {"", ""}});
+        assert(!hash.exists("nope") && hash.exists(""));
+
+        // Insertion order, as HGETALL shows it
+        vector<string> order;
+        hash.forEach([&](string_view field, string_view) { order.push_back(string(field)); });
+        assert((order == vector<string>{"name", "born", ""}));
+
+        // Shrinking a value moves what follows back
+        assert(!hash.set("name", "a"));
+        assert(hash.remove("born"));
+        assert(!hash.remove("born"));
+        assertHolds(hash, {{"name", "a"}, {"", ""}});
+
+        // The whole hash is one slab chunk
+        assert(hash.memoryUsage() == slabs.usedBytes());
+        assert(string(hash.encoding()) == "listpack");
+    }
+    assert(slabs.usedBytes() == 0);
+
+    cout << "✓ Hash listpack encoding test passed" << endl;
+}
+
+void testHashConversion() {
+    cout << "Testing hash conversion to a table..." << endl;
+
+    SlabAllocator slabs;
+    {
+        // Past MAX_LISTPACK_ENTRIES fields
+        HashValue hash(&slabs);
+        map<string, string> expected;
+        for (size_t i = 0; i < HashValue::MAX_LISTPACK_ENTRIES; i++) {
+            string field = "f" + to_string(i);
+            hash.set(field, to_string(i));
+            expected[field] = to_string(i);
+        }
+        assert(string(hash.encoding()) == "listpack");
+        hash.set("one more", "x");
+        expected["one more"] = "x";
+        assert(string(hash.encoding()) == "hashtable");
+        assertHolds(hash, expected);
+
+        // A long value converts a small hash too
+        HashValue wide(&slabs);
+        wide.set("a", "1");
+        wide.set("b", string(HashValue::MAX_LISTPACK_VALUE, 'v'));
+        assert(string(wide.encoding()) == "listpack");
+        wide.set("c", string(HashValue::MAX_LISTPACK_VALUE + 1, 'v'));
+        assert(string(wide.encoding()) == "hashtable");
+        assertHolds(wide, {{"a", "1"}, {"b", string(64, 'v')}, {"c", string(65, 'v')}});
+
+        // and stays a table once its fields shrink again
+        wide.remove("c");
+        assert(string(wide.encoding()) == "hashtable");
+        assert(hash.memoryUsage() + wide.memoryUsage() == slabs.usedBytes());
+    }
+    assert(slabs.usedBytes() == 0);
+
+    cout << "✓ Hash conversion test passed" << endl;
+}
+
+// Random sets and removes against a map; removal shifts probe chains back,
+// so every field must stay reachable
+void testHashTableChurn() {
+    cout << "Testing hash table churn..." << endl;
+
+    SlabAllocator slabs;
+    {
+        HashValue hash(&slabs);
+        map<string, string> expected;
+        mt19937 rng(42);
+        for (int i = 0; i < 50000; i++) {
+            string field = "field:" + to_string(rng() % 2000);
+            if (rng() % 3 == 0) {
+                assert(hash.remove(field) == (expected.erase(field) == 1));
+            } else {
+                string value = string(rng() % 100, 'x') + to_string(i);
+                assert(hash.set(field, value) == (expected.count(field) == 0));
+                expected[field] = value;
+            }
+        }
+        assert(string(hash.encoding()) == "hashtable");
+        assertHolds(hash, expected);
+        assert(hash.memoryUsage() == slabs.usedBytes());
+
+        for (const auto& entry : expected) {
+            assert(hash.remove(entry.first));
+        }
+        assert(hash.size() == 0);
+    }
+    assert(slabs.usedBytes() == 0);
+
+    cout << "✓ Hash table churn test passed" << endl;
+}
+
+void testHashSerialize() {
+    cout << "Testing hash serialization..." << endl;
+
+    SlabAllocator slabs;
+    for (size_t fields : {1, 10, 200}) {
+        HashValue hash(&slabs);
+        map<string, string> expected;
+        for (size_t i = 0; i < fields; i++) {
+            string value = string(i % 150, 'v');
+            hash.set("field" + to_string(i), value);
+            expected["field" + to_string(i)] = value;
+        }
+
+        string serialized;
+        hash.serialize(serialized);
+        assert(HashValue::isValid(serialized));
+        HashValue copy(&slabs, serialized);
+        assertHolds(copy, expected);
+        assert(string(copy.encoding()) == hash.encoding());
+
+        // Pairs come out in forEach order; a cut anywhere else is refused
+        set<size_t> boundaries;
+        size_t end = 0;
+        hash.forEach([&](string_view field, string_view value) {
+            end += 1 + field.size() + (value.size() < 128 ? 1 : 2) + value.size();
+            boundaries.insert(end);
+        });
+        assert(end == serialized.size());
+        for (size_t length = 0; length < serialized.size(); length++) {
+            assert(HashValue::isValid(serialized.substr(0, length)) == (boundaries.count(length) == 1));
+        }
+    }
+    // A length that does not fit 32 bits
+    assert(!HashValue::isValid(string(5, '\xff') + "\x01"));
+
+    cout << "✓ Hash serialization test passed" << endl;
+}
+
+void testCacheHashes() {
+    cout << "Testing hashes in the cache..." << endl;
+
+    Cache cache(SIZE_MAX, SIZE_MAX);
+    size_t added;
+    string_view user[] = {"name", "ada", "born", "1815"};
+    assert(cache.hset("user", user, 2, added) == Cache::OK && added == 2);
+
+    ValueType type;
+    assert(cache.type("user", type) && type == ValueType::HASH);
+    assert(string(cache.encoding("user")) == "listpack");
+    assert(cache.encoding("nope") == nullptr);
+
+    Cache::Result result;
+    const HashValue* hash = cache.readHash("user", result);
+    assert(result == Cache::OK && hash->size() == 2);
+    assert(cache.readHash("nope", result) == nullptr && result == Cache::NOT_FOUND);
+
+    long long value;
+    assert(cache.hincrby("user", "born", 10, value) == Cache::OK && value == 1825);
+    assert(cache.hincrby("user", "name", 1, value) == Cache::NOT_INTEGER);
+    assert(cache.hincrby("user", "born", LLONG_MAX, value) == Cache::OUT_OF_RANGE);
+    assert(cache.hincrby("counters", "a", -5, value) == Cache::OK && value == -5);
+
+    // Strings and hashes do not mix
+    cache.set("plain", "x");
+    ValueRef ref;
+    assert(cache.getString("user", ref) == Cache::WRONG_TYPE);
+    assert(cache.getString("plain", ref) == Cache::OK && ref.view() == "x");
+    assert(cache.hset("plain", user, 2, added) == Cache::WRONG_TYPE);
+    assert(cache.readHash("plain", result) == nullptr && result == Cache::WRONG_TYPE);
+    string copy;
+    assert(!cache.get("user", copy));
+
+    // Memory is accounted exactly as hashes grow, convert and shrink
+    for (int i = 0; i < 1000; i++) {
+        string field = "field" + to_string(i);
+        string_view pair[] = {field, string_view("value")};
+        cache.hset("big", pair, 1, added);
+    }
+    assert(string(cache.encoding("big")) == "hashtable");
+    CacheStats stats = cache.getStats();
+    assert(stats.pinnedBytes == 0);
+    assert(stats.valueBytes >= 1000 * (sizeof(uint32_t) * 3 + 13));
+
+    vector<string> fields;
+    for (int i = 0; i < 1000; i++) fields.push_back("field" + to_string(i));
+    vector<string_view> views(fields.begin(), fields.end());
+    size_t removed;
+    assert(cache.hdel("big", views.data(), 999, removed) == Cache::OK && removed == 999);
+    assert(cache.getStats().pinnedBytes == 0);
+    assert(cache.getStats().valueBytes < stats.valueBytes);
+
+    // The last field takes the key with it
+    assert(cache.hdel("big", &views[999], 1, removed) == Cache::OK && removed == 1);
+    assert(!cache.exists("big"));
+    assert(cache.hdel("big", &views[0], 1, removed) == Cache::NOT_FOUND && removed == 0);
+    assert(cache.getKeyCount() == 3);
+
+    // Replacing or deleting a hash frees all of it
+    ref.reset();
+    cache.set("user", "now a string");
+    cache.del("counters");
+    cache.del("plain");
+    cache.del("user");
+    stats = cache.getStats();
+    assert(stats.keyBytes == 0 && stats.valueBytes == 0 && stats.slabUsedBytes == 0);
+
+    cout << "✓ Cache hashes test passed" << endl;
+}
+
+int main() {
+    cout << "=== HASH TESTS ===" << endl << endl;
+
+    try {
+        testHashListpack();
+        testHashConversion();
+        testHashTableChurn();
+        testHashSerialize();
+        testCacheHashes();
+
+        cout << endl << "🎉 All hash tests passed!" << endl;
+    } catch (const exception& e) {
+        cerr << "❌ Hash test failed: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
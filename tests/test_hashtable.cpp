@@ -0,0 +1,141 @@
+#include <iostream>
+#include <cassert>
+#include "../include/HashTable.hpp"
+
+using namespace std;
+
+void testHashTableBasicOperations() {
+    cout << "Testing hash table basic operations..." << endl;
+
+    HashTable table;
+    string value;
+
+    assert(table.insert("key1", "value1"));
+    assert(table.get("key1", value));
+    assert(value == "value1");
+
+    // Overwrite keeps a single entry
+    assert(table.insert("key1", "value2"));
+    assert(table.get("key1", value));
+    assert(value == "value2");
+    assert(table.size() == 1);
+
+    assert(!table.get("missing", value));
+    assert(table.remove("key1"));
+    assert(!table.remove("key1"));
+    assert(table.size() == 0);
+
+    cout << "✓ Hash table basic operations test passed" << endl;
+}
+
+void testHashTableIncrementalRehash() {
+    cout << "Testing hash table incremental rehash..." << endl;
+
+    HashTable table;
+    const int NUM_KEYS = 100000;
+    string value;
+    bool sawRehash = false;
+
+    // Every key must stay reachable while groups migrate between tables
+    for (int i = 0; i < NUM_KEYS; i++) {
+        assert(table.insert("key" + to_string(i), "value" + to_string(i)));
+        sawRehash = sawRehash || table.isRehashing();
+
+        if (i % 97 == 0) {
+            for (int j = 0; j <= i; j += 1013) {
+                assert(table.get("key" + to_string(j), value));
+                assert(value == "value" + to_string(j));
+            }
+        }
+    }
+    assert(sawRehash);
+    assert(table.size() == NUM_KEYS);
+    assert(table.getAllKeys().size() == NUM_KEYS);
+
+    // Remove half mid-flight, then check both halves
+    for (int i = 0; i < NUM_KEYS; i += 2) {
+        assert(table.remove("key" + to_string(i)));
+    }
+    for (int i = 0; i < NUM_KEYS; i++) {
+        assert(table.get("key" + to_string(i), value) == (i % 2 == 1));
+    }
+    assert(table.size() == NUM_KEYS / 2);
+
+    cout << "✓ Hash table incremental rehash test passed" << endl;
+}
+
+void testHashTableTombstoneChurn() {
+    cout << "Testing hash table tombstone churn..." << endl;
+
+    HashTable table;
+    string value;
+
+    // Constant size, ever-changing keys: tombstones must be purged rather
+    // than growing the table without bound
+    for (int i = 0; i < 200000; i++) {
+        assert(table.insert("churn" + to_string(i), "v"));
+        if (i >= 100) {
+            assert(table.remove("churn" + to_string(i - 100)));
+        }
+    }
+    assert(table.size() == 100);
+    assert(table.capacity() <= 1024);
+    assert(table.get("churn199999", value));
+    assert(!table.get("churn0", value));
+
+    table.clear();
+    assert(table.size() == 0);
+    assert(!table.get("churn199999", value));
+
+    cout << "✓ Hash table tombstone churn test passed" << endl;
+}
+
+void testHashTableReserve() {
+    cout << "Testing hash table reserve..." << endl;
+
+    HashTable table;
+    string value;
+    assert(table.insert("existing", "value"));
+
+    // Sized once up front, bulk inserts never rehash
+    table.reserve(100000);
+    assert(!table.isRehashing());
+    size_t capacity = table.capacity();
+    assert(capacity >= 100000);
+    assert(table.get("existing", value) && value == "value");
+
+    for (int i = 0; i < 100000; i++) {
+        string key = "bulk" + to_string(i);
+        HashNode* node = table.insertUnique(key, HashTable::hashKey(key));
+        node->value = ValueRef::copyOf(to_string(i), &table.allocator());
+        assert(!table.isRehashing());
+    }
+    assert(table.capacity() == capacity);
+    assert(table.size() == 100001);
+    assert(table.get("bulk99999", value) && value == "99999");
+    assert(table.get("existing", value));
+
+    // Reserving less than is there already does nothing
+    table.reserve(10);
+    assert(table.capacity() == capacity);
+
+    cout << "✓ Hash table reserve test passed" << endl;
+}
+
+int main() {
+    cout << "=== HASH TABLE TESTS ===" << endl << endl;
+
+    try {
+        testHashTableBasicOperations();
+        testHashTableIncrementalRehash();
+        testHashTableTombstoneChurn();
+        testHashTableReserve();
+
+        cout << endl << "🎉 All hash table tests passed!" << endl;
+    } catch (const exception& e) {
+        cerr << "❌ Hash table test failed: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
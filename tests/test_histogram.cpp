@@ -0,0 +1,86 @@
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "../include/LatencyHistogram.hpp"
+
+using namespace std;
+
+void testHistogramPercentiles() {
+    cout << "Testing histogram percentiles..." << endl;
+
+    LatencyHistogram histogram;
+    assert(histogram.count() == 0 && histogram.percentile(99) == 0);
+
+    // Exact below 32
+    for (uint64_t v = 1; v <= 20; v++) {
+        histogram.record(v);
+    }
+    assert(histogram.count() == 20);
+    assert(histogram.percentile(50) == 10);
+    assert(histogram.percentile(100) == 20);
+    assert(histogram.min() == 1 && histogram.max() == 20);
+    assert(histogram.mean() == 10.5);
+
+    // Within the promised precision against sorted samples, 1 ns to 10 s
+    histogram.reset();
+    mt19937_64 rng(42);
+    lognormal_distribution<double> latency(9.0, 2.5);
+    vector<uint64_t> samples;
+    for (int i = 0; i < 200000; i++) {
+        uint64_t v = static_cast<uint64_t>(min(latency(rng), 1e10));
+        samples.push_back(v);
+        histogram.record(v);
+    }
+    sort(samples.begin(), samples.end());
+    for (double p : {50.0, 90.0, 99.0, 99.9, 99.99}) {
+        uint64_t exact = samples[static_cast<size_t>(p / 100 * samples.size() + 0.999999) - 1];
+        uint64_t reported = histogram.percentile(p);
+        assert(reported >= exact);
+        assert(reported <= exact + exact / 30 + 1);
+    }
+    assert(histogram.percentile(100) == samples.back());
+
+    cout << "✓ Histogram percentiles test passed" << endl;
+}
+
+void testHistogramMergeAndRange() {
+    cout << "Testing histogram merge and range..." << endl;
+
+    LatencyHistogram a, b;
+    a.record(100, 99);
+    b.record(1000000);
+    a.merge(b);
+    assert(a.count() == 100);
+    assert(a.percentile(99) >= 100 && a.percentile(99) < 104);
+    assert(a.percentile(99.5) >= 1000000 && a.max() == 1000000);
+    assert(a.min() == 100);
+
+    // Out of range values land in the last bucket without losing the max
+    LatencyHistogram huge;
+    huge.record(uint64_t(1) << 50);
+    assert(huge.percentile(50) == uint64_t(1) << 50);
+    assert(huge.count() == 1);
+
+    a.reset();
+    assert(a.count() == 0 && a.max() == 0 && a.min() == 0);
+
+    cout << "✓ Histogram merge and range test passed" << endl;
+}
+
+int main() {
+    cout << "=== LATENCY HISTOGRAM TESTS ===" << endl << endl;
+
+    try {
+        testHistogramPercentiles();
+        testHistogramMergeAndRange();
+
+        cout << endl << "🎉 All latency histogram tests passed!" << endl;
+    } catch (const exception& e) {
+        cerr << "❌ Latency histogram test failed: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
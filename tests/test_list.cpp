@@ -0,0 +1,250 @@
+#include <iostream>
+#include <cassert>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/ListValue.hpp"
+#include "../include/Cache.hpp"
+
+using namespace std;
+
+// Every element of list, in order, checked against what it should hold
+static void assertHolds(const ListValue& list, const deque<string>& expected) {
+    assert(list.size() == expected.size());
+    size_t index = 0;
+    list.forEach([&](string_view value) {
+        assert(index < expected.size() && expected[index] == value);
+        index++;
+    });
+    assert(index == expected.size());
+}
+
+void testListPushPop() {
+    cout << "Testing list push and pop..." << endl;
+
+    SlabAllocator slabs;
+    {
+        ListValue list(&slabs);
+        assert(list.size() == 0 && list.memoryUsage() == 0);
+        string value;
+        assert(!list.pop(true, value) && !list.pop(false, value));
+
+        list.push("b", false);
+        list.push("c", false);
+        list.push("a", true);
+        list.push("", false);      // empty elements are elements
+        assertHolds(list, {"a", "b", "c", ""});
+        assert(string(list.encoding()) == "listpack");
+
+        assert(list.pop(false, value) && value == "");
+        assert(list.pop(true, value) && value == "a");
+        assertHolds(list, {"b", "c"});
+
+        // One slab chunk while it fits
+        assert(list.memoryUsage() == slabs.usedBytes());
+
+        assert(list.pop(true, value) && value == "b");
+        assert(list.pop(true, value) && value == "c");
+        assert(!list.pop(true, value));
+        assert(list.size() == 0 && list.memoryUsage() == 0);
+    }
+    assert(slabs.usedBytes() == 0);
+
+    cout << "✓ List push and pop test passed" << endl;
+}
+
+void testListChunks() {
+    cout << "Testing list chunks..." << endl;
+
+    SlabAllocator slabs;
+    {
+        ListValue list(&slabs);
+        deque<string> expected;
+        mt19937 rng(7);
+
+        // Enough to span many chunks from both ends
+        for (int i = 0; i < 20000; i++) {
+            string value = "element:" + to_string(i) + string(rng() % 40, 'x');
+            bool front = rng() % 2;
+            list.push(value, front);
+            if (front) {
+                expected.push_front(value);
+            } else {
+                expected.push_back(value);
+            }
+        }
+        assertHolds(list, expected);
+        assert(string(list.encoding()) == "quicklist");
+        assert(list.memoryUsage() == slabs.usedBytes());
+
+        // Compact: chunks stay close to full
+        size_t payload = 0;
+        for (const string& value : expected) payload += value.size();
+        assert(list.memoryUsage() < payload * 2);
+
+        // An element larger than a chunk gets one of its own
+        string huge(ListValue::CHUNK_BYTES * 3, 'h');
+        list.push(huge, true);
+        list.push(huge, false);
+        expected.push_front(huge);
+        expected.push_back(huge);
+        assertHolds(list, expected);
+
+        // Random pops from either end
+        string value;
+        while (expected.size() > 100) {
+            if (rng() % 2) {
+                assert(list.pop(true, value) && value == expected.front());
+                expected.pop_front();
+            } else {
+                assert(list.pop(false, value) && value == expected.back());
+                expected.pop_back();
+            }
+        }
+        assertHolds(list, expected);
+        assert(list.memoryUsage() == slabs.usedBytes());
+    }
+    assert(slabs.usedBytes() == 0);
+
+    cout << "✓ List chunks test passed" << endl;
+}
+
+void testListRanges() {
+    cout << "Testing list ranges..." << endl;
+
+    SlabAllocator slabs;
+    ListValue list(&slabs);
+    deque<string> expected;
+    for (int i = 0; i < 5000; i++) {
+        string value = to_string(i) + string(i % 100, 'r');
+        list.push(value, false);
+        expected.push_back(value);
+    }
+
+    // Ranges from anywhere, found from either end
+    mt19937 rng(11);
+    for (int trial = 0; trial < 500; trial++) {
+        size_t start = rng() % expected.size();
+        size_t stop = start + rng() % 300;
+        if (stop >= expected.size()) stop = expected.size() - 1;
+        size_t index = start;
+        list.forEachInRange(start, stop, [&](string_view value) {
+            assert(expected[index] == value);
+            index++;
+        });
+        assert(index == stop + 1);
+    }
+
+    // The very ends
+    vector<string> seen;
+    list.forEachInRange(0, 0, [&](string_view value) { seen.emplace_back(value); });
+    list.forEachInRange(4999, 4999, [&](string_view value) { seen.emplace_back(value); });
+    assert((seen == vector<string>{expected.front(), expected.back()}));
+
+    cout << "✓ List ranges test passed" << endl;
+}
+
+void testListSerialize() {
+    cout << "Testing list serialization..." << endl;
+
+    SlabAllocator slabs;
+    ListValue list(&slabs);
+    deque<string> expected;
+    for (int i = 0; i < 3000; i++) {
+        string value = "v" + to_string(i * 7);
+        list.push(value, i % 3 == 0);
+        if (i % 3 == 0) {
+            expected.push_front(value);
+        } else {
+            expected.push_back(value);
+        }
+    }
+
+    string serialized;
+    list.serialize(serialized);
+    assert(ListValue::isValid(serialized));
+    ListValue copy(&slabs, serialized);
+    assertHolds(copy, expected);
+
+    // Empty or truncated input is rejected
+    assert(!ListValue::isValid(""));
+    assert(!ListValue::isValid(serialized.substr(0, serialized.size() - 1)));
+
+    cout << "✓ List serialization test passed" << endl;
+}
+
+void testCacheLists() {
+    cout << "Testing lists in the cache..." << endl;
+
+    Cache cache(SIZE_MAX, SIZE_MAX);
+    size_t length;
+    string_view values[] = {"a", "b", "c"};
+    assert(cache.push("queue", values, 3, false, length) == Cache::OK && length == 3);
+    assert(cache.push("queue", values, 1, true, length) == Cache::OK && length == 4);
+    assert(cache.getKeyCount() == 1);
+
+    Cache::Result result;
+    const ListValue* list = cache.readList("queue", result);
+    assert(list && result == Cache::OK);
+    assertHolds(*list, {"a", "a", "b", "c"});
+    assert(cache.readList("missing", result) == nullptr && result == Cache::NOT_FOUND);
+
+    vector<string> popped;
+    assert(cache.pop("queue", false, 2, popped) == Cache::OK);
+    assert((popped == vector<string>{"c", "b"}));
+    popped.clear();
+    assert(cache.pop("missing", true, 1, popped) == Cache::NOT_FOUND && popped.empty());
+
+    // Wrong types either way
+    cache.set("plain", "x");
+    assert(cache.push("plain", values, 1, false, length) == Cache::WRONG_TYPE);
+    assert(cache.pop("plain", true, 1, popped) == Cache::WRONG_TYPE);
+    ValueRef ref;
+    assert(cache.getString("queue", ref) == Cache::WRONG_TYPE);
+
+    // Popping the last elements takes the key with it, and a count past the
+    // end stops there
+    assert(cache.pop("queue", true, 10, popped) == Cache::OK);
+    assert((popped == vector<string>{"a", "a"}));
+    assert(!cache.exists("queue"));
+
+    // Memory is accounted exactly as lists grow and shrink
+    for (int i = 0; i < 10000; i++) {
+        string value = "item:" + to_string(i);
+        string_view view = value;
+        cache.push("long", &view, 1, false, length);
+    }
+    assert(string(cache.encoding("long")) == "quicklist");
+    CacheStats stats = cache.getStats();
+    assert(stats.pinnedBytes == 0);
+    popped.clear();
+    assert(cache.pop("long", true, 9000, popped) == Cache::OK && popped.size() == 9000);
+    assert(cache.getStats().valueBytes < stats.valueBytes);
+
+    cache.del("long");
+    cache.del("plain");
+    stats = cache.getStats();
+    assert(stats.keyBytes == 0 && stats.valueBytes == 0 && stats.slabUsedBytes == 0);
+
+    cout << "✓ Cache lists test passed" << endl;
+}
+
+int main() {
+    cout << "=== LIST TESTS ===" << endl << endl;
+
+    try {
+        testListPushPop();
+        testListChunks();
+        testListRanges();
+        testListSerialize();
+        testCacheLists();
+
+        cout << endl << "🎉 All list tests passed!" << endl;
+    } catch (const exception& e) {
+        cerr << "❌ List test failed: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
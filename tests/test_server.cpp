@@ -0,0 +1,591 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "../include/Cache.hpp"
+#include "../include/Server.hpp"
+
+using namespace std;
+
+static int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    return fd;
+}
+
+static void sendAll(int fd, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, 0);
+        assert(n > 0);
+        sent += n;
+    }
+}
+
+// Reads until `length` bytes arrived or the peer closed
+static string readBytes(int fd, size_t length) {
+    string result;
+    char buffer[4096];
+    while (result.size() < length) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        result.append(buffer, n);
+    }
+    return result;
+}
+
+static string roundTrip(int fd, const string& request, const string& expected) {
+    sendAll(fd, request);
+    return readBytes(fd, expected.size());
+}
+
+// Reads one bulk string reply of any length; the header byte by byte, so
+// nothing after the reply is consumed
+static string readBulk(int fd) {
+    string header;
+    char c;
+    while (header.size() < 2 || header.compare(header.size() - 2, 2, "\r\n") != 0) {
+        assert(recv(fd, &c, 1, 0) == 1);
+        header += c;
+    }
+    assert(header[0] == '$');
+    size_t length = stoul(header.substr(1));
+    string body = readBytes(fd, length + 2);
+    return body.substr(0, length);
+}
+
+static string command(const vector<string>& args) {
+    string out = "*" + to_string(args.size()) + "\r\n";
+    for (const string& arg : args) {
+        out += "$" + to_string(arg.size()) + "\r\n" + arg + "\r\n";
+    }
+    return out;
+}
+
+void testServerBasicCommands(int port) {
+    cout << "Testing server basic commands..." << endl;
+    
+    int fd = connectTo(port);
+    string expected;
+    
+    expected = "+PONG\r\n";
+    assert(roundTrip(fd, command({"PING"}), expected) == expected);
+    expected = "+OK\r\n";
+    assert(roundTrip(fd, command({"SET", "user:1", "hello world"}), expected) == expected);
+    expected = "$11\r\nhello world\r\n";
+    assert(roundTrip(fd, command({"GET", "user:1"}), expected) == expected);
+    expected = ":1\r\n";
+    assert(roundTrip(fd, command({"EXISTS", "user:1"}), expected) == expected);
+    assert(roundTrip(fd, command({"DEL", "user:1"}), expected) == expected);
+    expected = "$-1\r\n";
+    assert(roundTrip(fd, command({"GET", "user:1"}), expected) == expected);
+    expected = "+OK\r\n";
+    assert(roundTrip(fd, command({"SET", "session", "x", "EX", "100"}), expected) == expected);
+    expected = ":100\r\n";
+    assert(roundTrip(fd, command({"TTL", "session"}), expected) == expected);
+    expected = "+OK\r\n";
+    assert(roundTrip(fd, command({"PSETEX", "token", "100000", "y"}), expected) == expected);
+    expected = ":1\r\n";
+    assert(roundTrip(fd, command({"PEXPIRE", "session", "250000"}), expected) == expected);
+    expected = ":-2\r\n";
+    assert(roundTrip(fd, command({"PTTL", "nope"}), expected) == expected);
+    expected = ":1\r\n";
+    assert(roundTrip(fd, command({"DEL", "token"}), expected) == expected);
+    
+    // Multi-key commands
+    expected = "+OK\r\n";
+    assert(roundTrip(fd, command({"MSET", "a", "1", "b", "22"}), expected) == expected);
+    expected = "*3\r\n$1\r\n1\r\n$-1\r\n$2\r\n22\r\n";
+    assert(roundTrip(fd, command({"MGET", "a", "nope", "b"}), expected) == expected);
+    expected = ":2\r\n";
+    assert(roundTrip(fd, command({"DEL", "a", "b", "nope"}), expected) == expected);
+    
+    // Binary-safe values
+    string binary("a\r\nb\0c", 6);
+    expected = "+OK\r\n";
+    assert(roundTrip(fd, command({"SET", "bin", binary}), expected) == expected);
+    expected = "$6\r\n" + binary + "\r\n";
+    assert(roundTrip(fd, command({"GET", "bin"}), expected) == expected);
+    
+    // Errors keep the connection usable
+    expected = "-ERR wrong number of arguments for 'get' command\r\n";
+    assert(roundTrip(fd, command({"GET"}), expected) == expected);
+    expected = "-ERR unknown command 'NOPE'\r\n";
+    assert(roundTrip(fd, command({"NOPE"}), expected) == expected);
+    
+    close(fd);
+    cout << "✓ Server basic commands test passed" << endl;
+}
+
+void testServerFraming(int port) {
+    cout << "Testing server request framing..." << endl;
+    
+    int fd = connectTo(port);
+    
+    // Inline commands, as typed into telnet
+    string expected = "+OK\r\n$3\r\nbar\r\n";
+    assert(roundTrip(fd, "SET foo bar\r\nGET foo\n", expected) == expected);
+    
+    // Quoted inline arguments keep their spaces and are unescaped
+    expected = "+OK\r\n$6\r\na b\"A\n\r\n:1\r\n";
+    assert(roundTrip(fd, "SET quoted \"a b\\\"\\x41\\n\"\r\nGET 'quoted'\r\nDEL quoted\r\n", expected) == expected);
+    expected = "-ERR Protocol error: unbalanced quotes in request\r\n";
+    string reply = roundTrip(fd, "GET \"quoted\r\n", expected);
+    assert(reply == expected);
+    close(fd);
+    fd = connectTo(port);
+    
+    // A command split across several packets
+    string request = command({"SET", "split", "value"});
+    for (size_t i = 0; i < request.size(); i++) {
+        sendAll(fd, request.substr(i, 1));
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    expected = "+OK\r\n";
+    assert(readBytes(fd, expected.size()) == expected);
+    
+    // Several commands in one packet get all their replies, in order
+    expected = "$5\r\nvalue\r\n$-1\r\n:1\r\n";
+    assert(roundTrip(fd, command({"GET", "split"}) + command({"GET", "nope"}) + command({"EXISTS", "foo"}),
+                     expected) == expected);
+    
+    // QUIT replies and closes
+    expected = "+OK\r\n";
+    assert(roundTrip(fd, command({"QUIT"}), expected) == expected);
+    assert(readBytes(fd, 1).empty());
+    close(fd);
+    
+    // Protocol errors are reported and the connection is dropped
+    fd = connectTo(port);
+    reply = roundTrip(fd, "*1\r\n+PING\r\n", "-ERR Protocol error");
+    assert(reply.compare(0, 19, "-ERR Protocol error") == 0);
+    readBytes(fd, 1024);
+    close(fd);
+    
+    cout << "✓ Server request framing test passed" << endl;
+}
+
+void testServerConcurrentClients(int port) {
+    cout << "Testing server concurrent clients..." << endl;
+    
+    const int NUM_CLIENTS = 32;
+    const int OPS_PER_CLIENT = 200;
+    vector<thread> clients;
+    
+    for (int c = 0; c < NUM_CLIENTS; c++) {
+        clients.emplace_back([port, c]() {
+            int fd = connectTo(port);
+            for (int i = 0; i < OPS_PER_CLIENT; i++) {
+                string key = "c" + to_string(c) + ":" + to_string(i);
+                string ok = "+OK\r\n";
+                assert(roundTrip(fd, command({"SET", key, key}), ok) == ok);
+                string value = "$" + to_string(key.size()) + "\r\n" + key + "\r\n";
+                assert(roundTrip(fd, command({"GET", key}), value) == value);
+            }
+            close(fd);
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    
+    int fd = connectTo(port);
+    string expected = ":" + to_string(NUM_CLIENTS * OPS_PER_CLIENT + 4) + "\r\n";
+    assert(roundTrip(fd, command({"DBSIZE"}), expected) == expected);
+    close(fd);
+    
+    cout << "✓ Server concurrent clients test passed" << endl;
+}
+
+void testServerLargeValues(int port) {
+    cout << "Testing server large values..." << endl;
+    
+    int fd = connectTo(port);
+    string big(300 * 1024, 'x');
+    string medium(RESPWriter::ZERO_COPY_MIN_BYTES, 'm');
+    for (size_t i = 0; i < big.size(); i += 1000) {
+        big[i] = static_cast<char>('a' + i % 26);
+    }
+    
+    // Replies mix copied and pinned values; the pipeline is sent in full
+    // before reading, so the server has to resume partial writes
+    string request = command({"SET", "big", big}) + command({"SET", "medium", medium})
+                   + command({"GET", "big"}) + command({"SET", "big", "small now"})
+                   + command({"MGET", "medium", "nope", "big"}) + command({"GET", "big"});
+    for (int i = 0; i < 4; i++) {
+        request += command({"GET", "medium"});
+    }
+    
+    // The first GET still sees the old value even though SET replaced it
+    // before the reply went out
+    string expected = "+OK\r\n+OK\r\n$" + to_string(big.size()) + "\r\n" + big + "\r\n+OK\r\n"
+                    + "*3\r\n$" + to_string(medium.size()) + "\r\n" + medium + "\r\n$-1\r\n$9\r\nsmall now\r\n"
+                    + "$9\r\nsmall now\r\n";
+    for (int i = 0; i < 4; i++) {
+        expected += "$" + to_string(medium.size()) + "\r\n" + medium + "\r\n";
+    }
+    assert(roundTrip(fd, request, expected) == expected);
+    
+    close(fd);
+    cout << "✓ Server large values test passed" << endl;
+}
+
+void testServerInfo(int port) {
+    cout << "Testing server INFO and STATS RESET..." << endl;
+    
+    int fd = connectTo(port);
+    string expected = "+OK\r\n";
+    assert(roundTrip(fd, command({"STATS", "RESET"}), expected) == expected);
+    
+    string request = command({"SET", "info:1", "v"}) + command({"GET", "info:1"}) + command({"GET", "info:2"})
+                   + command({"EXPIRE", "info:1", "-5"}) + command({"NOSUCH"});
+    expected = "+OK\r\n$1\r\nv\r\n$-1\r\n-ERR invalid expire time in 'expire' command\r\n"
+               "-ERR unknown command 'NOSUCH'\r\n";
+    assert(roundTrip(fd, request, expected) == expected);
+    
+    sendAll(fd, command({"INFO"}));
+    string info = readBulk(fd);
+    assert(info.find("# Stats\r\n") != string::npos);
+    assert(info.find("keyspace_hits:1\r\n") != string::npos);
+    assert(info.find("keyspace_misses:1\r\n") != string::npos);
+    assert(info.find("unknown_commands:1\r\n") != string::npos);
+    assert(info.find("cmdstat_get:calls=2,") != string::npos);
+    assert(info.find("cmdstat_set:calls=1,") != string::npos);
+    assert(info.find("cmdstat_expire:calls=1,usec=") != string::npos);
+    assert(info.find(",failed_calls=1\r\n") != string::npos);
+    assert(info.find("latency_percentiles_usec_get:p50=") != string::npos);
+    assert(info.find("index_resizes:") != string::npos);
+    
+    // One section, and the counters start over after a reset
+    sendAll(fd, command({"INFO", "commandstats"}));
+    info = readBulk(fd);
+    assert(info.find("# Commandstats\r\n") == 0);
+    assert(info.find("# Stats") == string::npos);
+    assert(info.find("cmdstat_info:calls=1,") != string::npos);
+    expected = "+OK\r\n";
+    assert(roundTrip(fd, command({"CONFIG", "RESETSTAT"}), expected) == expected);
+    sendAll(fd, command({"INFO", "commandstats"}));
+    info = readBulk(fd);
+    assert(info.find("cmdstat_get") == string::npos);
+    
+    close(fd);
+    cout << "✓ Server INFO test passed" << endl;
+}
+
+void testServerCommandTable(int port) {
+    cout << "Testing server command table..." << endl;
+    
+    int fd = connectTo(port);
+    
+    // Names match in any case
+    string expected = "+OK\r\n$1\r\nv\r\n";
+    assert(roundTrip(fd, command({"sEt", "table", "v"}) + command({"get", "table"}), expected) == expected);
+    
+    // Arity is checked before a command runs
+    expected = "-ERR wrong number of arguments for 'expire' command\r\n";
+    assert(roundTrip(fd, command({"EXPIRE", "table"}), expected) == expected);
+    expected = "-ERR wrong number of arguments for 'set' command\r\n";
+    assert(roundTrip(fd, command({"SET", "table"}), expected) == expected);
+    expected = "-ERR wrong number of arguments for 'mset' command\r\n";
+    assert(roundTrip(fd, command({"MSET", "a", "1", "b"}), expected) == expected);
+    expected = "-ERR wrong number of arguments for 'dbsize' command\r\n";
+    assert(roundTrip(fd, command({"DBSIZE", "x"}), expected) == expected);
+    
+    // COMMAND COUNT and COMMAND INFO, unknown names as nil
+    string reply = roundTrip(fd, command({"COMMAND", "COUNT"}), ":NN\r\n");
+    assert(reply[0] == ':' && stoi(reply.substr(1)) >= 28);
+    expected = "*2\r\n*6\r\n$3\r\nget\r\n:2\r\n*2\r\n+readonly\r\n+fast\r\n:1\r\n:1\r\n:1\r\n$-1\r\n";
+    assert(roundTrip(fd, command({"COMMAND", "INFO", "GET", "nope"}), expected) == expected);
+    expected = "*1\r\n*6\r\n$4\r\nmset\r\n:-3\r\n*1\r\n+write\r\n:1\r\n:-1\r\n:2\r\n";
+    assert(roundTrip(fd, command({"command", "info", "mset"}), expected) == expected);
+    
+    close(fd);
+    
+    assert(CommandProcessor::lookupCommand("pexpireat") != nullptr);
+    assert(CommandProcessor::lookupCommand("PEXPIREAT")->arity == 3);
+    assert(CommandProcessor::lookupCommand("PEXPIREA") == nullptr);
+    assert(CommandProcessor::lookupCommand("") == nullptr);
+    
+    cout << "✓ Server command table test passed" << endl;
+}
+
+void testServerHashes(int port) {
+    cout << "Testing server hash commands..." << endl;
+    
+    int fd = connectTo(port);
+    
+    string expected = ":2\r\n:0\r\n$3\r\nada\r\n$-1\r\n";
+    assert(roundTrip(fd, command({"HSET", "user", "name", "ada", "born", "1815"}) +
+                         command({"HSET", "user", "name", "ada"}) + command({"HGET", "user", "name"}) +
+                         command({"HGET", "user", "nope"}), expected) == expected);
+    
+    // A small hash keeps insertion order
+    expected = "*4\r\n$4\r\nname\r\n$3\r\nada\r\n$4\r\nborn\r\n$4\r\n1815\r\n";
+    assert(roundTrip(fd, command({"HGETALL", "user"}), expected) == expected);
+    expected = "*3\r\n$4\r\n1815\r\n$-1\r\n$3\r\nada\r\n:2\r\n:1\r\n:0\r\n";
+    assert(roundTrip(fd, command({"HMGET", "user", "born", "nope", "name"}) + command({"HLEN", "user"}) +
+                         command({"HEXISTS", "user", "born"}) + command({"HEXISTS", "user", "nope"}),
+                     expected) == expected);
+    
+    // Missing keys read as empty hashes
+    expected = "*0\r\n:0\r\n*2\r\n$-1\r\n$-1\r\n";
+    assert(roundTrip(fd, command({"HGETALL", "nohash"}) + command({"HLEN", "nohash"}) +
+                         command({"HMGET", "nohash", "a", "b"}), expected) == expected);
+    
+    expected = ":1816\r\n:5\r\n-ERR hash value is not an integer\r\n"
+               "-ERR value is not an integer or out of range\r\n"
+               "-ERR increment or decrement would overflow\r\n";
+    assert(roundTrip(fd, command({"HINCRBY", "user", "born", "1"}) + command({"HINCRBY", "user", "count", "5"}) +
+                         command({"HINCRBY", "user", "name", "1"}) + command({"HINCRBY", "user", "count", "x"}) +
+                         command({"HINCRBY", "user", "count", "9223372036854775807"}), expected) == expected);
+    
+    // Types are checked both ways
+    string wrongType = "-WRONGTYPE Operation against a key holding the wrong kind of value\r\n";
+    expected = "+OK\r\n" + wrongType + wrongType + wrongType + "*2\r\n$-1\r\n$3\r\nstr\r\n";
+    assert(roundTrip(fd, command({"SET", "plain", "str"}) + command({"GET", "user"}) +
+                         command({"HSET", "plain", "f", "v"}) + command({"HGET", "plain", "f"}) +
+                         command({"MGET", "user", "plain"}), expected) == expected);
+    expected = "+hash\r\n+string\r\n+none\r\n$8\r\nlistpack\r\n$6\r\nembstr\r\n$-1\r\n";
+    assert(roundTrip(fd, command({"TYPE", "user"}) + command({"TYPE", "plain"}) + command({"TYPE", "nope"}) +
+                         command({"OBJECT", "ENCODING", "user"}) + command({"object", "encoding", "plain"}) +
+                         command({"OBJECT", "ENCODING", "nope"}), expected) == expected);
+    
+    // Deleting the last field deletes the key; SET replaces a hash
+    expected = ":1\r\n:0\r\n:3\r\n:0\r\n+OK\r\n+string\r\n:2\r\n";
+    assert(roundTrip(fd, command({"HSET", "short", "f", "v"}) + command({"HDEL", "short", "nope"}) +
+                         command({"HDEL", "user", "name", "born", "count"}) + command({"EXISTS", "user"}) +
+                         command({"SET", "short", "now a string"}) + command({"TYPE", "short"}) +
+                         command({"DEL", "short", "plain"}), expected) == expected);
+    
+    expected = "-ERR wrong number of arguments for 'hset' command\r\n";
+    assert(roundTrip(fd, command({"HSET", "user", "a", "1", "b"}), expected) == expected);
+    
+    close(fd);
+    cout << "✓ Server hash commands test passed" << endl;
+}
+
+void testServerZSets(int port) {
+    cout << "Testing server sorted set commands..." << endl;
+    
+    int fd = connectTo(port);
+    
+    string expected = ":3\r\n:0\r\n:2\r\n$3\r\n1.5\r\n$-1\r\n:3\r\n";
+    assert(roundTrip(fd, command({"ZADD", "board", "1", "a", "2", "b", "3", "c"}) +
+                         command({"ZADD", "board", "1", "a"}) +
+                         command({"ZADD", "board", "CH", "1.5", "a", "2.5", "b", "2.5", "b"}) +
+                         command({"ZSCORE", "board", "a"}) + command({"ZSCORE", "board", "nope"}) +
+                         command({"ZCARD", "board"}), expected) == expected);
+    
+    // Ranks and rank ranges, negative ranks from the end
+    expected = ":0\r\n:2\r\n$-1\r\n*2\r\n$1\r\nb\r\n$1\r\nc\r\n"
+               "*4\r\n$1\r\nc\r\n$1\r\n3\r\n$1\r\nb\r\n$3\r\n2.5\r\n*1\r\n$1\r\nc\r\n*0\r\n";
+    assert(roundTrip(fd, command({"ZRANK", "board", "a"}) + command({"ZREVRANK", "board", "a"}) +
+                         command({"ZRANK", "board", "nope"}) + command({"ZRANGE", "board", "1", "-1"}) +
+                         command({"ZREVRANGE", "board", "0", "1", "WITHSCORES"}) +
+                         command({"ZRANGE", "board", "0", "0", "REV"}) + command({"ZRANGE", "board", "5", "9"}),
+                     expected) == expected);
+    
+    // Score ranges with exclusive bounds, infinities and LIMIT
+    expected = "*2\r\n$1\r\nb\r\n$1\r\nc\r\n*1\r\n$1\r\nb\r\n*2\r\n$1\r\nc\r\n$1\r\nb\r\n:2\r\n:3\r\n"
+               "-ERR min or max is not a float\r\n";
+    assert(roundTrip(fd, command({"ZRANGEBYSCORE", "board", "(1.5", "+inf"}) +
+                         command({"ZRANGEBYSCORE", "board", "-inf", "inf", "LIMIT", "1", "1"}) +
+                         command({"ZREVRANGEBYSCORE", "board", "3", "2"}) + command({"ZCOUNT", "board", "2", "3"}) +
+                         command({"ZCOUNT", "board", "-inf", "+inf"}) + command({"ZCOUNT", "board", "x", "1"}),
+                     expected) == expected);
+    
+    // INCR and ZINCRBY reply with the score; NX skips, NaN is refused
+    expected = "$1\r\n4\r\n$3\r\n5.5\r\n$-1\r\n:1\r\n-ERR resulting score is not a number (NaN)\r\n"
+               "-ERR value is not a valid float\r\n";
+    assert(roundTrip(fd, command({"ZINCRBY", "board", "2.5", "a"}) +
+                         command({"ZADD", "board", "INCR", "1.5", "a"}) +
+                         command({"ZADD", "board", "NX", "INCR", "1", "a"}) +
+                         command({"ZADD", "board", "inf", "d"}) + command({"ZINCRBY", "board", "-inf", "d"}) +
+                         command({"ZADD", "board", "nan", "e"}), expected) == expected);
+    
+    // Option errors
+    expected = "-ERR XX and NX options at the same time are not compatible\r\n"
+               "-ERR GT, LT, and/or NX options at the same time are not compatible\r\n"
+               "-ERR INCR option supports a single increment-element pair\r\n"
+               "-ERR syntax error\r\n";
+    assert(roundTrip(fd, command({"ZADD", "board", "NX", "XX", "1", "a"}) +
+                         command({"ZADD", "board", "GT", "LT", "1", "a"}) +
+                         command({"ZADD", "board", "INCR", "1", "a", "2", "b"}) +
+                         command({"ZADD", "board", "1", "a", "2"}), expected) == expected);
+    
+    // Types, and the last member taking the key with it
+    string wrongType = "-WRONGTYPE Operation against a key holding the wrong kind of value\r\n";
+    expected = "+zset\r\n$8\r\nlistpack\r\n+OK\r\n" + wrongType + wrongType + ":1\r\n:3\r\n:0\r\n";
+    assert(roundTrip(fd, command({"TYPE", "board"}) + command({"OBJECT", "ENCODING", "board"}) +
+                         command({"SET", "plain", "str"}) + command({"ZADD", "plain", "1", "a"}) +
+                         command({"ZSCORE", "plain", "a"}) + command({"ZREM", "board", "a", "nope"}) +
+                         command({"ZREM", "board", "b", "c", "d"}) + command({"EXISTS", "board"}),
+                     expected) == expected);
+    
+    // Past 128 members the set is a skiplist
+    string batch;
+    for (int i = 0; i < 200; i++) {
+        batch += command({"ZADD", "ranked", to_string(i), "member" + to_string(i)});
+    }
+    string replies;
+    for (int i = 0; i < 200; i++) replies += ":1\r\n";
+    assert(roundTrip(fd, batch, replies) == replies);
+    expected = "$8\r\nskiplist\r\n:150\r\n*2\r\n$9\r\nmember199\r\n$9\r\nmember198\r\n:10\r\n";
+    assert(roundTrip(fd, command({"OBJECT", "ENCODING", "ranked"}) + command({"ZRANK", "ranked", "member150"}) +
+                         command({"ZREVRANGE", "ranked", "0", "1"}) + command({"ZCOUNT", "ranked", "(10", "20"}),
+                     expected) == expected);
+    
+    expected = ":0\r\n:2\r\n";
+    assert(roundTrip(fd, command({"ZCARD", "nope"}) + command({"DEL", "ranked", "plain"}), expected) == expected);
+    
+    close(fd);
+    cout << "✓ Server sorted set commands test passed" << endl;
+}
+
+void testServerListsAndSets(int port) {
+    cout << "Testing server list and set commands..." << endl;
+    
+    int fd = connectTo(port);
+    
+    // Pushes reply with the length; pops with one element or, given a
+    // count, an array
+    string expected = ":3\r\n:5\r\n$1\r\ny\r\n$1\r\nc\r\n*2\r\n$1\r\nx\r\n$1\r\na\r\n:1\r\n"
+                      "$-1\r\n$-1\r\n*0\r\n-ERR value is out of range, must be positive\r\n"
+                      "-ERR wrong number of arguments for 'lpop' command\r\n";
+    assert(roundTrip(fd, command({"RPUSH", "queue", "a", "b", "c"}) + command({"LPUSH", "queue", "x", "y"}) +
+                         command({"LPOP", "queue"}) + command({"RPOP", "queue"}) +
+                         command({"LPOP", "queue", "2"}) + command({"LLEN", "queue"}) +
+                         command({"LPOP", "missing"}) + command({"RPOP", "missing", "2"}) +
+                         command({"LPOP", "queue", "0"}) + command({"LPOP", "queue", "-1"}) +
+                         command({"LPOP", "queue", "1", "2"}),
+                     expected) == expected);
+    
+    // Ranges with negative indexes, clamped to the list
+    expected = ":6\r\n*6\r\n$1\r\nb\r\n$1\r\n1\r\n$1\r\n2\r\n$1\r\n3\r\n$1\r\n4\r\n$1\r\n5\r\n"
+               "*2\r\n$1\r\n4\r\n$1\r\n5\r\n*1\r\n$1\r\nb\r\n*0\r\n*0\r\n";
+    assert(roundTrip(fd, command({"RPUSH", "queue", "1", "2", "3", "4", "5"}) +
+                         command({"LRANGE", "queue", "0", "-1"}) + command({"LRANGE", "queue", "-2", "100"}) +
+                         command({"LRANGE", "queue", "-100", "0"}) + command({"LRANGE", "queue", "4", "2"}) +
+                         command({"LRANGE", "missing", "0", "-1"}),
+                     expected) == expected);
+    
+    // Popping the last element takes the key with it
+    expected = "*6\r\n$1\r\nb\r\n$1\r\n1\r\n$1\r\n2\r\n$1\r\n3\r\n$1\r\n4\r\n$1\r\n5\r\n:0\r\n:0\r\n";
+    assert(roundTrip(fd, command({"LPOP", "queue", "10"}) + command({"EXISTS", "queue"}) +
+                         command({"LLEN", "queue"}),
+                     expected) == expected);
+    
+    // Integers make an intset, listed in order; a string member converts
+    expected = ":3\r\n:1\r\n$6\r\nintset\r\n:1\r\n:0\r\n:4\r\n*4\r\n$1\r\n1\r\n$1\r\n2\r\n$1\r\n3\r\n$2\r\n10\r\n"
+               ":5\r\n$9\r\nhashtable\r\n";
+    assert(roundTrip(fd, command({"SADD", "ids", "3", "1", "2", "1"}) + command({"SADD", "ids", "10"}) +
+                         command({"OBJECT", "ENCODING", "ids"}) + command({"SISMEMBER", "ids", "10"}) +
+                         command({"SISMEMBER", "ids", "010"}) + command({"SCARD", "ids"}) +
+                         command({"SMEMBERS", "ids"}) + command({"SADD", "tags", "red", "blue", "1", "2", "3"}) +
+                         command({"OBJECT", "ENCODING", "tags"}),
+                     expected) == expected);
+    
+    // SINTER walks the smallest set; a missing key empties the result
+    expected = "*3\r\n$1\r\n1\r\n$1\r\n2\r\n$1\r\n3\r\n*0\r\n*0\r\n:0\r\n";
+    assert(roundTrip(fd, command({"SINTER", "tags", "ids"}) + command({"SINTER", "ids", "missing"}) +
+                         command({"SMEMBERS", "missing"}) + command({"SCARD", "missing"}),
+                     expected) == expected);
+    
+    // Types, and the last member taking the key with it
+    string wrongType = "-WRONGTYPE Operation against a key holding the wrong kind of value\r\n";
+    expected = "+set\r\n:1\r\n+list\r\n+OK\r\n" + wrongType + wrongType + wrongType + wrongType + wrongType +
+               ":4\r\n:0\r\n:3\r\n";
+    assert(roundTrip(fd, command({"TYPE", "ids"}) + command({"LPUSH", "list", "x"}) + command({"TYPE", "list"}) +
+                         command({"SET", "plain", "str"}) + command({"SADD", "plain", "x"}) +
+                         command({"SINTER", "ids", "plain"}) + command({"LPUSH", "plain", "x"}) +
+                         command({"LRANGE", "plain", "0", "-1"}) + command({"SADD", "list", "x"}) +
+                         command({"SREM", "ids", "1", "2", "3", "10", "nope"}) + command({"EXISTS", "ids"}) +
+                         command({"DEL", "list", "tags", "plain"}),
+                     expected) == expected);
+    
+    close(fd);
+    cout << "✓ Server list and set commands test passed" << endl;
+}
+
+void testServerCounters(int port) {
+    cout << "Testing server counter commands..." << endl;
+    
+    int fd = connectTo(port);
+    
+    // Counted server-side, one round trip each; GET sees the text
+    string expected = ":1\r\n:11\r\n:10\r\n:-90\r\n$3\r\n-90\r\n$3\r\nint\r\n+OK\r\n:43\r\n";
+    assert(roundTrip(fd, command({"INCR", "hits"}) + command({"INCRBY", "hits", "10"}) + command({"DECR", "hits"}) +
+                         command({"DECRBY", "hits", "100"}) + command({"GET", "hits"}) +
+                         command({"OBJECT", "ENCODING", "hits"}) + command({"SET", "views", "42"}) +
+                         command({"INCR", "views"}),
+                     expected) == expected);
+    
+    // Floats reply with their shortest text
+    expected = "$4\r\n10.5\r\n$4\r\n10.6\r\n$2\r\n43\r\n$3\r\n-40\r\n";
+    assert(roundTrip(fd, command({"INCRBYFLOAT", "temp", "10.5"}) + command({"INCRBYFLOAT", "temp", "0.1"}) +
+                         command({"INCRBYFLOAT", "views", "0"}) + command({"INCRBYFLOAT", "hits", "50"}),
+                     expected) == expected);
+    
+    // Errors
+    string notInteger = "-ERR value is not an integer or out of range\r\n";
+    string wrongType = "-WRONGTYPE Operation against a key holding the wrong kind of value\r\n";
+    expected = "+OK\r\n" + notInteger + notInteger + notInteger + "+OK\r\n" +
+               "-ERR increment or decrement would overflow\r\n-ERR decrement would overflow\r\n:1\r\n" +
+               wrongType + wrongType + "-ERR value is not a valid float\r\n-ERR value is not a valid float\r\n" +
+               "-ERR increment would produce NaN or Infinity\r\n";
+    assert(roundTrip(fd, command({"SET", "name", "ada"}) + command({"INCR", "name"}) + command({"INCR", "temp"}) +
+                         command({"INCRBY", "hits", "x"}) + command({"SET", "max", "9223372036854775807"}) +
+                         command({"INCR", "max"}) + command({"DECRBY", "hits", "-9223372036854775808"}) +
+                         command({"SADD", "members", "1"}) + command({"INCR", "members"}) +
+                         command({"INCRBYFLOAT", "members", "1"}) + command({"INCRBYFLOAT", "name", "1"}) +
+                         command({"INCRBYFLOAT", "temp", "x"}) + command({"INCRBYFLOAT", "temp", "inf"}),
+                     expected) == expected);
+    
+    expected = ":6\r\n";
+    assert(roundTrip(fd, command({"DEL", "hits", "views", "temp", "name", "max", "members"}), expected) == expected);
+    
+    close(fd);
+    cout << "✓ Server counter commands test passed" << endl;
+}
+
+int main() {
+    cout << "=== SERVER TESTS ===" << endl << endl;
+    
+    try {
+        Cache cache(1024 * 1024 * 100, 100000);
+        Server server(cache, 0);
+        server.start();
+        thread loop([&server]() { server.run(); });
+        
+        testServerBasicCommands(server.getPort());
+        testServerFraming(server.getPort());
+        testServerConcurrentClients(server.getPort());
+        testServerLargeValues(server.getPort());
+        testServerInfo(server.getPort());
+        testServerCommandTable(server.getPort());
+        testServerHashes(server.getPort());
+        testServerZSets(server.getPort());
+        testServerListsAndSets(server.getPort());
+        testServerCounters(server.getPort());
+        
+        server.stop();
+        loop.join();
+        
+        cout << endl << "🎉 All server tests passed!" << endl;
+    } catch (const exception& e) {
+        cerr << "❌ Server test failed: " << e.what() << endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,228 @@
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "../include/SetValue.hpp"
+#include "../include/Cache.hpp"
+
+using namespace std;
+
+// Every member of s, checked against what it should hold
+static void assertHolds(const SetValue& s, const set<string>& expected) {
+    assert(s.size() == expected.size());
+    size_t visited = 0;
+    s.forEach([&](string_view member) {
+        assert(expected.count(string(member)));
+        visited++;
+    });
+    assert(visited == expected.size());
+    for (const string& member : expected) {
+        assert(s.contains(member));
+    }
+}
+
+void testIntset() {
+    cout << "Testing intset encoding..." << endl;
+
+    SlabAllocator slabs;
+    {
+        SetValue s(&slabs);
+        assert(s.size() == 0 && string(s.encoding()) == "intset");
+
+        assert(s.add("5"));
+        assert(s.add("-3"));
+        assert(s.add("100"));
+        assert(!s.add("5"));
+        size_t narrow = s.memoryUsage();
+
+        // Numeric order, whatever the insertion order
+        vector<string> order;
+        s.forEach([&](string_view member) { order.emplace_back(member); });
+        assert((order == vector<string>{"-3", "5", "100"}));
+
+        // Widens to 4, then 8 bytes, keeping every member
+        assert(s.add("70000"));
+        assert(s.add("-9223372036854775808"));
+        assert(s.add("9223372036854775807"));
+        assertHolds(s, {"-3", "5", "100", "70000", "-9223372036854775808", "9223372036854775807"});
+        assert(string(s.encoding()) == "intset");
+        assert(s.memoryUsage() >= narrow);
+        assert(s.memoryUsage() == slabs.usedBytes());
+
+        // Only canonical integers are intset members
+        assert(!s.contains("+5") && !s.contains("05") && !s.contains(" 5"));
+        assert(!s.remove("05"));
+        assert(s.remove("5") && !s.remove("5"));
+        assertHolds(s, {"-3", "100", "70000", "-9223372036854775808", "9223372036854775807"});
+        assert(string(s.encoding()) == "intset");
+    }
+    assert(slabs.usedBytes() == 0);
+
+    cout << "✓ Intset test passed" << endl;
+}
+
+void testSetConversion() {
+    cout << "Testing set conversion..." << endl;
+
+    SlabAllocator slabs;
+    {
+        // A string member converts the set
+        SetValue s(&slabs);
+        s.add("1");
+        s.add("2");
+        assert(s.add("007"));
+        assert(string(s.encoding()) == "hashtable");
+        assertHolds(s, {"1", "2", "007"});
+        assert(s.memoryUsage() == slabs.usedBytes());
+
+        // For good, even once only integers are left
+        assert(s.remove("007"));
+        assert(string(s.encoding()) == "hashtable");
+        assertHolds(s, {"1", "2"});
+    }
+    {
+        // So does one integer past the limit
+        SetValue s(&slabs);
+        set<string> expected;
+        for (size_t i = 0; i < SetValue::MAX_INTSET_ENTRIES; i++) {
+            s.add(to_string(i * 3));
+            expected.insert(to_string(i * 3));
+        }
+        assert(string(s.encoding()) == "intset");
+        // 512 two-byte integers in one chunk
+        assert(s.memoryUsage() <= SetValue::MAX_INTSET_ENTRIES * 2 * 2);
+        s.add("1");
+        expected.insert("1");
+        assert(string(s.encoding()) == "hashtable");
+        assertHolds(s, expected);
+    }
+    assert(slabs.usedBytes() == 0);
+
+    cout << "✓ Set conversion test passed" << endl;
+}
+
+void testSetChurn() {
+    cout << "Testing set churn..." << endl;
+
+    SlabAllocator slabs;
+    {
+        SetValue s(&slabs);
+        set<string> expected;
+        mt19937 rng(3);
+        for (int i = 0; i < 50000; i++) {
+            string member = (rng() % 4 ? "m" : "") + to_string(rng() % 5000);
+            if (rng() % 3) {
+                assert(s.add(member) == expected.insert(member).second);
+            } else {
+                assert(s.remove(member) == (expected.erase(member) == 1));
+            }
+        }
+        assertHolds(s, expected);
+        assert(s.memoryUsage() == slabs.usedBytes());
+    }
+    assert(slabs.usedBytes() == 0);
+
+    cout << "✓ Set churn test passed" << endl;
+}
+
+void testSetSerialize() {
+    cout << "Testing set serialization..." << endl;
+
+    SlabAllocator slabs;
+    for (bool integers : {true, false}) {
+        SetValue s(&slabs);
+        set<string> expected;
+        for (int i = 0; i < 300; i++) {
+            string member = (integers ? "" : "s") + to_string(i * 11 - 1000);
+            s.add(member);
+            expected.insert(member);
+        }
+
+        string serialized;
+        s.serialize(serialized);
+        assert(SetValue::isValid(serialized));
+        SetValue copy(&slabs, serialized);
+        assertHolds(copy, expected);
+        assert(string(copy.encoding()) == s.encoding());
+    }
+    assert(!SetValue::isValid(""));
+    assert(!SetValue::isValid(string("\x05" "ab", 3)));
+
+    cout << "✓ Set serialization test passed" << endl;
+}
+
+void testCacheSets() {
+    cout << "Testing sets in the cache..." << endl;
+
+    Cache cache(SIZE_MAX, SIZE_MAX);
+    size_t added, removed;
+    string_view odd[] = {"1", "3", "5", "7"};
+    string_view small[] = {"1", "2", "3"};
+    assert(cache.sadd("odd", odd, 4, added) == Cache::OK && added == 4);
+    assert(cache.sadd("small", small, 3, added) == Cache::OK && added == 3);
+    assert(cache.sadd("small", small, 3, added) == Cache::OK && added == 0);
+    assert(string(cache.encoding("odd")) == "intset");
+
+    Cache::Result result;
+    const SetValue* s = cache.readSet("odd", result);
+    assert(s && result == Cache::OK && s->size() == 4);
+    assert(cache.readSet("missing", result) == nullptr && result == Cache::NOT_FOUND);
+
+    // Several keys at once; missing keys come back null
+    vector<const SetValue*> sets;
+    string_view keys[] = {"odd", "missing", "small"};
+    assert(cache.readSets(keys, 3, sets) == Cache::OK);
+    assert(sets.size() == 3 && sets[0] && !sets[1] && sets[2]);
+    assert(sets[2]->contains("2") && !sets[0]->contains("2"));
+
+    // A key of another type fails the lot
+    cache.set("plain", "x");
+    string_view mixed[] = {"odd", "plain"};
+    sets.clear();
+    assert(cache.readSets(mixed, 2, sets) == Cache::WRONG_TYPE);
+    assert(cache.sadd("plain", odd, 1, added) == Cache::WRONG_TYPE);
+    assert(cache.srem("plain", odd, 1, removed) == Cache::WRONG_TYPE);
+
+    // Removing the last member takes the key with it
+    assert(cache.srem("small", small, 3, removed) == Cache::OK && removed == 3);
+    assert(!cache.exists("small"));
+    assert(cache.srem("small", small, 1, removed) == Cache::NOT_FOUND && removed == 0);
+
+    // Memory is accounted exactly through conversion
+    for (int i = 0; i < 2000; i++) {
+        string member = to_string(i);
+        string_view view = member;
+        cache.sadd("grown", &view, 1, added);
+    }
+    assert(string(cache.encoding("grown")) == "hashtable");
+    assert(cache.getStats().pinnedBytes == 0);
+
+    cache.del("grown");
+    cache.del("odd");
+    cache.del("plain");
+    CacheStats stats = cache.getStats();
+    assert(stats.keyBytes == 0 && stats.valueBytes == 0 && stats.slabUsedBytes == 0);
+
+    cout << "✓ Cache sets test passed" << endl;
+}
+
+int main() {
+    cout << "=== SET TESTS ===" << endl << endl;
+
+    try {
+        testIntset();
+        testSetConversion();
+        testSetChurn();
+        testSetSerialize();
+        testCacheSets();
+
+        cout << endl << "🎉 All set tests passed!" << endl;
+    } catch (const exception& e) {
+        cerr << "❌ Set test failed: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
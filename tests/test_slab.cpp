@@ -0,0 +1,123 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <vector>
+#include "../include/SlabAllocator.hpp"
+
+using namespace std;
+
+void testSlabSizeClasses() {
+    cout << "Testing slab size classes..." << endl;
+
+    SlabAllocator slabs;
+    assert(slabs.chunkSize(1) == SlabAllocator::MIN_CHUNK_SIZE);
+    assert(slabs.chunkSize(SlabAllocator::MIN_CHUNK_SIZE) == SlabAllocator::MIN_CHUNK_SIZE);
+
+    // Every request fits its chunk, with at most 25% waste past the first class
+    size_t previous = 0;
+    for (size_t bytes = 1; bytes <= SlabAllocator::MAX_CHUNK_SIZE; bytes += 1 + bytes / 7) {
+        size_t chunk = slabs.chunkSize(bytes);
+        assert(chunk >= bytes && chunk >= previous);
+        assert(chunk % SlabAllocator::CHUNK_ALIGN == 0);
+        assert(bytes <= SlabAllocator::MIN_CHUNK_SIZE || chunk <= bytes * 5 / 4 + SlabAllocator::CHUNK_ALIGN);
+        previous = chunk;
+    }
+    assert(slabs.chunkSize(SlabAllocator::MAX_CHUNK_SIZE) == SlabAllocator::MAX_CHUNK_SIZE);
+    assert(slabs.chunkSize(SlabAllocator::MAX_CHUNK_SIZE + 1) == SlabAllocator::MAX_CHUNK_SIZE + 1);
+
+    cout << "✓ Slab size classes test passed" << endl;
+}
+
+void testSlabReuse() {
+    cout << "Testing slab chunk reuse..." << endl;
+
+    SlabAllocator slabs;
+    void* a = slabs.allocate(100);
+    void* b = slabs.allocate(100);
+    assert(a != b);
+    assert(slabs.pageBytes() == SlabAllocator::PAGE_SIZE);
+    assert(slabs.usedBytes() == 2 * slabs.chunkSize(100));
+
+    // A freed chunk is the next one handed out for that class
+    slabs.deallocate(a, 100);
+    assert(slabs.allocate(110) == a);
+
+    vector<SlabClassStats> classes = slabs.classStats();
+    assert(classes.size() == 1);
+    assert(classes[0].usedChunks == 2 && classes[0].requestedBytes == 210);
+
+    // Large requests bypass the slabs but are still accounted
+    void* large = slabs.allocate(SlabAllocator::MAX_CHUNK_SIZE * 2);
+    assert(slabs.getLargeAllocs() == 1);
+    assert(slabs.usedBytes() == 2 * slabs.chunkSize(100) + SlabAllocator::MAX_CHUNK_SIZE * 2);
+    slabs.deallocate(large, SlabAllocator::MAX_CHUNK_SIZE * 2);
+    slabs.deallocate(a, 110);
+    slabs.deallocate(b, 100);
+    assert(slabs.usedBytes() == 0 && slabs.getLargeAllocs() == 0);
+
+    // Churn stays within the pages already reserved
+    for (int round = 0; round < 100; round++) {
+        vector<void*> chunks;
+        for (int i = 0; i < 1000; i++) {
+            chunks.push_back(slabs.allocate(64 + i % 64));
+        }
+        for (int i = 0; i < 1000; i++) {
+            slabs.deallocate(chunks[i], 64 + i % 64);
+        }
+    }
+    assert(slabs.usedBytes() == 0);
+    assert(slabs.pageBytes() <= 4 * SlabAllocator::PAGE_SIZE);
+
+    cout << "✓ Slab chunk reuse test passed" << endl;
+}
+
+void testSlabSharedFree() {
+    cout << "Testing slab frees from other threads..." << endl;
+
+    SlabAllocator slabs;
+    const int NUM_CHUNKS = 10000;
+    vector<void*> chunks;
+    for (int i = 0; i < NUM_CHUNKS; i++) {
+        chunks.push_back(slabs.allocate(48));
+    }
+    size_t pages = slabs.pageBytes();
+
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&slabs, &chunks, t]() {
+            for (int i = t; i < NUM_CHUNKS; i += 4) {
+                slabs.deallocateShared(chunks[i], 48);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    assert(slabs.usedBytes() == 0);
+
+    // The owner takes them back before carving anything new
+    for (int i = 0; i < NUM_CHUNKS; i++) {
+        slabs.allocate(48);
+    }
+    assert(slabs.pageBytes() == pages);
+    assert(slabs.classStats()[0].usedChunks == NUM_CHUNKS);
+
+    cout << "✓ Slab shared free test passed" << endl;
+}
+
+int main() {
+    cout << "=== SLAB ALLOCATOR TESTS ===" << endl << endl;
+
+    try {
+        testSlabSizeClasses();
+        testSlabReuse();
+        testSlabSharedFree();
+
+        cout << endl << "🎉 All slab allocator tests passed!" << endl;
+    } catch (const exception& e) {
+        cerr << "❌ Slab allocator test failed: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,518 @@
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <cstdio>
+#include <cmath>
+#include <unistd.h>
+#include <dirent.h>
+#include "../include/Snapshot.hpp"
+#include "../include/ShardedCache.hpp"
+#include "../include/CommandProcessor.hpp"
+
+using namespace std;
+
+// Keeps the last reply, rendered like redis-cli
+class LastReplyWriter : public ReplyWriter {
+public:
+    string last;
+
+    using ReplyWriter::bulk;
+
+    void status(const string& message) override { last = message; }
+    void error(const string& message) override { last = "(error) " + message; }
+    void integer(long long value) override { last = "(integer) " + to_string(value); }
+    void bulk(const string& value) override { last = value; }
+    void nil() override { last = "(nil)"; }
+    void arrayHeader(size_t count) override { last = "*" + to_string(count); }
+    void text(const string& value) override { last = value; }
+};
+
+static string run(CommandProcessor& processor, vector<string> argv) {
+    LastReplyWriter reply;
+    processor.execute(argv, reply);
+    return reply.last;
+}
+
+static string tempPath(const string& name) {
+    string path = "/tmp/mini_redis_" + name + "_" + to_string(getpid()) + ".snapshot";
+    remove(path.c_str());
+    return path;
+}
+
+static bool loadThrows(Cache& cache, const string& path) {
+    try {
+        Snapshot::load(cache, path);
+    } catch (const runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+void testSnapshotChecksum() {
+    cout << "Testing snapshot checksum..." << endl;
+
+    // Published xxHash64 values (seed 0), one under a stripe, one over
+    SnapshotChecksum empty;
+    assert(empty.digest() == 0xEF46DB3751D8E999ULL);
+    SnapshotChecksum shortInput;
+    shortInput.update("hello, world", 12);
+    assert(shortInput.digest() == 0xB33A384E6D1B1242ULL);
+    string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789$";
+    SnapshotChecksum longInput;
+    longInput.update(alphabet.data(), alphabet.size());
+    assert(longInput.digest() == 0x1032D841E824F998ULL);
+
+    // Feeding the bytes in pieces gives the same digest as in one go
+    string data;
+    for (int i = 0; i < 1000; i++) {
+        data += to_string(i * 7919);
+    }
+    SnapshotChecksum whole;
+    whole.update(data.data(), data.size());
+    SnapshotChecksum pieces;
+    for (size_t pos = 0, step = 1; pos < data.size(); pos += step, step = step % 37 + 1) {
+        pieces.update(data.data() + pos, min(step, data.size() - pos));
+    }
+    assert(whole.digest() == pieces.digest());
+
+    data[500] ^= 1;
+    SnapshotChecksum flipped;
+    flipped.update(data.data(), data.size());
+    assert(flipped.digest() != whole.digest());
+
+    cout << "✓ Snapshot checksum test passed" << endl;
+}
+
+void testSnapshotRoundTrip() {
+    cout << "Testing snapshot round trip..." << endl;
+
+    string path = tempPath("roundtrip");
+    string large(100000, 'L');
+    string binary("a\0b\r\n", 5);
+    {
+        Cache cache(SIZE_MAX, SIZE_MAX);
+        SnapshotManager snapshots(path);
+        CommandProcessor processor(cache, nullptr, &snapshots);
+
+        for (int i = 0; i < 5000; i++) {
+            run(processor, {"SET", "key" + to_string(i), "value" + to_string(i)});
+        }
+        run(processor, {"SET", "ttl", "x", "EX", "100"});
+        run(processor, {"SET", "large", large});
+        run(processor, {"SET", "empty", ""});
+        run(processor, {"SET", binary, binary});
+        run(processor, {"DEL", "key0"});
+
+        assert(run(processor, {"LASTSAVE"}) == "(integer) 0");
+        assert(run(processor, {"SAVE"}) == "OK");
+        assert(run(processor, {"LASTSAVE"}) != "(integer) 0");
+        assert(snapshots.getStats().saves == 1);
+    }
+
+    Cache cache(SIZE_MAX, SIZE_MAX);
+    SnapshotManager snapshots(path);
+    assert(snapshots.load(cache));
+    CommandProcessor loader(cache);
+    assert(cache.getKeyCount() == 5003);
+    assert(run(loader, {"GET", "key1"}) == "value1");
+    assert(run(loader, {"GET", "key4999"}) == "value4999");
+    assert(run(loader, {"GET", "key0"}) == "(nil)");
+    assert(run(loader, {"GET", "large"}) == large);
+    assert(run(loader, {"GET", "empty"}) == "");
+    assert(run(loader, {"GET", binary}) == binary);
+
+    // TTLs were saved as absolute times
+    long long ttl = cache.pttl("ttl");
+    assert(ttl > 99000 && ttl <= 100000);
+    assert(cache.pttl("key1") == -1);
+
+    // Loaded keys behave like any other
+    run(loader, {"SET", "key1", "changed"});
+    assert(run(loader, {"GET", "key1"}) == "changed");
+    assert(cache.getKeyCount() == 5003);
+
+    // Only into an empty cache
+    assert(loadThrows(cache, path));
+
+    // No file is not an error
+    SnapshotManager missing(tempPath("missing"));
+    Cache other;
+    assert(!missing.load(other));
+
+    remove(path.c_str());
+    cout << "✓ Snapshot round trip test passed" << endl;
+}
+
+void testSnapshotExpiry() {
+    cout << "Testing snapshot expiry..." << endl;
+
+    string path = tempPath("expiry");
+    {
+        Cache cache;
+        cache.psetex("short", "x", 30);
+        cache.psetex("long", "y", 100000);
+        cache.set("forever", "z");
+        Snapshot::save(cache, path);
+    }
+
+    // "short" expires while the server is down
+    this_thread::sleep_for(chrono::milliseconds(50));
+
+    Cache cache;
+    assert(Snapshot::load(cache, path) == 2);
+    assert(!cache.exists("short"));
+    assert(cache.exists("long") && cache.exists("forever"));
+
+    remove(path.c_str());
+    cout << "✓ Snapshot expiry test passed" << endl;
+}
+
+void testSnapshotCorruption() {
+    cout << "Testing snapshot corruption..." << endl;
+
+    string path = tempPath("corrupt");
+    string bytes;
+    {
+        Cache cache;
+        for (int i = 0; i < 1000; i++) {
+            cache.set("key" + to_string(i), "value" + to_string(i));
+        }
+        Snapshot::save(cache, path);
+        ifstream in(path, ios::binary);
+        bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    auto writeFile = [&](const string& contents) {
+        ofstream out(path, ios::binary | ios::trunc);
+        out << contents;
+    };
+
+    // One flipped bit in a value fails the checksum, and nothing is kept
+    string flipped = bytes;
+    flipped[bytes.size() / 2] ^= 1;
+    writeFile(flipped);
+    Cache cache;
+    assert(loadThrows(cache, path));
+    assert(cache.getKeyCount() == 0);
+
+    // Cut off mid-write
+    writeFile(bytes.substr(0, bytes.size() - 100));
+    assert(loadThrows(cache, path));
+    assert(cache.getKeyCount() == 0);
+
+    // Not a snapshot at all
+    writeFile("*1\r\n$4\r\nPING\r\n and some more bytes to pass the size check");
+    assert(loadThrows(cache, path));
+
+    // The untouched file still loads
+    writeFile(bytes);
+    assert(Snapshot::load(cache, path) == 1000);
+
+    // Without a checksum the same flip goes unnoticed
+    Snapshot::save(cache, path, false);
+    {
+        ifstream in(path, ios::binary);
+        bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+    size_t pos = bytes.find("value500");
+    assert(pos != string::npos);
+    bytes[pos] = 'V';
+    writeFile(bytes);
+    Cache unchecked;
+    assert(Snapshot::load(unchecked, path) == 1000);
+
+    remove(path.c_str());
+    cout << "✓ Snapshot corruption test passed" << endl;
+}
+
+// A snapshot file built by hand, without a checksum: version 1 entries are
+// key/value pairs, version 2 ones are type/key/value
+static string snapshotFile(uint32_t version, const vector<vector<string>>& entries) {
+    string out("MREDISDB", 8);
+    uint32_t flags = 0;
+    uint64_t count = entries.size();
+    int64_t created = 0;
+    out.append(reinterpret_cast<const char*>(&version), 4);
+    out.append(reinterpret_cast<const char*>(&flags), 4);
+    out.append(reinterpret_cast<const char*>(&count), 8);
+    out.append(reinterpret_cast<const char*>(&created), 8);
+    for (const vector<string>& entry : entries) {
+        size_t i = 0;
+        if (version >= 2) {
+            out.push_back(static_cast<char>(stoi(entry[i++])));
+        }
+        uint32_t keyLength = entry[i].size();
+        uint32_t valueLength = entry[i + 1].size();
+        int64_t expiresAt = -1;
+        out.append(reinterpret_cast<const char*>(&keyLength), 4);
+        out.append(reinterpret_cast<const char*>(&valueLength), 4);
+        out.append(reinterpret_cast<const char*>(&expiresAt), 8);
+        out += entry[i] + entry[i + 1];
+    }
+    uint64_t checksum = 0;
+    out.append(reinterpret_cast<const char*>(&checksum), 8);
+    out.append("MRDB_EOF", 8);
+    return out;
+}
+
+void testSnapshotValueTypes() {
+    cout << "Testing snapshot value types..." << endl;
+
+    string path = tempPath("types");
+    string large(200, 'L');
+    {
+        Cache cache(SIZE_MAX, SIZE_MAX);
+        CommandProcessor processor(cache);
+        run(processor, {"SET", "string", "plain"});
+        run(processor, {"HSET", "small", "name", "ada", "born", "1815"});
+        run(processor, {"HSET", "small-ttl", "f", "v"});
+        run(processor, {"PEXPIRE", "small-ttl", "100000"});
+        // Table encoded: too many fields, and a value too long for a listpack
+        for (int i = 0; i < 500; i++) {
+            run(processor, {"HSET", "many", "field" + to_string(i), to_string(i)});
+        }
+        run(processor, {"HSET", "wide", "big", large});
+        run(processor, {"ZADD", "board", "1.5", "a", "-inf", "b"});
+        for (int i = 0; i < 500; i++) {
+            run(processor, {"ZADD", "ranked", to_string(i * 0.25), "member" + to_string(i)});
+        }
+        run(processor, {"RPUSH", "queue", "a", "b", large});
+        run(processor, {"SADD", "ids", "3", "-70000", "12"});
+        run(processor, {"SADD", "tags", "red", "7"});
+        run(processor, {"INCRBY", "counter", "-12345"});
+        assert(run(processor, {"OBJECT", "ENCODING", "many"}) == "hashtable");
+        assert(run(processor, {"OBJECT", "ENCODING", "wide"}) == "hashtable");
+        Snapshot::save(cache, path);
+    }
+
+    // Each hash, sorted set and set comes back in the encoding its contents call for
+    {
+        Cache cache(SIZE_MAX, SIZE_MAX);
+        assert(Snapshot::load(cache, path) == 11);
+        CommandProcessor loader(cache);
+        assert(run(loader, {"GET", "string"}) == "plain");
+        assert(run(loader, {"TYPE", "small"}) == "hash");
+        assert(run(loader, {"HGET", "small", "born"}) == "1815");
+        assert(run(loader, {"HLEN", "small"}) == "(integer) 2");
+        assert(run(loader, {"OBJECT", "ENCODING", "small"}) == "listpack");
+        assert(cache.pttl("small-ttl") > 99000);
+        assert(run(loader, {"HLEN", "many"}) == "(integer) 500");
+        assert(run(loader, {"HGET", "many", "field499"}) == "499");
+        assert(run(loader, {"OBJECT", "ENCODING", "many"}) == "hashtable");
+        assert(run(loader, {"HGET", "wide", "big"}) == large);
+        assert(run(loader, {"OBJECT", "ENCODING", "wide"}) == "hashtable");
+        assert(run(loader, {"TYPE", "board"}) == "zset");
+        assert(run(loader, {"ZRANGE", "board", "0", "0"}) == "b");
+        assert(run(loader, {"OBJECT", "ENCODING", "board"}) == "listpack");
+        assert(run(loader, {"ZRANK", "ranked", "member499"}) == "(integer) 499");
+        assert(run(loader, {"ZSCORE", "ranked", "member3"}) == "0.75");
+        assert(run(loader, {"OBJECT", "ENCODING", "ranked"}) == "skiplist");
+        assert(run(loader, {"TYPE", "queue"}) == "list");
+        assert(run(loader, {"LRANGE", "queue", "0", "-1"}) == large);
+        assert(run(loader, {"LLEN", "queue"}) == "(integer) 3");
+        assert(run(loader, {"SMEMBERS", "ids"}) == "12");
+        assert(run(loader, {"OBJECT", "ENCODING", "ids"}) == "intset");
+        assert(run(loader, {"SISMEMBER", "tags", "red"}) == "(integer) 1");
+        assert(run(loader, {"OBJECT", "ENCODING", "tags"}) == "hashtable");
+        assert(run(loader, {"GET", "counter"}) == "-12345");
+        assert(run(loader, {"OBJECT", "ENCODING", "counter"}) == "int");
+        assert(run(loader, {"OBJECT", "ENCODING", "string"}) == "embstr");
+    }
+    ShardedCache shards(4, SIZE_MAX, SIZE_MAX);
+    assert(Snapshot::load(shards, path) == 11);
+    assert(shards.getKeyCount() == 11);
+
+    auto writeFile = [&](const string& contents) {
+        ofstream out(path, ios::binary | ios::trunc);
+        out << contents;
+    };
+
+    // Version 1 files, from before value types, hold strings
+    writeFile(snapshotFile(1, {{"a", "1"}, {"b", "2"}}));
+    Cache old;
+    assert(Snapshot::load(old, path) == 2);
+    string value;
+    assert(old.get("b", value) && value == "2");
+
+    // An unknown type, or a hash whose lengths run past its value, is refused
+    Cache cache;
+    writeFile(snapshotFile(2, {{"0", "a", "1"}, {"9", "b", "2"}}));
+    assert(loadThrows(cache, path));
+    writeFile(snapshotFile(2, {{"1", "h", string("\x01" "f" "\x05" "v", 4)}}));
+    assert(loadThrows(cache, path));
+    writeFile(snapshotFile(2, {{"1", "h", string("\x01" "f" "\x01" "v", 4)}}));
+    assert(Snapshot::load(cache, path) == 1);
+    assert(cache.encoding("h") == string("listpack"));
+    // A sorted set with a NaN score is refused too
+    double nan = NAN;
+    writeFile(snapshotFile(2, {{"2", "z", string(reinterpret_cast<const char*>(&nan), 8) + "\x01" "m"}}));
+    assert(loadThrows(cache, path));
+
+    // And so is a version from the future
+    writeFile(snapshotFile(Snapshot::VERSION + 1, {}));
+    Cache future;
+    assert(loadThrows(future, path));
+
+    remove(path.c_str());
+    cout << "✓ Snapshot value types test passed" << endl;
+}
+
+// Segment files next to path, named PATH.GENERATION.INDEX
+static vector<string> listSegments(const string& path) {
+    size_t slash = path.rfind('/');
+    string prefix = path.substr(slash + 1) + ".";
+    vector<string> segments;
+    DIR* dir = opendir(path.substr(0, slash).c_str());
+    while (struct dirent* entry = readdir(dir)) {
+        string name = entry->d_name;
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            segments.push_back(path.substr(0, slash + 1) + name);
+        }
+    }
+    closedir(dir);
+    return segments;
+}
+
+void testSegmentedSnapshot() {
+    cout << "Testing segmented snapshot..." << endl;
+
+    string path = tempPath("segmented");
+    Cache cache(SIZE_MAX, SIZE_MAX);
+    for (int i = 0; i < 20000; i++) {
+        cache.set("key" + to_string(i), "value" + to_string(i), i % 3 == 0 ? 1000 : -1);
+    }
+
+    size_t bytes = Snapshot::save(cache, path, true, 4);
+    assert(listSegments(path).size() == 4);
+    assert(Snapshot::diskUsage(path) == bytes);
+
+    // Into a Cache, built on one thread
+    Cache loaded(SIZE_MAX, SIZE_MAX);
+    assert(Snapshot::load(loaded, path) == 20000);
+    string value;
+    assert(loaded.get("key0", value) && value == "value0");
+    assert(loaded.get("key19999", value) && value == "value19999");
+    assert(loaded.pttl("key3") > 990000 && loaded.pttl("key4") == -1);
+
+    // Into a ShardedCache, one thread per segment
+    ShardedCache sharded(8, SIZE_MAX, SIZE_MAX);
+    assert(Snapshot::load(sharded, path) == 20000);
+    assert(sharded.getKeyCount() == 20000);
+    assert(sharded.get("key12345", value) && value == "value12345");
+
+    // A new save replaces the segments of the last one, in any layout
+    Snapshot::save(sharded, path, true, 3);
+    assert(listSegments(path).size() == 3);
+    Cache fromSharded(SIZE_MAX, SIZE_MAX);
+    assert(Snapshot::load(fromSharded, path) == 20000);
+    Snapshot::save(cache, path);
+    assert(listSegments(path).size() == 0);
+    Snapshot::save(cache, path, true, 2);
+
+    // The manifest header is outside its checksum, so an entry count that
+    // disagrees with the segment table is rejected before anything is sized
+    uint64_t entries;
+    {
+        fstream file(path, ios::in | ios::out | ios::binary);
+        file.seekg(16);
+        file.read(reinterpret_cast<char*>(&entries), sizeof(entries));
+        uint64_t huge = UINT64_MAX / 2;
+        file.seekp(16);
+        file.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+    }
+    Cache patched(SIZE_MAX, SIZE_MAX);
+    assert(entries == 20000);
+    assert(loadThrows(patched, path));
+    assert(patched.getKeyCount() == 0);
+    {
+        fstream file(path, ios::in | ios::out | ios::binary);
+        file.seekp(16);
+        file.write(reinterpret_cast<const char*>(&entries), sizeof(entries));
+    }
+    assert(Snapshot::load(patched, path) == 20000);
+
+    // A damaged or missing segment fails the whole load
+    string segment = listSegments(path)[0];
+    {
+        fstream file(segment, ios::in | ios::out | ios::binary);
+        file.seekp(1000);
+        file.put('X');
+    }
+    Cache damaged(SIZE_MAX, SIZE_MAX);
+    assert(loadThrows(damaged, path));
+    assert(damaged.getKeyCount() == 0);
+    remove(segment.c_str());
+    assert(loadThrows(damaged, path));
+    assert(damaged.getKeyCount() == 0);
+
+    Snapshot::remove(path);
+    assert(listSegments(path).size() == 0);
+    assert(access(path.c_str(), F_OK) != 0);
+    cout << "✓ Segmented snapshot test passed" << endl;
+}
+
+void testBackgroundSave() {
+    cout << "Testing background save..." << endl;
+
+    string path = tempPath("bgsave");
+    Cache cache;
+    SnapshotManager snapshots(path);
+    CommandProcessor processor(cache, nullptr, &snapshots);
+
+    for (int i = 0; i < 1000; i++) {
+        run(processor, {"SET", "key" + to_string(i), "before"});
+    }
+    assert(run(processor, {"BGSAVE"}) == "Background saving started");
+    assert(run(processor, {"BGSAVE"}).find("already in progress") != string::npos);
+    assert(run(processor, {"SAVE"}).find("already in progress") != string::npos);
+
+    // Writes after the fork are not in this snapshot
+    run(processor, {"SET", "key0", "after"});
+    run(processor, {"SET", "new", "after"});
+
+    for (int i = 0; i < 5000 && snapshots.isSaving(); i++) {
+        snapshots.cron();
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    assert(!snapshots.isSaving());
+    SnapshotStats stats = snapshots.getStats();
+    assert(stats.saves == 1 && stats.lastSaveOk && stats.lastSaveBytes > 0);
+    assert(run(processor, {"LASTSAVE"}) != "(integer) 0");
+    assert(run(processor, {"STATS"}).find("=== SNAPSHOTS ===") != string::npos);
+
+    Cache loaded;
+    assert(Snapshot::load(loaded, path) == 1000);
+    CommandProcessor loader(loaded);
+    assert(run(loader, {"GET", "key0"}) == "before");
+    assert(run(loader, {"GET", "new"}) == "(nil)");
+
+    // Without a snapshot file configured
+    assert(run(loader, {"BGSAVE"}).find("not enabled") != string::npos);
+
+    remove(path.c_str());
+    cout << "✓ Background save test passed" << endl;
+}
+
+int main() {
+    cout << "=== SNAPSHOT TESTS ===" << endl << endl;
+
+    try {
+        testSnapshotChecksum();
+        testSnapshotRoundTrip();
+        testSnapshotExpiry();
+        testSnapshotCorruption();
+        testSnapshotValueTypes();
+        testSegmentedSnapshot();
+        testBackgroundSave();
+
+        cout << endl << "🎉 All snapshot tests passed!" << endl;
+    } catch (const exception& e) {
+        cerr << "❌ Snapshot test failed: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
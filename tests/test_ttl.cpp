@@ -0,0 +1,131 @@
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "../include/TTLManager.hpp"
+
+using namespace std;
+
+// Pops everything that expired before currentTime
+static size_t popAll(TTLManager& wheel, long long currentTime) {
+    size_t popped = 0;
+    while (HashNode* node = wheel.popExpired(currentTime)) {
+        assert(node->expiryTime < currentTime);
+        assert(node->ttlIndex == HashNode::NOT_SCHEDULED);
+        node->expiryTime = -1;  // marks it as popped
+        popped++;
+    }
+    return popped;
+}
+
+void testWheelExpiryOrder() {
+    cout << "Testing timing wheel expiry..." << endl;
+
+    const long long START = 1000000;
+    TTLManager wheel(START);
+    mt19937_64 rng(7);
+
+    // Spread over every level, including the overflow bucket
+    vector<HashNode> nodes(20000);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        long long range = 1LL << (rng() % 40);
+        nodes[i].expiryTime = START + static_cast<long long>(rng() % range);
+        wheel.schedule(&nodes[i]);
+    }
+    assert(wheel.size() == nodes.size());
+
+    // Nothing expires before its time, and everything due is found
+    long long now = START;
+    while (!wheel.empty()) {
+        now += 1 + static_cast<long long>(rng() % (1LL << (rng() % 38)));
+        popAll(wheel, now);
+        for (const HashNode& node : nodes) {
+            assert(node.expiryTime == -1 || node.expiryTime >= now);
+        }
+    }
+    assert(wheel.memoryUsage() == 0);
+
+    cout << "✓ Timing wheel expiry test passed" << endl;
+}
+
+void testWheelReschedule() {
+    cout << "Testing timing wheel reschedule and cancel..." << endl;
+
+    TTLManager wheel(0);
+    vector<HashNode> nodes(1000);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        nodes[i].expiryTime = 100 + i;
+        wheel.schedule(&nodes[i]);
+    }
+
+    // Rescheduling moves a node instead of adding another
+    for (int round = 0; round < 10; round++) {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            nodes[i].expiryTime = (i * 7919 + round * 104729) % 100000 + 50;
+            wheel.schedule(&nodes[i]);
+        }
+    }
+    assert(wheel.size() == nodes.size());
+
+    // Cancelled nodes never come back
+    for (size_t i = 0; i < nodes.size(); i += 2) {
+        wheel.cancel(&nodes[i]);
+        wheel.cancel(&nodes[i]);
+    }
+    assert(wheel.size() == nodes.size() / 2);
+
+    size_t popped = popAll(wheel, 200000);
+    assert(popped == nodes.size() / 2);
+    for (size_t i = 1; i < nodes.size(); i += 2) {
+        assert(nodes[i].expiryTime == -1);
+    }
+
+    // A node already due is ready at once; one moved later is not
+    HashNode late;
+    late.expiryTime = 100;
+    wheel.schedule(&late);
+    assert(wheel.hasExpired(200001));
+    late.expiryTime = 300000;
+    wheel.schedule(&late);
+    assert(!wheel.hasExpired(200002));
+    assert(popAll(wheel, 300001) == 1);
+
+    cout << "✓ Timing wheel reschedule test passed" << endl;
+}
+
+void testWheelClear() {
+    cout << "Testing timing wheel clear..." << endl;
+
+    TTLManager wheel(0);
+    HashNode a, b;
+    a.expiryTime = 10;
+    b.expiryTime = 1LL << 40;
+    wheel.schedule(&a);
+    wheel.schedule(&b);
+    assert(wheel.memoryUsage() > 0);
+
+    wheel.clear();
+    assert(wheel.empty() && wheel.memoryUsage() == 0);
+    assert(a.ttlIndex == HashNode::NOT_SCHEDULED && b.ttlIndex == HashNode::NOT_SCHEDULED);
+    assert(wheel.popExpired(1LL << 41) == nullptr);
+
+    cout << "✓ Timing wheel clear test passed" << endl;
+}
+
+int main() {
+    cout << "=== TTL MANAGER TESTS ===" << endl << endl;
+
+    try {
+        testWheelExpiryOrder();
+        testWheelReschedule();
+        testWheelClear();
+
+        cout << endl << "🎉 All TTL manager tests passed!" << endl;
+    } catch (const exception& e) {
+        cerr << "❌ TTL manager test failed: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
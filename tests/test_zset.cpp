@@ -0,0 +1,342 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <set>
+#include <map>
+#include <string>
+#include <vector>
+#include "../include/ZSetValue.hpp"
+#include "../include/Cache.hpp"
+#include "../include/utils.hpp"
+
+using namespace std;
+
+typedef set<pair<double, string>> Reference;
+
+// Every member of zset in order, checked against expected, with scores,
+// ranks from both ends and full range walks
+static void assertHolds(const ZSetValue& zset, const Reference& expected) {
+    assert(zset.size() == expected.size());
+    vector<pair<double, string>> walked;
+    zset.forEach([&](string_view member, double score) { walked.emplace_back(score, string(member)); });
+    assert((walked == vector<pair<double, string>>(expected.begin(), expected.end())));
+
+    long long rank = 0;
+    for (const auto& entry : expected) {
+        double score;
+        assert(zset.score(entry.second, score) && score == entry.first);
+        assert(zset.rank(entry.second) == rank);
+        assert(zset.rank(entry.second, true) == static_cast<long long>(expected.size()) - 1 - rank);
+        rank++;
+    }
+}
+
+void testZSetListpack() {
+    cout << "Testing sorted set listpack encoding..." << endl;
+
+    SlabAllocator slabs;
+    {
+        ZSetValue zset(&slabs);
+        assert(zset.size() == 0 && string(zset.encoding()) == "listpack");
+        assert(zset.memoryUsage() == 0);
+
+        double score;
+        assert(zset.add("carol", 3, 0, score) == ZSetValue::ADDED);
+        assert(zset.add("alice", 1, 0, score) == ZSetValue::ADDED);
+        assert(zset.add("bob", 2, 0, score) == ZSetValue::ADDED);
+        assert(zset.add("abe", 2, 0, score) == ZSetValue::ADDED);    // ties order by member
+        assertHolds(zset, {{1, "alice"}, {2, "abe"}, {2, "bob"}, {3, "carol"}});
+
+        // Updates move a member to its new place
+        assert(zset.add("alice", 5, 0, score) == ZSetValue::UPDATED && score == 5);
+        assert(zset.add("alice", 5, 0, score) == ZSetValue::UNCHANGED);
+        assert(zset.add("bob", 1.5, ZSetValue::ADD_INCR, score) == ZSetValue::UPDATED && score == 3.5);
+        assertHolds(zset, {{2, "abe"}, {3, "carol"}, {3.5, "bob"}, {5, "alice"}});
+
+        // NX, XX, GT and LT
+        assert(zset.add("abe", 0, ZSetValue::ADD_NX, score) == ZSetValue::SKIPPED);
+        assert(zset.add("dave", 0, ZSetValue::ADD_XX, score) == ZSetValue::SKIPPED);
+        assert(zset.add("abe", 1, ZSetValue::ADD_GT, score) == ZSetValue::SKIPPED);
+        assert(zset.add("abe", 4, ZSetValue::ADD_GT, score) == ZSetValue::UPDATED);
+        assert(zset.add("abe", 6, ZSetValue::ADD_LT, score) == ZSetValue::SKIPPED);
+        assert(zset.add("dave", 0, ZSetValue::ADD_GT, score) == ZSetValue::ADDED);  // GT still adds
+        assertHolds(zset, {{0, "dave"}, {3, "carol"}, {3.5, "bob"}, {4, "abe"}, {5, "alice"}});
+
+        // inf - inf is no score
+        assert(zset.add("dave", INFINITY, 0, score) == ZSetValue::UPDATED);
+        assert(zset.add("dave", -INFINITY, ZSetValue::ADD_INCR, score) == ZSetValue::NOT_A_NUMBER);
+        assert(zset.score("dave", score) && score == INFINITY);
+
+        assert(zset.remove("carol") && !zset.remove("carol"));
+        assert(zset.rank("carol") == -1);
+
+        // Ranges
+        ScoreRange range{3.5, INFINITY};
+        assert(zset.countInRange(range) == 4);
+        range.minExclusive = true;
+        vector<string> found;
+        zset.forEachInRange(range, true, 1, 2, [&](string_view member, double) { found.push_back(string(member)); });
+        assert((found == vector<string>{"alice", "abe"}));
+        found.clear();
+        zset.forEachInRanks(1, 2, true, [&](string_view member, double) { found.push_back(string(member)); });
+        assert((found == vector<string>{"alice", "abe"}));
+
+        // The whole set is one slab chunk
+        assert(zset.memoryUsage() == slabs.usedBytes());
+        assert(string(zset.encoding()) == "listpack");
+    }
+    assert(slabs.usedBytes() == 0);
+
+    cout << "✓ Sorted set listpack encoding test passed" << endl;
+}
+
+void testZSetConversion() {
+    cout << "Testing sorted set conversion to a skiplist..." << endl;
+
+    SlabAllocator slabs;
+    {
+        // Past MAX_LISTPACK_ENTRIES members
+        ZSetValue zset(&slabs);
+        Reference expected;
+        double score;
+        for (size_t i = 0; i < ZSetValue::MAX_LISTPACK_ENTRIES; i++) {
+            zset.add("m" + to_string(i), i % 7, 0, score);
+            expected.insert({i % 7, "m" + to_string(i)});
+        }
+        assert(string(zset.encoding()) == "listpack");
+        zset.add("one more", -1, 0, score);
+        expected.insert({-1, "one more"});
+        assert(string(zset.encoding()) == "skiplist");
+        assertHolds(zset, expected);
+
+        // A long member converts a small set too, and it stays converted
+        ZSetValue wide(&slabs);
+        wide.add("a", 1, 0, score);
+        wide.add(string(ZSetValue::MAX_LISTPACK_VALUE, 'm'), 2, 0, score);
+        assert(string(wide.encoding()) == "listpack");
+        wide.add(string(ZSetValue::MAX_LISTPACK_VALUE + 1, 'm'), 3, 0, score);
+        assert(string(wide.encoding()) == "skiplist");
+        wide.remove(string(ZSetValue::MAX_LISTPACK_VALUE + 1, 'm'));
+        assert(string(wide.encoding()) == "skiplist");
+        assertHolds(wide, {{1, "a"}, {2, string(64, 'm')}});
+        assert(zset.memoryUsage() + wide.memoryUsage() == slabs.usedBytes());
+    }
+    assert(slabs.usedBytes() == 0);
+
+    cout << "✓ Sorted set conversion test passed" << endl;
+}
+
+// Random adds, updates and removes against a std::set, with range queries
+// checked as the skiplist spans change
+void testZSetSkiplistChurn() {
+    cout << "Testing sorted set skiplist churn..." << endl;
+
+    SlabAllocator slabs;
+    {
+        ZSetValue zset(&slabs);
+        Reference expected;
+        map<string, double> scores;
+        mt19937 rng(7);
+        for (int i = 0; i < 40000; i++) {
+            string member = "member:" + to_string(rng() % 3000);
+            double score = static_cast<double>(rng() % 500) / 4;
+            auto it = scores.find(member);
+            double newScore;
+            if (rng() % 4 == 0) {
+                assert(zset.remove(member) == (it != scores.end()));
+                if (it != scores.end()) {
+                    expected.erase({it->second, member});
+                    scores.erase(it);
+                }
+            } else if (it == scores.end()) {
+                assert(zset.add(member, score, 0, newScore) == ZSetValue::ADDED);
+                expected.insert({score, member});
+                scores[member] = score;
+            } else {
+                ZSetValue::AddOutcome outcome = zset.add(member, score, 0, newScore);
+                assert(outcome == (score == it->second ? ZSetValue::UNCHANGED : ZSetValue::UPDATED));
+                expected.erase({it->second, member});
+                expected.insert({score, member});
+                it->second = score;
+            }
+
+            if (i % 1000 == 999) {
+                ScoreRange range{static_cast<double>(rng() % 125), static_cast<double>(rng() % 125), rng() % 2 == 0,
+                                 rng() % 2 == 0};
+                vector<pair<double, string>> want, got;
+                for (const auto& entry : expected) {
+                    if (range.contains(entry.first)) want.push_back(entry);
+                }
+                assert(zset.countInRange(range) == want.size());
+                zset.forEachInRange(range, false, 0, -1,
+                                    [&](string_view member, double s) { got.emplace_back(s, string(member)); });
+                assert(got == want);
+
+                // From the top, past an offset, limited
+                got.clear();
+                zset.forEachInRange(range, true, 3, 5,
+                                    [&](string_view member, double s) { got.emplace_back(s, string(member)); });
+                reverse(want.begin(), want.end());
+                want.erase(want.begin(), want.begin() + min<size_t>(3, want.size()));
+                if (want.size() > 5) want.resize(5);
+                assert(got == want);
+            }
+        }
+        assert(string(zset.encoding()) == "skiplist");
+        assertHolds(zset, expected);
+        assert(zset.memoryUsage() == slabs.usedBytes());
+
+        // Rank windows from both ends
+        vector<pair<double, string>> all(expected.begin(), expected.end());
+        vector<pair<double, string>> got;
+        zset.forEachInRanks(100, 199, false, [&](string_view member, double s) { got.emplace_back(s, string(member)); });
+        assert(equal(got.begin(), got.end(), all.begin() + 100));
+        got.clear();
+        zset.forEachInRanks(0, 9, true, [&](string_view member, double s) { got.emplace_back(s, string(member)); });
+        assert(equal(got.begin(), got.end(), all.rbegin()));
+
+        for (const auto& entry : scores) {
+            assert(zset.remove(entry.first));
+        }
+        assert(zset.size() == 0);
+    }
+    assert(slabs.usedBytes() == 0);
+
+    cout << "✓ Sorted set skiplist churn test passed" << endl;
+}
+
+void testZSetSerialize() {
+    cout << "Testing sorted set serialization..." << endl;
+
+    SlabAllocator slabs;
+    for (size_t members : {1, 10, 300}) {
+        ZSetValue zset(&slabs);
+        Reference expected;
+        double score;
+        for (size_t i = 0; i < members; i++) {
+            double value = i % 3 == 0 ? -INFINITY : static_cast<double>(i) / 3;
+            zset.add("member" + to_string(i), value, 0, score);
+            expected.insert({value, "member" + to_string(i)});
+        }
+
+        string serialized;
+        zset.serialize(serialized);
+        assert(ZSetValue::isValid(serialized));
+        ZSetValue copy(&slabs, serialized);
+        assertHolds(copy, expected);
+        assert(string(copy.encoding()) == zset.encoding());
+
+        // A cut anywhere but between entries is refused
+        set<size_t> boundaries;
+        size_t end = 0;
+        zset.forEach([&](string_view member, double) {
+            end += sizeof(double) + 1 + member.size();
+            boundaries.insert(end);
+        });
+        assert(end == serialized.size());
+        for (size_t length = 0; length < serialized.size(); length++) {
+            assert(ZSetValue::isValid(serialized.substr(0, length)) == (boundaries.count(length) == 1));
+        }
+    }
+    // NaN is never a score
+    double nan = NAN;
+    string bad(reinterpret_cast<const char*>(&nan), sizeof(nan));
+    assert(!ZSetValue::isValid(bad + "\x01" "m"));
+
+    cout << "✓ Sorted set serialization test passed" << endl;
+}
+
+void testCacheZSets() {
+    cout << "Testing sorted sets in the cache..." << endl;
+
+    Cache cache(SIZE_MAX, SIZE_MAX);
+    size_t added, updated;
+    double score;
+    double scores[] = {1, 2, 3};
+    string_view members[] = {"a", "b", "c"};
+    assert(cache.zadd("board", scores, members, 3, 0, added, updated, score) == Cache::OK);
+    assert(added == 3 && updated == 0 && score == 3);
+
+    ValueType type;
+    assert(cache.type("board", type) && type == ValueType::ZSET);
+    assert(string(cache.encoding("board")) == "listpack");
+
+    Cache::Result result;
+    const ZSetValue* zset = cache.readZSet("board", result);
+    assert(result == Cache::OK && zset->size() == 3);
+    assert(cache.readZSet("nope", result) == nullptr && result == Cache::NOT_FOUND);
+
+    // INCR, and an INCR that would be NaN changes nothing
+    double increment = INFINITY;
+    assert(cache.zadd("board", &increment, members, 1, ZSetValue::ADD_INCR, added, updated, score) == Cache::OK);
+    assert(updated == 1 && score == INFINITY);
+    increment = -INFINITY;
+    assert(cache.zadd("board", &increment, members, 1, ZSetValue::ADD_INCR, added, updated, score) ==
+           Cache::NOT_A_NUMBER);
+    assert(updated == 0);
+
+    // XX on a missing key leaves no key behind
+    assert(cache.zadd("ghost", scores, members, 1, ZSetValue::ADD_XX, added, updated, score) == Cache::OK);
+    assert(added == 0 && std::isnan(score) && !cache.exists("ghost"));
+
+    // Types do not mix
+    cache.set("plain", "x");
+    assert(cache.zadd("plain", scores, members, 1, 0, added, updated, score) == Cache::WRONG_TYPE);
+    size_t removed;
+    assert(cache.zrem("plain", members, 1, removed) == Cache::WRONG_TYPE);
+    string_view pair[] = {"f", "v"};
+    cache.hset("hash", pair, 1, added);
+    assert(cache.readZSet("hash", result) == nullptr && result == Cache::WRONG_TYPE);
+
+    // Memory is accounted exactly as sets grow, convert and shrink
+    vector<string> names;
+    for (int i = 0; i < 1000; i++) names.push_back("player" + to_string(i));
+    vector<string_view> views(names.begin(), names.end());
+    vector<double> points(1000);
+    for (int i = 0; i < 1000; i++) points[i] = i * 1.5;
+    cache.zadd("big", points.data(), views.data(), 1000, 0, added, updated, score);
+    assert(added == 1000 && string(cache.encoding("big")) == "skiplist");
+    CacheStats stats = cache.getStats();
+    assert(stats.pinnedBytes == 0);
+    assert(stats.valueBytes >= 1000 * (sizeof(double) + 2 * sizeof(void*) + 10));
+
+    assert(cache.zrem("big", views.data(), 999, removed) == Cache::OK && removed == 999);
+    assert(cache.getStats().valueBytes < stats.valueBytes);
+    assert(cache.zrem("big", &views[999], 1, removed) == Cache::OK && removed == 1);
+    assert(!cache.exists("big"));
+    assert(cache.zrem("big", views.data(), 1, removed) == Cache::NOT_FOUND);
+
+    // A TTL covers the whole set
+    cache.pexpire("board", 1000);
+    assert(cache.pttl("board") > 0);
+    cache.setClock(Utils::monotonicMillis() + 2000);
+    assert(cache.readZSet("board", result) == nullptr && result == Cache::NOT_FOUND);
+    cache.setClock(Utils::monotonicMillis());
+
+    cache.del("plain");
+    cache.del("hash");
+    stats = cache.getStats();
+    assert(stats.keyBytes == 0 && stats.valueBytes == 0 && stats.slabUsedBytes == 0);
+
+    cout << "✓ Cache sorted sets test passed" << endl;
+}
+
+int main() {
+    cout << "=== SORTED SET TESTS ===" << endl << endl;
+
+    try {
+        testZSetListpack();
+        testZSetConversion();
+        testZSetSkiplistChurn();
+        testZSetSerialize();
+        testCacheZSets();
+
+        cout << endl << "🎉 All sorted set tests passed!" << endl;
+    } catch (const exception& e) {
+        cerr << "❌ Sorted set test failed: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}